@@ -87,6 +87,11 @@ mag_converter_min_fov               = 0.001
 labels_amount                       = 3.0
 init_bortle_scale                   = 2
 
+# Star catalogs from this level on are read zone by zone when first needed (-1 to read them whole at startup)
+lazy_loading_min_level              = 4
+# Memory budget for the stars of the zones read on demand
+max_loaded_zones_mb                 = 256
+
 [custom_selected_info]
 flag_show_absolutemagnitude         = false
 flag_show_altaz                     = false
@@ -275,6 +280,10 @@ flag_planets                        = true
 flag_planets_hints                  = false
 flag_planets_orbits                 = false
 flag_light_travel_time              = true
+flag_parallel_planet_positions      = false
+flag_ephemeris_cache                = false
+ephemeris_cache_years               = 200
+ephemeris_cache_prefill_days        = 366
 flag_object_trails                  = false
 flag_nebula                         = true
 flag_nebula_name                    = false
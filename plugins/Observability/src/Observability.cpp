@@ -23,6 +23,7 @@
 #include <QSettings>
 #include <QString>
 #include <QTimer>
+#include <QtConcurrent>
 
 #include "Observability.hpp"
 #include "ObservabilityDialog.hpp"
@@ -942,7 +943,7 @@ void Observability::double2hms(double hfloat, int &h1, int &h2, int &h3)
 
 ////////////////////////////////////
 // Adds/subtracts 24hr to ensure a RA between 0 and 24hr:
-double Observability::toUnsignedRA(double RA)
+double Observability::toUnsignedRA(double RA) const
 {
 	double tempRA,tempmod;	
 	if (RA<0.0)
@@ -1009,18 +1010,17 @@ QString Observability::formatAsDateRange(int startDay, int endDay)
 // Compute planet's position for each day of the current year:
 void Observability::updatePlanetData(StelCore *core)
 {
+	const YearlyCoords& coords = getYearlyCoords(core, myPlanet);
 	double tempH;
 	for (int i=0; i<nDays; i++)
 	{
-		getPlanetCoords(core, yearJD[i], objectRA[i], objectDec[i], false);
+		objectRA[i] = coords.ra.at(i);
+		objectDec[i] = coords.dec.at(i);
 		tempH = calculateHourAngle(mylat, refractedHorizonAlt, objectDec[i]);
 		objectH0[i] = tempH;
 		objectSidT[0][i] = toUnsignedRA(objectRA[i]-tempH);
 		objectSidT[1][i] = toUnsignedRA(objectRA[i]+tempH);
 	}
-
-// Return the planet to its current time:
-	getPlanetCoords(core, myJD, objectRA[0], objectDec[0], true);
 }
 
 /////////////////////////////////////////////////
@@ -1039,23 +1039,57 @@ void Observability::updateSunData(StelCore* core)
 	StelUtils::getDateFromJulianDay(Jan1stJD+365., &sameYear, &month, &day);
 	nDays = (year==sameYear)?366:365;
 	
-// Compute Earth's position throughout the year:
-	Vec3d pos, sunPos;
 	for (int i=0; i<nDays; i++)
 	{
 		yearJD[i].first = Jan1stJD + (double)i;
 		yearJD[i].second = yearJD[i].first+core->computeDeltaT(yearJD[i].first)/86400.0;
-		myEarth->computePosition(yearJD[i].second);
-		myEarth->computeTransMatrix(yearJD[i].first, yearJD[i].second);
-		pos = myEarth->getHeliocentricEclipticPos();
-		sunPos = core->j2000ToEquinoxEqu((StelCore::matVsop87ToJ2000)*(-pos), StelCore::RefractionOff);
-		EarthPos[i] = -pos;
-		toRADec(sunPos,sunRA[i],sunDec[i]);
 	};
 
-//Return the Earth to its current time:
-	myEarth->computePosition(myJD.second);
-	myEarth->computeTransMatrix(myJD.first, myJD.second);
+// Get the Sun's position throughout the year:
+	const YearlyCoords& coords = getYearlyCoords(core, GETSTELMODULE(SolarSystem)->getSun().data());
+	for (int i=0; i<nDays; i++)
+	{
+		sunRA[i] = coords.ra.at(i);
+		sunDec[i] = coords.dec.at(i);
+	};
+}
+///////////////////////////////////////////////////
+
+
+////////////////////////////////////////////
+// Returns the yearly coordinates of a body, computing them only once per year:
+const Observability::YearlyCoords& Observability::getYearlyCoords(const StelCore* core, const Planet* body)
+{
+	const QString key = QString("%1|%2").arg(body->getEnglishName()).arg(curYear);
+	QHash<QString, YearlyCoords>::const_iterator it = yearlyCoordsCache.constFind(key);
+	if (it != yearlyCoordsCache.constEnd())
+		return it.value();
+
+	// Keep the Sun and a handful of planets for a few years.
+	if (yearlyCoordsCache.size() >= 64)
+		yearlyCoordsCache.clear();
+
+	YearlyCoords& coords = yearlyCoordsCache[key];
+	computeYearlyCoords(core, body, coords);
+	return coords;
+}
+///////////////////////////////////////////////////
+
+
+////////////////////////////////////////////
+// Computes the coordinates of a body for each day of the current year, in parallel:
+void Observability::computeYearlyCoords(const StelCore* core, const Planet* body, YearlyCoords& coords) const
+{
+	coords.ra.resize(nDays);
+	coords.dec.resize(nDays);
+	QVector<int> days(nDays);
+	for (int i=0; i<nDays; i++)
+		days[i] = i;
+
+	QtConcurrent::blockingMap(days, [this, core, body, &coords](const int& i) {
+		Vec3d pos = computeGeocentricEquPos(core, body, yearJD[i].second);
+		toRADec(pos, coords.ra[i], coords.dec[i]);
+	});
 }
 ///////////////////////////////////////////////////
 
@@ -1252,7 +1286,7 @@ int Observability::calculateAcroCos(int &acroRise, int &acroSet,
 
 ////////////////////////////////////////////
 // Convert an Equatorial Vec3d into RA and Dec:
-void Observability::toRADec(Vec3d vec3d, double& ra, double &dec)
+void Observability::toRADec(Vec3d vec3d, double& ra, double &dec) const
 {
 	vec3d.normalize();
 	dec = std::asin(vec3d[2]); // in radians
@@ -1274,45 +1308,27 @@ double Observability::sign(double d)
 
 //////////////////////////
 // Get the coordinates of Sun or Moon for a given JD:
-// getBack controls whether Earth and Moon must be returned to their original positions after computation.
-void Observability::getSunMoonCoords(StelCore *core, QPair<double, double> JD,
+void Observability::getSunMoonCoords(const StelCore *core, QPair<double, double> JD,
 				     double &raSun, double &decSun,
 				     double &raMoon, double &decMoon,
-				     double &eclLon, bool getBack)
-                                     //, Vec3d &AltAzVector)
+				     double &eclLon) const
 {
-
-	if (getBack) // Return the Moon and Earth to their current position:
-	{
-		myEarth->computePosition(JD.second);
-		myEarth->computeTransMatrix(JD.first, JD.second);
-		myMoon->computePosition(JD.second);
-		myMoon->computeTransMatrix(JD.first, JD.second);
-	} 
-	else // Compute coordinates:
-	{
-		myEarth->computePosition(JD.second);
-		myEarth->computeTransMatrix(JD.first, JD.second);
-		Vec3d earthPos = myEarth->getHeliocentricEclipticPos();
-		double curSidT;
+	Vec3d earthPos = myEarth->computeHeliocentricEclipticPos(JD.second);
 
 // Sun coordinates:
-		Vec3d sunPos = core->j2000ToEquinoxEqu((StelCore::matVsop87ToJ2000)*(-earthPos), StelCore::RefractionOff);
-		toRADec(sunPos, raSun, decSun);
+	Vec3d sunPos = core->j2000ToEquinoxEqu((StelCore::matVsop87ToJ2000)*(-earthPos), StelCore::RefractionOff);
+	toRADec(sunPos, raSun, decSun);
 
 // Moon coordinates:
-		curSidT = myEarth->getSiderealTime(JD.first, JD.second)/Rad2Deg;
-		RotObserver = (Mat4d::zrotation(curSidT))*ObserverLoc;
-		LocTrans = (StelCore::matVsop87ToJ2000)*(Mat4d::translation(-earthPos));
-		myMoon->computePosition(JD.second);
-		myMoon->computeTransMatrix(JD.first, JD.second);
-		Vec3d moonPos = myMoon->getHeliocentricEclipticPos();
-		sunPos = (core->j2000ToEquinoxEqu(LocTrans*moonPos, StelCore::RefractionOff))-RotObserver;
-		
-		eclLon = moonPos[0]*earthPos[1] - moonPos[1]*earthPos[0];
+	double curSidT = myEarth->getSiderealTime(JD.first, JD.second)/Rad2Deg;
+	Vec3d rotObserver = (Mat4d::zrotation(curSidT))*ObserverLoc;
+	Mat4d locTrans = (StelCore::matVsop87ToJ2000)*(Mat4d::translation(-earthPos));
+	Vec3d moonPos = myMoon->computeHeliocentricEclipticPos(JD.second);
+	Vec3d moonEquPos = (core->j2000ToEquinoxEqu(locTrans*moonPos, StelCore::RefractionOff))-rotObserver;
 
-		toRADec(sunPos,raMoon,decMoon);
-	};
+	eclLon = moonPos[0]*earthPos[1] - moonPos[1]*earthPos[0];
+
+	toRADec(moonEquPos,raMoon,decMoon);
 }
 //////////////////////////////////////////////
 
@@ -1320,41 +1336,14 @@ void Observability::getSunMoonCoords(StelCore *core, QPair<double, double> JD,
 
 //////////////////////////
 // Get the Observer-to-Moon distance JD:
-// getBack controls whether Earth and Moon must be returned to their original positions after computation.
-void Observability::getMoonDistance(StelCore *core, QPair<double, double> JD, double &distance, bool getBack)
+void Observability::getMoonDistance(const StelCore *core, QPair<double, double> JD, double &distance) const
 {
+	Vec3d earthPos = myEarth->computeHeliocentricEclipticPos(JD.second);
+	Mat4d locTrans = (StelCore::matVsop87ToJ2000)*(Mat4d::translation(-earthPos));
+	Vec3d moonPos = myMoon->computeHeliocentricEclipticPos(JD.second);
+	moonPos = core->j2000ToEquinoxEqu(locTrans*moonPos, StelCore::RefractionOff);
 
-	if (getBack) // Return the Moon and Earth to their current position:
-	{
-		myEarth->computePosition(JD.second);
-		myEarth->computeTransMatrix(JD.first, JD.second);
-		myMoon->computePosition(JD.second);
-		myMoon->computeTransMatrix(JD.first, JD.second);
-	} 
-	else
-	{	// Compute coordinates:
-		myEarth->computePosition(JD.second);
-		myEarth->computeTransMatrix(JD.first, JD.second);
-		Vec3d earthPos = myEarth->getHeliocentricEclipticPos();
-//		double curSidT;
-
-// Sun coordinates:
-//		Pos2 = core->j2000ToEquinoxEqu((core->matVsop87ToJ2000)*(-Pos0));
-//		toRADec(Pos2,RASun,DecSun);
-
-// Moon coordinates:
-//		curSidT = myEarth->getSiderealTime(JD)/Rad2Deg;
-//		RotObserver = (Mat4d::zrotation(curSidT))*ObserverLoc;
-		LocTrans = (StelCore::matVsop87ToJ2000)*(Mat4d::translation(-earthPos));
-		myMoon->computePosition(JD.second);
-		myMoon->computeTransMatrix(JD.first, JD.second);
-		Pos1 = myMoon->getHeliocentricEclipticPos();
-		Pos2 = (core->j2000ToEquinoxEqu(LocTrans*Pos1), StelCore::RefractionOff); //-RotObserver;
-
-		distance = std::sqrt(Pos2*Pos2);
-
-//		toRADec(Pos2,RAMoon,DecMoon);
-	};
+	distance = std::sqrt(moonPos*moonPos);
 }
 //////////////////////////////////////////////
 
@@ -1363,30 +1352,21 @@ void Observability::getMoonDistance(StelCore *core, QPair<double, double> JD, do
 
 //////////////////////////////////////////////
 // Get the Coords of a planet:
-void Observability::getPlanetCoords(StelCore *core, QPair<double, double> JD, double &RA, double &Dec, bool getBack)
+void Observability::getPlanetCoords(const StelCore *core, QPair<double, double> JD, double &RA, double &Dec) const
 {
+	toRADec(computeGeocentricEquPos(core, myPlanet, JD.second), RA, Dec);
+}
+//////////////////////////////////////////////
+
 
-	if (getBack)
-	{
-	// Return the planet to its current time:
-		myPlanet->computePosition(JD.second);
-		myPlanet->computeTransMatrix(JD.first, JD.second);
-		myEarth->computePosition(JD.second);
-		myEarth->computeTransMatrix(JD.first, JD.second);
-	} else
-	{
-	// Compute planet's position:
-		myPlanet->computePosition(JD.second);
-		myPlanet->computeTransMatrix(JD.first, JD.second);
-		Pos1 = myPlanet->getHeliocentricEclipticPos();
-		myEarth->computePosition(JD.second);
-		myEarth->computeTransMatrix(JD.first, JD.second);
-		Pos2 = myEarth->getHeliocentricEclipticPos();
-		LocTrans = (StelCore::matVsop87ToJ2000)*(Mat4d::translation(-Pos2));
-		Pos2 = core->j2000ToEquinoxEqu(LocTrans*Pos1, StelCore::RefractionOff);
-		toRADec(Pos2,RA,Dec);
-	};
 
+//////////////////////////////////////////////
+// Geocentric position of a body in equatorial coordinates of date:
+Vec3d Observability::computeGeocentricEquPos(const StelCore* core, const Planet* body, double JDE) const
+{
+	Vec3d bodyPos = body->computeHeliocentricEclipticPos(JDE);
+	Vec3d earthPos = myEarth->computeHeliocentricEclipticPos(JDE);
+	return core->j2000ToEquinoxEqu((StelCore::matVsop87ToJ2000)*(bodyPos-earthPos), StelCore::RefractionOff);
 }
 //////////////////////////////////////////////
 
@@ -1415,35 +1395,27 @@ bool Observability::calculateSolarSystemEvents(StelCore* core, int bodyType)
 
 		lastType = bodyType;
 
-		myEarth->computePosition(myJD.second);
-		myEarth->computeTransMatrix(myJD.first, myJD.second);
-		Vec3d earthPos = myEarth->getHeliocentricEclipticPos();
-
+		Vec3d equPos;
 		if (bodyType == 1) // Sun position
 		{
-			Pos2 = core->j2000ToEquinoxEqu((StelCore::matVsop87ToJ2000)*(-earthPos), StelCore::RefractionOff);
+			equPos = computeGeocentricEquPos(core, GETSTELMODULE(SolarSystem)->getSun().data(), myJD.second);
 		}
 		else if (bodyType==2) // Moon position
 		{
+			Vec3d earthPos = myEarth->computeHeliocentricEclipticPos(myJD.second);
 			curSidT = myEarth->getSiderealTime(myJD.first, myJD.second)/Rad2Deg;
-			RotObserver = (Mat4d::zrotation(curSidT))*ObserverLoc;
-			LocTrans = (StelCore::matVsop87ToJ2000)*(Mat4d::translation(-earthPos));
-			myMoon->computePosition(myJD.second);
-			myMoon->computeTransMatrix(myJD.first, myJD.second);
-			Pos1 = myMoon->getHeliocentricEclipticPos();
-			Pos2 = (core->j2000ToEquinoxEqu(LocTrans*Pos1, StelCore::RefractionOff))-RotObserver;
+			Vec3d rotObserver = (Mat4d::zrotation(curSidT))*ObserverLoc;
+			Mat4d locTrans = (StelCore::matVsop87ToJ2000)*(Mat4d::translation(-earthPos));
+			Vec3d moonPos = myMoon->computeHeliocentricEclipticPos(myJD.second);
+			equPos = (core->j2000ToEquinoxEqu(locTrans*moonPos, StelCore::RefractionOff))-rotObserver;
 		}
 		else // Planet position
 		{
-			myPlanet->computePosition(myJD.second);
-			myPlanet->computeTransMatrix(myJD.first, myJD.second);
-			Pos1 = myPlanet->getHeliocentricEclipticPos();
-			LocTrans = (StelCore::matVsop87ToJ2000)*(Mat4d::translation(-earthPos));
-			Pos2 = core->j2000ToEquinoxEqu(LocTrans*Pos1, StelCore::RefractionOff);
+			equPos = computeGeocentricEquPos(core, myPlanet, myJD.second);
 		};
 
-		toRADec(Pos2,ra,dec);
-		Vec3d moonAltAz = core->equinoxEquToAltAz(Pos2, StelCore::RefractionOff);
+		toRADec(equPos,ra,dec);
+		Vec3d moonAltAz = core->equinoxEquToAltAz(equPos, StelCore::RefractionOff);
 		hasRisen = moonAltAz[2] > refractedHorizonAlt;
 
 // Initial guesses of rise/set/transit times.
@@ -1478,10 +1450,10 @@ bool Observability::calculateSolarSystemEvents(StelCore* core, int bodyType)
 					getSunMoonCoords(core, tempJd,
 					                 raSun, decSun,
 					                 ra, dec,
-					                 eclLon, false);
+					                 eclLon);
 				} else
 				{
-					getPlanetCoords(core, tempJd, ra, dec, false);
+					getPlanetCoords(core, tempJd, ra, dec);
 				};
 
 				if (bodyType==1) {ra = raSun; dec = decSun;};
@@ -1517,9 +1489,9 @@ bool Observability::calculateSolarSystemEvents(StelCore* core, int bodyType)
 					getSunMoonCoords(core, tempJd,
 					                 raSun, decSun,
 					                 ra, dec,
-					                 eclLon, false);
+					                 eclLon);
 				else
-					getPlanetCoords(core, tempJd, ra, dec, false);
+					getPlanetCoords(core, tempJd, ra, dec);
 				
 				if (bodyType==1) {ra = raSun; dec = decSun;};
 				
@@ -1560,10 +1532,10 @@ bool Observability::calculateSolarSystemEvents(StelCore* core, int bodyType)
 
 			if (bodyType<3)
 			{
-				getSunMoonCoords(core,tempJd,raSun,decSun,ra,dec,eclLon,false);
+				getSunMoonCoords(core,tempJd,raSun,decSun,ra,dec,eclLon);
 			} else
 			{
-				getPlanetCoords(core,tempJd,ra,dec,false);
+				getPlanetCoords(core,tempJd,ra,dec);
 			};
 
 
@@ -1632,9 +1604,9 @@ bool Observability::calculateSolarSystemEvents(StelCore* core, int bodyType)
 				Sec2.second= core->computeDeltaT(Sec2.first)/86400.0; // enough to compute this once.
 
 				// for the computation calls, we need temporary QPairs here!
-				getSunMoonCoords(core,QPair<double, double>(Sec1.first, Sec1.first+Sec1.second),raSun,decSun,ra,dec,eclLon,false);
+				getSunMoonCoords(core,QPair<double, double>(Sec1.first, Sec1.first+Sec1.second),raSun,decSun,ra,dec,eclLon);
 				Temp1 = eclLon; //Lambda(RA,Dec,RAS,DecS);
-				getSunMoonCoords(core,QPair<double, double>(Sec2.first, Sec2.first+Sec2.second),raSun,decSun,ra,dec,eclLon,false);
+				getSunMoonCoords(core,QPair<double, double>(Sec2.first, Sec2.first+Sec2.second),raSun,decSun,ra,dec,eclLon);
 				Temp2 = eclLon; //Lambda(RA,Dec,RAS,DecS);
 
 
@@ -1642,7 +1614,7 @@ bool Observability::calculateSolarSystemEvents(StelCore* core, int bodyType)
 				{
 					Phase1 = (Sec2.first-Sec1.first)/(Temp1-Temp2)*Temp1+Sec1.first;
 					// The ad-hoc pair needs a DeltaT, use the one of Sec1
-					getSunMoonCoords(core,QPair<double, double>(Phase1, Phase1+Sec1.second),raSun,decSun,ra,dec,eclLon,false);
+					getSunMoonCoords(core,QPair<double, double>(Phase1, Phase1+Sec1.second),raSun,decSun,ra,dec,eclLon);
 					
 					if (Temp1*eclLon < 0.0) 
 					{
@@ -1715,7 +1687,7 @@ bool Observability::calculateSolarSystemEvents(StelCore* core, int bodyType)
 //			for (int i=-PrevMonths; i<13 ; i++)
 //			{
 //				jd1 = nextFullMoon + MoonT*((double) i);
-//				getMoonDistance(core,jd1,Distance,false); 
+//				getMoonDistance(core,jd1,Distance); 
 //				if (Distance < BestDistance)
 //				{  // Month with the largest Full Moon:
 //					BestDistance = Distance;
@@ -1736,17 +1708,6 @@ bool Observability::calculateSolarSystemEvents(StelCore* core, int bodyType)
 	}; 
 
 
-// Return the Moon and Earth to its current position:
-	if (bodyType<3)
-	{
-		getSunMoonCoords(core, myJD, raSun, decSun, ra, dec, eclLon, true);
-	}
-	else
-	{
-		getPlanetCoords(core, myJD, ra, dec, true);
-	};
-
-
 	return raises;
 }
 
@@ -22,6 +22,8 @@
 #include <QFont>
 #include <QString>
 #include <QPair>
+#include <QHash>
+#include <QVector>
 #include "VecMath.hpp"
 #include "SolarSystem.hpp"
 #include "Planet.hpp"
@@ -195,6 +197,7 @@ private:
 
 
 	//! Computes the Sun or Moon coordinates at a given Julian date.
+	//! The state of the Earth and of the Moon is not changed.
 	//! @param core the stellarium core.
 	//! @param JD QPair of double for the Julian date: first=JD_UT and .second=JDE_DT
 	//! @param RASun right ascension of the Sun (in hours).
@@ -204,28 +207,45 @@ private:
 	//! @param EclLon is the module of the vector product of Heliocentric Ecliptic Coordinates
 	//!        of Sun and Moon (projected over the Ecliptic plane). Useful to derive the dates
 	//!        of Full Moon.
-	//! @param getBack controls whether Earth and Moon must be returned to their original
-	//!        positions after computation.
-	void getSunMoonCoords(StelCore* core, QPair<double, double> JD,
+	void getSunMoonCoords(const StelCore* core, QPair<double, double> JD,
 			      double& raSun, double& decSun,
 			      double& raMoon, double& decMoon,
-			      double& eclLon, bool getBack);
+			      double& eclLon) const;
 
 
 	//! computes the selected-planet coordinates at a given Julian date.
+	//! The state of the planet and of the Earth is not changed.
 	//! @param core the stellarium core.
 	//! @param JD QPair for the Julian date: .first=JD(UT), .second=JDE
 	//! @param RA right ascension of the planet (in hours).
 	//! @param Dec declination of the planet (in radians).
-	//! @param getBack controls whether the planet must be returned to its original positions
-	//!        after computation.
-	void getPlanetCoords(StelCore* core,QPair<double, double> JD,
-			     double &RA, double &Dec, bool getBack);
+	void getPlanetCoords(const StelCore* core, QPair<double, double> JD,
+			     double &RA, double &Dec) const;
 
 	//! Computes the Earth-Moon distance (in AU) at a given Julian date.
 	//! The parameters are similar to those of getSunMoonCoords() or getPlanetCoords().
-	void getMoonDistance(StelCore* core, QPair<double, double> JD,
-			     double& distance, bool getBack);
+	void getMoonDistance(const StelCore* core, QPair<double, double> JD,
+			     double& distance) const;
+
+	//! Computes the geocentric equatorial position of date of a body at JDE,
+	//! without changing the state of the body or of the Earth.
+	Vec3d computeGeocentricEquPos(const StelCore* core, const Planet* body, double JDE) const;
+
+	//! Geocentric RA (in hours) and Dec (in radians) of a body for each day of the current year.
+	struct YearlyCoords
+	{
+		QVector<double> ra;
+		QVector<double> dec;
+	};
+
+	//! Returns the coordinates of a body for each day of the current year (see yearJD).
+	//! They are computed by computeYearlyCoords() the first time a body is requested for
+	//! a given year, and then taken from yearlyCoordsCache.
+	const YearlyCoords& getYearlyCoords(const StelCore* core, const Planet* body);
+
+	//! Computes the coordinates of a body for each day of yearJD. The days are evaluated
+	//! in parallel, and the state of the body and of the Earth is not changed.
+	void computeYearlyCoords(const StelCore* core, const Planet* body, YearlyCoords& coords) const;
 
 	//! Returns the angular separation (in radians) between two points.
 	//! @param RA1 right ascension of point 1 (in hours)
@@ -258,7 +278,7 @@ private:
 
 	//! Just subtracts/adds 24h to a RA (or HA), to make it fall within 0-24h.
 	//! @param RA right ascension (in hours).
-	double toUnsignedRA(double RA);
+	double toUnsignedRA(double RA) const;
 
 	//! Prepare arrays with data for the selected object for each day of the year.
 	//! Computes the RA, Dec and rise/set sidereal times of the selected planet
@@ -274,7 +294,7 @@ private:
 	void updateSunH();
 
 	//! Convert an equatorial position vector to RA/Dec.
-	void toRADec(Vec3d vec3d, double& ra, double& dec);
+	void toRADec(Vec3d vec3d, double& ra, double& dec) const;
 
 	//! Table containing the Julian Dates of the days of the current year.
 	QPair<double, double> yearJD[366]; // GZ: This had to become a QPair of JD.first=JD_UT, JD.second=JDE
@@ -331,14 +351,12 @@ private:
 	//! Rise/Set/Transit times for the Moon at current day:
 	double MoonRise, MoonSet, MoonCulm, lastJDMoon;
 
-	//! Vector of Earth position through the year.
-	Vec3d EarthPos[366];
-
-	//! Position of the observer relative to the Earth Center or other coordinates:
-	Vec3d ObserverLoc, Pos1, Pos2, RotObserver; //, Pos3;
+	//! Position of the observer relative to the Earth Center:
+	Vec3d ObserverLoc;
 
-	//! Matrix to transform coordinates for Sun/Moon ephemeris:
-	Mat4d LocTrans;
+	//! Yearly coordinates of the Sun and of the planets, keyed by name and year.
+	//! The coordinates are geocentric, so they do not depend on the location.
+	QHash<QString, YearlyCoords> yearlyCoordsCache;
 
 	//! Pointer to the Earth, Moon, and planet:
 	Planet* myEarth;
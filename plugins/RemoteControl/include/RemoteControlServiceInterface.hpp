@@ -189,6 +189,25 @@ public:
 	//! result in better performance if done correctly.
 	//! Unless you are sure, return false here.
 	virtual bool isThreadSafe() const = 0;
+	//! Return true if the given GET request can safely be run in the HTTP handler thread, even though isThreadSafe() returns false.
+	//! This allows answering frequent read-only requests without waiting for the main thread, for example
+	//! from a copy of the program state that is updated each frame.
+	//! The default implementation returns isThreadSafe().
+	virtual bool isThreadSafeGet(const QByteArray& operation, const APIParameters& parameters) const
+	{
+		Q_UNUSED(operation);
+		Q_UNUSED(parameters);
+		return isThreadSafe();
+	}
+	//! Like isThreadSafeGet(), for POST requests. This can be used for operations that only compute data
+	//! and only need a short visit in the main thread, so that the main thread is not blocked during the computation.
+	//! The default implementation returns isThreadSafe().
+	virtual bool isThreadSafePost(const QByteArray& operation, const APIParameters& parameters) const
+	{
+		Q_UNUSED(operation);
+		Q_UNUSED(parameters);
+		return isThreadSafe();
+	}
 	//! Implement this to define reactions to HTTP GET requests.
 	//! GET requests generally should only query data or program state, and not change it.
 	//! If there is an error with the request, use APIServiceResponse::writeRequestError to notify the client.
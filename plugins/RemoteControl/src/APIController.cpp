@@ -101,7 +101,7 @@ void APIController::service(HttpRequest &request, HttpResponse &response)
 #ifdef FORCE_THREADED_SERVICES
 			sv->get(operation, request.getParameterMap(), apiresponse);
 #else
-			if(sv->isThreadSafe())
+			if(sv->isThreadSafeGet(operation,request.getParameterMap()))
 			{
 				sv->get(operation,request.getParameterMap(), apiresponse);
 			}
@@ -122,7 +122,7 @@ void APIController::service(HttpRequest &request, HttpResponse &response)
 #ifdef FORCE_THREADED_SERVICES
 			sv->post(operation, request.getParameterMap(), request.getBody(), apiresponse);
 #else
-			if(sv->isThreadSafe())
+			if(sv->isThreadSafePost(operation,request.getParameterMap()))
 			{
 				sv->post(operation, request.getParameterMap(), request.getBody(), apiresponse);
 			}
@@ -47,6 +47,8 @@ public:
 	//! method depending on the HTTP request type.
 	//! If RemoteControlServiceInterface::isThreadSafe is false, these methods are called in the Stellarium main thread
 	//! using QMetaObject::invokeMethod, otherwise they are directly executed in the current thread (HTTP worker thread).
+	//! Requests for which RemoteControlServiceInterface::isThreadSafeGet or RemoteControlServiceInterface::isThreadSafePost
+	//! return true are always executed directly.
 	virtual void service(HttpRequest& request, HttpResponse& response);
 
 	//! Registers a service with the APIController.
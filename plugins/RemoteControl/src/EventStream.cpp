@@ -0,0 +1,330 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "EventStream.hpp"
+#include "MainService.hpp"
+
+#include "httpserver/httprequest.h"
+#include "httpserver/httpresponse.h"
+
+#include "StelApp.hpp"
+#include "StelActionMgr.hpp"
+#include "StelCore.hpp"
+#include "StelObjectMgr.hpp"
+#include "StelPropertyMgr.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonDocument>
+
+//! How long a subscriber waits for a new event before checking its connection again
+static const unsigned long WAIT_TIMEOUT = 1000;
+//! A comment is sent after this time without events, so that dead connections are detected and their thread is freed
+static const qint64 KEEPALIVE_INTERVAL = 10000;
+//! The selection info contains the current object position, so it is re-checked with the same interval the web interface used for polling
+static const qint64 SELECTION_INTERVAL = 1000;
+//! The time is re-sent after this interval even if it can still be extrapolated, to update Delta T and the time zone strings
+static const qint64 TIME_REFRESH_INTERVAL = 10000;
+
+EventStream::EventStream(MainService *mainService, QObject *parent)
+	: QObject(parent),
+	  mainService(mainService),
+	  selectionDirty(true),
+	  lastFov(0.0),
+	  lastSelectionUpdate(0),
+	  lastJD(0.0),
+	  lastTimeRate(0.0),
+	  lastIsTimeNow(false),
+	  lastTimeUpdate(0),
+	  maxSubscribers(15),
+	  //at 60 FPS, this keeps the deltas of the last second
+	  //slower clients get a full state instead
+	  eventCache(60),
+	  fullStateId(-1),
+	  fullStateRevision(0)
+{
+	//this is run in the main thread
+	core = StelApp::getInstance().getCore();
+
+	connect(StelApp::getInstance().getStelActionManager(),SIGNAL(actionToggled(QString,bool)),this,SLOT(actionToggled(QString,bool)));
+	connect(StelApp::getInstance().getStelPropertyManager(),SIGNAL(stelPropertyChanged(StelProperty*,QVariant)),this,SLOT(propertyChanged(StelProperty*,QVariant)));
+	connect(&StelApp::getInstance().getStelObjectMgr(),&StelObjectMgr::selectedObjectChanged,this,&EventStream::selectionChanged);
+}
+
+void EventStream::actionToggled(const QString &id, bool val)
+{
+	if(subscribers.load())
+		pendingActions.insert(id,val);
+}
+
+void EventStream::propertyChanged(StelProperty *prop, const QVariant &val)
+{
+	if(subscribers.load())
+		pendingProps.insert(prop->getId(),val);
+}
+
+void EventStream::selectionChanged()
+{
+	selectionDirty = true;
+}
+
+QJsonObject EventStream::getTime(qint64 now)
+{
+	QJsonObject time = mainService->getTimeInfo();
+	lastJD = time.value("jday").toDouble();
+	lastTimeRate = time.value("timerate").toDouble();
+	lastIsTimeNow = time.value("isTimeNow").toBool();
+	lastTimeUpdate = now;
+	return time;
+}
+
+void EventStream::update()
+{
+	if(!subscribers.load())
+	{
+		//nobody is listening, new subscribers start with a full state anyway
+		pendingActions.clear();
+		pendingProps.clear();
+		return;
+	}
+
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	QJsonObject event;
+
+	QJsonObject location = mainService->getLocationInfo();
+	bool locationChanged = location != lastLocation;
+	if(locationChanged)
+	{
+		lastLocation = location;
+		event.insert("location",location);
+	}
+
+	//the clients progress the time themselves using the time rate,
+	//so it only has to be sent when their extrapolation would be off by more than a second
+	double expectedJD = lastJD + lastTimeRate * (now - lastTimeUpdate) / 1000.0;
+	if(locationChanged || core->getTimeRate() != lastTimeRate || core->getIsTimeNow() != lastIsTimeNow
+			|| qAbs(core->getJD() - expectedJD) > StelCore::JD_SECOND
+			|| now - lastTimeUpdate > TIME_REFRESH_INTERVAL)
+	{
+		event.insert("time",getTime(now));
+	}
+
+	if(selectionDirty || now - lastSelectionUpdate >= SELECTION_INTERVAL)
+	{
+		selectionDirty = false;
+		lastSelectionUpdate = now;
+		QString info = mainService->getInfoString();
+		if(info != lastSelectionInfo)
+		{
+			lastSelectionInfo = info;
+			event.insert("selectioninfo",info);
+		}
+	}
+
+	QJsonObject view = mainService->getViewInfo();
+	double fov = view.value("fov").toDouble();
+	if(fov != lastFov)
+	{
+		lastFov = fov;
+		event.insert("view",view);
+	}
+
+	//only the last value of each action/property since the last frame is sent
+	if(!pendingActions.isEmpty())
+	{
+		QJsonObject changes;
+		for(QHash<QString,bool>::const_iterator it = pendingActions.constBegin();it!=pendingActions.constEnd();++it)
+			changes.insert(it.key(),it.value());
+		pendingActions.clear();
+
+		QJsonObject obj;
+		obj.insert("changes",changes);
+		event.insert("actionChanges",obj);
+	}
+	if(!pendingProps.isEmpty())
+	{
+		QJsonObject changes;
+		for(QHash<QString,QVariant>::const_iterator it = pendingProps.constBegin();it!=pendingProps.constEnd();++it)
+			changes.insert(it.key(),QJsonValue::fromVariant(it.value()));
+		pendingProps.clear();
+
+		QJsonObject obj;
+		obj.insert("changes",changes);
+		event.insert("propertyChanges",obj);
+	}
+
+	if(!event.isEmpty())
+		publish(event);
+
+	//new or lagging subscribers wait for this
+	if(fullStateRequested.testAndSetOrdered(1,0))
+		publishFullState();
+}
+
+void EventStream::publish(const QJsonObject &event)
+{
+	QJsonObject obj = event;
+
+	eventMutex.lock();
+	int id = eventCache.lastIndex() + 1;
+	obj.insert("id",id);
+
+	//serialized once, and written as-is to all subscribers
+	QByteArray msg = "id:" + QByteArray::number(id) + "\ndata:" + QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n\n";
+	eventCache.append(msg);
+	if(!eventCache.areIndexesValid())
+	{
+		//subscribers will notice the gap and reload the full state
+		qWarning()<<"[RemoteControl] Event cache indices invalid";
+		eventCache.clear();
+	}
+	eventMutex.unlock();
+
+	eventAvailable.wakeAll();
+}
+
+void EventStream::publishFullState()
+{
+	QJsonObject obj;
+	obj.insert("location",mainService->getLocationInfo());
+	obj.insert("time",mainService->getTimeInfo());
+	obj.insert("selectioninfo",mainService->getInfoString());
+	obj.insert("view",mainService->getViewInfo());
+
+	QJsonObject actions;
+	actions.insert("changes",mainService->getAllActionStates());
+	obj.insert("actionChanges",actions);
+
+	QJsonObject props;
+	props.insert("changes",mainService->getAllPropertyValues());
+	obj.insert("propertyChanges",props);
+
+	obj.insert("reset",true);
+
+	//this runs in the main thread, so no delta can be published while the state is collected
+	eventMutex.lock();
+	fullStateId = eventCache.lastIndex();
+	obj.insert("id",fullStateId);
+	fullState = "retry:1000\nid:" + QByteArray::number(fullStateId) + "\ndata:" + QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n\n";
+	++fullStateRevision;
+	eventMutex.unlock();
+
+	eventAvailable.wakeAll();
+}
+
+void EventStream::stop()
+{
+	eventMutex.lock();
+	generation.ref();
+	eventMutex.unlock();
+	eventAvailable.wakeAll();
+}
+
+void EventStream::serve(HttpRequest &request, HttpResponse &response)
+{
+	Q_UNUSED(request);
+
+	if(subscribers.fetchAndAddOrdered(1) >= maxSubscribers.load())
+	{
+		//the web interface falls back to polling when the stream never opened
+		subscribers.deref();
+		response.setStatus(503,"Service Unavailable");
+		response.write("Too many event streams, poll main/status instead",true);
+		return;
+	}
+
+	//the end of the stream is marked by closing the connection, this avoids the chunked encoding overhead
+	response.setHeader("Content-Type","text/event-stream; charset=utf-8");
+	response.setHeader("Cache-Control","no-cache");
+	response.setHeader("Connection","close");
+
+	const int gen = generation.load();
+
+	int seq = -1;
+	bool reset = true;
+	qint64 lastWrite = 0;
+
+	while(response.isConnected() && generation.load() == gen)
+	{
+		QByteArray out;
+
+		if(reset)
+		{
+			//the client is new or fell behind the cache, so send it everything
+			//the state is collected by the next update() in the main thread, meanwhile stop() can still wake us up
+			eventMutex.lock();
+			const int revision = fullStateRevision;
+			fullStateRequested.storeRelease(1);
+			while(fullStateRevision == revision && generation.load() == gen)
+			{
+				//on timeout, the connection is checked again
+				if(!eventAvailable.wait(&eventMutex,WAIT_TIMEOUT))
+					break;
+			}
+			if(generation.load() != gen)
+			{
+				eventMutex.unlock();
+				break;
+			}
+			if(fullStateRevision != revision)
+			{
+				seq = fullStateId;
+				out = fullState;
+				reset = false;
+			}
+			eventMutex.unlock();
+		}
+		else
+		{
+			eventMutex.lock();
+			if(eventCache.lastIndex() == seq)
+				eventAvailable.wait(&eventMutex,WAIT_TIMEOUT);
+			if(generation.load() != gen)
+			{
+				eventMutex.unlock();
+				break;
+			}
+			if(seq > eventCache.lastIndex() || seq < eventCache.firstIndex() - 1)
+			{
+				reset = true;
+			}
+			else
+			{
+				for(int i = seq + 1; i <= eventCache.lastIndex(); ++i)
+					out.append(eventCache.at(i));
+				seq = eventCache.lastIndex();
+			}
+			eventMutex.unlock();
+		}
+
+		qint64 now = QDateTime::currentMSecsSinceEpoch();
+		if(out.isEmpty() && now - lastWrite >= KEEPALIVE_INTERVAL)
+			out = ":keepalive\n\n";
+
+		if(!out.isEmpty())
+		{
+			//a failed write closes the socket, which ends the loop
+			response.write(out);
+			response.flush();
+			lastWrite = now;
+		}
+	}
+
+	subscribers.deref();
+}
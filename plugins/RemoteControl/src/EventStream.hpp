@@ -0,0 +1,117 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef EVENTSTREAM_HPP_
+#define EVENTSTREAM_HPP_
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QContiguousCache>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QVariant>
+#include <QWaitCondition>
+
+class HttpRequest;
+class HttpResponse;
+class MainService;
+class StelCore;
+class StelProperty;
+
+//! @ingroup remoteControl
+//! Implements the \c main/events Server-Sent Events stream, a push alternative to polling \c main/status.
+//!
+//! StelAction and StelProperty changes are coalesced in the main thread (only the last value of each one is kept),
+//! and once per frame a single delta event is built, serialized once, and handed to all subscribers.
+//! Time is only sent when the rate changes or the current time deviates from what a client would extrapolate,
+//! location, view and selection info only when they have changed. Frames without changes send nothing.
+//!
+//! Each subscriber keeps one HTTP connection thread busy for as long as it is connected.
+//! To leave threads for the other requests, only setMaxSubscribers() streams are served at the same time,
+//! further clients are answered with <tt>503 Service Unavailable</tt> and poll \c main/status instead.
+//! @see @ref rcMainServiceEvents
+class EventStream : public QObject
+{
+	Q_OBJECT
+public:
+	EventStream(MainService* mainService, QObject* parent = Q_NULLPTR);
+
+	//! Called in the main thread each frame. Builds and publishes the delta event if anything changed.
+	void update();
+
+	//! Serves the event stream to a single client. This blocks the calling HTTP worker thread until
+	//! the client disconnects or stop() is called.
+	void serve(HttpRequest& request, HttpResponse& response);
+
+	//! Makes all currently running serve() calls return as soon as possible.
+	//! Must be called before the HttpListener is destroyed, because it waits for all its connection threads.
+	void stop();
+
+	//! Sets how many streams may be served at the same time. RemoteControl uses half of the \c max_threads setting.
+	void setMaxSubscribers(int max) { maxSubscribers = max; }
+
+private slots:
+	void actionToggled(const QString& id, bool val);
+	void propertyChanged(StelProperty* prop, const QVariant& val);
+	void selectionChanged();
+
+private:
+	//! Stores the given event under the next sequence number, and wakes up all waiting subscribers
+	void publish(const QJsonObject& event);
+	//! Builds an event containing the full current state, like the \c main/status operation, for the subscribers
+	//! that requested it. Its \c id is the one of the last published delta already contained in it.
+	//! The subscribers never call into the main thread themselves, so that stop() can not deadlock with them.
+	void publishFullState();
+	//! Returns the \c time object and remembers it as the base for the extrapolation check
+	QJsonObject getTime(qint64 now);
+
+	MainService* mainService;
+	StelCore* core;
+
+	//these are only accessed from the main thread
+	QHash<QString,bool> pendingActions;
+	QHash<QString,QVariant> pendingProps;
+	bool selectionDirty;
+	QJsonObject lastLocation;
+	double lastFov;
+	QString lastSelectionInfo;
+	qint64 lastSelectionUpdate;
+	double lastJD;
+	double lastTimeRate;
+	bool lastIsTimeNow;
+	qint64 lastTimeUpdate;
+
+	QAtomicInt subscribers;
+	QAtomicInt maxSubscribers;
+	QAtomicInt generation;
+	//set by subscribers that need a full state, served in the next update()
+	QAtomicInt fullStateRequested;
+
+	//the recently published events, indexed by their sequence number
+	QContiguousCache<QByteArray> eventCache;
+	//the last full state event, its id, and a counter incremented each time it is rebuilt
+	QByteArray fullState;
+	int fullStateId;
+	int fullStateRevision;
+	QMutex eventMutex;
+	QWaitCondition eventAvailable;
+};
+
+#endif
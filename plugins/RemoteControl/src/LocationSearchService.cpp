@@ -79,6 +79,26 @@ void LocationSearchService::get(const QByteArray& operation, const APIParameters
 
 		response.writeJSON(QJsonDocument(results));
 	}
+	else if(operation=="prefix")
+	{
+		//like search, but only finds the locations starting with the term, which is much faster on big location lists
+		QString term = QString::fromUtf8(parameters.value("term"));
+		if(term.isEmpty())
+		{
+			response.writeRequestError("needs non-empty 'term' parameter");
+			return;
+		}
+		bool ok;
+		int limit = QString::fromUtf8(parameters.value("limit")).toInt(&ok);
+		if(!ok)
+			limit = -1;
+
+		locMgrMutex.lock();
+		QStringList results = locMgr.pickLocationIdsByPrefix(term, limit);
+		locMgrMutex.unlock();
+
+		response.writeJSON(QJsonDocument(QJsonArray::fromStringList(results)));
+	}
 	else if(operation=="nearby")
 	{
 		QString sPlanet = QString::fromUtf8(parameters.value("planet"));
@@ -99,6 +119,6 @@ void LocationSearchService::get(const QByteArray& operation, const APIParameters
 	else
 	{
 		//TODO some sort of service description?
-		response.writeRequestError("unsupported operation. GET: search,nearby");
+		response.writeRequestError("unsupported operation. GET: search,prefix,nearby");
 	}
 }
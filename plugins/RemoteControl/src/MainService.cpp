@@ -60,6 +60,8 @@ MainService::MainService(QObject *parent)
 	connect(actionMgr,SIGNAL(actionToggled(QString,bool)),this,SLOT(actionToggled(QString,bool)));
 	connect(propMgr,SIGNAL(stelPropertyChanged(StelProperty*,QVariant)),this,SLOT(propertyChanged(StelProperty*,QVariant)));
 
+	stateSnapshots = new StateSnapshotPublisher(this,this);
+
 	Q_ASSERT(this->thread()==objMgr->thread());
 }
 
@@ -95,6 +97,14 @@ void MainService::update(double deltaTime)
 		//this is required to enable maximal fps for smoothness
 		StelMainView::getInstance().thereWasAnEvent();
 	}
+
+	stateSnapshots->update();
+}
+
+bool MainService::isThreadSafeGet(const QByteArray &operation, const APIParameters &parameters) const
+{
+	Q_UNUSED(parameters);
+	return operation=="status";
 }
 
 void MainService::get(const QByteArray& operation, const APIParameters &parameters, APIServiceResponse &response)
@@ -111,79 +121,23 @@ void MainService::get(const QByteArray& operation, const APIParameters &paramete
 		bool propOk;
 		int propId = sPropId.toInt(&propOk);
 
-		QJsonObject obj;
+		//this runs in the HTTP thread, everything comes from the snapshot of the last frame
+		StateSnapshotP snapshot = stateSnapshots->get();
 
-		//// Location
-		const StelLocation& loc = core->getCurrentLocation();
-		{
-			QJsonObject obj2;
-			obj2.insert("name",loc.name);
-			obj2.insert("role",QString(loc.role));
-			obj2.insert("planet",loc.planetName);
-			obj2.insert("latitude",loc.latitude);
-			obj2.insert("longitude",loc.longitude);
-			obj2.insert("altitude",loc.altitude);
-			obj2.insert("country",loc.country);
-			obj2.insert("state",loc.state);
-			obj2.insert("landscapeKey",loc.landscapeKey);
-			obj.insert("location",obj2);
-		}
-
-		//// Time related stuff
-		{
-			double jday = core->getJD();
-			double deltaT = core->getDeltaT() * StelCore::JD_SECOND;
-
-			double gmtShift = core->getUTCOffset(jday) / 24.0;
-
-			QString utcIso = StelUtils::julianDayToISO8601String(jday,true).append('Z');
-			QString localIso = StelUtils::julianDayToISO8601String(jday+gmtShift,true);
-
-			//time zone string
-			QString timeZone = localeMgr->getPrintableTimeZoneLocal(jday);
-
-			QJsonObject obj2;
-			obj2.insert("jday",jday);
-			obj2.insert("deltaT",deltaT);
-			obj2.insert("gmtShift",gmtShift);
-			obj2.insert("timeZone",timeZone);
-			obj2.insert("utc",utcIso);
-			obj2.insert("local",localIso);
-			obj2.insert("isTimeNow",core->getIsTimeNow());
-			obj2.insert("timerate",core->getTimeRate());
-			obj.insert("time",obj2);
-		}
+		QJsonObject obj;
 
+		obj.insert("location",snapshot->location);
+		obj.insert("time",snapshot->time);
 		//// Info about selected object (only primary)
-		{
-			QString infoStr;
-			QMetaObject::invokeMethod(this,"getInfoString",SERVICE_DEFAULT_INVOKETYPE,
-						  Q_RETURN_ARG(QString,infoStr));
-			obj.insert("selectioninfo",infoStr);
-		}
-
-		//// Info about current view
-		{
-			QJsonObject obj2;
-
-			// the aim fov may lie outside the min/max bounds, so constrain it
-			double fov = mvmgr->getAimFov();
-			if(fov < mvmgr->getMinFov())
-				fov = mvmgr->getMinFov();
-			else if (fov>mvmgr->getMaxFov())
-				fov = mvmgr->getMaxFov();
-
-			obj2.insert("fov",fov);
-
-			obj.insert("view",obj2);
-		}
+		obj.insert("selectioninfo",snapshot->selectionInfo);
+		obj.insert("view",snapshot->view);
 
 		//// Info about changed actions & props (if requested)
 		{
 			if(actionOk)
-				obj.insert("actionChanges",getActionChangesSinceID(actionId));
+				obj.insert("actionChanges",getActionChangesSinceID(actionId,*snapshot));
 			if(propOk)
-				obj.insert("propertyChanges",getPropertyChangesSinceID(propId));
+				obj.insert("propertyChanges",getPropertyChangesSinceID(propId,*snapshot));
 		}
 
 		response.writeJSON(QJsonDocument(obj));
@@ -566,7 +520,100 @@ void MainService::propertyChanged(StelProperty* prop, const QVariant& val)
 	propMutex.unlock();
 }
 
-QJsonObject MainService::getActionChangesSinceID(int changeId)
+QJsonObject MainService::getLocationInfo() const
+{
+	const StelLocation& loc = core->getCurrentLocation();
+	QJsonObject obj;
+	obj.insert("name",loc.name);
+	obj.insert("role",QString(loc.role));
+	obj.insert("planet",loc.planetName);
+	obj.insert("latitude",loc.latitude);
+	obj.insert("longitude",loc.longitude);
+	obj.insert("altitude",loc.altitude);
+	obj.insert("country",loc.country);
+	obj.insert("state",loc.state);
+	obj.insert("landscapeKey",loc.landscapeKey);
+	return obj;
+}
+
+QJsonObject MainService::getTimeInfo() const
+{
+	double jday = core->getJD();
+	double deltaT = core->getDeltaT() * StelCore::JD_SECOND;
+
+	double gmtShift = core->getUTCOffset(jday) / 24.0;
+
+	QString utcIso = StelUtils::julianDayToISO8601String(jday,true).append('Z');
+	QString localIso = StelUtils::julianDayToISO8601String(jday+gmtShift,true);
+
+	//time zone string
+	QString timeZone = localeMgr->getPrintableTimeZoneLocal(jday);
+
+	QJsonObject obj;
+	obj.insert("jday",jday);
+	obj.insert("deltaT",deltaT);
+	obj.insert("gmtShift",gmtShift);
+	obj.insert("timeZone",timeZone);
+	obj.insert("utc",utcIso);
+	obj.insert("local",localIso);
+	obj.insert("isTimeNow",core->getIsTimeNow());
+	obj.insert("timerate",core->getTimeRate());
+	return obj;
+}
+
+QJsonObject MainService::getViewInfo() const
+{
+	QJsonObject obj;
+
+	// the aim fov may lie outside the min/max bounds, so constrain it
+	double fov = mvmgr->getAimFov();
+	if(fov < mvmgr->getMinFov())
+		fov = mvmgr->getMinFov();
+	else if (fov>mvmgr->getMaxFov())
+		fov = mvmgr->getMaxFov();
+
+	obj.insert("fov",fov);
+	return obj;
+}
+
+QJsonObject MainService::getAllActionStates() const
+{
+	QJsonObject changes;
+	foreach(StelAction* ac, actionMgr->getActionList())
+	{
+		if(ac->isCheckable())
+		{
+			changes.insert(ac->getId(),ac->isChecked());
+		}
+	}
+	return changes;
+}
+
+QJsonObject MainService::getAllPropertyValues() const
+{
+	QJsonObject changes;
+	const StelPropertyMgr::StelPropertyMap& map = propMgr->getPropertyMap();
+	for(StelPropertyMgr::StelPropertyMap::const_iterator it = map.constBegin();
+	    it!=map.constEnd();++it)
+	{
+		changes.insert(it.key(), QJsonValue::fromVariant((*it)->getValue()));
+	}
+	return changes;
+}
+
+int MainService::getActionChangeId()
+{
+	QMutexLocker locker(&actionMutex);
+	return actionCache.lastIndex();
+}
+
+int MainService::getPropertyChangeId()
+{
+	QMutexLocker locker(&propMutex);
+	return propCache.lastIndex();
+}
+
+QJsonObject MainService::getActionChangesSinceID(int changeId, const StateSnapshot& snapshot)
 {
 	//changeId is the last id the interface is available
 	//or -2 if the interface just started
@@ -586,14 +633,8 @@ QJsonObject MainService::getActionChangesSinceID(int changeId)
 			//something is "broken", probably from an existing web interface that reconnected after restart
 			//force a full reload
 
-			foreach(StelAction* ac, actionMgr->getActionList())
-			{
-				if(ac->isCheckable())
-				{
-					changes.insert(ac->getId(),ac->isChecked());
-				}
-			}
-			newId = -1;
+			changes = snapshot.actions;
+			newId = snapshot.actionChangeId;
 		}
 	}
 	else
@@ -602,14 +643,8 @@ QJsonObject MainService::getActionChangesSinceID(int changeId)
 		{
 			//this is either the initial state (-2) or
 			//"broken" state again, force full reload
-			foreach(StelAction* ac, actionMgr->getActionList())
-			{
-				if(ac->isCheckable())
-				{
-					changes.insert(ac->getId(),ac->isChecked());
-				}
-			}
-			newId = actionCache.lastIndex();
+			changes = snapshot.actions;
+			newId = snapshot.actionChangeId;
 		}
 		else if(changeId < actionCache.lastIndex())
 		{
@@ -631,7 +666,7 @@ QJsonObject MainService::getActionChangesSinceID(int changeId)
 	return obj;
 }
 
-QJsonObject MainService::getPropertyChangesSinceID(int changeId)
+QJsonObject MainService::getPropertyChangesSinceID(int changeId, const StateSnapshot& snapshot)
 {
 	//changeId is the last id the interface is available
 	//or -2 if the interface just started
@@ -648,13 +683,8 @@ QJsonObject MainService::getPropertyChangesSinceID(int changeId)
 			//this is either the initial state (-2) or
 			//something is "broken", probably from an existing web interface that reconnected after restart
 			//force a full reload
-			const StelPropertyMgr::StelPropertyMap& map = propMgr->getPropertyMap();
-			for(StelPropertyMgr::StelPropertyMap::const_iterator it = map.constBegin();
-			    it!=map.constEnd();++it)
-			{
-				changes.insert(it.key(), QJsonValue::fromVariant((*it)->getValue()));
-			}
-			newId = -1;
+			changes = snapshot.properties;
+			newId = snapshot.propertyChangeId;
 		}
 	}
 	else
@@ -663,13 +693,8 @@ QJsonObject MainService::getPropertyChangesSinceID(int changeId)
 		{
 			//this is either the initial state (-2) or
 			//"broken" state again, force full reload
-			const StelPropertyMgr::StelPropertyMap& map = propMgr->getPropertyMap();
-			for(StelPropertyMgr::StelPropertyMap::const_iterator it = map.constBegin();
-			    it!=map.constEnd();++it)
-			{
-				changes.insert(it.key(), QJsonValue::fromVariant((*it)->getValue()));
-			}
-			newId = propCache.lastIndex();
+			changes = snapshot.properties;
+			newId = snapshot.propertyChangeId;
 		}
 		else if(changeId < propCache.lastIndex())
 		{
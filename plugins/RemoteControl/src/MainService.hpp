@@ -21,6 +21,7 @@
 #define MAINSERVICE_HPP_
 
 #include "AbstractAPIService.hpp"
+#include "StateSnapshot.hpp"
 
 #include "StelObjectType.hpp"
 #include "VecMath.hpp"
@@ -63,6 +64,8 @@ public:
 	//! Used to implement move functionality
 	virtual void update(double deltaTime) Q_DECL_OVERRIDE;
 	virtual QLatin1String getPath() const Q_DECL_OVERRIDE { return QLatin1String("main"); }
+	//! The \c status operation is answered from the StateSnapshot in the HTTP thread
+	virtual bool isThreadSafeGet(const QByteArray& operation, const APIParameters& parameters) const Q_DECL_OVERRIDE;
 	//! @brief Implements the GET operations
 	//! @see @ref rcMainServiceGET
 	virtual void get(const QByteArray& operation,const APIParameters &parameters, APIServiceResponse& response) Q_DECL_OVERRIDE;
@@ -70,12 +73,31 @@ public:
 	//! @see @ref rcMainServicePOST
 	virtual void post(const QByteArray &operation, const APIParameters &parameters, const QByteArray &data, APIServiceResponse &response) Q_DECL_OVERRIDE;
 
-private slots:
-	StelObjectP getSelectedObject();
-
+	//! Returns the \c location part of the \c status operation
+	QJsonObject getLocationInfo() const;
+	//! Returns the \c time part of the \c status operation
+	QJsonObject getTimeInfo() const;
+	//! Returns the \c view part of the \c status operation
+	QJsonObject getViewInfo() const;
+	//! Returns the checked state of all checkable StelActions, as used for a full reload of the interface
+	QJsonObject getAllActionStates() const;
+	//! Returns the value of all StelProperties, as used for a full reload of the interface
+	QJsonObject getAllPropertyValues() const;
+	//! Returns the ID of the newest StelAction change. Thread-safe.
+	int getActionChangeId();
+	//! Returns the ID of the newest StelProperty change. Thread-safe.
+	int getPropertyChangeId();
+
+	//! Provides the per-frame snapshots of the program state, which can be used by other services too
+	StateSnapshotPublisher* getStateSnapshots() const { return stateSnapshots; }
+
+public slots:
 	//! Returns the info string of the currently selected object
 	QString getInfoString();
 
+private slots:
+	StelObjectP getSelectedObject();
+
 	//! Like StelDialog::gotoObject
 	bool focusObject(const QString& name, SelectionMode mode);
 	void focusPosition(const Vec3d& pos);
@@ -99,6 +121,8 @@ private:
 	StelScriptMgr* scriptMgr;
 	StelSkyCultureMgr* skyCulMgr;
 
+	StateSnapshotPublisher* stateSnapshots;
+
 	double moveX,moveY;
 	qint64 lastMoveUpdateTime;
 
@@ -112,7 +136,7 @@ private:
 	//lists the recently toggled actions - this is a pseudo-circular buffer
 	QContiguousCache<ActionCacheEntry> actionCache;
 	QMutex actionMutex;
-	QJsonObject getActionChangesSinceID(int changeId);
+	QJsonObject getActionChangesSinceID(int changeId, const StateSnapshot& snapshot);
 
 	struct PropertyCacheEntry
 	{
@@ -122,7 +146,7 @@ private:
 	};
 	QContiguousCache<PropertyCacheEntry> propCache;
 	QMutex propMutex;
-	QJsonObject getPropertyChangesSinceID(int changeId);
+	QJsonObject getPropertyChangesSinceID(int changeId, const StateSnapshot& snapshot);
 
 };
 
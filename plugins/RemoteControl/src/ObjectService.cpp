@@ -18,6 +18,7 @@
  */
 
 #include "ObjectService.hpp"
+#include "StateSnapshot.hpp"
 
 #include "SearchDialog.hpp"
 #include "StelApp.hpp"
@@ -27,6 +28,8 @@
 #include "StelModuleMgr.hpp"
 #include "StelObjectMgr.hpp"
 #include "LandscapeMgr.hpp"
+#include "SolarSystem.hpp"
+#include "StelUtils.hpp"
 
 #include <QEventLoop>
 #include <QJsonArray>
@@ -34,16 +37,30 @@
 #include <QJsonObject>
 #include <QSettings>
 #include <QMutex>
+#include <QReadLocker>
 #include <QThreadPool>
 #include <QRunnable>
 #include <QWaitCondition>
+#include <QDataStream>
 
-ObjectService::ObjectService(QObject *parent) : AbstractAPIService(parent)
+#include <cmath>
+#include <limits>
+
+//! The values computed for each target and epoch by the batch operation, in this order
+static const char* const BATCH_FIELDS[] = { "raJ2000", "decJ2000", "azimuth", "altitude", "vmag", "rise", "transit", "set" };
+static const int BATCH_FIELD_COUNT = 8;
+//! Upper limit for the number of targets times the number of epochs of a batch request
+static const int MAX_BATCH_SIZE = 100000;
+
+ObjectService::ObjectService(StateSnapshotPublisher *stateSnapshots, QObject *parent) : AbstractAPIService(parent), stateSnapshots(stateSnapshots)
 {
 	//this is run in the main thread
 	core = StelApp::getInstance().getCore();
 	objMgr = &StelApp::getInstance().getStelObjectMgr();
+	solarSystem = GETSTELMODULE(SolarSystem);
 	useStartOfWords = StelApp::getInstance().getSettings()->value("search/flag_start_words", false).toBool();
+
+	qRegisterMetaType<ObjectService::BatchData>();
 }
 
 QStringList ObjectService::performSearch(const QString &text)
@@ -65,6 +82,17 @@ QStringList ObjectService::performSearch(const QString &text)
 	return matches;
 }
 
+bool ObjectService::isThreadSafeGet(const QByteArray &operation, const APIParameters &parameters) const
+{
+	return operation == "info" && parameters.value("name").isEmpty() && parameters.value("format") != "map";
+}
+
+bool ObjectService::isThreadSafePost(const QByteArray &operation, const APIParameters &parameters) const
+{
+	Q_UNUSED(parameters);
+	return operation == "batch";
+}
+
 QString ObjectService::substituteGreek(const QString &text)
 {
 	//use the searchdialog static method for that
@@ -121,6 +149,20 @@ void ObjectService::get(const QByteArray& operation, const APIParameters &parame
 		else
 			formatHtml=true;
 
+		if(name.isEmpty() && formatHtml)
+		{
+			//this runs in the HTTP thread, see isThreadSafeGet
+			StateSnapshotP snapshot = stateSnapshots->get();
+			if(!snapshot->hasSelection)
+			{
+				response.setStatus(404,"not found");
+				response.setData("no current selection, and no name parameter given");
+				return;
+			}
+			response.setData(snapshot->selectionInfoHtml.toUtf8());
+			return;
+		}
+
 		StelObjectP obj;
 		if(!name.isEmpty())
 		{
@@ -231,6 +273,252 @@ void ObjectService::get(const QByteArray& operation, const APIParameters &parame
 	}
 }
 
+//! Standard altitude of the rise and set of a target (Meeus, Astronomical Algorithms, chapter 15)
+static double getStandardAltitude(const ObjectService::BatchTarget& target)
+{
+	if(target.englishName == "Sun")
+		return -0.8333 * M_PI / 180.;
+	if(target.englishName == "Moon")
+		return 0.125 * M_PI / 180.;
+	return -0.5667 * M_PI / 180.;
+}
+
+//! Computes the geometric hour angle and declination of date of a target at JD from its horizontal position
+static void getHourAngleDec(const ObjectService::BatchData& data, const ObjectService::BatchTarget& target, double JD, double* ha, double* dec)
+{
+	const EphemerisContext& ctx = data.context;
+	Vec3d j2000 = target.planet ? ctx.getJ2000EquatorialPos(target.planet.data(), JD) : target.j2000Pos;
+	Vec3d v = ctx.j2000ToAltAz(j2000, JD, false);
+	v.normalize();
+
+	//the horizontal frame has x to the south and y to the east,
+	//rotating it around the east axis by the colatitude gives the hour angle frame
+	const double sinLat = std::sin(data.latitude);
+	const double cosLat = std::cos(data.latitude);
+	double x = v[0] * sinLat + v[2] * cosLat;
+	double z = v[2] * sinLat - v[0] * cosLat;
+	*ha = std::atan2(-v[1], x);
+	*dec = std::asin(qBound(-1., z, 1.));
+}
+
+//! Returns the hour angle at which the target crosses its standard altitude, or NaN if it does not
+static double getHorizonHourAngle(const ObjectService::BatchData& data, const ObjectService::BatchTarget& target, double dec)
+{
+	const double denom = std::cos(data.latitude) * std::cos(dec);
+	if(qAbs(denom) < 1e-9)
+		return std::numeric_limits<double>::quiet_NaN();
+	const double cosH0 = (std::sin(getStandardAltitude(target)) - std::sin(data.latitude) * std::sin(dec)) / denom;
+	if(cosH0 < -1. || cosH0 > 1.)
+		return std::numeric_limits<double>::quiet_NaN();
+	return std::acos(cosH0);
+}
+
+//! Computes the transit nearest to JD, and the rise and set around it (Meeus, Astronomical Algorithms, chapter 15).
+//! Each event is refined once with the position at its first estimate, which is enough for the Moon.
+//! Rise and set are NaN for circumpolar targets and targets which do not rise.
+static void computeRiseTransitSet(const ObjectService::BatchData& data, const ObjectService::BatchTarget& target, double JD,
+				  double* rise, double* transit, double* set)
+{
+	const double siderealDay = data.context.getHomePlanet()->getSiderealDay();
+	double ha, dec;
+
+	double tr = JD;
+	for(int i = 0; i < 2; ++i)
+	{
+		getHourAngleDec(data, target, tr, &ha, &dec);
+		tr -= ha / (2. * M_PI) * siderealDay;
+	}
+	*transit = tr;
+
+	double events[2];
+	for(int side = 0; side < 2; ++side)
+	{
+		//rise is at the negative, set at the positive horizon hour angle
+		const double sign = side ? 1. : -1.;
+		double H0 = getHorizonHourAngle(data, target, dec);
+		double t = tr + sign * H0 / (2. * M_PI) * siderealDay;
+		if(!qIsNaN(t))
+		{
+			getHourAngleDec(data, target, t, &ha, &dec);
+			H0 = getHorizonHourAngle(data, target, dec);
+			double dH = std::remainder(sign * H0 - ha, 2. * M_PI);
+			t += dH / (2. * M_PI) * siderealDay;
+		}
+		events[side] = t;
+		getHourAngleDec(data, target, tr, &ha, &dec);
+	}
+	*rise = events[0];
+	*set = events[1];
+}
+
+//! Computes the BATCH_FIELDS of a target at JD
+static void computeBatchValues(const ObjectService::BatchData& data, const ObjectService::BatchTarget& target, double JD, double* values)
+{
+	for(int i = 0; i < BATCH_FIELD_COUNT; ++i)
+		values[i] = std::numeric_limits<double>::quiet_NaN();
+	//the observer's own planet has no meaningful position
+	if(!target.obj || target.planet.data() == data.context.getHomePlanet())
+		return;
+
+	Vec3d j2000, altAz;
+	double vMag;
+	if(target.planet)
+	{
+		EphemerisContext::BodyState state = data.context.computeState(target.planet.data(), JD);
+		j2000 = state.j2000Pos;
+		altAz = state.altAzPosAuto;
+		vMag = state.vMagnitude;
+	}
+	else
+	{
+		j2000 = target.j2000Pos;
+		altAz = data.context.j2000ToAltAz(j2000, JD, true);
+		vMag = target.vMagnitude;
+	}
+
+	double ra, dec, az, alt;
+	StelUtils::rectToSphe(&ra, &dec, j2000);
+	StelUtils::rectToSphe(&az, &alt, altAz);
+	// N is zero, E is 90 degrees, like StelObject::getInfoMap
+	az = (data.southAzimuth ? 2. : 3.) * M_PI - az;
+	if(ra < 0.)
+		ra += 2. * M_PI;
+	if(az > 2. * M_PI)
+		az -= 2. * M_PI;
+	values[0] = ra * 180. / M_PI;
+	values[1] = dec * 180. / M_PI;
+	values[2] = az * 180. / M_PI;
+	values[3] = alt * 180. / M_PI;
+	values[4] = vMag;
+	computeRiseTransitSet(data, target, JD, &values[5], &values[6], &values[7]);
+}
+
+void ObjectService::post(const QByteArray &operation, const APIParameters &parameters, const QByteArray &data, APIServiceResponse &response)
+{
+	Q_UNUSED(data);
+
+	if(operation == "batch")
+	{
+		//this runs in the HTTP thread, see isThreadSafePost
+		QJsonDocument targetsDoc = QJsonDocument::fromJson(parameters.value("targets"));
+		if(!targetsDoc.isArray())
+		{
+			response.writeRequestError("missing or invalid targets parameter, use a JSON array of names or {type,id} objects");
+			return;
+		}
+
+		QVector<double> epochs;
+		const QByteArray& rawEpochs = parameters.value("epochs");
+		if(!rawEpochs.isEmpty())
+		{
+			QJsonDocument epochsDoc = QJsonDocument::fromJson(rawEpochs);
+			if(!epochsDoc.isArray())
+			{
+				response.writeRequestError("invalid epochs parameter, use a JSON array of Julian days");
+				return;
+			}
+			foreach(const QJsonValue& val, epochsDoc.array())
+			{
+				double jd = val.toDouble(std::numeric_limits<double>::quiet_NaN());
+				if(qIsNaN(jd) || qIsInf(jd))
+				{
+					response.writeRequestError("invalid epoch value");
+					return;
+				}
+				epochs.append(jd);
+			}
+		}
+
+		const QJsonArray targets = targetsDoc.array();
+		if(static_cast<qint64>(targets.size()) * qMax(epochs.size(), 1) > MAX_BATCH_SIZE)
+		{
+			response.writeRequestError("too many targets and epochs in one request");
+			return;
+		}
+
+		//the bodies must not be reloaded while they are computed here. The lock cannot be held while waiting
+		//for the main thread, which may be reloading, so the targets are resolved again if a reload came in between.
+		ObjectService::BatchData batch;
+		QReadLocker reloadLocker(solarSystem->getReloadLock());
+		do
+		{
+			reloadLocker.unlock();
+			QMetaObject::invokeMethod(this,"resolveBatch",SERVICE_DEFAULT_INVOKETYPE,
+						  Q_RETURN_ARG(ObjectService::BatchData,batch),
+						  Q_ARG(QJsonArray,targets));
+			reloadLocker.relock();
+		} while(batch.reloadCount != solarSystem->getReloadCount());
+
+		if(epochs.isEmpty())
+			epochs.append(batch.currentJD);
+
+		double values[BATCH_FIELD_COUNT];
+		if(parameters.value("format") == "binary")
+		{
+			//little-endian doubles, ordered by target, then epoch, then field
+			QByteArray buf;
+			buf.reserve(batch.targets.size() * epochs.size() * BATCH_FIELD_COUNT * static_cast<int>(sizeof(double)));
+			QDataStream stream(&buf, QIODevice::WriteOnly);
+			stream.setByteOrder(QDataStream::LittleEndian);
+			stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+			foreach(const BatchTarget& target, batch.targets)
+			{
+				foreach(double jd, epochs)
+				{
+					computeBatchValues(batch, target, jd, values);
+					for(int i = 0; i < BATCH_FIELD_COUNT; ++i)
+						stream << values[i];
+				}
+			}
+			response.setHeader("Content-Type","application/octet-stream");
+			response.setData(buf);
+			return;
+		}
+
+		QJsonArray fieldsArr;
+		for(int i = 0; i < BATCH_FIELD_COUNT; ++i)
+			fieldsArr.append(QString(BATCH_FIELDS[i]));
+		QJsonArray epochsArr;
+		foreach(double jd, epochs)
+			epochsArr.append(jd);
+
+		QJsonArray objectsArr;
+		foreach(const BatchTarget& target, batch.targets)
+		{
+			QJsonObject obj;
+			obj.insert("target", target.query);
+			obj.insert("found", !target.obj.isNull());
+			if(target.obj)
+			{
+				obj.insert("name", target.englishName);
+				obj.insert("type", target.type);
+
+				QJsonArray dataArr;
+				foreach(double jd, epochs)
+				{
+					computeBatchValues(batch, target, jd, values);
+					QJsonArray row;
+					for(int i = 0; i < BATCH_FIELD_COUNT; ++i)
+						row.append(qIsNaN(values[i]) ? QJsonValue() : QJsonValue(values[i]));
+					dataArr.append(row);
+				}
+				obj.insert("data", dataArr);
+			}
+			objectsArr.append(obj);
+		}
+
+		QJsonObject root;
+		root.insert("fields", fieldsArr);
+		root.insert("epochs", epochsArr);
+		root.insert("objects", objectsArr);
+		response.writeJSON(QJsonDocument(root));
+	}
+	else
+	{
+		response.writeRequestError("unsupported operation. POST: batch");
+	}
+}
+
 StelObjectP ObjectService::findObject(const QString &name)
 {
 	StelObjectP obj = objMgr->searchByNameI18n(name);
@@ -243,3 +531,40 @@ QString ObjectService::getInfoString(const StelObjectP obj)
 {
 	return obj->getInfoString(core);
 }
+
+ObjectService::BatchData ObjectService::resolveBatch(const QJsonArray &targets)
+{
+	BatchData data;
+	data.context = EphemerisContext(core);
+	data.currentJD = core->getJD();
+	data.latitude = static_cast<double>(core->getCurrentLocation().latitude) * M_PI / 180.;
+	data.southAzimuth = StelApp::getInstance().getFlagSouthAzimuthUsage();
+	data.reloadCount = solarSystem->getReloadCount();
+
+	data.targets.reserve(targets.size());
+	foreach(const QJsonValue& val, targets)
+	{
+		BatchTarget target;
+		target.query = val;
+		if(val.isObject())
+		{
+			QJsonObject idObj = val.toObject();
+			target.obj = objMgr->searchByID(idObj.value("type").toString(), idObj.value("id").toString());
+		}
+		else
+		{
+			target.obj = findObject(val.toString());
+		}
+
+		if(target.obj)
+		{
+			target.planet = target.obj.dynamicCast<Planet>();
+			target.englishName = target.obj->getEnglishName();
+			target.type = target.obj->getType();
+			target.j2000Pos = target.obj->getJ2000EquatorialPos(core);
+			target.vMagnitude = target.obj->getVMagnitude(core);
+		}
+		data.targets.append(target);
+	}
+	return data;
+}
@@ -21,12 +21,17 @@
 #define OBJECTSERVICE_HPP_
 
 #include "AbstractAPIService.hpp"
+#include "EphemerisContext.hpp"
 #include "StelObjectType.hpp"
 
+#include <QJsonArray>
 #include <QStringList>
+#include <QVector>
 
 class StelCore;
 class StelObjectMgr;
+class SolarSystem;
+class StateSnapshotPublisher;
 
 //! @ingroup remoteControl
 //! Provides operations to look up objects in the Stellarium catalogs
@@ -36,12 +41,51 @@ class ObjectService : public AbstractAPIService
 {
 	Q_OBJECT
 public:
-	ObjectService(QObject* parent = Q_NULLPTR);
+	//! @param stateSnapshots used to answer \c info requests for the current selection in the HTTP thread
+	ObjectService(StateSnapshotPublisher* stateSnapshots, QObject* parent = Q_NULLPTR);
 
 	virtual QLatin1String getPath() const Q_DECL_OVERRIDE { return QLatin1String("objects"); }
+	//! The HTML \c info of the current selection is answered from the StateSnapshot in the HTTP thread
+	virtual bool isThreadSafeGet(const QByteArray& operation, const APIParameters& parameters) const Q_DECL_OVERRIDE;
+	//! The \c batch operation only visits the main thread once to resolve the targets, and is computed in the HTTP thread
+	virtual bool isThreadSafePost(const QByteArray& operation, const APIParameters& parameters) const Q_DECL_OVERRIDE;
 	//! @brief Implements the HTTP GET method
 	//! @see \ref rcObjectServiceGET
 	virtual void get(const QByteArray& operation,const APIParameters& parameters, APIServiceResponse& response) Q_DECL_OVERRIDE;
+	//! @brief Implements the HTTP POST method
+	//! @see \ref rcObjectServicePOST
+	virtual void post(const QByteArray& operation, const APIParameters& parameters, const QByteArray& data, APIServiceResponse& response) Q_DECL_OVERRIDE;
+
+	//! A target of the \c batch operation, with everything that has to be read in the main thread
+	struct BatchTarget
+	{
+		BatchTarget() : vMagnitude(0.f) {}
+		//! The target as given in the request
+		QJsonValue query;
+		//! Null if the target was not found
+		StelObjectP obj;
+		//! Only set for solar system bodies, which are computed for each epoch
+		PlanetP planet;
+		QString englishName;
+		QString type;
+		//! The position at the current time. Other objects are assumed to be fixed in J2000 coordinates.
+		Vec3d j2000Pos;
+		float vMagnitude;
+	};
+
+	//! Everything the \c batch operation needs from the main thread
+	struct BatchData
+	{
+		BatchData() : currentJD(0.), latitude(0.), southAzimuth(false), reloadCount(0) {}
+		QVector<BatchTarget> targets;
+		EphemerisContext context;
+		double currentJD;
+		//! Latitude of the observer in radians
+		double latitude;
+		bool southAzimuth;
+		//! SolarSystem::getReloadCount() when the targets were resolved
+		int reloadCount;
+	};
 
 private slots:
 	//! Executed in Stellarium main thread to avoid multiple QMetaObject::invoke calls
@@ -54,12 +98,19 @@ private slots:
 
 	//! Wrapper around obj->getInfoString
 	QString getInfoString(const StelObjectP obj);
+
+	//! Resolves all targets of a \c batch request in a single main thread visit
+	ObjectService::BatchData resolveBatch(const QJsonArray& targets);
 private:
 	StelCore* core;
 	StelObjectMgr* objMgr;
+	SolarSystem* solarSystem;
+	StateSnapshotPublisher* stateSnapshots;
 	bool useStartOfWords;
 };
 
+Q_DECLARE_METATYPE(ObjectService::BatchData)
+
 
 
 #endif
@@ -91,6 +91,7 @@ RemoteControl::~RemoteControl()
 	{
 		//we manually delete the listener here to make sure
 		//all connections are closed before the requesthandler is deleted
+		requestHandler->stopEventStreams();
 		delete httpListener;
 		httpListener = Q_NULLPTR;
 	}
@@ -242,6 +243,8 @@ void RemoteControl::startServer()
 	//set request handler password settings
 	requestHandler->setPassword(password);
 	requestHandler->setUsePassword(usePassword);
+	//the event streams must not occupy all threads, otherwise no other request could be answered
+	requestHandler->setMaxEventStreams(maxThreads / 2);
 	HttpListenerSettings settings;
 	settings.port = port;
 	settings.minThreads = minThreads;
@@ -253,6 +256,8 @@ void RemoteControl::stopServer()
 {
 	if(httpListener)
 	{
+		//open event streams would otherwise block the listener from shutting down
+		requestHandler->stopEventStreams();
 		delete httpListener;
 		httpListener = Q_NULLPTR;
 	}
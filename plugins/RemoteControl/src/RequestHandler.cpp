@@ -22,6 +22,8 @@
 #include "templateengine/template.h"
 
 #include "APIController.hpp"
+#include "EventStream.hpp"
+#include "StateSnapshot.hpp"
 #include "LocationService.hpp"
 #include "LocationSearchService.hpp"
 #include "MainService.hpp"
@@ -92,8 +94,10 @@ RequestHandler::RequestHandler(const StaticFileControllerSettings& settings, QOb
 	//register the services
 	//they "live" in the main thread in the QObject sense, but their service methods are actually
 	//executed in the HTTP handler threads
-	apiController->registerService(new MainService(apiController));
-	apiController->registerService(new ObjectService(apiController));
+	MainService* mainService = new MainService(apiController);
+	apiController->registerService(mainService);
+	stateSnapshots = mainService->getStateSnapshots();
+	apiController->registerService(new ObjectService(mainService->getStateSnapshots(),apiController));
 	apiController->registerService(new ScriptService(apiController));
 	apiController->registerService(new SimbadService(apiController));
 	apiController->registerService(new StelActionService(apiController));
@@ -102,6 +106,8 @@ RequestHandler::RequestHandler(const StaticFileControllerSettings& settings, QOb
 	apiController->registerService(new LocationSearchService(apiController));
 	apiController->registerService(new ViewService(apiController));
 
+	eventStream = new EventStream(mainService,this);
+
 	connect(&StelApp::getInstance().getModuleMgr(), SIGNAL(extensionsAdded(QObjectList)), this, SLOT(addExtensionServices(QObjectList)));
 	addExtensionServices(StelApp::getInstance().getModuleMgr().getExtensionList());
 
@@ -130,6 +136,17 @@ void RequestHandler::addExtensionServices(QObjectList services)
 void RequestHandler::update(double deltaTime)
 {
 	apiController->update(deltaTime);
+	eventStream->update();
+}
+
+void RequestHandler::stopEventStreams()
+{
+	eventStream->stop();
+}
+
+void RequestHandler::setMaxEventStreams(int max)
+{
+	eventStream->setMaxSubscribers(max);
 }
 
 void RequestHandler::service(HttpRequest &request, HttpResponse &response)
@@ -160,10 +177,24 @@ void RequestHandler::service(HttpRequest &request, HttpResponse &response)
 	QByteArray path = request.getPath();
 	//qDebug()<<"Request path:"<<rawPath<<" decoded:"<<path;
 
-	if(path.startsWith("/api/"))
+	if(path == "/api/main/events")
+	{
+		//the event stream keeps this connection (and thread) until the client disconnects
+		eventStream->serve(request,response);
+	}
+	else if(path.startsWith("/api/"))
 	{
+		//a POST may change the state: invalidate the snapshot before it is dispatched, so that GETs served
+		//meanwhile do not keep the old state, and again after it returns, as a snapshot may have been taken while it ran
+		const bool isPost = request.getMethod()=="POST";
+		if(isPost)
+			stateSnapshots->invalidate();
+
 		//this is an API request, pass it on
 		apiController->service(request,response);
+
+		if(isPost)
+			stateSnapshots->invalidate();
 	}
 	else
 	{
@@ -24,6 +24,8 @@
 #include "httpserver/staticfilecontroller.h"
 
 class APIController;
+class EventStream;
+class StateSnapshotPublisher;
 class StaticFileController;
 
 //! This is the main request handler for the remote control plugin, receiving and dispatching the HTTP requests.
@@ -41,14 +43,23 @@ public:
 	//! The internal APIController, and all registered services are deleted
 	virtual ~RequestHandler();
 
-	//! Called in the main thread each frame, only passed on to APIController::update
+	//! Called in the main thread each frame, passed on to APIController::update and to the EventStream
 	void update(double deltaTime);
 
+	//! Ends all open \c main/events streams. This has to be done before the HttpListener is deleted,
+	//! because it waits for the connection threads that serve them.
+	void stopEventStreams();
+	//! Sets how many \c main/events streams are served at the same time, each of them blocks one connection thread.
+	//! Further clients receive a <tt>503 Service Unavailable</tt> reply.
+	void setMaxEventStreams(int max);
+
 	//! Receives the HttpRequest from the HttpListener.
 	//! It checks the optional HTTP authentication and sets the keep-alive header if requested
 	//! by the client.
 	//!
 	//! If the authentication is correct, the request is processed according to the following rules:
+	//!  - If the request path is @c "/api/main/events", the connection is handed to the EventStream,
+	//! which keeps it open and pushes state changes to the client.
 	//!  - If the request path starts with the string @c "/api/", then the request is passed to
 	//! the \ref APIController without further processing.
 	//!  - If a file specified in the special \c translate_files file is requested, the cached translated version
@@ -82,6 +93,8 @@ private:
 	QString password;
 	QByteArray passwordReply;
 	APIController* apiController;
+	EventStream* eventStream;
+	StateSnapshotPublisher* stateSnapshots;
 	StaticFileController* staticFiles;
 	QMutex templateMutex;
 
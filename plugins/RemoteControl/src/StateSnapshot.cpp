@@ -0,0 +1,186 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StateSnapshot.hpp"
+#include "MainService.hpp"
+
+#include "StelApp.hpp"
+#include "StelActionMgr.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelMovementMgr.hpp"
+#include "StelObject.hpp"
+#include "StelObjectMgr.hpp"
+#include "StelPropertyMgr.hpp"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QThread>
+
+//! Snapshots are only taken while they have been requested in this time
+static const qint64 DEMAND_TIMEOUT = 5000;
+//! While in demand, a snapshot is taken each frame, so an older one means that the main thread was idle
+//! and it is safer to wait for a fresh one
+static const qint64 MAX_SNAPSHOT_AGE = 2000;
+//! The selection info contains the current object position, so it is refreshed with the same interval the web interface polls
+static const qint64 SELECTION_INTERVAL = 1000;
+//! The full action and property lists are re-read in this interval, to include newly registered ones
+static const qint64 FULL_REFRESH_INTERVAL = 10000;
+
+static QJsonArray toJsonArray(const Vec3d& v)
+{
+	QJsonArray arr;
+	arr.append(v[0]);
+	arr.append(v[1]);
+	arr.append(v[2]);
+	return arr;
+}
+
+StateSnapshotPublisher::StateSnapshotPublisher(MainService *mainService, QObject *parent)
+	: QObject(parent),
+	  mainService(mainService),
+	  lastFullRefresh(0),
+	  hasSelection(false),
+	  selectionDirty(true),
+	  lastSelectionUpdate(0),
+	  version(0),
+	  lastRequest(0)
+{
+	//this is run in the main thread
+	core = StelApp::getInstance().getCore();
+	mvmgr = GETSTELMODULE(StelMovementMgr);
+	objMgr = &StelApp::getInstance().getStelObjectMgr();
+
+	connect(StelApp::getInstance().getStelActionManager(),SIGNAL(actionToggled(QString,bool)),this,SLOT(actionToggled(QString,bool)));
+	connect(StelApp::getInstance().getStelPropertyManager(),SIGNAL(stelPropertyChanged(StelProperty*,QVariant)),this,SLOT(propertyChanged(StelProperty*,QVariant)));
+	connect(objMgr,&StelObjectMgr::selectedObjectChanged,this,&StateSnapshotPublisher::selectionChanged);
+}
+
+void StateSnapshotPublisher::actionToggled(const QString &id, bool val)
+{
+	//keep the lists current between the full refreshes
+	if(!actions.isEmpty())
+		actions.insert(id,val);
+}
+
+void StateSnapshotPublisher::propertyChanged(StelProperty *prop, const QVariant &val)
+{
+	if(!properties.isEmpty())
+		properties.insert(prop->getId(),QJsonValue::fromVariant(val));
+}
+
+void StateSnapshotPublisher::selectionChanged()
+{
+	selectionDirty = true;
+}
+
+void StateSnapshotPublisher::update()
+{
+	if(QDateTime::currentMSecsSinceEpoch() - lastRequest.load() < DEMAND_TIMEOUT)
+		publish();
+}
+
+void StateSnapshotPublisher::invalidate()
+{
+	outdated.store(1);
+}
+
+StateSnapshotP StateSnapshotPublisher::get()
+{
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	lastRequest.store(now);
+
+	snapshotMutex.lock();
+	StateSnapshotP snapshot = current;
+	snapshotMutex.unlock();
+
+	if(snapshot.isNull() || outdated.load() || now - snapshot->timestamp > MAX_SNAPSHOT_AGE)
+	{
+		//wait for the main thread once, the next snapshots are taken each frame
+		if(QThread::currentThread() == thread())
+			publish();
+		else
+			QMetaObject::invokeMethod(this,"publish",Qt::BlockingQueuedConnection);
+
+		snapshotMutex.lock();
+		snapshot = current;
+		snapshotMutex.unlock();
+	}
+	return snapshot;
+}
+
+void StateSnapshotPublisher::publish()
+{
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	//cleared before the state is read, so that a concurrent invalidate() is never lost
+	outdated.store(0);
+
+	StateSnapshot* snapshot = new StateSnapshot();
+	snapshot->version = ++version;
+	snapshot->timestamp = now;
+
+	snapshot->location = mainService->getLocationInfo();
+	snapshot->time = mainService->getTimeInfo();
+
+	QJsonObject view = mainService->getViewInfo();
+	Vec3d viewDirJ2000 = mvmgr->getViewDirectionJ2000();
+	view.insert("j2000",toJsonArray(viewDirJ2000));
+	view.insert("altAz",toJsonArray(core->j2000ToAltAz(viewDirJ2000,StelCore::RefractionOff)));
+	snapshot->view = view;
+
+	if(selectionDirty || now - lastSelectionUpdate >= SELECTION_INTERVAL)
+	{
+		selectionDirty = false;
+		lastSelectionUpdate = now;
+
+		const QList<StelObjectP> selection = objMgr->getSelectedObject();
+		hasSelection = !selection.isEmpty();
+		if(hasSelection)
+		{
+			selectionInfo = selection[0]->getInfoString(core,StelObject::AllInfo | StelObject::NoFont);
+			selectionInfoHtml = selection[0]->getInfoString(core);
+		}
+		else
+		{
+			selectionInfo.clear();
+			selectionInfoHtml.clear();
+		}
+	}
+	snapshot->hasSelection = hasSelection;
+	snapshot->selectionInfo = selectionInfo;
+	snapshot->selectionInfoHtml = selectionInfoHtml;
+
+	if(actions.isEmpty() || properties.size() != StelApp::getInstance().getStelPropertyManager()->getPropertyMap().size()
+			|| now - lastFullRefresh >= FULL_REFRESH_INTERVAL)
+	{
+		actions = mainService->getAllActionStates();
+		properties = mainService->getAllPropertyValues();
+		lastFullRefresh = now;
+	}
+	//the change signals have all been handled at this point, so the IDs match the values
+	snapshot->actions = actions;
+	snapshot->actionChangeId = mainService->getActionChangeId();
+	snapshot->properties = properties;
+	snapshot->propertyChangeId = mainService->getPropertyChangeId();
+
+	StateSnapshotP p(snapshot);
+	snapshotMutex.lock();
+	current = p;
+	snapshotMutex.unlock();
+}
@@ -0,0 +1,129 @@
+/*
+ * Stellarium Remote Control plugin
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STATESNAPSHOT_HPP_
+#define STATESNAPSHOT_HPP_
+
+#include <QObject>
+#include <QAtomicInteger>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVariant>
+
+class MainService;
+class StelCore;
+class StelMovementMgr;
+class StelObjectMgr;
+class StelProperty;
+
+//! @ingroup remoteControl
+//! An immutable copy of the frequently queried program state, taken in the main thread.
+//! Read-only requests can be answered from it in the HTTP threads, without waiting for the main thread.
+struct StateSnapshot
+{
+	//! Incremented with each published snapshot
+	quint64 version;
+	//! The real time the snapshot was taken, in ms since the epoch
+	qint64 timestamp;
+
+	//! See MainService::getLocationInfo
+	QJsonObject location;
+	//! See MainService::getTimeInfo
+	QJsonObject time;
+	//! See MainService::getViewInfo, extended with the current view direction in \c j2000 and \c altAz coordinates
+	QJsonObject view;
+
+	//! If an object is selected
+	bool hasSelection;
+	//! Info string of the selected object, as used by the \c main/status operation
+	QString selectionInfo;
+	//! Info string of the selected object with the default flags, as used by the \c objects/info operation
+	QString selectionInfoHtml;
+
+	//! The checked state of all checkable StelActions
+	QJsonObject actions;
+	//! The newest action change ID contained in #actions, see MainService
+	int actionChangeId;
+	//! The values of all StelProperties
+	QJsonObject properties;
+	//! The newest property change ID contained in #properties, see MainService
+	int propertyChangeId;
+};
+
+typedef QSharedPointer<const StateSnapshot> StateSnapshotP;
+
+//! @ingroup remoteControl
+//! Publishes a new StateSnapshot each frame while they are requested.
+//!
+//! The actions and properties are tracked through their change signals, and the selection info strings are
+//! only refreshed when the selection changes or once per second, so taking a snapshot is cheap for the main thread.
+//! When nobody requested a snapshot for a while, none are taken at all. The first get() call after such a
+//! pause (or after invalidate()) waits for the main thread once.
+class StateSnapshotPublisher : public QObject
+{
+	Q_OBJECT
+public:
+	StateSnapshotPublisher(MainService* mainService, QObject* parent = Q_NULLPTR);
+
+	//! Called in the main thread each frame. Publishes a new snapshot if they were requested recently.
+	void update();
+
+	//! Marks the current snapshot as outdated, for example because a POST request changed the state.
+	//! The next get() call waits for a fresh snapshot. Can be called from any thread.
+	void invalidate();
+
+	//! Returns the newest snapshot. Can be called from any thread.
+	StateSnapshotP get();
+
+private slots:
+	//! Takes a new snapshot. Must run in the main thread.
+	void publish();
+
+	void actionToggled(const QString& id, bool val);
+	void propertyChanged(StelProperty* prop, const QVariant& val);
+	void selectionChanged();
+
+private:
+	MainService* mainService;
+	StelCore* core;
+	StelMovementMgr* mvmgr;
+	StelObjectMgr* objMgr;
+
+	//these are only accessed from the main thread
+	QJsonObject actions;
+	QJsonObject properties;
+	qint64 lastFullRefresh;
+	bool hasSelection;
+	QString selectionInfo;
+	QString selectionInfoHtml;
+	bool selectionDirty;
+	qint64 lastSelectionUpdate;
+	quint64 version;
+
+	QAtomicInt outdated;
+	//the time of the last get() call, in ms since the epoch
+	QAtomicInteger<qint64> lastRequest;
+
+	//only held to copy or replace the pointer, never while a snapshot is taken
+	QMutex snapshotMutex;
+	StateSnapshotP current;
+};
+
+#endif
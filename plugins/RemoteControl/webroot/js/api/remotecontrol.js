@@ -11,6 +11,16 @@ define(["jquery", "settings", "translationdata"], function($, settings, Translat
     var lastActionId = -2;
     var lastPropId = -2;
 
+    //the event stream, if it is used instead of polling
+    var eventSource;
+    //the last full status, the stream events only contain the parts that changed
+    var streamStatus;
+    var lastTimeReceived;
+    //changes the handlers did not accept yet, they are re-sent with the next event
+    var pendingActionChanges = {};
+    var pendingPropChanges = {};
+    var pendingRetry;
+
     // Translates a string using Stellariums current locale.
     // String must be present in translationdata.js
     // All strings from tr() calls in the .js files will be written in translationdata.js when update_translationdata.py is executed
@@ -96,6 +106,100 @@ define(["jquery", "settings", "translationdata"], function($, settings, Translat
         });
     }
 
+    //passes the accumulated stream changes to the handlers, returns the changes that were not accepted
+    function fireStreamChanges(name, pending) {
+        if ($.isEmptyObject(pending))
+            return pending;
+
+        var evt = $.Event(name);
+        $(rc).trigger(evt, pending);
+        if (evt.isDefaultPrevented()) {
+            //same as with polling, this is required to make sure the actions/props are loaded first
+            //a stream may not send anything for a while, so retry on our own
+            console.log(name + " error, resending same changes later");
+            if (!pendingRetry) {
+                pendingRetry = setTimeout(function() {
+                    pendingRetry = undefined;
+                    pendingActionChanges = fireStreamChanges("stelActionsChanged", pendingActionChanges);
+                    pendingPropChanges = fireStreamChanges("stelPropertiesChanged", pendingPropChanges);
+                }, settings.updateInterval);
+            }
+            return pending;
+        }
+        return {};
+    }
+
+    //handles an event of the /api/main/events stream
+    function streamEventReceived(evt) {
+        var data = JSON.parse(evt.data);
+        var now = $.now();
+
+        if (data.reset) {
+            //this contains everything, including all actions and properties
+            streamStatus = data;
+            pendingActionChanges = {};
+            pendingPropChanges = {};
+            lastTimeReceived = now;
+        } else if (streamStatus) {
+            //merge the parts that changed, so that the handlers always get the full status
+            if ("location" in data)
+                streamStatus.location = data.location;
+            if ("selectioninfo" in data)
+                streamStatus.selectioninfo = data.selectioninfo;
+            if ("view" in data)
+                streamStatus.view = data.view;
+
+            if ("time" in data) {
+                streamStatus.time = data.time;
+            } else {
+                //the server only sends the time if it can not be extrapolated,
+                //the handlers progress it from the moment they receive it, so do the same here
+                streamStatus.time.jday += ((now - lastTimeReceived) / 1000.0) * streamStatus.time.timerate;
+            }
+            lastTimeReceived = now;
+        } else {
+            return;
+        }
+
+        lastDataTime = now;
+        $(rc).trigger('serverDataReceived', streamStatus);
+
+        if (data.actionChanges)
+            pendingActionChanges = fireStreamChanges("stelActionsChanged", $.extend(pendingActionChanges, data.actionChanges.changes));
+        if (data.propertyChanges)
+            pendingPropChanges = fireStreamChanges("stelPropertiesChanged", $.extend(pendingPropChanges, data.propertyChanges.changes));
+
+        connectionLost = false;
+    }
+
+    //receive the updates through the server-sent event stream
+    function startEventStream() {
+        var opened = false;
+        eventSource = new EventSource("/api/main/events");
+
+        eventSource.onopen = function() {
+            opened = true;
+        };
+        eventSource.onmessage = streamEventReceived;
+        eventSource.onerror = function() {
+            //handle reconnection ourselves, the next stream starts with a full state again
+            eventSource.close();
+            eventSource = undefined;
+            streamStatus = undefined;
+
+            $(rc).trigger("serverDataError", "event stream error");
+            connectionLost = true;
+
+            if (opened) {
+                setTimeout(startEventStream, settings.updateInterval);
+            } else {
+                //the stream never worked (maybe a proxy is in between), use polling instead
+                console.log("Event stream not available, falling back to polling");
+                update(true);
+            }
+        };
+    }
+
     //remove panels for disabled plugins and load additional JS files if required for enabled ones
     function processPluginInfo(data) {
         //iterate over all stelplugin elements
@@ -164,7 +268,11 @@ define(["jquery", "settings", "translationdata"], function($, settings, Translat
         tr: tr,
         //Kicks off the update loop. If the loop is disabled, this still requests the data one time
         startUpdateLoop: function() {
-            update(true);
+            if (settings.updatePoll && settings.useEventStream && window.EventSource) {
+                startEventStream();
+            } else {
+                update(true);
+            }
         },
         isConnectionLost: function() {
             return connectionLost;
@@ -188,7 +296,9 @@ define(["jquery", "settings", "translationdata"], function($, settings, Translat
                             alert(data);
                         }
                     }
-                    update();
+                    //the event stream sends the changes by itself
+                    if (!eventSource)
+                        update();
                 },
                 error: function(xhr, status, errorThrown) {
                     console.log("Error posting command " + url);
@@ -201,7 +311,8 @@ define(["jquery", "settings", "translationdata"], function($, settings, Translat
         },
 
         forceUpdate: function() {
-            update();
+            if (!eventSource)
+                update();
         },
     };
 
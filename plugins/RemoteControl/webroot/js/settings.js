@@ -9,6 +9,8 @@ define(function() {
   data.updatePoll = true;
   //the interval for automatic polling
   data.updateInterval = 1000;
+  //receive updates through the server-sent event stream instead of polling, if the browser supports it
+  data.useEventStream = true;
   //use the Browser's requestAnimationFrame for animation instead of setTimeout
   data.useAnimationFrame = true;
   //If animation frame is not used, this is the delay between 2 animation steps
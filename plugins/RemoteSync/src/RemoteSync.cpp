@@ -59,6 +59,8 @@ StelPluginInfo RemoteSyncStelPluginInterface::getPluginInfo() const
 RemoteSync::RemoteSync()
 	: clientServerPort(20180)
 	, serverPort(20180)
+	, serverMulticastPort(20181)
+	, serverQuantizeFrames(false)
 	, connectionLostBehavior(ClientBehavior::RECONNECT)
 	, quitBehavior(ClientBehavior::NONE)
 	, state(IDLE)
@@ -124,9 +126,14 @@ void RemoteSync::update(double deltaTime)
 	Q_UNUSED(deltaTime);
 	if(server)
 	{
-		//pass update on to server, client does not need this
+		//pass update on to server
 		server->update();
 	}
+	else if(client)
+	{
+		//the client extrapolates the received state between packets
+		client->update();
+	}
 }
 
 double RemoteSync::getCallOrder(StelModuleActionName actionName) const
@@ -166,6 +173,33 @@ void RemoteSync::setServerPort(const int port)
 	}
 }
 
+void RemoteSync::setServerMulticastGroup(const QString &group)
+{
+	if(group != serverMulticastGroup)
+	{
+		serverMulticastGroup = group;
+		emit serverMulticastGroupChanged(group);
+	}
+}
+
+void RemoteSync::setServerMulticastPort(const int port)
+{
+	if(port != serverMulticastPort)
+	{
+		serverMulticastPort = port;
+		emit serverMulticastPortChanged(port);
+	}
+}
+
+void RemoteSync::setServerQuantizeFrames(const bool quantize)
+{
+	if(quantize != serverQuantizeFrames)
+	{
+		serverQuantizeFrames = quantize;
+		emit serverQuantizeFramesChanged(quantize);
+	}
+}
+
 void RemoteSync::setClientSyncOptions(SyncClient::SyncOptions options)
 {
 	if(options!=syncOptions)
@@ -207,6 +241,15 @@ void RemoteSync::startServer()
 	if(state == IDLE)
 	{
 		server = new SyncServer(this);
+		server->setQuantizeFrames(serverQuantizeFrames);
+		if(!serverMulticastGroup.isEmpty())
+		{
+			QHostAddress group(serverMulticastGroup);
+			if(group.isMulticast())
+				server->setMulticastGroup(group, static_cast<quint16>(serverMulticastPort));
+			else
+				qCWarning(remoteSync)<<"Ignoring invalid multicast group address"<<serverMulticastGroup;
+		}
 		if(server->start(serverPort))
 			setState(SERVER);
 		else
@@ -319,6 +362,9 @@ void RemoteSync::loadSettings()
 	setClientServerHost(conf->value("clientServerHost","127.0.0.1").toString());
 	setClientServerPort(conf->value("clientServerPort",20180).toInt());
 	setServerPort(conf->value("serverPort",20180).toInt());
+	setServerMulticastGroup(conf->value("serverMulticastGroup","").toString());
+	setServerMulticastPort(conf->value("serverMulticastPort",20181).toInt());
+	setServerQuantizeFrames(conf->value("serverQuantizeFrames",false).toBool());
 	setClientSyncOptions(SyncClient::SyncOptions(conf->value("clientSyncOptions", SyncClient::ALL).toInt()));
 	setStelPropFilter(unpackStringList(conf->value("stelPropFilter").toString()));
 	setConnectionLostBehavior(static_cast<ClientBehavior>(conf->value("connectionLostBehavior",1).toInt()));
@@ -333,6 +379,9 @@ void RemoteSync::saveSettings()
 	conf->setValue("clientServerHost",clientServerHost);
 	conf->setValue("clientServerPort",clientServerPort);
 	conf->setValue("serverPort",serverPort);
+	conf->setValue("serverMulticastGroup",serverMulticastGroup);
+	conf->setValue("serverMulticastPort",serverMulticastPort);
+	conf->setValue("serverQuantizeFrames",serverQuantizeFrames);
 	conf->setValue("clientSyncOptions",static_cast<int>(syncOptions));
 	conf->setValue("stelPropFilter", packStringList(stelPropFilter));
 	conf->setValue("connectionLostBehavior", connectionLostBehavior);
@@ -76,6 +76,9 @@ public:
 	QString getClientServerHost() const { return clientServerHost; }
 	int getClientServerPort() const { return clientServerPort; }
 	int getServerPort() const { return serverPort; }
+	QString getServerMulticastGroup() const { return serverMulticastGroup; }
+	int getServerMulticastPort() const { return serverMulticastPort; }
+	bool getServerQuantizeFrames() const { return serverQuantizeFrames; }
 	SyncClient::SyncOptions getClientSyncOptions() const { return syncOptions; }
 	QStringList getStelPropFilter() const { return stelPropFilter; }
 	ClientBehavior getConnectionLostBehavior() const { return connectionLostBehavior; }
@@ -87,6 +90,11 @@ public slots:
 	void setClientServerHost(const QString& clientServerHost);
 	void setClientServerPort(const int port);
 	void setServerPort(const int port);
+	//! Sets the multicast group address the server additionally sends frames to. An empty string disables multicast.
+	void setServerMulticastGroup(const QString& group);
+	void setServerMulticastPort(const int port);
+	//! If enabled, the server sends view direction and fov with float precision
+	void setServerQuantizeFrames(const bool quantize);
 	void setClientSyncOptions(SyncClient::SyncOptions options);
 	void setStelPropFilter(const QStringList& stelPropFilter);
 	void setConnectionLostBehavior(const ClientBehavior bh);
@@ -130,6 +138,9 @@ signals:
 	void clientServerHostChanged(const QString& clientServerHost);
 	void clientServerPortChanged(const int port);
 	void serverPortChanged(const int port);
+	void serverMulticastGroupChanged(const QString& group);
+	void serverMulticastPortChanged(const int port);
+	void serverQuantizeFramesChanged(const bool quantize);
 	void clientSyncOptionsChanged(const SyncClient::SyncOptions options);
 	void stelPropFilterChanged(const QStringList& stelPropFilter);
 	void connectionLostBehaviorChanged(const ClientBehavior bh);
@@ -155,6 +166,10 @@ private:
 	int clientServerPort;
 	//the port used in server mode
 	int serverPort;
+	//the multicast group and port used in server mode, disabled if empty
+	QString serverMulticastGroup;
+	int serverMulticastPort;
+	bool serverQuantizeFrames;
 	SyncClient::SyncOptions syncOptions;
 	QStringList stelPropFilter;
 	ClientBehavior connectionLostBehavior;
@@ -26,18 +26,35 @@
 #include <QDateTime>
 #include <QTcpSocket>
 #include <QTimerEvent>
+#include <QUdpSocket>
 
 Q_LOGGING_CATEGORY(syncClient,"stel.plugin.remoteSync.client")
 
 using namespace SyncProtocol;
 
+//! Number of recent ping results used to estimate the clock offset
+static const int CLOCK_SAMPLE_COUNT = 8;
+//! Ping interval in ms after connecting, until enough samples are collected
+static const int PING_INTERVAL_FAST = 250;
+//! Ping interval in ms afterwards, to follow clock drift
+static const int PING_INTERVAL = 2000;
+
 SyncClient::SyncClient(SyncOptions options, const QStringList &excludeProperties, QObject *parent)
 	: QObject(parent),
 	  options(options),
 	  stelPropFilter(excludeProperties),
 	  isConnecting(false),
 	  server(Q_NULLPTR),
-	  timeoutTimerId(-1)
+	  timeoutTimerId(-1),
+	  multicastSocket(Q_NULLPTR),
+	  multicastPort(0),
+	  multicastSessionId(0),
+	  lastMulticastFrame(0),
+	  multicastConfirmed(false),
+	  multicastTimerId(-1),
+	  clockOffset(0),
+	  pingTimerId(-1),
+	  fastPing(true)
 {
 	handlerList.resize(MSGTYPE_SIZE);
 	handlerList[ERROR] = new ClientErrorHandler(this);
@@ -46,18 +63,33 @@ SyncClient::SyncClient(SyncOptions options, const QStringList &excludeProperties
 	handlerList[ALIVE] = new ClientAliveHandler();
 
 	//these are the actual sync handlers
+	ClientTimeHandler* timeHandler = Q_NULLPTR;
+	ClientLocationHandler* locationHandler = Q_NULLPTR;
+	ClientSelectionHandler* selectionHandler = Q_NULLPTR;
+	ClientStelPropertyUpdateHandler* propertyHandler = Q_NULLPTR;
+	ClientViewHandler* viewHandler = Q_NULLPTR;
+	ClientFovHandler* fovHandler = Q_NULLPTR;
 	if(options.testFlag(SyncTime))
-		handlerList[TIME] = new ClientTimeHandler();
+		handlerList[TIME] = timeHandler = new ClientTimeHandler(this);
 	if(options.testFlag(SyncLocation))
-		handlerList[LOCATION] = new ClientLocationHandler();
+		handlerList[LOCATION] = locationHandler = new ClientLocationHandler();
 	if(options.testFlag(SyncSelection))
-		handlerList[SELECTION] = new ClientSelectionHandler();
+		handlerList[SELECTION] = selectionHandler = new ClientSelectionHandler();
 	if(options.testFlag(SyncStelProperty))
-		handlerList[STELPROPERTY] = new ClientStelPropertyUpdateHandler(options.testFlag(SkipGUIProps), stelPropFilter);
+		handlerList[STELPROPERTY] = propertyHandler = new ClientStelPropertyUpdateHandler(options.testFlag(SkipGUIProps), stelPropFilter);
 	if(options.testFlag(SyncView))
-		handlerList[VIEW] = new ClientViewHandler();
+		handlerList[VIEW] = viewHandler = new ClientViewHandler(this);
 	if(options.testFlag(SyncFov))
-		handlerList[FOV] = new ClientFovHandler();
+		handlerList[FOV] = fovHandler = new ClientFovHandler(this);
+
+	//frames are split up into the handlers above
+	frameHandler = new ClientFrameHandler(timeHandler, locationHandler, selectionHandler, propertyHandler, viewHandler, fovHandler);
+	handlerList[FRAME] = frameHandler;
+	handlerList[MULTICAST] = new ClientMulticastHandler(this);
+	handlerList[PING] = new ClientPingHandler(this);
+
+	//the clock offset is estimated as soon as the connection is authenticated
+	connect(this, SIGNAL(connected()), this, SLOT(startClockSync()));
 
 	//fill unused handlers with dummies
 	for(int t = TIME;t<MSGTYPE_SIZE;++t)
@@ -115,6 +147,16 @@ void SyncClient::timerEvent(QTimerEvent *evt)
 		checkTimeout();
 		evt->accept();
 	}
+	else if(evt->timerId() == pingTimerId)
+	{
+		sendPing();
+		evt->accept();
+	}
+	else if(evt->timerId() == multicastTimerId)
+	{
+		checkMulticastTimeout();
+		evt->accept();
+	}
 }
 
 void SyncClient::checkTimeout()
@@ -128,6 +170,13 @@ void SyncClient::checkTimeout()
 void SyncClient::serverDisconnected(bool clean)
 {
 	qCDebug(syncClient)<<"Disconnected from server";
+	leaveMulticastGroup();
+	if(pingTimerId>=0)
+	{
+		killTimer(pingTimerId);
+		pingTimerId = -1;
+	}
+	clockSamples.clear();
 	if(!clean)
 		errorStr = server->getError();
 	server->deleteLater();
@@ -144,3 +193,184 @@ void SyncClient::emitServerError(const QString &errorStr)
 {
 	this->errorStr = errorStr;
 }
+
+bool SyncClient::joinMulticastGroup(const MulticastInfo &info)
+{
+	if(!options.testFlag(UseMulticast))
+	{
+		qCDebug(syncClient)<<"Multicast offered by server, but disabled by options";
+		return false;
+	}
+
+	leaveMulticastGroup();
+
+	QHostAddress group(info.groupAddress);
+	multicastSocket = new QUdpSocket(this);
+	//multiple clients on the same computer share the port
+	bool ok = multicastSocket->bind(QHostAddress(QHostAddress::AnyIPv4), info.port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
+	ok = ok && multicastSocket->joinMulticastGroup(group);
+
+	if(!ok)
+	{
+		qCWarning(syncClient)<<"Could not join multicast group"<<info.groupAddress<<"on port"<<info.port<<":"<<multicastSocket->errorString();
+		leaveMulticastGroup();
+		return false;
+	}
+
+	multicastGroup = info.groupAddress;
+	multicastPort = info.port;
+	multicastSessionId = info.sessionId;
+	lastMulticastFrame = 0;
+	multicastConfirmed = false;
+	connect(multicastSocket, SIGNAL(readyRead()), this, SLOT(readMulticastDatagrams()));
+	//routers or firewalls may drop the datagrams even though joining worked, so wait for the first one
+	lastMulticastDatagram.start();
+	multicastTimerId = startTimer(SYNC_MULTICAST_KEYFRAME_INTERVAL, Qt::VeryCoarseTimer);
+	qCDebug(syncClient)<<"Joined multicast group"<<info.groupAddress<<"on port"<<info.port<<", waiting for datagrams";
+	return true;
+}
+
+void SyncClient::leaveMulticastGroup()
+{
+	if(multicastSocket)
+	{
+		multicastSocket->deleteLater();
+		multicastSocket = Q_NULLPTR;
+	}
+	if(multicastTimerId>=0)
+	{
+		killTimer(multicastTimerId);
+		multicastTimerId = -1;
+	}
+	multicastConfirmed = false;
+}
+
+void SyncClient::sendMulticastState(bool joined)
+{
+	if(!server || !server->isAuthenticated())
+		return;
+
+	MulticastInfo msg;
+	msg.groupAddress = multicastGroup;
+	msg.port = multicastPort;
+	msg.sessionId = multicastSessionId;
+	msg.joined = joined;
+	server->writeMessage(msg);
+}
+
+void SyncClient::checkMulticastTimeout()
+{
+	if(!multicastSocket || lastMulticastDatagram.elapsed() < SYNC_MULTICAST_TIMEOUT)
+		return;
+
+	if(multicastConfirmed)
+		qCWarning(syncClient)<<"No multicast datagrams received for"<<lastMulticastDatagram.elapsed()<<"ms, receiving frames through TCP again";
+	else
+		qCWarning(syncClient)<<"No multicast datagrams received after joining the group, they are probably blocked by the network. Receiving frames through TCP";
+	sendMulticastState(false);
+	leaveMulticastGroup();
+}
+
+void SyncClient::readMulticastDatagrams()
+{
+	while(multicastSocket && multicastSocket->hasPendingDatagrams())
+	{
+		QByteArray datagram(static_cast<int>(multicastSocket->pendingDatagramSize()), '\0');
+		multicastSocket->readDatagram(datagram.data(), datagram.size());
+
+		QDataStream stream(datagram);
+		stream.setVersion(SYNC_DATASTREAM_VERSION);
+
+		//datagrams of other servers using the same group are ignored
+		quint32 sessionId;
+		SyncHeader header;
+		stream>>sessionId>>header;
+		if(stream.status() || sessionId != multicastSessionId || header.msgType != FRAME
+				|| header.dataSize != datagram.size() - static_cast<qint64>(sizeof(quint32)) - SYNC_HEADER_SIZE)
+			continue;
+
+		Frame frame;
+		if(!frame.deserialize(stream, header.dataSize))
+		{
+			qCWarning(syncClient)<<"Invalid multicast frame received";
+			continue;
+		}
+
+		lastMulticastDatagram.restart();
+		if(!multicastConfirmed)
+		{
+			//the server sends the full frames through TCP until it is told that the datagrams arrive,
+			//so the frames received until then are only used to confirm the multicast
+			multicastConfirmed = true;
+			sendMulticastState(true);
+			qCDebug(syncClient)<<"Receiving frames through multicast";
+			continue;
+		}
+
+		//UDP does not preserve order, so drop frames older than the last applied one
+		if(lastMulticastFrame && static_cast<qint32>(frame.frameNumber - lastMulticastFrame) <= 0)
+			continue;
+		lastMulticastFrame = frame.frameNumber;
+
+		frameHandler->apply(frame);
+	}
+}
+
+void SyncClient::update()
+{
+	frameHandler->update();
+}
+
+qint64 SyncClient::getServerTime() const
+{
+	return QDateTime::currentMSecsSinceEpoch() + clockOffset;
+}
+
+void SyncClient::startClockSync()
+{
+	fastPing = true;
+	pingTimerId = startTimer(PING_INTERVAL_FAST, Qt::PreciseTimer);
+	sendPing();
+}
+
+void SyncClient::sendPing()
+{
+	if(!server || !server->isAuthenticated())
+		return;
+
+	Ping msg;
+	msg.clientTime = QDateTime::currentMSecsSinceEpoch();
+	server->writeMessage(msg);
+}
+
+void SyncClient::addClockSample(qint64 clientSendTime, qint64 serverTime, qint64 clientReceiveTime)
+{
+	//like NTP, assume the message took the same time in both directions
+	ClockSample sample;
+	sample.roundTrip = clientReceiveTime - clientSendTime;
+	sample.offset = serverTime - (clientSendTime + clientReceiveTime) / 2;
+
+	clockSamples.append(sample);
+	if(clockSamples.size() > CLOCK_SAMPLE_COUNT)
+		clockSamples.removeFirst();
+
+	//the sample with the shortest round trip was least delayed by queueing, so its offset is the most accurate one
+	ClockSample best = clockSamples.first();
+	foreach(const ClockSample& s, clockSamples)
+	{
+		if(s.roundTrip < best.roundTrip)
+			best = s;
+	}
+
+	if(best.offset != clockOffset)
+		qCDebug(syncClient)<<"Clock offset to server"<<best.offset<<"ms, round trip time"<<best.roundTrip<<"ms";
+	clockOffset = best.offset;
+
+	if(fastPing && pingTimerId>=0 && clockSamples.size() >= CLOCK_SAMPLE_COUNT)
+	{
+		//enough samples collected, only follow the clock drift from now on
+		fastPing = false;
+		killTimer(pingTimerId);
+		pingTimerId = startTimer(PING_INTERVAL, Qt::VeryCoarseTimer);
+	}
+}
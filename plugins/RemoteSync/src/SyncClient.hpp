@@ -20,6 +20,7 @@
 #ifndef SYNCCLIENT_HPP_
 #define SYNCCLIENT_HPP_
 
+#include <QElapsedTimer>
 #include <QLoggingCategory>
 #include <QObject>
 #include <QTcpSocket>
@@ -28,6 +29,13 @@ Q_DECLARE_LOGGING_CATEGORY(syncClient)
 
 class SyncMessageHandler;
 class SyncRemotePeer;
+class ClientFrameHandler;
+class QUdpSocket;
+
+namespace SyncProtocol
+{
+class MulticastInfo;
+}
 
 //! A client which can connect to a SyncServer to receive state changes, and apply them
 class SyncClient : public QObject
@@ -47,6 +55,7 @@ public:
 		SyncView	= 0x0010,
 		SyncFov		= 0x0020,
 		SkipGUIProps	= 0x0040,
+		UseMulticast	= 0x0080, //join the multicast group if offered by the server
 		ALL		= 0xFFFF
 	};
 	Q_DECLARE_FLAGS(SyncOptions, SyncOption)
@@ -56,6 +65,15 @@ public:
 
 	QString errorString() const { return errorStr; }
 
+	//! Should be called once per frame, extrapolates the synchronized state between the received packets
+	void update();
+
+	//! The estimated difference of the server's system clock to the local one, in ms.
+	//! This is zero until the first clock sample is received, i.e. the clocks are assumed to be synchronized.
+	qint64 getClockOffset() const { return clockOffset; }
+	//! The estimated current system time of the server, in ms since epoch
+	qint64 getServerTime() const;
+
 public slots:
 	void connectToServer(const QString& host, const int port);
 	void disconnectFromServer();
@@ -69,9 +87,22 @@ private slots:
 	void serverDisconnected(bool clean);
 	void socketConnected();
 	void emitServerError(const QString& errorStr);
+	void readMulticastDatagrams();
+	void startClockSync();
 
 private:
 	void checkTimeout();
+	//! Joins the multicast group of the server if allowed by the options, returns true on success.
+	//! The server is only told to stop sending the continuous fields through TCP once the first datagram arrives.
+	bool joinMulticastGroup(const SyncProtocol::MulticastInfo& info);
+	void leaveMulticastGroup();
+	//! Tells the server whether the multicast datagrams are received
+	void sendMulticastState(bool joined);
+	//! Falls back to TCP if no datagram was received for SYNC_MULTICAST_TIMEOUT
+	void checkMulticastTimeout();
+	void sendPing();
+	//! Adds the result of a ping to the clock offset estimation
+	void addClockSample(qint64 clientSendTime, qint64 serverTime, qint64 clientReceiveTime);
 
 	SyncOptions options;
 	QStringList stelPropFilter; // list of excluded properties
@@ -80,8 +111,31 @@ private:
 	SyncRemotePeer* server;
 	int timeoutTimerId;
 	QVector<SyncMessageHandler*> handlerList;
+	ClientFrameHandler* frameHandler;
+
+	QUdpSocket* multicastSocket;
+	QString multicastGroup;
+	quint16 multicastPort;
+	quint32 multicastSessionId;
+	quint32 lastMulticastFrame;
+	//! True once a datagram was received and the server was told about it
+	bool multicastConfirmed;
+	QElapsedTimer lastMulticastDatagram;
+	int multicastTimerId;
+
+	struct ClockSample
+	{
+		qint64 offset;
+		qint64 roundTrip;
+	};
+	QList<ClockSample> clockSamples;
+	qint64 clockOffset;
+	int pingTimerId;
+	bool fastPing;
 
 	friend class ClientErrorHandler;
+	friend class ClientMulticastHandler;
+	friend class ClientPingHandler;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(SyncClient::SyncOptions)
@@ -29,8 +29,16 @@
 #include "StelObjectMgr.hpp"
 #include "StelPropertyMgr.hpp"
 
+#include <QDateTime>
+
 using namespace SyncProtocol;
 
+//! Received view/fov samples further apart than this (in ms) are not treated as continuous movement
+static const qint64 MAX_SAMPLE_INTERVAL = 500;
+//! The view/fov is extrapolated at most twice the sample interval after the last sample, and never longer than this (in ms).
+//! After that the movement is assumed to have stopped, e.g. because the unchanged sample of the server was lost.
+static const qint64 MAX_EXTRAPOLATION = 250;
+
 ClientHandler::ClientHandler()
 	: client(Q_NULLPTR)
 {
@@ -160,6 +168,31 @@ bool ClientAliveHandler::handleMessage(QDataStream &stream, SyncProtocol::tPaylo
 	return p.deserialize(stream,dataSize);
 }
 
+ClientPingHandler::ClientPingHandler(SyncClient *client)
+	: ClientHandler(client)
+{
+
+}
+
+bool ClientPingHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
+{
+	Q_UNUSED(peer);
+	Ping msg;
+	bool ok = msg.deserialize(stream, dataSize);
+
+	if(!ok)
+		return false;
+
+	client->addClockSample(msg.clientTime, msg.serverTime, QDateTime::currentMSecsSinceEpoch());
+	return true;
+}
+
+ClientTimeHandler::ClientTimeHandler(SyncClient *client)
+	: ClientHandler(client), hasTime(false), appliedClockOffset(0)
+{
+
+}
+
 bool ClientTimeHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
 {
 	Time msg;
@@ -168,13 +201,37 @@ bool ClientTimeHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloa
 	if(!ok)
 		return false;
 
+	apply(msg);
+	return true;
+}
+
+void ClientTimeHandler::apply(const Time &msg)
+{
 	//set time variables, time rate first because it causes a resetSync which we overwrite
 	core->setTimeRate(msg.timeRate);
 	core->setJD(msg.jDay);
-	//This is needed for compensation of network delay. Requires system clocks of client/server to be calibrated to the same values.
-	core->setMilliSecondsOfLastJDUpdate(msg.lastTimeSyncTime);
+	//The server's time reference is converted to the local clock, this compensates the network delay.
+	//StelCore extrapolates from this reference with the time rate, so the arrival time of the message does not matter.
+	appliedClockOffset = client->getClockOffset();
+	core->setMilliSecondsOfLastJDUpdate(msg.lastTimeSyncTime - appliedClockOffset);
 
-	return true;
+	lastTime = msg;
+	hasTime = true;
+}
+
+void ClientTimeHandler::update()
+{
+	if(!hasTime || appliedClockOffset == client->getClockOffset())
+		return;
+
+	//only move the reference if the time has not been changed locally in the meantime
+	if(core->getJDOfLastJDUpdate() == lastTime.jDay && core->getTimeRate() == lastTime.timeRate)
+	{
+		appliedClockOffset = client->getClockOffset();
+		core->setMilliSecondsOfLastJDUpdate(lastTime.lastTimeSyncTime - appliedClockOffset);
+	}
+	else
+		hasTime = false;
 }
 
 bool ClientLocationHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
@@ -185,6 +242,12 @@ bool ClientLocationHandler::handleMessage(QDataStream &stream, SyncProtocol::tPa
 	if(!ok)
 		return false;
 
+	apply(msg);
+	return true;
+}
+
+void ClientLocationHandler::apply(const Location &msg)
+{
 	//replicated from StelCore::moveObserverTo
 	if(msg.totalDuration>0.0)
 	{
@@ -209,9 +272,6 @@ bool ClientLocationHandler::handleMessage(QDataStream &stream, SyncProtocol::tPa
 	}
 	emit core->targetLocationChanged(msg.stelLocation);
 	emit core->locationChanged(core->getCurrentLocation());
-
-
-	return true;
 }
 
 ClientSelectionHandler::ClientSelectionHandler()
@@ -227,13 +287,19 @@ bool ClientSelectionHandler::handleMessage(QDataStream &stream, SyncProtocol::tP
 	if(!ok)
 		return false;
 
+	apply(msg);
+	return true;
+}
+
+void ClientSelectionHandler::apply(const Selection &msg)
+{
 	qDebug()<<msg;
 
 	//lookup the objects from their names
 	//this might cause problems if 2 objects of different types have the same name!
 	QList<StelObjectP> selection;
 
-	for(QList< QPair<QString,QString> >::iterator it = msg.selectedObjects.begin(); it!=msg.selectedObjects.end();++it)
+	for(QList< QPair<QString,QString> >::const_iterator it = msg.selectedObjects.constBegin(); it!=msg.selectedObjects.constEnd();++it)
 	{
 		StelObjectP obj = objMgr->searchByID(it->first, it->second);
 		if(obj)
@@ -249,8 +315,6 @@ bool ClientSelectionHandler::handleMessage(QDataStream &stream, SyncProtocol::tP
 		//set selection
 		objMgr->setSelectedObject(selection,StelModule::ReplaceSelection);
 	}
-
-	return true;
 }
 
 ClientStelPropertyUpdateHandler::ClientStelPropertyUpdateHandler(bool skipGuiProps, const QStringList &excludeProps)
@@ -306,6 +370,12 @@ bool ClientStelPropertyUpdateHandler::handleMessage(QDataStream &stream, SyncPro
 	if(!ok)
 		return false;
 
+	apply(msg);
+	return true;
+}
+
+void ClientStelPropertyUpdateHandler::apply(const StelPropertyUpdate &msg)
+{
 	qDebug()<<msg;
 
 	QRegularExpressionMatch match = filter.match(msg.propId);
@@ -313,13 +383,13 @@ bool ClientStelPropertyUpdateHandler::handleMessage(QDataStream &stream, SyncPro
 	{
 		//filtered property
 		qDebug()<<"Filtered"<<msg;
-		return true;
+		return;
 	}
 	propMgr->setStelPropertyValue(msg.propId,msg.value);
-	return true;
 }
 
-ClientViewHandler::ClientViewHandler()
+ClientViewHandler::ClientViewHandler(SyncClient *client)
+	: ClientHandler(client), lastView(0.0), viewVelocity(0.0), lastViewTime(0), sampleInterval(0), isMoving(false)
 {
 	mvMgr = core->getMovementMgr();
 }
@@ -330,11 +400,52 @@ bool ClientViewHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloa
 	bool ok = msg.deserialize(stream, dataSize);
 	if(!ok) return false;
 
-	mvMgr->setViewDirectionJ2000(core->altAzToJ2000(msg.viewAltAz, StelCore::RefractionOff));
+	apply(msg);
 	return true;
 }
 
-ClientFovHandler::ClientFovHandler()
+void ClientViewHandler::apply(const View &msg, qint64 serverTime)
+{
+	qint64 dt = serverTime - lastViewTime;
+	isMoving = serverTime && lastViewTime && dt > 0 && dt <= MAX_SAMPLE_INTERVAL;
+	if(isMoving)
+	{
+		sampleInterval = dt;
+		viewVelocity = (msg.viewAltAz - lastView) / static_cast<double>(dt);
+		//the server sends an unchanged view once when it stops moving
+		isMoving = viewVelocity.lengthSquared() > 0.0;
+	}
+
+	lastView = msg.viewAltAz;
+	lastViewTime = serverTime;
+
+	if(isMoving)
+		update();
+	else
+		mvMgr->setViewDirectionJ2000(core->altAzToJ2000(lastView, StelCore::RefractionOff));
+}
+
+void ClientViewHandler::update()
+{
+	if(!isMoving)
+		return;
+
+	//the packet is already some time old when it arrives, so it is also extrapolated to the current server time
+	qint64 dt = qMax(Q_INT64_C(0), client->getServerTime() - lastViewTime);
+	const qint64 limit = qMin(2 * sampleInterval, MAX_EXTRAPOLATION);
+	if(dt >= limit)
+	{
+		//no further sample arrived, stay where the extrapolation ended
+		dt = limit;
+		isMoving = false;
+	}
+	Vec3d view = lastView + viewVelocity * static_cast<double>(dt);
+	view.normalize();
+	mvMgr->setViewDirectionJ2000(core->altAzToJ2000(view, StelCore::RefractionOff));
+}
+
+ClientFovHandler::ClientFovHandler(SyncClient *client)
+	: ClientHandler(client), lastFov(0.0), fovVelocity(0.0), lastFovTime(0), sampleInterval(0), isMoving(false)
 {
 	mvMgr = core->getMovementMgr();
 }
@@ -345,6 +456,110 @@ bool ClientFovHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayload
 	bool ok = msg.deserialize(stream, dataSize);
 	if(!ok) return false;
 
-	mvMgr->zoomTo(msg.fov, 0.0f);
+	apply(msg);
+	return true;
+}
+
+void ClientFovHandler::apply(const Fov &msg, qint64 serverTime)
+{
+	qint64 dt = serverTime - lastFovTime;
+	isMoving = serverTime && lastFovTime && dt > 0 && dt <= MAX_SAMPLE_INTERVAL;
+	if(isMoving)
+	{
+		sampleInterval = dt;
+		fovVelocity = (msg.fov - lastFov) / dt;
+		isMoving = fovVelocity != 0.0;
+	}
+
+	lastFov = msg.fov;
+	lastFovTime = serverTime;
+
+	if(isMoving)
+		update();
+	else
+		mvMgr->zoomTo(lastFov, 0.0f);
+}
+
+void ClientFovHandler::update()
+{
+	if(!isMoving)
+		return;
+
+	qint64 dt = qMax(Q_INT64_C(0), client->getServerTime() - lastFovTime);
+	const qint64 limit = qMin(2 * sampleInterval, MAX_EXTRAPOLATION);
+	if(dt >= limit)
+	{
+		dt = limit;
+		isMoving = false;
+	}
+	mvMgr->zoomTo(lastFov + fovVelocity * dt, 0.0f);
+}
+
+ClientFrameHandler::ClientFrameHandler(ClientTimeHandler *timeHandler, ClientLocationHandler *locationHandler, ClientSelectionHandler *selectionHandler,
+				       ClientStelPropertyUpdateHandler *propertyHandler, ClientViewHandler *viewHandler, ClientFovHandler *fovHandler)
+	: timeHandler(timeHandler), locationHandler(locationHandler), selectionHandler(selectionHandler),
+	  propertyHandler(propertyHandler), viewHandler(viewHandler), fovHandler(fovHandler)
+{
+
+}
+
+bool ClientFrameHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
+{
+	Frame msg;
+	bool ok = msg.deserialize(stream, dataSize);
+	if(!ok) return false;
+
+	apply(msg);
+	return true;
+}
+
+void ClientFrameHandler::apply(const Frame &msg)
+{
+	//same order as the single messages were sent before frames existed
+	if(timeHandler && msg.hasField(Frame::FieldTime))
+		timeHandler->apply(msg.time);
+	if(locationHandler && msg.hasField(Frame::FieldLocation))
+		locationHandler->apply(msg.location);
+	if(selectionHandler && msg.hasField(Frame::FieldSelection))
+		selectionHandler->apply(msg.selection);
+	if(propertyHandler && msg.hasField(Frame::FieldProperties))
+	{
+		foreach(const StelPropertyUpdate& prop, msg.properties)
+			propertyHandler->apply(prop);
+	}
+	if(viewHandler && msg.hasField(Frame::FieldView))
+		viewHandler->apply(msg.view, msg.serverTime);
+	if(fovHandler && msg.hasField(Frame::FieldFov))
+		fovHandler->apply(msg.fov, msg.serverTime);
+}
+
+void ClientFrameHandler::update()
+{
+	if(timeHandler)
+		timeHandler->update();
+	if(viewHandler)
+		viewHandler->update();
+	if(fovHandler)
+		fovHandler->update();
+}
+
+ClientMulticastHandler::ClientMulticastHandler(SyncClient *client)
+	: ClientHandler(client)
+{
+
+}
+
+bool ClientMulticastHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
+{
+	MulticastInfo msg;
+	bool ok = msg.deserialize(stream, dataSize);
+	if(!ok) return false;
+
+	//the client confirms the multicast with the same message once it receives the first datagram
+	if(!client->joinMulticastGroup(msg))
+	{
+		msg.joined = false;
+		peer.writeMessage(msg);
+	}
 	return true;
 }
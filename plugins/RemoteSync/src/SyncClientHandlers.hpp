@@ -21,6 +21,7 @@
 #define SYNCCLIENTHANDLERS_HPP_
 
 #include "SyncProtocol.hpp"
+#include "SyncMessages.hpp"
 
 #include <QRegularExpression>
 
@@ -65,16 +66,36 @@ public:
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
 };
 
+//! Receives the server's clock replies, used by the SyncClient to estimate the clock offset
+class ClientPingHandler : public ClientHandler
+{
+public:
+	ClientPingHandler(SyncClient* client);
+	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+};
+
+//! Applies the server's time reference, converted to the local clock using the estimated clock offset.
+//! StelCore then extrapolates the time with the server's time rate between messages.
 class ClientTimeHandler : public ClientHandler
 {
 public:
+	ClientTimeHandler(SyncClient* client);
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+	//! Applies the received state, also used for the time field of frames
+	void apply(const SyncProtocol::Time& msg);
+	//! Called once per frame, moves the applied time reference if the clock offset estimate has changed
+	void update();
+private:
+	SyncProtocol::Time lastTime;
+	bool hasTime;
+	qint64 appliedClockOffset;
 };
 
 class ClientLocationHandler : public ClientHandler
 {
 public:
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+	void apply(const SyncProtocol::Location& msg);
 };
 
 class StelObjectMgr;
@@ -83,6 +104,7 @@ class ClientSelectionHandler : public ClientHandler
 public:
 	ClientSelectionHandler();
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+	void apply(const SyncProtocol::Selection& msg);
 private:
 	StelObjectMgr* objMgr;
 };
@@ -93,28 +115,77 @@ class ClientStelPropertyUpdateHandler : public ClientHandler
 public:
 	ClientStelPropertyUpdateHandler(bool skipGuiProps, const QStringList& excludeProps);
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+	void apply(const SyncProtocol::StelPropertyUpdate& msg);
 private:
 	StelPropertyMgr* propMgr;
 	QRegularExpression filter;
 };
 
 class StelMovementMgr;
+//! Applies the view direction. While the server's view is moving, the timestamps of the frames
+//! are used to extrapolate the view between the received packets.
 class ClientViewHandler : public ClientHandler
 {
 public:
-	ClientViewHandler();
+	ClientViewHandler(SyncClient* client);
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+	//! @param serverTime the server time of the frame containing the view, or 0 if unknown
+	void apply(const SyncProtocol::View& msg, qint64 serverTime = 0);
+	//! Called once per frame, extrapolates the view while it is moving.
+	//! The extrapolation ends when no sample arrived within twice the interval of the previous ones.
+	void update();
 private:
 	StelMovementMgr* mvMgr;
+	Vec3d lastView;
+	Vec3d viewVelocity; //change of the alt/az view vector per ms
+	qint64 lastViewTime;
+	qint64 sampleInterval; //time between the last two samples in ms
+	bool isMoving;
 };
 
+//! Applies the fov, extrapolating it between packets like ClientViewHandler
 class ClientFovHandler : public ClientHandler
 {
 public:
-	ClientFovHandler();
+	ClientFovHandler(SyncClient* client);
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+	void apply(const SyncProtocol::Fov& msg, qint64 serverTime = 0);
+	void update();
 private:
 	StelMovementMgr* mvMgr;
+	double lastFov;
+	double fovVelocity; //change of the fov in degrees per ms
+	qint64 lastFovTime;
+	qint64 sampleInterval;
+	bool isMoving;
+};
+
+//! Applies the fields of a frame using the handlers of the single message types.
+//! Handlers of state that is not synchronized by this client are NULL.
+class ClientFrameHandler : public ClientHandler
+{
+public:
+	ClientFrameHandler(ClientTimeHandler* timeHandler, ClientLocationHandler* locationHandler, ClientSelectionHandler* selectionHandler,
+			   ClientStelPropertyUpdateHandler* propertyHandler, ClientViewHandler* viewHandler, ClientFovHandler* fovHandler);
+	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+	void apply(const SyncProtocol::Frame& msg);
+	//! Called once per frame, passed on to the handlers which extrapolate state between packets
+	void update();
+private:
+	ClientTimeHandler* timeHandler;
+	ClientLocationHandler* locationHandler;
+	ClientSelectionHandler* selectionHandler;
+	ClientStelPropertyUpdateHandler* propertyHandler;
+	ClientViewHandler* viewHandler;
+	ClientFovHandler* fovHandler;
+};
+
+//! Tries to join the multicast group offered by the server, and replies with the result
+class ClientMulticastHandler : public ClientHandler
+{
+public:
+	ClientMulticastHandler(SyncClient* client);
+	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
 };
 
 #endif
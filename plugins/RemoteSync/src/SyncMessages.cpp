@@ -18,6 +18,7 @@
  */
 
 #include "SyncMessages.hpp"
+#include "StelUtils.hpp"
 
 using namespace SyncProtocol;
 
@@ -213,3 +214,237 @@ bool Fov::deserialize(QDataStream &stream, tPayloadSize dataSize)
 
 	return !stream.status();
 }
+
+//! QDataStream writes floats as doubles by default, so the precision has to be switched to really save the space
+static void writeFloat(QDataStream &stream, float val)
+{
+	stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+	stream<<val;
+	stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+}
+
+static float readFloat(QDataStream &stream)
+{
+	float val;
+	stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+	stream>>val;
+	stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+	return val;
+}
+
+Frame::Frame()
+	: frameNumber(0), serverTime(0), fields(0)
+{
+
+}
+
+void Frame::clear()
+{
+	fields = 0;
+	properties.clear();
+}
+
+Frame Frame::filtered(int fieldMask) const
+{
+	Frame f(*this);
+	f.fields &= (fieldMask | Quantized);
+	if(!f.hasField(FieldProperties))
+		f.properties.clear();
+	return f;
+}
+
+void Frame::merge(const Frame &other, int fieldMask)
+{
+	int mask = other.fields & fieldMask & AllFields;
+	if(mask & FieldTime)
+		time = other.time;
+	if(mask & FieldLocation)
+		location = other.location;
+	if(mask & FieldSelection)
+		selection = other.selection;
+	if(mask & FieldProperties)
+	{
+		foreach(const StelPropertyUpdate& prop, other.properties)
+			set(prop);
+	}
+	if(mask & FieldView)
+		view = other.view;
+	if(mask & FieldFov)
+		fov = other.fov;
+	fields |= mask;
+}
+
+void Frame::set(const Time &msg)
+{
+	time = msg;
+	fields |= FieldTime;
+}
+
+void Frame::set(const Location &msg)
+{
+	location = msg;
+	fields |= FieldLocation;
+}
+
+void Frame::set(const Selection &msg)
+{
+	selection = msg;
+	fields |= FieldSelection;
+}
+
+void Frame::set(const StelPropertyUpdate &msg)
+{
+	fields |= FieldProperties;
+	//only the last value of a property during a frame is relevant
+	for(QVector<StelPropertyUpdate>::iterator it = properties.begin(); it!=properties.end(); ++it)
+	{
+		if(it->propId == msg.propId)
+		{
+			it->value = msg.value;
+			return;
+		}
+	}
+	properties.append(msg);
+}
+
+void Frame::set(const View &msg)
+{
+	view = msg;
+	fields |= FieldView;
+}
+
+void Frame::set(const Fov &msg)
+{
+	fov = msg;
+	fields |= FieldFov;
+}
+
+void Frame::serialize(QDataStream &stream) const
+{
+	stream<<frameNumber;
+	stream<<serverTime;
+	stream<<fields;
+
+	if(hasField(FieldTime))
+		time.serialize(stream);
+	if(hasField(FieldLocation))
+		location.serialize(stream);
+	if(hasField(FieldSelection))
+		selection.serialize(stream);
+	if(hasField(FieldProperties))
+	{
+		stream<<static_cast<quint16>(properties.size());
+		foreach(const StelPropertyUpdate& prop, properties)
+			prop.serialize(stream);
+	}
+	if(hasField(FieldView))
+	{
+		if(hasField(Quantized))
+		{
+			float az, alt;
+			StelUtils::rectToSphe(&az, &alt, view.viewAltAz);
+			writeFloat(stream, az);
+			writeFloat(stream, alt);
+		}
+		else
+			view.serialize(stream);
+	}
+	if(hasField(FieldFov))
+	{
+		if(hasField(Quantized))
+			writeFloat(stream, static_cast<float>(fov.fov));
+		else
+			fov.serialize(stream);
+	}
+}
+
+bool Frame::deserialize(QDataStream &stream, tPayloadSize dataSize)
+{
+	stream>>frameNumber;
+	stream>>serverTime;
+	stream>>fields;
+
+	//the fixed-size fields are read directly, their message classes check the payload size
+	if(hasField(FieldTime))
+		stream>>time.lastTimeSyncTime>>time.jDay>>time.timeRate;
+	if(hasField(FieldLocation))
+		location.deserialize(stream, dataSize);
+	if(hasField(FieldSelection))
+		selection.deserialize(stream, dataSize);
+	properties.clear();
+	if(hasField(FieldProperties))
+	{
+		quint16 count;
+		stream>>count;
+		properties.resize(count);
+		for(int i = 0; i<count; ++i)
+			properties[i].deserialize(stream, dataSize);
+	}
+	if(hasField(FieldView))
+	{
+		if(hasField(Quantized))
+		{
+			float az = readFloat(stream);
+			float alt = readFloat(stream);
+			StelUtils::spheToRect(static_cast<double>(az), static_cast<double>(alt), view.viewAltAz);
+		}
+		else
+			stream>>view.viewAltAz;
+	}
+	if(hasField(FieldFov))
+	{
+		if(hasField(Quantized))
+			fov.fov = readFloat(stream);
+		else
+			stream>>fov.fov;
+	}
+
+	return !stream.status();
+}
+
+MulticastInfo::MulticastInfo()
+	: port(0), sessionId(0), joined(false)
+{
+
+}
+
+void MulticastInfo::serialize(QDataStream &stream) const
+{
+	writeString(stream, groupAddress);
+	stream<<port;
+	stream<<sessionId;
+	stream<<joined;
+}
+
+bool MulticastInfo::deserialize(QDataStream &stream, tPayloadSize dataSize)
+{
+	Q_UNUSED(dataSize);
+	groupAddress = readString(stream);
+	stream>>port;
+	stream>>sessionId;
+	stream>>joined;
+	return !stream.status();
+}
+
+Ping::Ping()
+	: clientTime(0), serverTime(0)
+{
+
+}
+
+void Ping::serialize(QDataStream &stream) const
+{
+	stream<<clientTime;
+	stream<<serverTime;
+}
+
+bool Ping::deserialize(QDataStream &stream, tPayloadSize dataSize)
+{
+	if(dataSize != 2 * sizeof(qint64))
+		return false;
+
+	stream>>clientTime;
+	stream>>serverTime;
+
+	return !stream.status();
+}
@@ -172,6 +172,124 @@ public:
 	double fov;
 };
 
+//! Batches all state changes the server has seen during a single frame into one packet.
+//! Only the fields marked in the field mask are transmitted. With the Quantized flag set,
+//! the view direction is sent as float azimuth/altitude pair and the fov as float instead of doubles,
+//! which still is more accurate than one arc second.
+class Frame : public SyncMessage
+{
+public:
+	enum Field
+	{
+		FieldTime	= 0x01,
+		FieldLocation	= 0x02,
+		FieldSelection	= 0x04,
+		FieldProperties	= 0x08,
+		FieldView	= 0x10,
+		FieldFov	= 0x20,
+		Quantized	= 0x80,
+
+		//! Fields which are changing continuously and may be lost without harm, because they are overwritten by the next change.
+		//! These are sent through the multicast channel, if enabled.
+		ContinuousFields = FieldView | FieldFov,
+		//! Fields which have to be delivered reliably. The time is only sent when it jumps or its rate changes,
+		//! and the clients extrapolate it in between, so a lost time change would never be repaired.
+		ReliableFields = FieldTime | FieldLocation | FieldSelection | FieldProperties,
+		AllFields = ContinuousFields | ReliableFields
+	};
+
+	Frame();
+
+	SyncMessageType getMessageType() const Q_DECL_OVERRIDE { return SyncProtocol::FRAME; }
+
+	void serialize(QDataStream& stream) const Q_DECL_OVERRIDE;
+	bool deserialize(QDataStream &stream, tPayloadSize dataSize) Q_DECL_OVERRIDE;
+
+	QDebug debugOutput(QDebug dbg) const Q_DECL_OVERRIDE
+	{
+		return dbg<<frameNumber<<serverTime<<QString::number(fields,16);
+	}
+
+	//! True if no field is set
+	bool isEmpty() const { return !(fields & AllFields); }
+	bool hasField(Field f) const { return fields & f; }
+	//! Removes all fields
+	void clear();
+	//! Returns a copy of this frame that only contains the specified fields
+	Frame filtered(int fieldMask) const;
+	//! Copies the specified fields of the other frame into this one, replacing current values
+	void merge(const Frame& other, int fieldMask);
+
+	//! Adds the state of the given message to this frame, replacing an earlier state of the same kind.
+	//! Property updates are coalesced by property ID.
+	void set(const Time& msg);
+	void set(const Location& msg);
+	void set(const Selection& msg);
+	void set(const StelPropertyUpdate& msg);
+	void set(const View& msg);
+	void set(const Fov& msg);
+
+	//! Increasing number of the frame, may be used to discard outdated frames from an unordered transport
+	quint32 frameNumber;
+	//! The server's system time (ms since epoch) when the frame was sent, used by clients to extrapolate the view
+	qint64 serverTime;
+	//! Combination of the Field values
+	quint8 fields;
+	Time time;
+	Location location;
+	Selection selection;
+	QVector<StelPropertyUpdate> properties;
+	View view;
+	Fov fov;
+};
+
+//! Sent by the server after authentication when frames are also distributed through UDP multicast.
+//! The client replies with the same message. joined is set to true once the client has received a datagram of the group,
+//! the server then stops sending the continuous fields to it through TCP. joined is set to false if the client could not
+//! join the group or stops receiving datagrams, the server then sends the full frames through TCP again.
+class MulticastInfo : public SyncMessage
+{
+public:
+	MulticastInfo();
+
+	SyncMessageType getMessageType() const Q_DECL_OVERRIDE { return SyncProtocol::MULTICAST; }
+
+	void serialize(QDataStream& stream) const Q_DECL_OVERRIDE;
+	bool deserialize(QDataStream &stream, tPayloadSize dataSize) Q_DECL_OVERRIDE;
+
+	QDebug debugOutput(QDebug dbg) const Q_DECL_OVERRIDE
+	{
+		return dbg<<groupAddress<<port<<joined;
+	}
+
+	QString groupAddress;
+	quint16 port;
+	//! Random value prefixed to each datagram of this server session, to filter out foreign datagrams
+	quint32 sessionId;
+	bool joined;
+};
+
+//! NTP-like clock synchronization message. The client sends it with its current system time,
+//! the server immediately replies with the same message, with its current system time added.
+class Ping : public SyncMessage
+{
+public:
+	Ping();
+
+	SyncMessageType getMessageType() const Q_DECL_OVERRIDE { return SyncProtocol::PING; }
+
+	void serialize(QDataStream& stream) const Q_DECL_OVERRIDE;
+	bool deserialize(QDataStream &stream, tPayloadSize dataSize) Q_DECL_OVERRIDE;
+
+	QDebug debugOutput(QDebug dbg) const Q_DECL_OVERRIDE
+	{
+		return dbg<<clientTime<<serverTime;
+	}
+
+	qint64 clientTime; //client system time in ms since epoch when the ping was sent
+	qint64 serverTime; //server system time in ms since epoch when the ping was answered
+};
+
 }
 
 #endif
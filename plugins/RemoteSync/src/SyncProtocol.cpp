@@ -102,7 +102,7 @@ QString SyncMessage::readString(QDataStream &stream)
 }
 
 SyncRemotePeer::SyncRemotePeer(QAbstractSocket *socket, bool isServer, const QVector<SyncMessageHandler *> &handlerList)
-	: sock(socket), stream(sock), expectDisconnect(false), isPeerAServer(isServer), authenticated(false), authResponseSent(false), waitingForBody(false),
+	: sock(socket), stream(sock), expectDisconnect(false), isPeerAServer(isServer), authenticated(false), authResponseSent(false), receivesMulticast(false), waitingForBody(false),
 	  handlerList(handlerList)
 {
 	Q_ASSERT(sock);
@@ -32,7 +32,7 @@ namespace SyncProtocol
 //Important: All data should use the sized typedefs provided by Qt (i.e. qint32 instead of 4 byte int on x86)
 
 //! Should be changed with every breaking change
-const quint8 SYNC_PROTOCOL_VERSION = 2;
+const quint8 SYNC_PROTOCOL_VERSION = 4;
 const QDataStream::Version SYNC_DATASTREAM_VERSION = QDataStream::Qt_5_0;
 //! Magic value for protocol used during connection. Should NEVER change.
 const QByteArray SYNC_MAGIC_VALUE = "StellariumSyncPluginProtocol";
@@ -55,6 +55,12 @@ const qint64 SYNC_HEADER_SIZE = sizeof(quint8) + sizeof(tPayloadSize); //3 byte
 const qint64 SYNC_MAX_PAYLOAD_SIZE = (2<<15) - 1; // 65535
 const qint64 SYNC_MAX_MESSAGE_SIZE = SYNC_HEADER_SIZE + SYNC_MAX_PAYLOAD_SIZE;
 
+//! Interval in ms in which the server resends the full continuous state through multicast, to repair lost datagrams.
+//! The keyframe is also sent when nothing changes, so that clients can tell that they still receive the group.
+const qint64 SYNC_MULTICAST_KEYFRAME_INTERVAL = 1000;
+//! Time in ms without multicast datagrams after which a client falls back to TCP (a few keyframe intervals)
+const qint64 SYNC_MULTICAST_TIMEOUT = 3 * SYNC_MULTICAST_KEYFRAME_INTERVAL;
+
 //! Contains the possible message types. The enum value is used as an ID to identify the message type over the network.
 //! The classes handling these messages are defined in SyncMessages.hpp
 enum SyncMessageType
@@ -72,8 +78,11 @@ enum SyncMessageType
 	STELPROPERTY, //stelproperty updates
 	VIEW, //view change
 	FOV, //fov change
+	FRAME, //all state changes of a single server frame, batched into one packet
+	MULTICAST, //offer (server) or acknowledgement (client) of the UDP multicast frame channel
+	PING, //sent from the client to estimate the clock offset to the server, which replies with its current time
 
-	MSGTYPE_MAX = FOV,
+	MSGTYPE_MAX = PING,
 	MSGTYPE_SIZE = MSGTYPE_MAX+1
 };
 
@@ -110,6 +119,15 @@ inline QDebug& operator<<(QDebug& deb, SyncMessageType msg)
 		case SyncProtocol::FOV:
 			deb<<"FOV";
 			break;
+		case SyncProtocol::FRAME:
+			deb<<"FRAME";
+			break;
+		case SyncProtocol::MULTICAST:
+			deb<<"MULTICAST";
+			break;
+		case SyncProtocol::PING:
+			deb<<"PING";
+			break;
 		case SyncProtocol::ALIVE:
 			deb<<"ALIVE";
 			break;
@@ -185,6 +203,9 @@ public:
 	QDebug peerLog() const;
 
 	bool isAuthenticated() const { return authenticated; }
+	//! Only used on the server: true if this client has joined the multicast group, and receives the continuously
+	//! changing frame fields (time, view, fov) through it instead of through its TCP connection.
+	bool isReceivingMulticast() const { return receivesMulticast; }
 	QUuid getID() const { return id; }
 
 	void checkTimeout();
@@ -210,6 +231,7 @@ private:
 	QUuid id; // An ID value, currently not used for anything else than auth. The server always has a NULL UUID.
 	bool authenticated; // True if the peer ran through the HELLO process and can receive/send all message types
 	bool authResponseSent; //only for client use, tracks if the client has sent a resonse to the server challenge
+	bool receivesMulticast; //only for server use, tracks if the client has acknowledged the multicast frame channel
 	bool waitingForBody; //True if waiting for full message body (after header was received)
 	SyncProtocol::SyncHeader msgHeader; //the last message header read/currently being processed
 	qint64 lastReceiveTime; // The time the last data of this peer was received
@@ -219,6 +241,7 @@ private:
 
 	friend class ServerAuthHandler;
 	friend class ClientAuthHandler;
+	friend class ServerMulticastHandler;
 };
 
 //! Base interface for message handlers, i.e. reacting to messages
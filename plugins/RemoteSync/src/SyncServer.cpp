@@ -25,14 +25,19 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QTimerEvent>
+#include <QUdpSocket>
 
 
 Q_LOGGING_CATEGORY(syncServer,"stel.plugin.remoteSync.server")
 
 using namespace SyncProtocol;
 
+//! Frames with more property changes than this are split up, to stay below the maximal message size
+static const int MAX_FRAME_PROPERTIES = 64;
+
 SyncServer::SyncServer(QObject* parent)
-	: QObject(parent), stopping(false), timeoutTimerId(-1)
+	: QObject(parent), multicastSocket(Q_NULLPTR), multicastPort(0), multicastSessionId(0), lastKeyframeTime(0),
+	  stopping(false), timeoutTimerId(-1), frameCounter(0), quantizeFrames(false)
 {
 	qserver = new QTcpServer(this);
 	connect(qserver,SIGNAL(newConnection()), this, SLOT(handleNewConnection()));
@@ -43,6 +48,8 @@ SyncServer::SyncServer(QObject* parent)
 	handlerList[ERROR] =  new ServerErrorHandler();
 	handlerList[CLIENT_CHALLENGE_RESPONSE] = new ServerAuthHandler(this, false);
 	handlerList[ALIVE] = new ServerAliveHandler();
+	handlerList[MULTICAST] = new ServerMulticastHandler();
+	handlerList[PING] = new ServerPingHandler();
 }
 
 SyncServer::~SyncServer()
@@ -79,6 +86,16 @@ bool SyncServer::start(int port)
 		addSender(new StelPropertyEventSender());
 		addSender(new ViewEventSender());
 		addSender(new FovEventSender());
+
+		if(!multicastGroup.isNull())
+		{
+			multicastSocket = new QUdpSocket(this);
+			multicastSocket->bind(QHostAddress(QHostAddress::AnyIPv4), 0);
+			//keep the datagrams in the local network
+			multicastSocket->setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
+			multicastSessionId = QUuid::createUuid().data1;
+			qCDebug(syncServer)<<"Sending frames to multicast group"<<multicastGroup.toString()<<"on port"<<multicastPort;
+		}
 	}
 	else
 		qCCritical(syncServer)<<"Error while starting:"<<qserver->errorString();
@@ -92,6 +109,11 @@ void SyncServer::addSender(SyncServerEventSender *snd)
 }
 
 void SyncServer::broadcastMessage(const SyncMessage &msg)
+{
+	broadcastMessage(msg, AllPeers);
+}
+
+void SyncServer::broadcastMessage(const SyncMessage &msg, PeerSelection selection)
 {
 	qCDebug(syncServer)<<"Broadcast message"<<msg;
 	qint64 size = msg.createFullMessage(broadcastBuffer);
@@ -110,7 +132,7 @@ void SyncServer::broadcastMessage(const SyncMessage &msg)
 	for(tClientList::iterator it = clients.begin();it!=clients.end();++it)
 	{
 		SyncRemotePeer* client = *it;
-		if(client->isAuthenticated())
+		if(client->isAuthenticated() && (selection == AllPeers || client->isReceivingMulticast() == (selection == MulticastPeers)))
 		{
 			client->writeData(broadcastBuffer,size);
 		}
@@ -133,6 +155,11 @@ void SyncServer::stop()
 				delete s;
 		}
 		senderList.clear();
+		pendingFrame.clear();
+		keyframe.clear();
+
+		delete multicastSocket;
+		multicastSocket = Q_NULLPTR;
 
 		for(tClientList::iterator it = clients.begin();it!=clients.end(); )
 		{
@@ -153,6 +180,103 @@ void SyncServer::update()
 	{
 		s->update();
 	}
+
+	flushFrame();
+}
+
+void SyncServer::flushFrame()
+{
+	qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
+	//datagrams are sent as soon as a client is connected: clients only confirm the multicast after receiving them
+	bool useMulticast = multicastSocket && hasPeers(AllPeers);
+	bool sendKeyframe = useMulticast && currentTime - lastKeyframeTime >= SYNC_MULTICAST_KEYFRAME_INTERVAL;
+
+	if(pendingFrame.isEmpty() && !sendKeyframe)
+		return;
+
+	pendingFrame.frameNumber = ++frameCounter;
+	pendingFrame.serverTime = currentTime;
+	keyframe.merge(pendingFrame, Frame::ContinuousFields);
+	keyframe.frameNumber = frameCounter;
+	keyframe.serverTime = currentTime;
+	if(quantizeFrames)
+	{
+		pendingFrame.fields |= Frame::Quantized;
+		keyframe.fields |= Frame::Quantized;
+	}
+
+	if(useMulticast)
+	{
+		//clients receiving multicast only get the reliable fields through TCP
+		if(hasPeers(MulticastPeers))
+		{
+			broadcastFrame(pendingFrame, UnicastPeers);
+			broadcastFrame(pendingFrame.filtered(Frame::ReliableFields), MulticastPeers);
+		}
+		else
+			broadcastFrame(pendingFrame, AllPeers);
+
+		if(sendKeyframe)
+		{
+			//the keyframe contains the current continuous fields anyway
+			sendMulticastFrame(keyframe);
+			lastKeyframeTime = currentTime;
+		}
+		else
+		{
+			Frame continuousFrame = pendingFrame.filtered(Frame::ContinuousFields);
+			if(!continuousFrame.isEmpty())
+				sendMulticastFrame(continuousFrame);
+		}
+	}
+	else
+		broadcastFrame(pendingFrame, AllPeers);
+
+	pendingFrame.clear();
+}
+
+void SyncServer::broadcastFrame(const Frame &frame, PeerSelection selection)
+{
+	if(frame.isEmpty())
+		return;
+
+	if(frame.properties.size() > MAX_FRAME_PROPERTIES)
+	{
+		//many properties changed at once (e.g. by a script), send them individually
+		foreach(const StelPropertyUpdate& prop, frame.properties)
+			broadcastMessage(prop, selection);
+		broadcastFrame(frame.filtered(Frame::AllFields & ~Frame::FieldProperties), selection);
+	}
+	else
+		broadcastMessage(frame, selection);
+}
+
+void SyncServer::sendMulticastFrame(const Frame &frame)
+{
+	//the continuous fields are small enough to always fit into a message
+	qint64 size = frame.createFullMessage(broadcastBuffer);
+	Q_ASSERT(size);
+
+	//each datagram contains the session ID, followed by the full message
+	QByteArray datagram;
+	QDataStream stream(&datagram, QIODevice::WriteOnly);
+	stream.setVersion(SYNC_DATASTREAM_VERSION);
+	stream<<multicastSessionId;
+	stream.writeRawData(broadcastBuffer.constData(), size);
+
+	if(multicastSocket->writeDatagram(datagram, multicastGroup, multicastPort) < 0)
+		qCWarning(syncServer)<<"Could not send multicast datagram:"<<multicastSocket->errorString();
+}
+
+bool SyncServer::hasPeers(PeerSelection selection) const
+{
+	for(tClientList::const_iterator it = clients.constBegin(); it!=clients.constEnd(); ++it)
+	{
+		const SyncRemotePeer* client = *it;
+		if(client->isAuthenticated() && (selection == AllPeers || client->isReceivingMulticast() == (selection == MulticastPeers)))
+			return true;
+	}
+	return false;
 }
 
 void SyncServer::timerEvent(QTimerEvent *evt)
@@ -218,6 +342,16 @@ void SyncServer::clientAuthenticated(SyncRemotePeer &peer)
 	{
 		s->newClientConnected(peer);
 	}
+
+	//offer the multicast channel, the client replies if it could join the group
+	if(multicastSocket)
+	{
+		MulticastInfo msg;
+		msg.groupAddress = multicastGroup.toString();
+		msg.port = multicastPort;
+		msg.sessionId = multicastSessionId;
+		peer.writeMessage(msg);
+	}
 }
 
 void SyncServer::clientDisconnected(bool clean)
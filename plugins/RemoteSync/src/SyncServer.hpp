@@ -21,13 +21,16 @@
 #define SYNCSERVER_HPP_
 
 #include "SyncProtocol.hpp"
+#include "SyncMessages.hpp"
 #include <QObject>
+#include <QHostAddress>
 #include <QAbstractSocket>
 #include <QDateTime>
 #include <QLoggingCategory>
 #include <QUuid>
 
 class QTcpServer;
+class QUdpSocket;
 class SyncServerEventSender;
 
 Q_DECLARE_LOGGING_CATEGORY(syncServer)
@@ -46,6 +49,18 @@ public:
 
 	//! Broadcasts this message to all connected and authenticated clients
 	void broadcastMessage(const SyncProtocol::SyncMessage& msg);
+
+	//! The frame collecting all state changes of the current frame.
+	//! It is sent to the clients at the end of update().
+	SyncProtocol::Frame& getPendingFrame() { return pendingFrame; }
+
+	//! If enabled, the view direction and fov are transmitted with reduced (float) precision in frames.
+	//! Must be set before start().
+	void setQuantizeFrames(bool val) { quantizeFrames = val; }
+	//! Enables distribution of the continuously changing frame fields through UDP multicast to the specified group.
+	//! Clients which join the group do not receive these fields through TCP anymore.
+	//! Use a null address to disable multicast. Must be set before start().
+	void setMulticastGroup(const QHostAddress& group, quint16 port) { multicastGroup = group; multicastPort = port; }
 public slots:
 	//! Starts the SyncServer on the specified port. If the server is already running, stops it first.
 	//! Returns true if successful (false usually means port was in use, use getErrorString)
@@ -68,12 +83,33 @@ private slots:
 	void clientDisconnected(bool clean);
 
 private:
+	enum PeerSelection
+	{
+		AllPeers,
+		MulticastPeers,
+		UnicastPeers
+	};
+
 	void addSender(SyncServerEventSender* snd);
+	//! Writes the message to all authenticated clients matching the selection
+	void broadcastMessage(const SyncProtocol::SyncMessage& msg, PeerSelection selection);
+	//! Same as broadcastMessage, but splits up frames with too many property changes
+	void broadcastFrame(const SyncProtocol::Frame& frame, PeerSelection selection);
+	//! Sends the pending frame to the clients, and resets it
+	void flushFrame();
+	void sendMulticastFrame(const SyncProtocol::Frame& frame);
+	//! True if an authenticated client matches the selection
+	bool hasPeers(PeerSelection selection) const;
 	void checkTimeouts();
 	void checkStopState();
 	//use composition instead of inheritance, cleaner interfaace this way
-	//for now, we use TCP, but will test multicast UDP later if the basic setup is working
+	//TCP is used for the connection, frames may additionally be sent through multicast UDP
 	QTcpServer* qserver;
+	QUdpSocket* multicastSocket;
+	QHostAddress multicastGroup;
+	quint16 multicastPort;
+	quint32 multicastSessionId;
+	qint64 lastKeyframeTime;
 	QVector<SyncMessageHandler*> handlerList;
 	QVector<SyncServerEventSender*> senderList;
 
@@ -85,6 +121,13 @@ private:
 
 	QByteArray broadcastBuffer;
 	int timeoutTimerId;
+
+	SyncProtocol::Frame pendingFrame;
+	//the last state of the continuous fields, resent periodically through multicast to repair lost datagrams
+	SyncProtocol::Frame keyframe;
+	quint32 frameCounter;
+	bool quantizeFrames;
+
 	friend class ServerAuthHandler;
 };
 
@@ -41,6 +41,11 @@ void SyncServerEventSender::broadcastMessage(const SyncMessage &msg)
 	server->broadcastMessage(msg);
 }
 
+Frame& SyncServerEventSender::getPendingFrame()
+{
+	return server->getPendingFrame();
+}
+
 TimeEventSender::TimeEventSender()
 {
 	//this is the only event we need to listen to
@@ -121,7 +126,7 @@ void StelPropertyEventSender::sendStelPropChange(StelProperty* prop, const QVari
 		StelPropertyUpdate msg;
 		msg.propId = prop->getId();
 		msg.value = val;
-		broadcastMessage(msg);
+		addToFrame(msg);
 	}
 }
 
@@ -142,7 +147,7 @@ void StelPropertyEventSender::newClientConnected(SyncRemotePeer &client)
 }
 
 ViewEventSender::ViewEventSender()
-	: lastView(0.0)
+	: lastView(0.0), isMoving(false)
 {
 	mvMgr = core->getMovementMgr();
 }
@@ -166,12 +171,18 @@ void ViewEventSender::update()
 	if(!(qFuzzyCompare(viewDir[0], lastView[0]) && qFuzzyCompare(viewDir[1], lastView[1]) && qFuzzyCompare(viewDir[2], lastView[2])))
 	{
 		lastView = viewDir;
-		broadcastMessage(constructMessage());
+		isMoving = true;
+		addToFrame(constructMessage());
+	}
+	else if(isMoving)
+	{
+		isMoving = false;
+		addToFrame(constructMessage());
 	}
 }
 
 FovEventSender::FovEventSender()
-	: lastFov(0.0)
+	: lastFov(0.0), isMoving(false)
 {
 	mvMgr = core->getMovementMgr();
 }
@@ -190,6 +201,12 @@ void FovEventSender::update()
 	if(curFov!=lastFov)
 	{
 		lastFov = curFov;
-		broadcastMessage(constructMessage());
+		isMoving = true;
+		addToFrame(constructMessage());
+	}
+	else if(isMoving)
+	{
+		isMoving = false;
+		addToFrame(constructMessage());
 	}
 }
@@ -55,11 +55,16 @@ protected:
 
 	//! Subclasses can call this to broadcast a message to all valid connected clients
 	void broadcastMessage(const SyncProtocol::SyncMessage& msg);
+	//! Subclasses should call this to add their state change to the frame which is sent at the end of the current update.
+	//! This replaces state of the same kind that has been queued earlier in the frame.
+	template<class T>
+	void addToFrame(const T& msg) { getPendingFrame().set(msg); }
 	//! Free to use by sublasses. Recommendation: use to track if update() should broadcast a message.
 	bool isDirty;
 	//! Direct access to StelCore
 	StelCore* core;
 private:
+	SyncProtocol::Frame& getPendingFrame();
 	SyncServer* server;
 	friend class SyncServer;
 };
@@ -76,7 +81,7 @@ protected:
 	//! Uses constructMessage() to send a message to the new client.
 	virtual void newClientConnected(SyncRemotePeer& client) Q_DECL_OVERRIDE;
 
-	//! If isDirty is true, broadcasts a message to all using constructMessage() and broadcastMessage,
+	//! If isDirty is true, adds a message to the pending frame using constructMessage() and addToFrame,
 	//! and resets isDirty.
 	virtual void update() Q_DECL_OVERRIDE;
 };
@@ -92,7 +97,7 @@ void TypedSyncServerEventSender<T>::update()
 {
 	if(isDirty)
 	{
-		broadcastMessage(constructMessage());
+		addToFrame(constructMessage());
 		isDirty = false;
 	}
 }
@@ -156,6 +161,8 @@ protected:
 private:
 	StelMovementMgr* mvMgr;
 	Vec3d lastView;
+	//true while the view changes, the first unchanged view is sent once more to let clients stop extrapolating
+	bool isMoving;
 };
 
 class FovEventSender : public TypedSyncServerEventSender<SyncProtocol::Fov>
@@ -170,6 +177,7 @@ protected:
 private:
 	StelMovementMgr* mvMgr;
 	double lastFov;
+	bool isMoving;
 };
 
 #endif
@@ -20,6 +20,8 @@
 #include "SyncServerHandlers.hpp"
 #include "SyncServer.hpp"
 
+#include <QDateTime>
+
 using namespace SyncProtocol;
 
 ServerHandler::ServerHandler(SyncServer *server)
@@ -105,3 +107,33 @@ bool ServerAliveHandler::handleMessage(QDataStream &stream, SyncProtocol::tPaylo
 	Alive p;
 	return p.deserialize(stream,dataSize);
 }
+
+bool ServerPingHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
+{
+	Ping msg;
+	bool ok = msg.deserialize(stream, dataSize);
+
+	if(!ok)
+		return false;
+
+	//reply as fast as possible, any processing delay here shows up as clock offset error
+	msg.serverTime = QDateTime::currentMSecsSinceEpoch();
+	peer.writeMessage(msg);
+	return true;
+}
+
+bool ServerMulticastHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
+{
+	MulticastInfo msg;
+	bool ok = msg.deserialize(stream, dataSize);
+
+	if(!ok)
+		return false;
+
+	peer.receivesMulticast = msg.joined;
+	if(msg.joined)
+		peer.peerLog("Client receives frames through multicast");
+	else
+		peer.peerLog("Client does not receive the multicast datagrams, sending frames through TCP");
+	return true;
+}
@@ -58,4 +58,18 @@ public:
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
 };
 
+//! Answers clock synchronization requests of clients
+class ServerPingHandler : public SyncMessageHandler
+{
+public:
+	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+};
+
+//! Receives the reply of a client to the multicast offer
+class ServerMulticastHandler : public SyncMessageHandler
+{
+public:
+	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+};
+
 #endif
@@ -89,8 +89,9 @@ Satellite::Satellite(const QString& identifier, const QVariantMap& map)
 	, pSatWrapper(Q_NULLPTR)
 	, visibility(gSatWrapper::UNKNOWN)
 	, phaseAngle(0.)
-	, lastEpochCompForOrbit(0.)
 	, epochTime(0.)
+	, orbitRingStart(0)
+	, orbitFirstSlot(0)
 {
 	// return initialized if the mandatory fields are not present
 	if (identifier.isEmpty())
@@ -528,171 +529,155 @@ float Satellite::getVMagnitude(const StelCore* core) const
 		{
 			// Calculation of approx. visual magnitude for artificial satellites
 			// described here: http://www.prismnet.com/~mmccants/tles/mccdesc.html
-			double fracil = calculateIlluminatedFraction();
-			if (fracil==0)
-				fracil = 0.000001;
 			if (pSatWrapper && name.startsWith("IRIDIUM"))
 			{
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
 				myText = "";
 #endif
-				Vec3d Sun3d = pSatWrapper->getSunECIPos();
-				QVector3D sun(Sun3d.data()[0],Sun3d.data()[1],Sun3d.data()[2]);
-				QVector3D sunN = sun; sunN.normalize();
+				StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
+				const double  radLatitude    = loc.latitude * KDEG2RAD;
+				const double  theta          = pSatWrapper->getEpoch().toThetaLMST(loc.longitude * KDEG2RAD);
 
+				Vec3d observerECIPos;
+				Vec3d observerECIVel;
+				pSatWrapper->calcObserverECIPosition(observerECIPos, observerECIVel);
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "Sun3d = " + QString("[%1 %2 %3]")
-						.arg(sunN.x())
-						.arg(sunN.y())
-						.arg(sunN.z())
-						+ "<br>\n";
+				myText += "ObsPos = " + observerECIPos.toString() + " (" + observerECIPos.toStringLonLat() + ")<br>\n";
+				myText += "ObsVel = " + observerECIVel.toString() + " (" + observerECIVel.toStringLonLat() + ")<br>\n";
 #endif
-				//static double sin1 = sin(40*M_PI/180);
-				//static double cos1 = cos(40*M_PI/180);
-				//static double sin2 = sin(120*M_PI/180);
-				//static double cos2 = cos(120*M_PI/180);
-				// position, velocity are known
-				QVector3D Vx(velocity.data()[0],velocity.data()[1],velocity.data()[2]); Vx.normalize();
+				sunReflAngle = computeIridiumSunReflectionAngle(position, velocity, pSatWrapper->getSunECIPos(),
+										observerECIPos, radLatitude, theta, elAzPosition);
+				vmag = qMin(stdMag, computeIridiumFlareMagnitude(sunReflAngle));
+			}
+			else // not Iridium
+			{
+				sunReflAngle = -1;
+				vmag = stdMag;
+			}
+
+			vmag = computeVMagnitude(vmag, range, phaseAngle);
+
+		}
+	}
+	return vmag;
+}
+
+double Satellite::computeIridiumSunReflectionAngle(const Vec3d& position, const Vec3d& velocity, const Vec3d& sunECIPos,
+						   const Vec3d& observerECIPos, double radLatitude, double theta, const Vec3d& elAzPosition)
+{
+	QVector3D sun(sunECIPos.data()[0],sunECIPos.data()[1],sunECIPos.data()[2]);
 
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "Vx = " + QString("[%1 %2 %3]")
-						.arg(Vx.x())
-						.arg(Vx.y())
-						.arg(Vx.z())
-						+ "<br>\n";
+	QVector3D sunN = sun; sunN.normalize();
+	myText += "Sun3d = " + QString("[%1 %2 %3]")
+			.arg(sunN.x())
+			.arg(sunN.y())
+			.arg(sunN.z())
+			+ "<br>\n";
 #endif
-				//QVector3D SatPos(position.data()[0],position.data()[1],position.data()[2]);
-				Vec3d vy = (position^velocity);
-				QVector3D Vy(vy.data()[0],vy.data()[1],vy.data()[2]); Vy.normalize();
+	// position, velocity are known
+	QVector3D Vx(velocity.data()[0],velocity.data()[1],velocity.data()[2]); Vx.normalize();
 
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "Vy = " + QString("[%1 %2 %3]")
-						.arg(Vy.x())
-						.arg(Vy.y())
-						.arg(Vy.z())
-						+ "<br>\n";
+	myText += "Vx = " + QString("[%1 %2 %3]")
+			.arg(Vx.x())
+			.arg(Vx.y())
+			.arg(Vx.z())
+			+ "<br>\n";
 #endif
-				QVector3D Vz = QVector3D::crossProduct(Vx,Vy); Vz.normalize();
+	Vec3d vy = (position^velocity);
+	QVector3D Vy(vy.data()[0],vy.data()[1],vy.data()[2]); Vy.normalize();
 
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "Vz = " + QString("[%1 %2 %3]")
-						.arg(Vz.x())
-						.arg(Vz.y())
-						.arg(Vz.z())
-						+ "<br>\n";
+	myText += "Vy = " + QString("[%1 %2 %3]")
+			.arg(Vy.x())
+			.arg(Vy.y())
+			.arg(Vy.z())
+			+ "<br>\n";
 #endif
+	QVector3D Vz = QVector3D::crossProduct(Vx,Vy); Vz.normalize();
 
-				// move this to constructor for optimizing
-				QMatrix4x4 m0;
-				m0.rotate(40, Vy);
-				QVector3D Vx0 = m0.mapVector(Vx);
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "mirror0 = " + QString("[%1 %2 %3]")
-						.arg(Vx0.x())
-						.arg(Vx0.y())
-						.arg(Vx0.z())
-						+ "<br>\n";
+	myText += "Vz = " + QString("[%1 %2 %3]")
+			.arg(Vz.x())
+			.arg(Vz.y())
+			.arg(Vz.z())
+			+ "<br>\n";
 #endif
 
-				QMatrix4x4 m[3];
-				//m[2] = m[1] = m[0];
-				m[0].rotate(0, Vz);
-				m[1].rotate(120, Vz);
-				m[2].rotate(-120, Vz);
-
-				StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
-				const double  radLatitude    = loc.latitude * KDEG2RAD;
-				const double  theta          = pSatWrapper->getEpoch().toThetaLMST(loc.longitude * KDEG2RAD);
-				const double sinRadLatitude=sin(radLatitude);
-				const double cosRadLatitude=cos(radLatitude);
-				const double sinTheta=sin(theta);
-				const double cosTheta=cos(theta);
-
-				Vec3d observerECIPos;
-				Vec3d observerECIVel;
-				pSatWrapper->calcObserverECIPosition(observerECIPos, observerECIVel);
+	// move this to constructor for optimizing
+	QMatrix4x4 m0;
+	m0.rotate(40, Vy);
+	QVector3D Vx0 = m0.mapVector(Vx);
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "ObsPos = " + observerECIPos.toString() + " (" + observerECIPos.toStringLonLat() + ")<br>\n";
-				myText += "ObsVel = " + observerECIVel.toString() + " (" + observerECIVel.toStringLonLat() + ")<br>\n";
+	myText += "mirror0 = " + QString("[%1 %2 %3]")
+			.arg(Vx0.x())
+			.arg(Vx0.y())
+			.arg(Vx0.z())
+			+ "<br>\n";
 #endif
-				sunReflAngle = 180.;
-				QVector3D mirror;
-				for (int i = 0; i<3; i++)
-				{
-					mirror = m[i].mapVector(Vx0);
-					mirror.normalize();
+
+	QMatrix4x4 m[3];
+	m[0].rotate(0, Vz);
+	m[1].rotate(120, Vz);
+	m[2].rotate(-120, Vz);
+
+	const double sinRadLatitude=sin(radLatitude);
+	const double cosRadLatitude=cos(radLatitude);
+	const double sinTheta=sin(theta);
+	const double cosTheta=cos(theta);
+
+	double angle = 180.;
+	QVector3D mirror;
+	for (int i = 0; i<3; i++)
+	{
+		mirror = m[i].mapVector(Vx0);
+		mirror.normalize();
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-					myText += "mirror = " + QString("[%1 %2 %3]")
-							.arg(mirror.x())
-							.arg(mirror.y())
-							.arg(mirror.z())
-							+ "<br>\n";
+		myText += "mirror = " + QString("[%1 %2 %3]")
+				.arg(mirror.x())
+				.arg(mirror.y())
+				.arg(mirror.z())
+				+ "<br>\n";
 #endif
-					// reflection R = 2*(V dot N)*N - V
-					QVector3D rsun =  2*QVector3D::dotProduct(sun,mirror)*mirror - sun;
-					rsun = -rsun;
-					Vec3d rSun(rsun.x(),rsun.y(),rsun.z());
+		// reflection R = 2*(V dot N)*N - V
+		QVector3D rsun =  2*QVector3D::dotProduct(sun,mirror)*mirror - sun;
+		rsun = -rsun;
+		Vec3d rSun(rsun.x(),rsun.y(),rsun.z());
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-					myText += "rSun = " + rSun.toString() + "<br>\n";
+		myText += "rSun = " + rSun.toString() + "<br>\n";
 #endif
 
-					//Vec3d satECIPos  = getTEMEPos();
-					Vec3d slantRange = rSun - observerECIPos;
-					Vec3d topoRSunPos;
-					//top_s
-					topoRSunPos[0] = (sinRadLatitude * cosTheta * slantRange[0]
-							+ sinRadLatitude * sinTheta * slantRange[1]
-							- cosRadLatitude * slantRange[2]);
-					//top_e
-					topoRSunPos[1] = ((-1.0) * sinTheta * slantRange[0]
-							+ cosTheta * slantRange[1]);
-
-					//top_z
-					topoRSunPos[2] = (cosRadLatitude * cosTheta * slantRange[0]
-							+ cosRadLatitude * sinTheta * slantRange[1]
-							+ sinRadLatitude * slantRange[2]);
+		Vec3d slantRange = rSun - observerECIPos;
+		Vec3d topoRSunPos = gSatWrapper::toTopocentric(slantRange, sinRadLatitude, cosRadLatitude, sinTheta, cosTheta);
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-					myText += "SunRefl = " + topoRSunPos.toString() + " (" + topoRSunPos.toStringLonLat() + ")<br>\n";
+		myText += "SunRefl = " + topoRSunPos.toString() + " (" + topoRSunPos.toStringLonLat() + ")<br>\n";
 #endif
-					sunReflAngle = qMin(elAzPosition.angle(topoRSunPos) * KRAD2DEG, sunReflAngle) ;
+		angle = qMin(elAzPosition.angle(topoRSunPos) * KRAD2DEG, angle) ;
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-					myText += QString("Angle = %1").arg(QString::number(sunReflAngle, 'f', 1)) + "<br>";
+		myText += QString("Angle = %1").arg(QString::number(angle, 'f', 1)) + "<br>";
 #endif
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-
-				}
-
-				// very simple flare model
-				double iridiumFlare = 100;
-				if (sunReflAngle<0.5)
-				{
-					iridiumFlare = -8.92 + sunReflAngle*6;
-				}
-				else
-				if (sunReflAngle<0.7)
-				{
-					iridiumFlare = -5.92 + (sunReflAngle-0.5)*10;
-				}
-					else
-				{
-					iridiumFlare = -3.92 + (sunReflAngle-0.7)*5;
-				}
-
-
-				 vmag = qMin(stdMag, iridiumFlare);
-			}
-			else // not Iridium
-			{
-				sunReflAngle = -1;
-				vmag = stdMag;
-			}
+	}
+	return angle;
+}
 
-			vmag = vmag - 15.75 + 2.5 * std::log10(range * range / fracil);
+double Satellite::computeIridiumFlareMagnitude(double sunReflAngle)
+{
+	// very simple flare model
+	if (sunReflAngle<0.5)
+		return -8.92 + sunReflAngle*6;
+	else if (sunReflAngle<0.7)
+		return -5.92 + (sunReflAngle-0.5)*10;
+	else
+		return -3.92 + (sunReflAngle-0.7)*5;
+}
 
-		}
-	}
-	return vmag;
+double Satellite::computeVMagnitude(double stdMag, double range, double phaseAngle)
+{
+	double fracil = (1. + cos(phaseAngle))*0.5;
+	if (fracil==0)
+		fracil = 0.000001;
+	return stdMag - 15.75 + 2.5 * std::log10(range * range / fracil);
 }
 
 // Calculate illumination fraction of artifical satellite
@@ -766,9 +751,21 @@ void Satellite::update(double)
 	if (pSatWrapper && orbitValid)
 	{
 		StelCore* core = StelApp::getInstance().getCore();
+		gSatWrapper::setCommonEpoch(core->getJD());
+		propagate(core);
+
+		// Compute orbit points to draw orbit line.
+		if (orbitValid && orbitDisplayed) computeOrbitPoints();
+	}
+}
+
+void Satellite::propagate(const StelCore* core)
+{
+	if (pSatWrapper && orbitValid)
+	{
 		epochTime = core->getJD(); // + timeShift; // We have "true" JD (UTC) from core, satellites don't need JDE!
 
-		pSatWrapper->setEpoch(epochTime);
+		pSatWrapper->propagate();
 		position                 = pSatWrapper->getTEMEPos();
 		velocity                 = pSatWrapper->getTEMEVel();
 		latLongSubPointPosition  = pSatWrapper->getSubPoint();
@@ -793,9 +790,7 @@ void Satellite::update(double)
 		pSatWrapper->getSlantRange(range, rangeRate);
 		visibility = pSatWrapper->getVisibilityPredict();
 		phaseAngle = pSatWrapper->getPhaseAngle();
-
-		// Compute orbit points to draw orbit line.
-		if (orbitDisplayed) computeOrbitPoints();
+		XYZ = getJ2000EquatorialPos(core);
 	}
 }
 
@@ -809,8 +804,8 @@ double Satellite::getDoppler(double freq) const
 
 void Satellite::recalculateOrbitLines(void)
 {
-	orbitPoints.clear();
-	visibilityPoints.clear();
+	orbitSamples.clear();
+	orbitSampleJDs.clear();
 }
 
 SatFlags Satellite::getFlags() const
@@ -892,7 +887,7 @@ void Satellite::draw(StelCore* core, StelPainter& painter)
 	if (core->getJD()<jdLaunchYearJan1 || qAbs(core->getTimeRate())>=timeRateLimit)
 		return;
 
-	XYZ = getJ2000EquatorialPos(core);
+	// XYZ has been computed by propagate() for this frame
 	StelSkyDrawer* sd = core->getSkyDrawer();
 	Vec3f drawColor = (visibility == gSatWrapper::VISIBLE) ? hintColor : invisibleSatelliteColor; // Use hintColor for visible satellites only
 	painter.setColor(drawColor[0], drawColor[1], drawColor[2], hintBrightness);
@@ -954,25 +949,33 @@ void Satellite::drawOrbit(StelCore *core, StelPainter& painter)
 {
 	Vec3d position, onscreen;
 	Vec3f drawColor;
-	int size = orbitPoints.size();
+	const int size = orbitSamples.size();
+	if (size<2)
+		return;
+
+	// Convert the whole ring at once, for the current location.
+	QVector<Vec3d> altAzPoints;
+	QVector<gSatWrapper::Visibility> visibilityPoints;
+	gSatWrapper::temeToAltAz(orbitSampleJDs, orbitSamples, altAzPoints, visibilityPoints);
 
 	QVector<Vec3d> vertexArray;
 	QVector<Vec4f> colorArray;
 	StelProjectorP prj = painter.getProjector();
 
-	vertexArray.resize(size);
-	colorArray.resize(size);
+	vertexArray.reserve(size);
+	colorArray.reserve(size);
 
 	//Rest of points
 	for (int i=1; i<size; i++)
 	{
-		position = core->altAzToJ2000(orbitPoints[i].toVec3d());
+		const int index = (orbitRingStart + i) % size;
+		position = core->altAzToJ2000(altAzPoints.at(index));
 		position.normalize();
 
 		if (prj->project(position, onscreen)) // check position on the screen
 		{
 			vertexArray.append(position);
-			drawColor = (visibilityPoints[i] == gSatWrapper::VISIBLE) ? orbitColor : invisibleSatelliteColor;
+			drawColor = (visibilityPoints.at(index) == gSatWrapper::VISIBLE) ? orbitColor : invisibleSatelliteColor;
 			colorArray.append(Vec4f(drawColor[0], drawColor[1], drawColor[2], hintBrightness * calculateOrbitSegmentIntensity(i)));
 		}
 	}
@@ -996,94 +999,42 @@ float Satellite::calculateOrbitSegmentIntensity(int segNum)
 
 void Satellite::computeOrbitPoints()
 {
-	gTimeSpan computeInterval(0, 0, 0, orbitLineSegmentDuration);
-	gTimeSpan orbitSpan(0, 0, 0, orbitLineSegments*orbitLineSegmentDuration/2);
-	gTime epochTm;
-	gTime epoch(epochTime);
-	gTime lastEpochComp(lastEpochCompForOrbit);
-	Vec3d elAzVector;
-	int diffSlots;
-
-
-	if (orbitPoints.isEmpty())//Setup orbitPoins
-	{
-		epochTm  = epoch - orbitSpan;
-
-		for (int i=0; i<=orbitLineSegments; i++)
-		{
-			pSatWrapper->setEpoch(epochTm.getGmtTm());
-			elAzVector  = pSatWrapper->getAltAz();
-			orbitPoints.append(elAzVector);
-			visibilityPoints.append(pSatWrapper->getVisibilityPredict());
-			epochTm    += computeInterval;
-		}
-		lastEpochCompForOrbit = epochTime;
+	const int capacity = orbitLineSegments + 1;
+	const double slotsPerDay = static_cast<double>(KSEC_PER_DAY) / orbitLineSegmentDuration;
+	const qint64 firstSlot = static_cast<qint64>(std::floor(epochTime*slotsPerDay + 0.5)) - orbitLineSegments/2;
+
+	if (orbitSamples.size() != capacity || qAbs(firstSlot - orbitFirstSlot) >= capacity)
+	{ // (re)fill the whole ring after a setup or a jump of the clock
+		orbitSamples.resize(capacity);
+		orbitSampleJDs.resize(capacity);
+		orbitRingStart = 0;
+		orbitFirstSlot = firstSlot;
+		for (int i=0; i<capacity; i++)
+			computeOrbitSample(i, firstSlot + i);
+		return;
 	}
-	else if (epochTime > lastEpochCompForOrbit)
-	{ // compute next orbit point when clock runs forward
-
-		gTimeSpan diffTime = epoch - lastEpochComp;
-		diffSlots          = (int)(diffTime.getDblSeconds()/orbitLineSegmentDuration);
-
-		if (diffSlots > 0)
-		{
-			if (diffSlots > orbitLineSegments)
-			{
-				diffSlots = orbitLineSegments + 1;
-				epochTm  = epoch - orbitSpan;
-			}
-			else
-			{
-				epochTm   = lastEpochComp + orbitSpan + computeInterval;
-			}
 
-			for (int i=0; i<diffSlots; i++)
-			{
-				//remove points at beginning of list and add points at end.
-				orbitPoints.removeFirst();
-				visibilityPoints.removeFirst();
-				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
-				orbitPoints.append(elAzVector);
-				visibilityPoints.append(pSatWrapper->getVisibilityPredict());
-				epochTm    += computeInterval;
-			}
-
-			lastEpochCompForOrbit = epochTime;
-		}
+	while (orbitFirstSlot < firstSlot)
+	{ // clock runs forward: the earliest sample becomes the latest one
+		computeOrbitSample(orbitRingStart, orbitFirstSlot + capacity);
+		orbitRingStart = (orbitRingStart + 1) % capacity;
+		orbitFirstSlot++;
 	}
-	else if (epochTime < lastEpochCompForOrbit)
-	{ // compute next orbit point when clock runs backward
-		gTimeSpan diffTime = lastEpochComp - epoch;
-		diffSlots          = (int)(diffTime.getDblSeconds()/orbitLineSegmentDuration);
-
-		if (diffSlots > 0)
-		{
-			if (diffSlots > orbitLineSegments)
-			{
-				diffSlots = orbitLineSegments + 1;
-				epochTm   = epoch + orbitSpan;
-			}
-			else
-			{
-				epochTm   = epoch - orbitSpan - computeInterval;
-			}
-			for (int i=0; i<diffSlots; i++)
-			{ //remove points at end of list and add points at beginning.
-				orbitPoints.removeLast();
-				visibilityPoints.removeLast();
-				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
-				orbitPoints.push_front(elAzVector);
-				visibilityPoints.push_front(pSatWrapper->getVisibilityPredict());
-				epochTm -= computeInterval;
-
-			}
-			lastEpochCompForOrbit = epochTime;
-		}
+	while (orbitFirstSlot > firstSlot)
+	{ // clock runs backward: the latest sample becomes the earliest one
+		orbitRingStart = (orbitRingStart + capacity - 1) % capacity;
+		orbitFirstSlot--;
+		computeOrbitSample(orbitRingStart, orbitFirstSlot);
 	}
 }
 
+void Satellite::computeOrbitSample(int index, qint64 slot)
+{
+	const double jd = static_cast<double>(slot) * orbitLineSegmentDuration / KSEC_PER_DAY;
+	orbitSampleJDs[index] = jd;
+	orbitSamples[index] = pSatWrapper->getTEMEPosAt(jd);
+}
+
 
 bool operator <(const SatelliteP& left, const SatelliteP& right)
 {
@@ -207,12 +207,30 @@ public:
 	//! Calculation of illuminated fraction of the satellite.
 	float calculateIlluminatedFraction() const;
 
+	//! Angle (degrees) between the satellite and the nearest reflection of the Sun by one of the three main
+	//! mission antennas of an Iridium satellite, as seen by the observer. Positions and velocity are in km
+	//! and km/s in the ECI (TEME) frame, elAzPosition is the topocentric position of the satellite.
+	static double computeIridiumSunReflectionAngle(const Vec3d& position, const Vec3d& velocity, const Vec3d& sunECIPos,
+						       const Vec3d& observerECIPos, double radLatitude, double theta, const Vec3d& elAzPosition);
+	//! Standard magnitude of an Iridium flare for a given Sun reflection angle (degrees).
+	static double computeIridiumFlareMagnitude(double sunReflAngle);
+	//! Visual magnitude of a sunlit satellite of standard magnitude stdMag at range (km) and phase angle (radians).
+	static double computeVMagnitude(double stdMag, double range, double phaseAngle);
+
 	//! Get operational status of satellite
 	QString getOperationalStatus() const;
 
 private:
+	//! Compute the position and visibility at the epoch set by gSatWrapper::setCommonEpoch() (the date of core).
+	//! Only modifies this object, see Satellites::update(). The orbit points are not computed.
+	void propagate(const StelCore* core);
+
 	//draw orbits methods
+	//! Slide the ring buffer of orbit samples to be centred on epochTime, propagating only the new samples.
+	//! Only modifies this object, like propagate().
 	void computeOrbitPoints();
+	//! Propagate the orbit sample at index of the ring buffer to the date of slot.
+	void computeOrbitSample(int index, qint64 slot);
 	void drawOrbit(StelCore* core, StelPainter& painter);
 	//! returns 0 - 1.0 for the DRAWORBIT_FADE_NUMBER segments at
 	//! each end of an orbit, with 1 in the middle.
@@ -301,10 +319,14 @@ private:
 	//Satellite Orbit Draw
 	QFont     font;
 	Vec3f    orbitColor;
-	double    lastEpochCompForOrbit; //measured in Julian Days
 	double    epochTime;  //measured in Julian Days
-	QList<Vec3d> orbitPoints; //orbit points represented by ElAzPos vectors
-	QList<gSatWrapper::Visibility> visibilityPoints; //orbit visibility points
+	//! Ring buffer of the orbit samples, taken every orbitLineSegmentDuration seconds (slots since JD 0).
+	//! The positions are kept in TEME, which does not depend on the observer, and are converted
+	//! to alt/az for the whole orbit line in drawOrbit().
+	QVector<Vec3d> orbitSamples;
+	QVector<double> orbitSampleJDs;
+	int       orbitRingStart; //index of the earliest sample
+	qint64    orbitFirstSlot; //slot of the earliest sample
 };
 
 typedef QSharedPointer<Satellite> SatelliteP;
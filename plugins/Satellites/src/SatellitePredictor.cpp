@@ -0,0 +1,434 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "SatellitePredictor.hpp"
+#include "Satellite.hpp"
+#include "SolarSystem.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelUtils.hpp"
+
+#include "gsatellite/gSatTEME.hpp"
+#include "gsatellite/gTime.hpp"
+#include "gsatellite/stdsat.h"
+
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	float southAzimuth(float azimuth)
+	{
+		azimuth += M_PI;
+		if (azimuth >= M_PI*2)
+			azimuth -= M_PI*2;
+		return azimuth;
+	}
+
+	bool isInInterval(const IridiumFlaresPrediction& flare, double startJD, double endJD)
+	{
+		return flare.JD >= startJD && flare.JD <= endJD;
+	}
+
+	bool isInInterval(const SatellitePass& pass, double startJD, double endJD)
+	{
+		return pass.setJD >= startJD && pass.riseJD <= endJD;
+	}
+}
+
+SatellitePredictor::SatellitePredictor()
+	: generation(0)
+{
+}
+
+SatellitePredictor::~SatellitePredictor()
+{
+	cancel();
+	foreach (QFuture<void> future, running)
+		future.waitForFinished();
+}
+
+void SatellitePredictor::cancel()
+{
+	generation.fetchAndAddOrdered(1);
+}
+
+void SatellitePredictor::addRunning(const QFuture<void>& future)
+{
+	for (int i=running.size()-1; i>=0; i--)
+	{
+		if (running.at(i).isFinished())
+			running.removeAt(i);
+	}
+	running.append(future);
+}
+
+void SatellitePredictor::clearCache()
+{
+	QMutexLocker locker(&cacheMutex);
+	flaresCache.clear();
+	passesCache.clear();
+}
+
+SatellitePredictor::Request SatellitePredictor::makeRequest(StelCore* core, double startJD, double endJD) const
+{
+	Request request;
+	request.context = EphemerisContext(core);
+	request.sun = GETSTELMODULE(SolarSystem)->getSun();
+	request.location = core->getCurrentLocation();
+	request.locationKey = QString("%1|%2|%3|%4")
+			.arg(request.location.planetName)
+			.arg(request.location.latitude, 0, 'f', 6)
+			.arg(request.location.longitude, 0, 'f', 6)
+			.arg(request.location.altitude);
+	request.startJD = startJD;
+	request.endJD = qMax(startJD, endJD);
+	request.useSouthAzimuth = StelApp::getInstance().getFlagSouthAzimuthUsage();
+	request.generation = generation.load();
+	const double firstHour = std::floor(request.startJD*24.);
+	const int hours = (int)(std::floor(request.endJD*24.) - firstHour) + 1;
+	for (int i=0; i<hours; i++)
+		request.utcOffsets.append(core->getUTCOffset((firstHour + i)/24.));
+	return request;
+}
+
+double SatellitePredictor::Request::getUTCOffset(double JD) const
+{
+	const int i = (int)(std::floor(JD*24.) - std::floor(startJD*24.));
+	return utcOffsets.at(qBound(0, i, utcOffsets.size() - 1));
+}
+
+QString SatellitePredictor::getCacheKey(const SatelliteData& satellite, const Request& request)
+{
+	// The epoch of the element set is in columns 19-32 of the first line
+	return QString("%1|%2|%3").arg(satellite.id, QString::fromLatin1(satellite.tle1.mid(18, 14)), request.locationKey);
+}
+
+Vec3d SatellitePredictor::SunTable::at(double JD) const
+{
+	const double x = (JD - startJD) / step;
+	const int i = qBound(0, (int)std::floor(x), positions.size() - 2);
+	const double f = x - i;
+	return positions.at(i) + (positions.at(i+1) - positions.at(i)) * f;
+}
+
+SatellitePredictor::SunTable SatellitePredictor::computeSunTable(const Request& request) const
+{
+	SunTable table;
+	table.startJD = request.startJD;
+	table.step = 1./24.;
+	const int count = (int)std::ceil((request.endJD - request.startJD) / table.step) + 2;
+	table.positions.resize(count);
+	// AU to km, like gSatWrapper::updateSunECIPos()
+	for (int i=0; i<count; i++)
+		table.positions[i] = request.context.getEquinoxEquatorialPos(request.sun.data(), table.startJD + i*table.step) * AU;
+	return table;
+}
+
+SatellitePredictor::Sample SatellitePredictor::computeSample(gSatTEME& satellite, const SatelliteData& data, bool iridium,
+							   const Request& request, const SunTable& sunTable, double JD)
+{
+	satellite.setEpoch(JD);
+	const gVector pos = satellite.getPos();
+	const gVector vel = satellite.getVel();
+	const Vec3d position(pos[0], pos[1], pos[2]);
+	const Vec3d velocity(vel[0], vel[1], vel[2]);
+
+	// Same frames and visibility conditions as gSatWrapper, for the date of the sample.
+	const double radLatitude    = request.location.latitude * KDEG2RAD;
+	const double theta          = gTime(JD).toThetaLMST(request.location.longitude * KDEG2RAD);
+	const double sinRadLatitude = sin(radLatitude);
+	const double cosRadLatitude = cos(radLatitude);
+	const double sinTheta       = sin(theta);
+	const double cosTheta       = cos(theta);
+	const Vec3d observerPos = gSatWrapper::computeObserverECIPos(request.location, theta);
+	const Vec3d sunPos = sunTable.at(JD) + observerPos;
+	const Vec3d altAz = gSatWrapper::toTopocentric(position - observerPos, sinRadLatitude, cosRadLatitude, sinTheta, cosTheta);
+
+	Sample sample;
+	sample.JD = JD;
+	sample.altitude = altAz.latitude();
+	sample.azimuth = M_PI - altAz.longitude();
+	if (sample.azimuth < 0.)
+		sample.azimuth += 2.*M_PI;
+	else if (sample.azimuth >= 2.*M_PI)
+		sample.azimuth -= 2.*M_PI;
+	sample.sunReflAngle = -1.;
+	sample.magnitude = 17.;
+
+	if (altAz[2] <= 0)
+		sample.visibility = gSatWrapper::NOT_VISIBLE;
+	else if (gSatWrapper::toTopocentric(sunPos - observerPos, sinRadLatitude, cosRadLatitude, sinTheta, cosTheta)[2] > 0.0)
+		sample.visibility = gSatWrapper::RADAR_SUN;
+	else
+	{
+		double sunSatAngle = sunPos.angle(position);
+		double Dist = position.length()*cos(sunSatAngle - (M_PI/2));
+		sample.visibility = (Dist > KEARTHRADIUS) ? gSatWrapper::VISIBLE : gSatWrapper::RADAR_NIGHT;
+	}
+
+	if (sample.visibility == gSatWrapper::VISIBLE && data.stdMag != 99.)
+	{
+		double mag = data.stdMag;
+		if (iridium)
+		{
+			sample.sunReflAngle = Satellite::computeIridiumSunReflectionAngle(position, velocity, sunPos, observerPos, radLatitude, theta, altAz);
+			mag = qMin(mag, Satellite::computeIridiumFlareMagnitude(sample.sunReflAngle));
+		}
+		sample.magnitude = Satellite::computeVMagnitude(mag, (position - observerPos).length(), sunPos.angle(position));
+	}
+	return sample;
+}
+
+IridiumFlaresPredictionList SatellitePredictor::findIridiumFlares(const SatelliteData& data, const Request& request, const SunTable& sunTable) const
+{
+	IridiumFlaresPredictionList flares;
+	QByteArray t1(data.tle1), t2(data.tle2);
+	t1.truncate(130);
+	t2.truncate(130);
+	gSatTEME satellite(data.name.toLatin1().data(), t1.data(), t2.data());
+
+	double JD = request.startJD;
+	Sample previous = computeSample(satellite, data, true, request, sunTable, JD);
+	bool flareFound = false;
+	while (JD < request.endJD && !isCancelled(request))
+	{
+		// Slow down when the satellite is close to a reflection
+		if (flareFound)
+			JD += 1./24;
+		else if (previous.altitude < 0)
+			JD += qMax(-previous.altitude*KRAD2DEG, 1.) / 5600;
+		else if (previous.sunReflAngle > 0)
+			JD += qMax(previous.sunReflAngle, 1.) / (4*86400);
+		else
+			JD += 0.25/1440; // in daylight or eclipsed, assuming 1/4 minute to leave this
+
+		const Sample sample = computeSample(satellite, data, true, request, sunTable, JD);
+		// The satellite was at its brightest at the previous sample
+		flareFound = sample.magnitude > previous.magnitude
+			  && previous.magnitude < 1. // brighness limit
+			  && previous.sunReflAngle > 0.
+			  && previous.sunReflAngle < 2.;
+		if (flareFound)
+		{
+			IridiumFlaresPrediction flare;
+			flare.JD        = previous.JD;
+			flare.satellite = data.name;
+			flare.azimuth   = previous.azimuth;
+			flare.altitude  = previous.altitude;
+			flare.magnitude = previous.magnitude;
+			flares.append(flare);
+		}
+		previous = sample;
+		if (flareFound)
+			previous.magnitude = 17.; // block extra report
+	}
+	return flares;
+}
+
+SatellitePassList SatellitePredictor::findPasses(const SatelliteData& data, const Request& request, const SunTable& sunTable) const
+{
+	static const double passStep = 10./86400.; // while above the horizon
+
+	SatellitePassList passes;
+	QByteArray t1(data.tle1), t2(data.tle2);
+	t1.truncate(130);
+	t2.truncate(130);
+	gSatTEME satellite(data.name.toLatin1().data(), t1.data(), t2.data());
+
+	SatellitePass pass;
+	const auto updatePass = [&pass, &data](const Sample& sample) {
+		if (sample.altitude > pass.maxAltitude)
+		{
+			pass.maxAltitude = sample.altitude;
+			pass.culminationJD = sample.JD;
+		}
+		if (sample.visibility == gSatWrapper::VISIBLE)
+		{
+			pass.visible = true;
+			if (data.stdMag != 99.)
+				pass.magnitude = qMin(pass.magnitude, (float)sample.magnitude);
+		}
+	};
+	const auto startPass = [&pass, &data, &updatePass](const Sample& sample) {
+		pass.id = data.id;
+		pass.satellite = data.name;
+		pass.riseJD = pass.culminationJD = pass.setJD = sample.JD;
+		pass.riseAzimuth = pass.setAzimuth = sample.azimuth;
+		pass.maxAltitude = sample.altitude;
+		pass.magnitude = 99.f;
+		pass.visible = false;
+		updatePass(sample);
+	};
+	const auto endPass = [&pass, &passes, &updatePass](const Sample& sample) {
+		updatePass(sample);
+		pass.setJD = sample.JD;
+		pass.setAzimuth = sample.azimuth;
+		passes.append(pass);
+	};
+	// Bisection to one second between two samples on both sides of the horizon
+	const auto findHorizon = [&](Sample before, Sample after) -> Sample {
+		const bool afterAbove = after.altitude > 0;
+		while (after.JD - before.JD > 1./86400.)
+		{
+			const Sample middle = computeSample(satellite, data, false, request, sunTable, (before.JD + after.JD)/2);
+			if ((middle.altitude > 0) == afterAbove)
+				after = middle;
+			else
+				before = middle;
+		}
+		return after;
+	};
+
+	double JD = request.startJD;
+	Sample sample = computeSample(satellite, data, false, request, sunTable, JD);
+	bool inPass = sample.altitude > 0;
+	if (inPass)
+		startPass(sample);
+	while (JD < request.endJD && !isCancelled(request))
+	{
+		// Below the horizon, the step is short enough for the altitude of low orbits to change by less than the distance to the horizon
+		const double step = inPass ? passStep : qMax(-sample.altitude*KRAD2DEG, 1.) / 11520.;
+		JD = qMin(JD + step, request.endJD);
+		const Sample next = computeSample(satellite, data, false, request, sunTable, JD);
+		if (!inPass && next.altitude > 0)
+		{
+			startPass(findHorizon(sample, next));
+			updatePass(next);
+			inPass = true;
+		}
+		else if (inPass && next.altitude <= 0)
+		{
+			endPass(findHorizon(sample, next));
+			inPass = false;
+		}
+		else if (inPass)
+			updatePass(next);
+		sample = next;
+	}
+	if (inPass)
+		endPass(sample);
+	return passes;
+}
+
+template<class T> bool SatellitePredictor::getCached(const QHash<QString, CacheEntry<T> >& cache, const QString& key, const Request& request, QList<T>& results) const
+{
+	QMutexLocker locker(&cacheMutex);
+	typename QHash<QString, CacheEntry<T> >::const_iterator it = cache.constFind(key);
+	if (it == cache.constEnd() || it->startJD > request.startJD || it->endJD < request.endJD)
+		return false;
+	results.clear();
+	foreach (const T& result, it->results)
+	{
+		if (isInInterval(result, request.startJD, request.endJD))
+			results.append(result);
+	}
+	return true;
+}
+
+template<class T> void SatellitePredictor::putCached(QHash<QString, CacheEntry<T> >& cache, const QString& key, const Request& request, const QList<T>& results)
+{
+	QMutexLocker locker(&cacheMutex);
+	CacheEntry<T>& entry = cache[key];
+	entry.startJD = request.startJD;
+	entry.endJD = request.endJD;
+	entry.results = results;
+}
+
+QFuture<IridiumFlaresPredictionList> SatellitePredictor::predictIridiumFlares(StelCore* core, const QList<SatelliteData>& satellites, double startJD, double endJD)
+{
+	const Request request = makeRequest(core, startJD, endJD);
+	QFuture<IridiumFlaresPredictionList> future = QtConcurrent::run([this, request, satellites]() {
+		QVector<IridiumFlaresPredictionList> results(satellites.size());
+		QVector<int> missing;
+		for (int i=0; i<satellites.size(); i++)
+		{
+			if (!getCached(flaresCache, getCacheKey(satellites.at(i), request), request, results[i]))
+				missing.append(i);
+		}
+		if (!missing.isEmpty())
+		{
+			const SunTable sunTable = computeSunTable(request);
+			QtConcurrent::blockingMap(missing, [&](const int& i) {
+				results[i] = findIridiumFlares(satellites.at(i), request, sunTable);
+				if (!isCancelled(request))
+					putCached(flaresCache, getCacheKey(satellites.at(i), request), request, results.at(i));
+			});
+		}
+
+		IridiumFlaresPredictionList flares;
+		foreach (const IridiumFlaresPredictionList& list, results)
+			flares.append(list);
+		std::sort(flares.begin(), flares.end(), [](const IridiumFlaresPrediction& a, const IridiumFlaresPrediction& b) {return a.JD < b.JD;});
+		for (int i=0; i<flares.size(); i++)
+		{
+			IridiumFlaresPrediction& flare = flares[i];
+			flare.datetime = StelUtils::julianDayToISO8601String(flare.JD + request.getUTCOffset(flare.JD)/24.);
+			if (request.useSouthAzimuth)
+				flare.azimuth = southAzimuth(flare.azimuth);
+		}
+		return flares;
+	});
+	addRunning(QFuture<void>(future));
+	return future;
+}
+
+QFuture<SatellitePassList> SatellitePredictor::predictPasses(StelCore* core, const QList<SatelliteData>& satellites, double startJD, double endJD)
+{
+	const Request request = makeRequest(core, startJD, endJD);
+	QFuture<SatellitePassList> future = QtConcurrent::run([this, request, satellites]() {
+		QVector<SatellitePassList> results(satellites.size());
+		QVector<int> missing;
+		for (int i=0; i<satellites.size(); i++)
+		{
+			if (!getCached(passesCache, getCacheKey(satellites.at(i), request), request, results[i]))
+				missing.append(i);
+		}
+		if (!missing.isEmpty())
+		{
+			const SunTable sunTable = computeSunTable(request);
+			QtConcurrent::blockingMap(missing, [&](const int& i) {
+				results[i] = findPasses(satellites.at(i), request, sunTable);
+				if (!isCancelled(request))
+					putCached(passesCache, getCacheKey(satellites.at(i), request), request, results.at(i));
+			});
+		}
+
+		SatellitePassList passes;
+		foreach (const SatellitePassList& list, results)
+			passes.append(list);
+		std::sort(passes.begin(), passes.end(), [](const SatellitePass& a, const SatellitePass& b) {return a.riseJD < b.riseJD;});
+		if (request.useSouthAzimuth)
+		{
+			for (int i=0; i<passes.size(); i++)
+			{
+				passes[i].riseAzimuth = southAzimuth(passes.at(i).riseAzimuth);
+				passes[i].setAzimuth = southAzimuth(passes.at(i).setAzimuth);
+			}
+		}
+		return passes;
+	});
+	addRunning(QFuture<void>(future));
+	return future;
+}
@@ -0,0 +1,187 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _SATELLITEPREDICTOR_HPP_
+#define _SATELLITEPREDICTOR_HPP_
+
+#include "EphemerisContext.hpp"
+#include "StelLocation.hpp"
+#include "VecMath.hpp"
+#include "gSatWrapper.hpp"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+class StelCore;
+class gSatTEME;
+
+//! @ingroup satellites
+struct IridiumFlaresPrediction
+{
+	QString datetime;
+	QString satellite;
+	float azimuth;		// radians
+	float altitude;		// radians
+	float magnitude;
+	double JD;		// UTC
+};
+
+typedef QList<IridiumFlaresPrediction> IridiumFlaresPredictionList;
+
+//! A pass of a satellite above the horizon of the observer.
+//! @ingroup satellites
+struct SatellitePass
+{
+	QString id;
+	QString satellite;
+	double riseJD;		// UTC
+	double culminationJD;	// UTC
+	double setJD;		// UTC
+	float riseAzimuth;	// radians
+	float maxAltitude;	// radians
+	float setAzimuth;	// radians
+	//! Brightest magnitude while the satellite is visible, 99 if it is never visible or its standard magnitude is unknown.
+	float magnitude;
+	//! The satellite is in sunlight while the sky is dark at some time during the pass.
+	bool visible;
+};
+
+typedef QList<SatellitePass> SatellitePassList;
+
+//! @class SatellitePredictor
+//! Predicts the Iridium flares and the passes of satellites without changing the date of the core,
+//! the Solar System or the satellites.
+//! Each satellite is propagated with its own copy of its TLE set and the Sun with an EphemerisContext,
+//! so the predictions run on the global thread pool, one satellite per task.
+//! The results are cached per satellite, TLE epoch and observer location: repeating a prediction,
+//! or asking for a part of a predicted interval, does not compute anything.
+//! @ingroup satellites
+class SatellitePredictor
+{
+public:
+	//! Orbit data of a satellite, copied from the Satellite when a prediction starts.
+	struct SatelliteData
+	{
+		QString id;
+		QString name;
+		QByteArray tle1;
+		QByteArray tle2;
+		double stdMag;
+	};
+
+	SatellitePredictor();
+	//! Cancel the running predictions and wait for them.
+	~SatellitePredictor();
+
+	//! Predict the Iridium flares seen from the current location of core between startJD and endJD (UTC).
+	//! satellites should only contain Iridium satellites. Must be called from the main thread.
+	//! The flares are sorted by date, azimuths follow the south azimuth setting when the prediction starts.
+	QFuture<IridiumFlaresPredictionList> predictIridiumFlares(StelCore* core, const QList<SatelliteData>& satellites, double startJD, double endJD);
+	//! Predict the passes of satellites above the horizon of the current location of core between startJD and endJD (UTC).
+	//! A pass in progress at startJD or endJD starts or ends there. Must be called from the main thread.
+	//! The passes are sorted by rise date.
+	QFuture<SatellitePassList> predictPasses(StelCore* core, const QList<SatelliteData>& satellites, double startJD, double endJD);
+
+	//! Stop the running predictions. Their futures return the results found so far, which are not cached.
+	void cancel();
+	//! Forget all predictions, e.g. after the TLE sets have been updated.
+	void clearCache();
+
+private:
+	//! Observer, Sun and interval of a prediction, taken from the core when it starts
+	struct Request
+	{
+		EphemerisContext context;
+		PlanetP sun;
+		StelLocation location;
+		QString locationKey;
+		double startJD;
+		double endJD;
+		bool useSouthAzimuth;
+		int generation;
+		//! UTC offsets (hours) of the time zone of the core at each whole UTC hour from startJD to endJD,
+		//! as StelCore::getUTCOffset() must not be called from the prediction threads.
+		QVector<double> utcOffsets;
+		double getUTCOffset(double JD) const;
+	};
+
+	//! Positions of the Sun relative to the observer in equatorial coordinates of date (km), interpolated linearly
+	//! between dates one hour apart. The Sun moves by less than 0.05° per hour in this frame.
+	struct SunTable
+	{
+		double startJD;
+		double step;
+		QVector<Vec3d> positions;
+		Vec3d at(double JD) const;
+	};
+
+	//! Circumstances of a satellite at a date
+	struct Sample
+	{
+		double JD;
+		double altitude;	// radians
+		double azimuth;		// radians, from the north to the east
+		gSatWrapper::Visibility visibility;
+		//! see Satellite::computeIridiumSunReflectionAngle(), -1 if not computed
+		double sunReflAngle;
+		//! 17 if the satellite is not visible or its standard magnitude is unknown
+		double magnitude;
+	};
+
+	template<class T> struct CacheEntry
+	{
+		double startJD;
+		double endJD;
+		QList<T> results;
+	};
+
+	Request makeRequest(StelCore* core, double startJD, double endJD) const;
+	//! Remember a started prediction, so that the destructor can wait for it.
+	void addRunning(const QFuture<void>& future);
+	//! Run in the background job of the prediction, before the satellites are processed in parallel.
+	SunTable computeSunTable(const Request& request) const;
+	bool isCancelled(const Request& request) const {return generation.load()!=request.generation;}
+	static QString getCacheKey(const SatelliteData& satellite, const Request& request);
+	static Sample computeSample(gSatTEME& satellite, const SatelliteData& data, bool iridium,
+				    const Request& request, const SunTable& sunTable, double JD);
+
+	//! Follow one satellite through the interval with adaptive steps, see the Iridium flares model in Satellite::getVMagnitude().
+	IridiumFlaresPredictionList findIridiumFlares(const SatelliteData& data, const Request& request, const SunTable& sunTable) const;
+	SatellitePassList findPasses(const SatelliteData& data, const Request& request, const SunTable& sunTable) const;
+
+	//! Take the results of satellite from the cache if they cover the interval of request.
+	template<class T> bool getCached(const QHash<QString, CacheEntry<T> >& cache, const QString& key, const Request& request, QList<T>& results) const;
+	template<class T> void putCached(QHash<QString, CacheEntry<T> >& cache, const QString& key, const Request& request, const QList<T>& results);
+
+	//! Incremented by cancel(), the predictions started with another value stop
+	QAtomicInt generation;
+	mutable QMutex cacheMutex;
+	QHash<QString, CacheEntry<IridiumFlaresPrediction> > flaresCache;
+	QHash<QString, CacheEntry<SatellitePass> > passesCache;
+	QList<QFuture<void> > running;
+};
+
+#endif // _SATELLITEPREDICTOR_HPP_
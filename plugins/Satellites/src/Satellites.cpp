@@ -55,6 +55,7 @@
 #include <QVariant>
 #include <QDir>
 #include <QTemporaryFile>
+#include <QtConcurrent>
 
 StelModule* SatellitesStelPluginInterface::getStelModule() const
 {
@@ -96,6 +97,8 @@ Satellites::Satellites()
 {
 	setObjectName("Satellites");
 	configDialog = new SatellitesDialog();
+	connect(&iridiumFlaresWatcher, SIGNAL(finished()), this, SLOT(iridiumFlaresPredicted()));
+	connect(&satellitePassesWatcher, SIGNAL(finished()), this, SLOT(satellitePassesPredicted()));
 }
 
 void Satellites::deinit()
@@ -814,6 +817,7 @@ void Satellites::setDataMap(const QVariantMap& map)
 		satelliteListModel->beginSatellitesChange();
 	
 	satellites.clear();
+	frameSnapshot.clear();
 	groups.clear();
 	QVariantMap satMap = map.value("satellites").toMap();
 	foreach(const QString& satId, satMap.keys())
@@ -1036,6 +1040,7 @@ void Satellites::remove(const QStringList& idList)
 			
 			qDebug() << "Satellite removed:" << sat->id << sat->name;
 			satellites.removeAt(i);
+			frameSnapshot.clear();
 			i--; //Compensate for the change in the array's indexing
 			numRemoved++;
 		}
@@ -1443,6 +1448,9 @@ void Satellites::updateSatellites(TleDataHash& newTleSets)
 		return;
 	}
 	
+	// The predictions made with the old TLE sets won't be used again.
+	predictor.clearCache();
+
 	if (satelliteListModel)
 		satelliteListModel->beginSatellitesChange();
 	
@@ -1688,6 +1696,7 @@ void Satellites::update(double deltaTime)
 		return;
 
 	StelCore *core = StelApp::getInstance().getCore();
+	frameSnapshot.clear();
 
 	if (qAbs(core->getTimeRate())>=Satellite::timeRateLimit) // Do not show satellites when time rate is over limit
 		return;
@@ -1697,11 +1706,57 @@ void Satellites::update(double deltaTime)
 
 	hintFader.update((int)(deltaTime*1000));
 
+	// The observer and Sun positions shared by all satellites are computed once here,
+	// so propagating each satellite only modifies the satellite itself.
+	const double jd = core->getJD();
+	gSatWrapper::setCommonEpoch(jd);
+
+	FrameSnapshot& snap = frameSnapshot;
 	foreach(const SatelliteP& sat, satellites)
 	{
-		if (sat->initialized && sat->displayed)
-			sat->update(deltaTime);
+		if (sat->initialized && sat->displayed && sat->orbitValid && sat->pSatWrapper && jd>=sat->jdLaunchYearJan1)
+			snap.satellites.append(sat);
+	}
+	const int count = snap.satellites.size();
+	snap.positions.resize(count);
+	snap.orbitDisplayed.resize(count);
+
+	// SGP4 for a few thousand satellites: propagate in chunks on the global thread pool.
+	static const int chunkSize = 256;
+	QVector<int> chunks;
+	for (int i=0; i<count; i+=chunkSize)
+		chunks.append(i);
+	QtConcurrent::blockingMap(chunks, [&snap, core, count](const int& start) {
+		const int end = qMin(start+chunkSize, count);
+		for (int i=start; i<end; ++i)
+		{
+			Satellite* sat = snap.satellites.at(i).data();
+			sat->propagate(core);
+			if (sat->orbitValid && sat->orbitDisplayed)
+				sat->computeOrbitPoints();
+			snap.positions[i] = sat->XYZ;
+			snap.orbitDisplayed[i] = sat->orbitDisplayed;
+		}
+	});
+
+	// Drop the satellites whose orbit decayed.
+	int kept = 0;
+	for (int i=0; i<count; ++i)
+	{
+		const SatelliteP& sat = snap.satellites.at(i);
+		if (!sat->orbitValid)
+			continue;
+		if (kept!=i)
+		{
+			snap.satellites[kept] = sat;
+			snap.positions[kept] = snap.positions.at(i);
+			snap.orbitDisplayed[kept] = snap.orbitDisplayed.at(i);
+		}
+		kept++;
 	}
+	snap.satellites.resize(kept);
+	snap.positions.resize(kept);
+	snap.orbitDisplayed.resize(kept);
 }
 
 void Satellites::draw(StelCore* core)
@@ -1724,10 +1779,12 @@ void Satellites::draw(StelCore* core)
 	painter.setBlending(true);
 	Satellite::hintTexture->bind();
 	Satellite::viewportHalfspace = painter.getProjector()->getBoundingCap();
-	foreach (const SatelliteP& sat, satellites)
+	for (int i=0; i<frameSnapshot.satellites.size(); ++i)
 	{
-		if (sat && sat->initialized && sat->displayed)
-			sat->draw(core, painter);
+		// Satellites out of the viewport have nothing to draw, except for their orbit line.
+		if (!frameSnapshot.orbitDisplayed.at(i) && !Satellite::viewportHalfspace.contains(frameSnapshot.positions.at(i)))
+			continue;
+		frameSnapshot.satellites.at(i)->draw(core, painter);
 	}
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
@@ -1805,241 +1862,104 @@ bool Satellites::isValidRangeDates(const StelCore *core) const
 		return true;
 }
 
-#ifdef _OLD_IRIDIUM_PREDICTIONS
-IridiumFlaresPredictionList Satellites::getIridiumFlaresPrediction()
+QList<SatellitePredictor::SatelliteData> Satellites::getPredictorData(bool iridium, const QStringList& ids) const
 {
-	StelCore* pcore = StelApp::getInstance().getCore();
-	double currentJD = pcore->getJD(); // save current JD
-	bool isTimeNow = pcore->getIsTimeNow();
-	long iJD =currentJD;
-	double JDMidnight = iJD + 0.5 - pcore->getCurrentLocation().longitude / 360.f;
-	double delta = currentJD - JDMidnight;
-
-	pcore->setJD(iJD + 0.5 - pcore->getCurrentLocation().longitude / 360.f);
-	pcore->update(10); // force update to get new coordinates
-
-	IridiumFlaresPredictionList predictions;
-	predictions.clear();
+	QList<SatellitePredictor::SatelliteData> data;
 	foreach(const SatelliteP& sat, satellites)
 	{
-		if (sat->initialized && sat.data()->getEnglishName().startsWith("IRIDIUM"))
-		{
-			double dt  = 0;
-			double angle0 = 100;
-			double lat0 = -1;
-			while (dt<1)
-			{
-				Satellite::timeShift = dt+delta;
-				sat.data()->update(0);
-
-				Vec3d pos = sat.data()->getAltAzPosApparent(pcore);
-				double lat = pos.latitude();
-				double lon = M_PI - pos.longitude();
-				double v =   sat.data()->getVMagnitude(pcore);
-				double angle =  sat.data()->sunReflAngle;
-
-				if (angle>0 && angle<2)
-				{
-					if (angle>angle0 && (v<1) && lat>5*M_PI/180)
-					{
-						IridiumFlaresPrediction flare;
-						flare.datetime = StelUtils::julianDayToISO8601String(currentJD+dt+StelApp::getInstance().getCore()->getUTCOffset(currentJD+dt)/24.f);
-						flare.satellite = sat.data()->getEnglishName();
-						flare.azimuth   = lon;
-						flare.altitude  = lat;
-						flare.magnitude = v;
-
-						predictions.append(flare);
-
-						dt +=0.005;
-					}
-					angle0 = angle;
-				}
-				if (angle>0)
-					dt+=0.000002*angle*angle;
-				else
-				{
-					if (lat0>0 && lat<0)
-						dt+=0.05;
-					else
-						dt+=0.0002;
-				}
-				lat0 = lat;
-			}
-		}
+		if (!sat->initialized || !sat->orbitValid)
+			continue;
+		if (iridium ? !sat->getEnglishName().startsWith("IRIDIUM") : (ids.isEmpty() ? !sat->displayed : !ids.contains(sat->id)))
+			continue;
+		SatellitePredictor::SatelliteData d;
+		d.id = sat->id;
+		d.name = sat->getEnglishName();
+		d.tle1 = sat->tleElements.first;
+		d.tle2 = sat->tleElements.second;
+		d.stdMag = sat->stdMag;
+		data.append(d);
 	}
-	Satellite::timeShift = 0.;
-	if (isTimeNow)
-		pcore->setTimeNow();
-	else
-		pcore->setJD(currentJD);
-
-	return predictions;
+	return data;
 }
-#else
 
-struct SatDataStruct {
-	double nextJD;
-	double angleToSun;
-	double altitude;
-	double azimuth;
-	double v;
-};
+QFuture<IridiumFlaresPredictionList> Satellites::startIridiumFlaresPrediction()
+{
+	StelCore* core = StelApp::getInstance().getCore();
+	const double currentJD = core->getJD();
+	//  investigate what's seen recently, 7 days interval by default
+	return predictor.predictIridiumFlares(core, getPredictorData(true), currentJD - 1., currentJD + getIridiumFlaresPredictionDepth());
+}
 
 IridiumFlaresPredictionList Satellites::getIridiumFlaresPrediction()
 {
-	StelCore* pcore = StelApp::getInstance().getCore();
-	SolarSystem* ssystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
+	return startIridiumFlaresPrediction().result();
+}
 
-	double currentJD = pcore->getJD(); // save current JD
-	bool isTimeNow = pcore->getIsTimeNow();
+QFuture<SatellitePassList> Satellites::startSatellitePassesPrediction(const QStringList& ids, double startJD, double endJD)
+{
+	return predictor.predictPasses(StelApp::getInstance().getCore(), getPredictorData(false, ids), startJD, endJD);
+}
 
-	double predictionJD = currentJD - 1.;  //  investigate what's seen recently// yesterday
-	double predictionEndJD = currentJD + getIridiumFlaresPredictionDepth(); // 7 days interval by default
-	pcore->setJD(predictionJD);
+void Satellites::predictIridiumFlares()
+{
+	iridiumFlaresWatcher.setFuture(startIridiumFlaresPrediction());
+}
 
-	bool useSouthAzimuth = StelApp::getInstance().getFlagSouthAzimuthUsage();
+void Satellites::predictSatellitePasses(const QStringList& ids, double days)
+{
+	const double currentJD = StelApp::getInstance().getCore()->getJD();
+	satellitePassesWatcher.setFuture(startSatellitePassesPrediction(ids, currentJD, currentJD + days));
+}
 
-	IridiumFlaresPredictionList predictions;
+void Satellites::iridiumFlaresPredicted()
+{
+	predictedIridiumFlares = iridiumFlaresWatcher.result();
+	emit iridiumFlaresChanged();
+}
 
-// create a lіst of Iridiums
-	QMap<SatelliteP,SatDataStruct> iridiums;
-	SatDataStruct sds;
-	double nextJD = predictionJD + 1./24;
+void Satellites::satellitePassesPredicted()
+{
+	predictedSatellitePasses = satellitePassesWatcher.result();
+	emit satellitePassesChanged();
+}
 
-	foreach(const SatelliteP& sat, satellites)
+QVariantList Satellites::getIridiumFlares() const
+{
+	QVariantList list;
+	foreach (const IridiumFlaresPrediction& flare, predictedIridiumFlares)
 	{
-		if (sat->initialized && sat.data()->getEnglishName().startsWith("IRIDIUM"))
-		{
-			Vec3d pos = sat.data()->getAltAzPosApparent(pcore);
-			sds.angleToSun = sat.data()->sunReflAngle;
-			sds.altitude = pos.latitude();
-			sds.azimuth = pos.longitude();
-			sds.v = sat.data()->getVMagnitude(pcore);
-			double t;
-			if (sds.altitude<0)
-				t = qMax(-sds.altitude, 1.) / 2880;
-			else
-			if (sds.angleToSun>0)
-				t = qMax(sds.angleToSun, 1.) / (2*86400);
-			else
-			{
-				//qDebug() << "IRIDIUM warn: alt, angleToSun = " <<sds.altitude << sds.angleToSun;
-				t = 0.25/1440; // we should never be here, but assuming 1/4 minute to leave this
-			}
-
-			sds.nextJD = predictionJD + t;
-			iridiums.insert(sat, sds);
-			//qDebug() << sat.data()->getEnglishName() << ": "
-			//		 << sds.altitude
-			//		 << sds.azimuth
-			//		 << sds.angleToSun
-			//		 << sds.v
-			//		 << StelUtils::julianDayToISO8601String(predictionJD+StelApp::getInstance().getCore()->getUTCOffset(predictionJD)/24.f)
-			//			;
-			if (nextJD>sds.nextJD)
-				nextJD = sds.nextJD;
-		}
+		QVariantMap map;
+		map.insert("datetime", flare.datetime);
+		map.insert("jd", flare.JD);
+		map.insert("satellite", flare.satellite);
+		map.insert("azimuth", flare.azimuth*180./M_PI);
+		map.insert("altitude", flare.altitude*180./M_PI);
+		map.insert("magnitude", flare.magnitude);
+		list.append(map);
 	}
-	predictionJD = nextJD;
+	return list;
+}
 
-	while (predictionJD<predictionEndJD)
+QVariantList Satellites::getSatellitePasses() const
+{
+	QVariantList list;
+	foreach (const SatellitePass& pass, predictedSatellitePasses)
 	{
-		nextJD = predictionJD + 1./24;
-		pcore->setJD(predictionJD);
-
-		ssystem->getEarth().data()->computePosition(predictionJD);
-		pcore->update(0);
-
-		QMap<SatelliteP,SatDataStruct>::iterator i = iridiums.begin();
-		while (i != iridiums.end())
-		{
-			if ( i.value().nextJD<=predictionJD)
-			{
-
-				i.key().data()->update(0);
-
-				double v = i.key().data()->getVMagnitude(pcore);
-				bool flareFound = false;
-				if (v > i.value().v)
-				{
-					if (i.value().v < 1. // brighness limit
-					 && i.value().angleToSun>0.
-					 && i.value().angleToSun<2.)
-					{
-						IridiumFlaresPrediction flare;
-						flare.datetime = StelUtils::julianDayToISO8601String(predictionJD+StelApp::getInstance().getCore()->getUTCOffset(predictionJD)/24.f);
-						flare.satellite = i.key().data()->getEnglishName();
-						flare.azimuth   = i.value().azimuth;
-						if (useSouthAzimuth)
-						{
-							flare.azimuth += M_PI;
-							if (flare.azimuth > M_PI*2)
-								flare.azimuth -= M_PI*2;
-						}
-						flare.altitude  = i.value().altitude;
-						flare.magnitude = i.value().v;
-
-						predictions.append(flare);
-						flareFound = true;
-						//qDebug() << "Flare:" << flare.datetime << flare.satellite;
-
-					}
-				}
-
-/*				qDebug() << QString::asprintf("%20s  alt:%6.1f  az:%6.1f  sun:%6.1f  v:%6.1f",
-											 i.key().data()->getEnglishName().toStdString(),
-											 i.value().altitude*180/M_PI,
-											 i.value().azimuth*180/M_PI,
-											 i.value().angleToSun,
-											 v
-											 )
-						 <<  StelUtils::julianDayToISO8601String(predictionJD+StelApp::getInstance().getCore()->getUTCOffset(predictionJD)/24.f)
-							 ;
-*/
-
-				Vec3d pos = i.key().data()->getAltAzPosApparent(pcore);
-
-				i.value().v = flareFound ?  17 : v; // block extra report
-				i.value().altitude = pos.latitude();
-				i.value().azimuth = M_PI - pos.longitude();
-				i.value().angleToSun = i.key().data()->sunReflAngle;
-
-
-
-
-				double t;
-				if (flareFound)
-					t = 1./24;
-				else
-				if (i.value().altitude<0)
-					t = qMax((-i.value().altitude)*57,1.) / 5600;
-				else
-				if (i.value().angleToSun>0)
-					t = qMax(i.value().angleToSun,1.) / (4*86400);
-				else
-				{
-					//qDebug() << "IRIDIUM warn2: alt, angleToSun = " <<i.value().altitude << i.value().angleToSun;
-					t = 0.25/1440; // we should never be here, but assuming 1/4 minute to leave this
-				}
-				i.value().nextJD = predictionJD + t;
-				if (nextJD>i.value().nextJD)
-					nextJD = i.value().nextJD;
-			}
-			++i;
-		}
-		predictionJD = nextJD;
+		QVariantMap map;
+		map.insert("id", pass.id);
+		map.insert("satellite", pass.satellite);
+		map.insert("rise-jd", pass.riseJD);
+		map.insert("culmination-jd", pass.culminationJD);
+		map.insert("set-jd", pass.setJD);
+		map.insert("rise-azimuth", pass.riseAzimuth*180./M_PI);
+		map.insert("max-altitude", pass.maxAltitude*180./M_PI);
+		map.insert("set-azimuth", pass.setAzimuth*180./M_PI);
+		map.insert("magnitude", pass.magnitude);
+		map.insert("visible", pass.visible);
+		list.append(map);
 	}
-
-	//Satellite::timeShift = 0.;
-	if (isTimeNow)
-		pcore->setTimeNow();
-	else
-		pcore->setJD(currentJD);
-
-	return predictions;
+	return list;
 }
-#endif
 
 
 void Satellites::translations()
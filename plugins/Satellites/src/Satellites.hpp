@@ -22,12 +22,14 @@
 
 #include "StelObjectModule.hpp"
 #include "Satellite.hpp"
+#include "SatellitePredictor.hpp"
 #include "StelFader.hpp"
 #include "StelGui.hpp"
 #include "StelDialog.hpp"
 #include "StelLocation.hpp"
 
 #include <QDateTime>
+#include <QFutureWatcher>
 #include <QFile>
 #include <QDir>
 #include <QUrl>
@@ -125,17 +127,6 @@ struct TleSource
 //! @ingroup satellites
 typedef QList<TleSource> TleSourceList;
 
-struct IridiumFlaresPrediction
-{
-	QString datetime;
-	QString satellite;
-	float azimuth;		// radians
-	float altitude;		// radians
-	float magnitude;
-};
-
-typedef QList<IridiumFlaresPrediction> IridiumFlaresPredictionList;
-
 //! @class Satellites
 //! Main class of the %Satellites plugin.
 //! @author Matthew Gates
@@ -163,6 +154,12 @@ class Satellites : public StelObjectModule
 	Q_PROPERTY(bool realisticMode
 		   READ getFlagRealisticMode
 		   WRITE setFlagRelisticMode)
+	Q_PROPERTY(QVariantList iridiumFlares
+		   READ getIridiumFlares
+		   NOTIFY iridiumFlaresChanged)
+	Q_PROPERTY(QVariantList satellitePasses
+		   READ getSatellitePasses
+		   NOTIFY satellitePassesChanged)
 	
 public:
 	//! @enum UpdateState
@@ -375,7 +372,25 @@ public:
 	//! Get depth of prediction for Iridium flares
 	int getIridiumFlaresPredictionDepth(void) const { return iridiumFlaresPredictionDepth; }
 
+	//! Predict the Iridium flares from one day before the current date to getIridiumFlaresPredictionDepth()
+	//! days after it, for the current location. The prediction runs on the global thread pool and does
+	//! not change the date of the core, see SatellitePredictor.
+	QFuture<IridiumFlaresPredictionList> startIridiumFlaresPrediction();
+	//! Same as startIridiumFlaresPrediction(), waiting for the result.
 	IridiumFlaresPredictionList getIridiumFlaresPrediction();
+	//! Predict the passes of the satellites with the given identifiers between startJD and endJD (UTC),
+	//! for the current location, on the global thread pool.
+	QFuture<SatellitePassList> startSatellitePassesPrediction(const QStringList& ids, double startJD, double endJD);
+
+	//! Get the result of the last prediction started by predictIridiumFlares().
+	const IridiumFlaresPredictionList& getPredictedIridiumFlares() const { return predictedIridiumFlares; }
+	//! Get the result of the last prediction started by predictIridiumFlares(), for scripts and RemoteControl.
+	//! Each flare is a map with the keys "datetime" (local time), "jd" (UTC), "satellite", "azimuth", "altitude" (degrees) and "magnitude".
+	QVariantList getIridiumFlares() const;
+	//! Get the result of the last prediction started by predictSatellitePasses(), for scripts and RemoteControl.
+	//! Each pass is a map with the keys "id", "satellite", "rise-jd", "culmination-jd", "set-jd" (UTC),
+	//! "rise-azimuth", "max-altitude", "set-azimuth" (degrees), "magnitude" and "visible".
+	QVariantList getSatellitePasses() const;
 
 signals:
 	void hintsVisibleChanged(bool b);
@@ -400,6 +415,11 @@ signals:
 	//! update source(s) (and were removed, if autoRemoveEnabled is set).
 	void tleUpdateComplete(int updated, int total, int added, int missing);
 
+	//! Emitted when a prediction started by predictIridiumFlares() is finished.
+	void iridiumFlaresChanged();
+	//! Emitted when a prediction started by predictSatellitePasses() is finished.
+	void satellitePassesChanged();
+
 public slots:
 	// FIXME: Put back the getter functions - for scripts? --BM
 	
@@ -472,7 +492,18 @@ public slots:
 	//! @param depth in days
 	void setIridiumFlaresPredictionDepth(int depth) { iridiumFlaresPredictionDepth=depth; }
 
+	//! Start a prediction of the Iridium flares in the background, see startIridiumFlaresPrediction().
+	//! The result is available from getIridiumFlares() when iridiumFlaresChanged() is emitted.
+	void predictIridiumFlares();
+	//! Start a prediction of the passes of satellites in the background, see startSatellitePassesPrediction().
+	//! The result is available from getSatellitePasses() when satellitePassesChanged() is emitted.
+	//! @param ids the identifiers (catalog numbers) of the satellites, all displayed satellites if empty
+	//! @param days the length of the prediction from the current date
+	void predictSatellitePasses(const QStringList& ids = QStringList(), double days = 1.);
+
 private slots:
+	void iridiumFlaresPredicted();
+	void satellitePassesPredicted();
 
 private:
 	//! Add to the current collection the satellite described by the data.
@@ -542,6 +573,17 @@ private:
 	QList<SatelliteP> satellites;
 	SatellitesListModel* satelliteListModel;
 
+	//! Satellites to draw in the current frame, with their positions.
+	//! Filled by update(), which propagates the orbits in parallel, and used by draw().
+	struct FrameSnapshot
+	{
+		QVector<SatelliteP> satellites;
+		QVector<Vec3d> positions;
+		QVector<bool> orbitDisplayed;
+		void clear() { satellites.clear(); positions.clear(); orbitDisplayed.clear(); }
+	};
+	FrameSnapshot frameSnapshot;
+
 	QHash<QString, double> qsMagList;
 	
 	//! Union of the groups used by all loaded satellites - see @ref groups.
@@ -604,6 +646,18 @@ private:
 
 	int iridiumFlaresPredictionDepth;
 
+	//! @name Flares and passes prediction
+	//@{
+	//! Get the orbit data of the satellites for the predictor: the Iridium satellites if iridium is true, or
+	//! the satellites with the given ids (all displayed satellites if ids is empty).
+	QList<SatellitePredictor::SatelliteData> getPredictorData(bool iridium, const QStringList& ids = QStringList()) const;
+	SatellitePredictor predictor;
+	QFutureWatcher<IridiumFlaresPredictionList> iridiumFlaresWatcher;
+	QFutureWatcher<SatellitePassList> satellitePassesWatcher;
+	IridiumFlaresPredictionList predictedIridiumFlares;
+	SatellitePassList predictedSatellitePasses;
+	//@}
+
 	// GUI
 	SatellitesDialog* configDialog;
 
@@ -116,6 +116,17 @@ Vec3d gSatWrapper::getSubPoint() const
 	return returnedVector;
 }
 
+Vec3d gSatWrapper::getTEMEPosAt(double ai_julianDaysEpoch)
+{
+	if (pSatellite != Q_NULLPTR)
+	{
+		pSatellite->setEpoch(gTime(ai_julianDaysEpoch));
+		return getTEMEPos();
+	}
+	qWarning() << "gSatWrapper::getTEMEPosAt Method called without pSatellite initialized";
+	return Vec3d(0.,0.,0.);
+}
+
 void gSatWrapper::setEpoch(double ai_julianDaysEpoch)
 {
     epoch = ai_julianDaysEpoch;
@@ -123,6 +134,21 @@ void gSatWrapper::setEpoch(double ai_julianDaysEpoch)
 		pSatellite->setEpoch(epoch);
 }
 
+void gSatWrapper::setCommonEpoch(double ai_julianDaysEpoch)
+{
+	epoch = ai_julianDaysEpoch;
+	// Force the update, the location may have changed since the last call.
+	lastCalcObserverECIPosition = 0.0;
+	lastSunECIepoch = 0.0;
+	getSunECIPos();
+}
+
+void gSatWrapper::propagate()
+{
+	if (pSatellite)
+		pSatellite->setEpoch(epoch);
+}
+
 
 void gSatWrapper::calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_velocity)
 {
@@ -133,19 +159,10 @@ void gSatWrapper::calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_velocity
 
 		double radLatitude = loc.latitude * KDEG2RAD;
 		double theta       = epoch.toThetaLMST(loc.longitude * KDEG2RAD);
-		double r;
-		double c,sq;
-
-		/* Reference:  Explanatory supplement to the Astronomical Almanac 1992, page 209-210. */
-		/* Elipsoid earth model*/
-		/* c = Nlat/a */
-		c = 1/std::sqrt(1 + __f*(__f - 2)*Sqr(sin(radLatitude)));
-		sq = Sqr(1 - __f)*c;
-
-		r = (KEARTHRADIUS*c + (loc.altitude/1000))*cos(radLatitude);
-		ao_position[0] = r * cos(theta);/*kilometers*/
-		ao_position[1] = r * sin(theta);
-		ao_position[2] = (KEARTHRADIUS*sq + (loc.altitude/1000))*sin(radLatitude);
+		observerRadLatitude = radLatitude;
+		observerTheta = theta;
+
+		ao_position = computeObserverECIPos(loc, theta);
 		ao_velocity[0] = -KMFACTOR*ao_position[1];/*kilometers/second*/
 		ao_velocity[1] =  KMFACTOR*ao_position[0];
 		ao_velocity[2] =  0;
@@ -156,24 +173,45 @@ void gSatWrapper::calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_velocity
 
 
 
-Vec3d gSatWrapper::getAltAz() const
+Vec3d gSatWrapper::computeObserverECIPos(const StelLocation& loc, double theta)
 {
-	StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
-	Vec3d topoSatPos;
-
-	const double  radLatitude    = loc.latitude * KDEG2RAD;
-	const double  theta          = epoch.toThetaLMST(loc.longitude * KDEG2RAD);
-	const double sinRadLatitude=sin(radLatitude);
-	const double cosRadLatitude=cos(radLatitude);
-	const double sinTheta=sin(theta);
-	const double cosTheta=cos(theta);
+	const double radLatitude = loc.latitude * KDEG2RAD;
+	Vec3d position;
+
+	/* Reference:  Explanatory supplement to the Astronomical Almanac 1992, page 209-210. */
+	/* Elipsoid earth model*/
+	/* c = Nlat/a */
+	double c  = 1/std::sqrt(1 + __f*(__f - 2)*Sqr(sin(radLatitude)));
+	double sq = Sqr(1 - __f)*c;
+
+	double r = (KEARTHRADIUS*c + (loc.altitude/1000))*cos(radLatitude);
+	position[0] = r * cos(theta);/*kilometers*/
+	position[1] = r * sin(theta);
+	position[2] = (KEARTHRADIUS*sq + (loc.altitude/1000))*sin(radLatitude);
+	return position;
+}
 
+Vec3d gSatWrapper::getAltAz() const
+{
 	// This now only updates if required.
 	calcObserverECIPosition(observerECIPos, observerECIVel);
 
+	const double sinRadLatitude=sin(observerRadLatitude);
+	const double cosRadLatitude=cos(observerRadLatitude);
+	const double sinTheta=sin(observerTheta);
+	const double cosTheta=cos(observerTheta);
+
 	Vec3d satECIPos  = getTEMEPos();
 	Vec3d slantRange = satECIPos - observerECIPos;
 
+	return toTopocentric(slantRange, sinRadLatitude, cosRadLatitude, sinTheta, cosTheta);
+}
+
+Vec3d gSatWrapper::toTopocentric(const Vec3d& slantRange, double sinRadLatitude, double cosRadLatitude,
+				 double sinTheta, double cosTheta)
+{
+	Vec3d topoSatPos;
+
 	//top_s
 	topoSatPos[0] = (sinRadLatitude * cosTheta*slantRange[0]
 			 + sinRadLatitude* sinTheta*slantRange[1]
@@ -190,6 +228,44 @@ Vec3d gSatWrapper::getAltAz() const
 	return topoSatPos;
 }
 
+void gSatWrapper::temeToAltAz(const QVector<double>& jds, const QVector<Vec3d>& temePositions,
+			      QVector<Vec3d>& altAz, QVector<Visibility>& visibility)
+{
+	const int count = qMin(jds.size(), temePositions.size());
+	altAz.resize(count);
+	visibility.resize(count);
+
+	// The observer is placed with the rotation of the Earth for each date.
+	const StelLocation loc      = StelApp::getInstance().getCore()->getCurrentLocation();
+	const double radLatitude    = loc.latitude * KDEG2RAD;
+	const double radLongitude   = loc.longitude * KDEG2RAD;
+	const double sinRadLatitude = sin(radLatitude);
+	const double cosRadLatitude = cos(radLatitude);
+
+	const Vec3d sunPos = getSunECIPos();
+
+	for (int i=0; i<count; i++)
+	{
+		const double theta    = gTime(jds.at(i)).toThetaLMST(radLongitude);
+		const double sinTheta = sin(theta);
+		const double cosTheta = cos(theta);
+		const Vec3d observerPos = computeObserverECIPos(loc, theta);
+		const Vec3d& satECIPos = temePositions.at(i);
+
+		altAz[i] = toTopocentric(satECIPos - observerPos, sinRadLatitude, cosRadLatitude, sinTheta, cosTheta);
+		if (altAz.at(i)[2] <= 0)
+			visibility[i] = NOT_VISIBLE;
+		else if (toTopocentric(sunPos - observerPos, sinRadLatitude, cosRadLatitude, sinTheta, cosTheta)[2] > 0.0)
+			visibility[i] = RADAR_SUN;
+		else
+		{
+			double sunSatAngle = sunPos.angle(satECIPos);
+			double Dist = satECIPos.length()*cos(sunSatAngle - (M_PI/2));
+			visibility[i] = (Dist > KEARTHRADIUS) ? VISIBLE : RADAR_NIGHT;
+		}
+	}
+}
+
 void  gSatWrapper::getSlantRange(double &ao_slantRange, double &ao_slantRangeRate) const
 {
 	//Vec3d observerECIPos;
@@ -215,6 +291,7 @@ void gSatWrapper::updateSunECIPos()
 
 	static const SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
 	Vec3d sunEquinoxEqPos = solsystem->getSun()->getEquinoxEquatorialPos(StelApp::getInstance().getCore());
+	sunAltAzPos = solsystem->getSun()->getAltAzPosGeometric(StelApp::getInstance().getCore());
 
 	//sunEquinoxEqPos is measured in AU. we need measure it in Km
 	//Vec3d sunECIPos;
@@ -244,8 +321,7 @@ gSatWrapper::Visibility gSatWrapper::getVisibilityPredict()
 	if (satAltAzPos[2] > 0)
 	{
 		Vec3d satECIPos = getTEMEPos();
-		static const SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
-		Vec3d sunAltAzPos = solsystem->getSun()->getAltAzPosGeometric(StelApp::getInstance().getCore());
+		// Also updates sunAltAzPos if required.
 		Vec3d sunECIPos = getSunECIPos();
 
 		if (sunAltAzPos[2] > 0.0)
@@ -284,3 +360,6 @@ gTime gSatWrapper::lastCalcObserverECIPosition;
 Vec3d gSatWrapper::sunECIPos; // enough to have this once.
 Vec3d gSatWrapper::observerECIPos;
 Vec3d gSatWrapper::observerECIVel;
+double gSatWrapper::observerRadLatitude = 0.0;
+double gSatWrapper::observerTheta = 0.0;
+Vec3d gSatWrapper::sunAltAzPos;
@@ -30,8 +30,10 @@
 #define _GSATWRAPPER_HPP_ 1
 
 #include <QString>
+#include <QVector>
 
 #include "VecMath.hpp"
+#include "StelLocation.hpp"
 
 #include "gsatellite/gSatTEME.hpp"
 #include "gsatellite/gTime.hpp"
@@ -59,11 +61,26 @@ public:
 	//! from Stellarium Julian Date.
 	void setEpoch(double ai_julianDaysEpoch);
 
+	//! Set the epoch shared by all satellites and compute the observer and Sun positions for it.
+	//! Must be called from the main thread before propagate() is called for the satellites,
+	//! and again when the location changes.
+	static void setCommonEpoch(double ai_julianDaysEpoch);
+
+	//! Update the gSatTEME object to the epoch given to setCommonEpoch().
+	//! Until the epoch changes again, this and the position, visibility and phase angle
+	//! methods only modify this object, so that the satellites can be propagated in parallel.
+	void propagate();
+
 	// Operation getTEMEPos
 	//! @brief This operation isolate gSatTEME getPos operation.
 	//! @return Vec3d with TEME position. Units measured in Km.
 	Vec3d getTEMEPos() const;
 
+	//! Propagate the gSatTEME object to another date and return its TEME position (in km).
+	//! Does not change the common epoch, so it can be called for several satellites in parallel,
+	//! but propagate() must be called again before using the other getters.
+	Vec3d getTEMEPosAt(double ai_julianDaysEpoch);
+
 	// Operation getSunECIPos
 	//! @brief Get Sun positions in ECI system.
 	//! @return Vec3d with ECI position.
@@ -118,6 +135,13 @@ public:
 	Visibility getVisibilityPredict();
 
 	double getPhaseAngle() const;
+
+	//! Convert TEME positions (in km) at the given dates to StelCore::FrameAltAz (in km) for the
+	//! current location, and predict the visibility as getVisibilityPredict() does.
+	//! This is meant for whole orbit lines: the observer is placed for each date, and the
+	//! Sun position of the common epoch is used for all of them.
+	static void temeToAltAz(const QVector<double>& jds, const QVector<Vec3d>& temePositions,
+				QVector<Vec3d>& altAz, QVector<Visibility>& visibility);
 	gTime	getEpoch() const { return epoch; }
 
 
@@ -137,6 +161,13 @@ public:
 	static void calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_vel) ;
 
 
+	//! Compute the ECI position (in km) of an observer at loc, for the local sidereal angle theta (radians).
+	static Vec3d computeObserverECIPos(const StelLocation& loc, double theta);
+
+	//! Rotate an ECI vector relative to the observer to the topocentric (south, east, zenith) frame.
+	static Vec3d toTopocentric(const Vec3d& slantRange, double sinRadLatitude, double cosRadLatitude,
+				   double sinTheta, double cosTheta);
+
 private:
 	//! do the actual work to compute a cached value.
 	static void updateSunECIPos();
@@ -150,6 +181,9 @@ private:
 	static Vec3d observerECIPos;
 	static Vec3d observerECIVel;
 	static gTime lastCalcObserverECIPosition;
+	// The observer location and Sun horizontal position at lastCalcObserverECIPosition and lastSunECIepoch
+	static double observerRadLatitude, observerTheta;
+	static Vec3d sunAltAzPos;
 
 };
 
@@ -228,6 +228,7 @@ void SatellitesDialog::createDialogContent()
 	ui->flaresPredictionDepthSpinBox->setValue(plugin->getIridiumFlaresPredictionDepth());
 	connect(ui->flaresPredictionDepthSpinBox, SIGNAL(valueChanged(int)), plugin, SLOT(setIridiumFlaresPredictionDepth(int)));
 	connect(ui->pushButtonPredictIridiumFlares, SIGNAL(clicked()), this, SLOT(predictIridiumFlares()));
+	connect(plugin, SIGNAL(iridiumFlaresChanged()), this, SLOT(showIridiumFlares()));
 	connect(ui->iridiumFlaresTreeWidget, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(selectCurrentIridiumFlare(QModelIndex)));
 }
 
@@ -969,8 +970,15 @@ void SatellitesDialog::initListIridiumFlares()
 
 void SatellitesDialog::predictIridiumFlares()
 {
-	IridiumFlaresPredictionList predictions = GETSTELMODULE(Satellites)->getIridiumFlaresPrediction();
+	ui->pushButtonPredictIridiumFlares->setEnabled(false);
+	GETSTELMODULE(Satellites)->predictIridiumFlares();
+}
+
+void SatellitesDialog::showIridiumFlares()
+{
+	const IridiumFlaresPredictionList& predictions = GETSTELMODULE(Satellites)->getPredictedIridiumFlares();
 
+	ui->pushButtonPredictIridiumFlares->setEnabled(true);
 	ui->iridiumFlaresTreeWidget->clear();
 	foreach (const IridiumFlaresPrediction& flare, predictions)
 	{
@@ -109,7 +109,9 @@ private slots:
 	void setOrbitParams(void);
 	void updateTLEs(void);
 
+	//! Start the prediction in the background, the table is filled by showIridiumFlares() when it is done.
 	void predictIridiumFlares();
+	void showIridiumFlares();
 	void selectCurrentIridiumFlare(const QModelIndex &modelIndex);
 
 private:
@@ -0,0 +1,116 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelCacheFile.hpp"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace
+{
+	struct Header
+	{
+		quint32 magic;
+		quint32 version;
+		quint32 nbStrings;
+		quint32 nbRecords;
+		quint32 nbChars;
+		quint32 recordSize;
+	};
+}
+
+StelCacheFile::StringTable::StringTable(const QString& stamp)
+{
+	intern(stamp);
+}
+
+quint32 StelCacheFile::StringTable::intern(const QString& str)
+{
+	QHash<QString, quint32>::const_iterator it = index.constFind(str);
+	if (it!=index.constEnd())
+		return it.value();
+	const Entry entry = {(quint32)chars.size(), (quint32)str.size()};
+	chars.append(str);
+	entries.append(entry);
+	index.insert(str, entries.size()-1);
+	return entries.size()-1;
+}
+
+bool StelCacheFile::write(const QString& fileName, quint32 magic, quint32 version, const StringTable& strings,
+			  const void* records, int nbRecords, int recordSize)
+{
+	const Header header = {magic, version, (quint32)strings.entries.size(), (quint32)nbRecords, (quint32)strings.chars.size(), (quint32)recordSize};
+	QDir().mkpath(QFileInfo(fileName).absolutePath());
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning() << "Could not write cache file" << QDir::toNativeSeparators(fileName) << ":" << file.errorString();
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	file.write(reinterpret_cast<const char*>(strings.entries.constData()), strings.entries.size()*sizeof(StringTable::Entry));
+	file.write(reinterpret_cast<const char*>(records), (qint64)nbRecords*recordSize);
+	file.write(reinterpret_cast<const char*>(strings.chars.constData()), strings.chars.size()*sizeof(QChar));
+	return file.commit();
+}
+
+bool StelCacheFile::read(const QString& fileName, quint32 magic, quint32 version, const QString& stamp, int recordSize)
+{
+	file.setFileName(fileName);
+	if (!file.open(QIODevice::ReadOnly) || file.size()<(qint64)sizeof(Header))
+		return false;
+
+	// Map the file, or read it if this is not possible
+	const qint64 size = file.size();
+	const uchar* data = file.map(0, size);
+	if (!data)
+	{
+		content = file.readAll();
+		data = reinterpret_cast<const uchar*>(content.constData());
+	}
+
+	const Header* header = reinterpret_cast<const Header*>(data);
+	if (header->magic!=magic || header->version!=version || header->recordSize!=(quint32)recordSize || header->nbStrings==0
+	    || size!=(qint64)sizeof(Header)+(qint64)header->nbStrings*sizeof(StringTable::Entry)+(qint64)header->nbRecords*recordSize+(qint64)header->nbChars*sizeof(QChar))
+		return false;
+	const StringTable::Entry* stringEntries = reinterpret_cast<const StringTable::Entry*>(data+sizeof(Header));
+	const uchar* recordData = reinterpret_cast<const uchar*>(stringEntries+header->nbStrings);
+	const QChar* chars = reinterpret_cast<const QChar*>(recordData+(qint64)header->nbRecords*recordSize);
+
+	// The stamp is checked before creating any other string
+	const StringTable::Entry& stampEntry = stringEntries[0];
+	if ((quint64)stampEntry.offset+stampEntry.length>header->nbChars || QString::fromRawData(chars+stampEntry.offset, stampEntry.length)!=stamp)
+		return false;
+
+	QVector<QString> result(header->nbStrings);
+	result[0] = stamp;
+	for (quint32 i=1; i<header->nbStrings; ++i)
+	{
+		const StringTable::Entry& entry = stringEntries[i];
+		if ((quint64)entry.offset+entry.length>header->nbChars)
+			return false;
+		result[i] = QString(chars+entry.offset, entry.length);
+	}
+	strings = result;
+	records = recordData;
+	recordCount = header->nbRecords;
+	return true;
+}
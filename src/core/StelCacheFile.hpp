@@ -0,0 +1,87 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELCACHEFILE_HPP_
+#define _STELCACHEFILE_HPP_
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+//! @class StelCacheFile
+//! Binary file of fixed size records which refer to a shared table of strings by index, used by the caches
+//! of data which are slow to parse (see StelLocationCache and SolarSystemCache).
+//! Each distinct string is stored once, so that reading creates one QString per distinct string.
+//! The file is memory mapped when reading. It uses the native byte order and is only meant for the machine which wrote it.
+//! Layout: header, string entries, records, then the UTF-16 characters of all strings. String 0 is the stamp.
+class StelCacheFile
+{
+public:
+	//! Strings of the records to write
+	class StringTable
+	{
+	public:
+		//! @param stamp identifies the source data and the environment it was checked in; the file is only read back with the same stamp.
+		explicit StringTable(const QString& stamp);
+		//! Get the index of str, adding it to the table if needed.
+		quint32 intern(const QString& str);
+
+	private:
+		friend class StelCacheFile;
+		//! Position of a string in the characters, in UTF-16 units
+		struct Entry
+		{
+			quint32 offset;
+			quint32 length;
+		};
+		QHash<QString, quint32> index;
+		QVector<Entry> entries;
+		QString chars;
+	};
+
+	StelCacheFile() : records(Q_NULLPTR), recordCount(0) {}
+
+	//! Write the records (nbRecords records of recordSize bytes) and their strings to a cache file, creating its directory if needed.
+	//! The records should not contain uninitialized padding.
+	//! @param magic, version identify the format of the records
+	//! @return false if the file could not be written.
+	static bool write(const QString& fileName, quint32 magic, quint32 version, const StringTable& strings,
+			  const void* records, int nbRecords, int recordSize);
+
+	//! Read a cache file written with the same magic, version, stamp and record size.
+	//! @return false if the file is missing, invalid or written with another stamp.
+	bool read(const QString& fileName, quint32 magic, quint32 version, const QString& stamp, int recordSize);
+
+	//! Get the strings read, by index.
+	const QVector<QString>& getStrings() const {return strings;}
+	//! Get the records read, which stay valid as long as this object exists.
+	const void* getRecords() const {return records;}
+	int getRecordCount() const {return recordCount;}
+
+private:
+	QFile file;
+	QByteArray content;
+	QVector<QString> strings;
+	const void* records;
+	int recordCount;
+};
+
+#endif // _STELCACHEFILE_HPP_
@@ -1846,10 +1846,11 @@ double StelCore::getDeltaT() const
 double StelCore::computeDeltaT(const double JD)
 {
 	double DeltaT = 0.;
+	// This is also called from the parallel update of SolarSystem, so don't modify members here.
+	// For the Custom algorithm, setDeltaTCustomNDot() keeps deltaTnDot up to date.
 	if (currentDeltaTAlgorithm==Custom)
 	{
 		// User defined coefficients for quadratic equation for DeltaT may change frequently.
-		deltaTnDot = deltaTCustomNDot; // n.dot = custom value "/cy/cy
 		int year, month, day;
 		StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
 		double u = (StelUtils::getDecYear(year,month,day)-getDeltaTCustomYear())/100;
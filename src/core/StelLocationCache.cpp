@@ -0,0 +1,115 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelLocationCache.hpp"
+#include "StelCacheFile.hpp"
+
+#include <QVector>
+
+// The strings of the records are indices into the string table of the StelCacheFile.
+namespace
+{
+	const quint32 LOCATION_CACHE_MAGIC = 0x534c4331; // "SLC1"
+	const quint32 LOCATION_CACHE_VERSION = 2;
+
+	struct Record
+	{
+		quint32 id;
+		quint32 name;
+		quint32 state;
+		quint32 country;
+		quint32 planetName;
+		quint32 landscapeKey;
+		quint32 ianaTimeZone;
+		float longitude;
+		float latitude;
+		qint32 altitude;
+		float bortleScaleIndex;
+		qint32 population;
+		quint16 role;
+		quint16 isUserLocation;
+	};
+}
+
+bool StelLocationCache::write(const QString& fileName, const QString& stamp, const QMap<QString, StelLocation>& locations)
+{
+	StelCacheFile::StringTable strings(stamp);
+	QVector<Record> records;
+	records.reserve(locations.size());
+	for (QMap<QString, StelLocation>::const_iterator it=locations.constBegin(); it!=locations.constEnd(); ++it)
+	{
+		const StelLocation& loc = it.value();
+		Record r;
+		r.id = strings.intern(it.key());
+		r.name = strings.intern(loc.name);
+		r.state = strings.intern(loc.state);
+		r.country = strings.intern(loc.country);
+		r.planetName = strings.intern(loc.planetName);
+		r.landscapeKey = strings.intern(loc.landscapeKey);
+		r.ianaTimeZone = strings.intern(loc.ianaTimeZone);
+		r.longitude = loc.longitude;
+		r.latitude = loc.latitude;
+		r.altitude = loc.altitude;
+		r.bortleScaleIndex = loc.bortleScaleIndex;
+		r.population = loc.population;
+		r.role = loc.role.unicode();
+		r.isUserLocation = loc.isUserLocation;
+		records.append(r);
+	}
+	return StelCacheFile::write(fileName, LOCATION_CACHE_MAGIC, LOCATION_CACHE_VERSION, strings, records.constData(), records.size(), sizeof(Record));
+}
+
+bool StelLocationCache::read(const QString& fileName, const QString& stamp, QMap<QString, StelLocation>& locations)
+{
+	locations.clear();
+	StelCacheFile file;
+	if (!file.read(fileName, LOCATION_CACHE_MAGIC, LOCATION_CACHE_VERSION, stamp, sizeof(Record)))
+		return false;
+	const QVector<QString>& strings = file.getStrings();
+	const quint32 nbStrings = strings.size();
+	const Record* records = static_cast<const Record*>(file.getRecords());
+
+	for (int i=0; i<file.getRecordCount(); ++i)
+	{
+		const Record& r = records[i];
+		const quint32 maxIndex = qMax(qMax(qMax(r.id, r.name), qMax(r.state, r.country)), qMax(qMax(r.planetName, r.landscapeKey), r.ianaTimeZone));
+		if (maxIndex>=nbStrings)
+		{
+			locations.clear();
+			return false;
+		}
+		StelLocation loc;
+		loc.name = strings.at(r.name);
+		loc.state = strings.at(r.state);
+		loc.country = strings.at(r.country);
+		loc.planetName = strings.at(r.planetName);
+		loc.landscapeKey = strings.at(r.landscapeKey);
+		loc.ianaTimeZone = strings.at(r.ianaTimeZone);
+		loc.longitude = r.longitude;
+		loc.latitude = r.latitude;
+		loc.altitude = r.altitude;
+		loc.bortleScaleIndex = r.bortleScaleIndex;
+		loc.population = r.population;
+		loc.role = QChar(r.role);
+		loc.isUserLocation = r.isUserLocation!=0;
+		// The records are sorted by ID, so that each location is appended at the end of the map
+		locations.insert(locations.constEnd(), strings.at(r.id), loc);
+	}
+	return true;
+}
@@ -0,0 +1,47 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELLOCATIONCACHE_HPP_
+#define _STELLOCATIONCACHE_HPP_
+
+#include "StelLocation.hpp"
+
+#include <QMap>
+#include <QString>
+
+//! @class StelLocationCache
+//! Compact binary copy of the location database, written once the database has been loaded and its time zones
+//! checked, and memory mapped on the next startups instead of parsing and checking the database again.
+//! Each distinct string is stored once, and each location is a fixed size record of indices into the string table
+//! and numbers, so that loading creates one QString per distinct string, shared by all the locations using it.
+//! The records are sorted by ID. The file uses the native byte order and is only meant for the machine which wrote it.
+class StelLocationCache
+{
+public:
+	//! Write locations to a cache file.
+	//! @param stamp identifies the source data and the environment it was checked in; the file is only read back with the same stamp.
+	//! @return false if the file could not be written.
+	static bool write(const QString& fileName, const QString& stamp, const QMap<QString, StelLocation>& locations);
+
+	//! Read locations from a cache file, replacing the content of locations.
+	//! @return false if the file is missing, invalid or written with another stamp. locations is then left empty.
+	static bool read(const QString& fileName, const QString& stamp, QMap<QString, StelLocation>& locations);
+};
+
+#endif // _STELLOCATIONCACHE_HPP_
@@ -0,0 +1,135 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelLocationIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Cells of 1x1 degree
+#define LOCATION_INDEX_ROWS 180
+#define LOCATION_INDEX_COLUMNS 360
+
+// Margin in degrees added around the searched area against rounding differences
+#define LOCATION_INDEX_MARGIN 0.01f
+
+int StelLocationIndex::cellRow(float latitude)
+{
+	return qBound(0, (int)std::floor(latitude+90.f), LOCATION_INDEX_ROWS-1);
+}
+
+int StelLocationIndex::cellColumn(float longitude)
+{
+	const int column = (int)std::floor(longitude+180.f) % LOCATION_INDEX_COLUMNS;
+	return column<0 ? column+LOCATION_INDEX_COLUMNS : column;
+}
+
+void StelLocationIndex::clear()
+{
+	grids.clear();
+	sortedIds.clear();
+}
+
+void StelLocationIndex::build(const QMap<QString, StelLocation>& locations)
+{
+	clear();
+	const int nbCells = LOCATION_INDEX_ROWS*LOCATION_INDEX_COLUMNS;
+
+	// Count the locations of each cell, then place them after the locations of the previous cells
+	for (QMap<QString, StelLocation>::const_iterator it=locations.constBegin(); it!=locations.constEnd(); ++it)
+	{
+		PlanetGrid& grid = grids[it->planetName];
+		if (grid.cellStart.isEmpty())
+			grid.cellStart.fill(0, nbCells+1);
+		++grid.cellStart[cellRow(it->latitude)*LOCATION_INDEX_COLUMNS+cellColumn(it->longitude)+1];
+	}
+	QHash<QString, QVector<int> > nextEntry;
+	for (QHash<QString, PlanetGrid>::iterator g=grids.begin(); g!=grids.end(); ++g)
+	{
+		QVector<int>& cellStart = g->cellStart;
+		for (int i=0; i<nbCells; ++i)
+			cellStart[i+1] += cellStart[i];
+		g->entries.resize(cellStart[nbCells]);
+		nextEntry.insert(g.key(), cellStart);
+	}
+	sortedIds.reserve(locations.size());
+	for (QMap<QString, StelLocation>::const_iterator it=locations.constBegin(); it!=locations.constEnd(); ++it)
+	{
+		const int cell = cellRow(it->latitude)*LOCATION_INDEX_COLUMNS+cellColumn(it->longitude);
+		grids[it->planetName].entries[nextEntry[it->planetName][cell]++] = it;
+		sortedIds.append(qMakePair(it.key().toCaseFolded(), it.key()));
+	}
+	std::sort(sortedIds.begin(), sortedIds.end());
+}
+
+QVector<StelLocationIndex::Entry> StelLocationIndex::candidatesNearby(const QString& planetName, float longitude, float latitude, float radiusDegrees) const
+{
+	QVector<Entry> result;
+	QHash<QString, PlanetGrid>::const_iterator g = grids.constFind(planetName);
+	if (g==grids.constEnd() || radiusDegrees<0.f)
+		return result;
+	const PlanetGrid& grid = g.value();
+
+	// Bounding box of the circle. The longitudes are only limited if the circle does not contain a pole.
+	const float radius = radiusDegrees+LOCATION_INDEX_MARGIN;
+	const float latMin = latitude-radius;
+	const float latMax = latitude+radius;
+	int firstColumn = 0;
+	int lastColumn = LOCATION_INDEX_COLUMNS-1;
+	if (latMin>-90.f && latMax<90.f)
+	{
+		const float DEGREES = M_PI/180.0f;
+		const float sinDeltaLongitude = std::sin(radius*DEGREES)/std::cos(latitude*DEGREES);
+		if (sinDeltaLongitude<1.f)
+		{
+			const float deltaLongitude = std::asin(sinDeltaLongitude)/DEGREES+LOCATION_INDEX_MARGIN;
+			const int first = (int)std::floor(longitude-deltaLongitude+180.f);
+			const int last = (int)std::floor(longitude+deltaLongitude+180.f);
+			if (last-first<LOCATION_INDEX_COLUMNS-1)
+			{
+				firstColumn = first;
+				lastColumn = last;
+			}
+		}
+	}
+
+	for (int row=cellRow(latMin); row<=cellRow(latMax); ++row)
+	{
+		for (int c=firstColumn; c<=lastColumn; ++c)
+		{
+			int column = c % LOCATION_INDEX_COLUMNS;
+			if (column<0)
+				column += LOCATION_INDEX_COLUMNS;
+			const int cell = row*LOCATION_INDEX_COLUMNS+column;
+			for (int i=grid.cellStart.at(cell); i<grid.cellStart.at(cell+1); ++i)
+				result.append(grid.entries.at(i));
+		}
+	}
+	return result;
+}
+
+QStringList StelLocationIndex::idsWithPrefix(const QString& prefix, int maxResults) const
+{
+	const QString key = prefix.toCaseFolded();
+	QStringList result;
+	QVector<QPair<QString, QString> >::const_iterator it = std::lower_bound(sortedIds.constBegin(), sortedIds.constEnd(), qMakePair(key, QString()));
+	for (; it!=sortedIds.constEnd() && it->first.startsWith(key) && (maxResults<0 || result.size()<maxResults); ++it)
+		result.append(it->second);
+	return result;
+}
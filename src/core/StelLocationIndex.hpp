@@ -0,0 +1,71 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELLOCATIONINDEX_HPP_
+#define _STELLOCATIONINDEX_HPP_
+
+#include "StelLocation.hpp"
+
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+//! @class StelLocationIndex
+//! Index of a map of locations by position and by ID, used by StelLocationMgr to avoid scanning all locations.
+//! The locations of each planet are sorted into cells of 1x1 degree, and the IDs are kept sorted
+//! case-insensitively so that all IDs with a given prefix are found by binary search.
+//! The index points to the values of the map and has to be rebuilt whenever the map changes.
+class StelLocationIndex
+{
+public:
+	//! An indexed location, with its ID as key
+	typedef QMap<QString, StelLocation>::const_iterator Entry;
+
+	//! Index the given locations, whose keys are the location IDs.
+	void build(const QMap<QString, StelLocation>& locations);
+	void clear();
+
+	//! Get the locations of a planet which may be within radiusDegrees of a point.
+	//! All locations within the radius are returned, but also some farther ones:
+	//! the caller has to check the distance with StelLocation::distanceDegrees().
+	QVector<Entry> candidatesNearby(const QString& planetName, float longitude, float latitude, float radiusDegrees) const;
+
+	//! Get the IDs of the locations starting with prefix, ignoring case, in alphabetical order.
+	//! @param maxResults the maximum number of IDs to return, or -1 for all
+	QStringList idsWithPrefix(const QString& prefix, int maxResults=-1) const;
+
+private:
+	//! The locations of a planet sorted by cell, the locations of cell i are entries[cellStart[i]] to entries[cellStart[i+1]-1].
+	struct PlanetGrid
+	{
+		QVector<int> cellStart;
+		QVector<Entry> entries;
+	};
+
+	static int cellRow(float latitude);
+	static int cellColumn(float longitude);
+
+	QHash<QString, PlanetGrid> grids;
+	//! Pairs of (case folded ID, ID), sorted
+	QVector<QPair<QString, QString> > sortedIds;
+};
+
+#endif // _STELLOCATIONINDEX_HPP_
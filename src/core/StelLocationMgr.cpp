@@ -18,6 +18,7 @@
 
 #include "StelLocationMgr.hpp"
 #include "StelLocationMgr_p.hpp"
+#include "StelLocationCache.hpp"
 
 #include "StelApp.hpp"
 #include "StelCore.hpp"
@@ -38,6 +39,9 @@
 #include <QUrlQuery>
 #include <QSettings>
 #include <QTimeZone>
+#include <QFileInfo>
+#include <QSet>
+#include <QSysInfo>
 
 TimezoneNameMap StelLocationMgr::locationDBToIANAtranslations;
 
@@ -348,6 +352,7 @@ StelLocationMgr::StelLocationMgr()
 
 	locations = loadCitiesBin("data/base_locations.bin.gz");
 	locations.unite(loadCities("data/user_locations.txt", true));
+	locationIndex.build(locations);
 	
 	// Init to Paris France because it's the center of the world.
 	lastResortLocation = locationForString(conf->value("init_location/last_location", "Paris, France").toString());
@@ -374,6 +379,7 @@ void StelLocationMgr::setLocations(const LocationList &locations)
 	{
 		this->locations.insert(it->getID(),*it);
 	}
+	locationIndex.build(this->locations);
 
 	emit locationListChanged();
 }
@@ -406,6 +412,16 @@ LocationMap StelLocationMgr::loadCitiesBin(const QString& fileName)
 		return res;
 	}
 
+	// The locations with their checked time zones are cached. The cache is valid as long as the location file,
+	// the translations of time zone names in this file and the time zones available on this system do not change.
+	const QFileInfo sourceInfo(cityDataPath);
+	const QString cacheDir = StelFileMgr::getCacheDir();
+	const QString cachePath = cacheDir + "/locations.cache";
+	const QString cacheStamp = QString("%1|%2|%3|%4|%5|%6").arg(cityDataPath).arg(sourceInfo.size()).arg(sourceInfo.lastModified().toMSecsSinceEpoch())
+				   .arg(StelUtils::getApplicationVersion(), qVersion(), QSysInfo::prettyProductName());
+	if (StelLocationCache::read(cachePath, cacheStamp, res))
+		return res;
+
 	if (fileName.endsWith(".gz"))
 	{
 		QDataStream in(StelUtils::uncompress(sourcefile.readAll()));
@@ -420,7 +436,7 @@ LocationMap StelLocationMgr::loadCitiesBin(const QString& fileName)
 	}
 	// Now res has all location data. However, some timezone names are not available in various versions of Qt.
 	// Sanity checks: It seems we must translate timezone names. Quite a number on Windows, but also still some on Linux.
-	QList<QByteArray> availableTimeZoneList=QTimeZone::availableTimeZoneIds();
+	const QSet<QByteArray> availableTimeZoneList=QTimeZone::availableTimeZoneIds().toSet();
 	QStringList unknownTZlist;
 	QMap<QString, StelLocation>::iterator i=res.begin();
 	while (i!=res.end())
@@ -457,6 +473,9 @@ LocationMap StelLocationMgr::loadCitiesBin(const QString& fileName)
 		// Note to developers: Fill those names and replacements to the map above.
 	}
 
+	if (QDir().mkpath(cacheDir))
+		StelLocationCache::write(cachePath, cacheStamp, res);
+
 	return res;
 }
 
@@ -597,6 +616,7 @@ bool StelLocationMgr::saveUserLocation(const StelLocation& loc)
 
 	// Add in the program
 	locations[loc.getID()]=loc;
+	locationIndex.build(locations);
 
 	//emit before saving the list
 	emit locationListChanged();
@@ -655,6 +675,7 @@ bool StelLocationMgr::deleteUserLocation(const QString& id)
 		return false;
 
 	locations.remove(id);
+	locationIndex.build(locations);
 
 	//emit before saving the list
 	emit locationListChanged();
@@ -805,13 +826,11 @@ void StelLocationMgr::changeLocationFromNetworkLookup()
 LocationMap StelLocationMgr::pickLocationsNearby(const QString planetName, const float longitude, const float latitude, const float radiusDegrees)
 {
 	QMap<QString, StelLocation> results;
-	QMapIterator<QString, StelLocation> iter(locations);
-	while (iter.hasNext())
+	// The index only gives the locations around, the distance still has to be checked
+	foreach (const StelLocationIndex::Entry& iter, locationIndex.candidatesNearby(planetName, longitude, latitude, radiusDegrees))
 	{
-		iter.next();
 		const StelLocation *loc=&iter.value();
-		if ( (loc->planetName == planetName) &&
-				(StelLocation::distanceDegrees(longitude, latitude, loc->longitude, loc->latitude) <= radiusDegrees) )
+		if (StelLocation::distanceDegrees(longitude, latitude, loc->longitude, loc->latitude) <= radiusDegrees)
 		{
 			results.insert(iter.key(), iter.value());
 		}
@@ -819,6 +838,11 @@ LocationMap StelLocationMgr::pickLocationsNearby(const QString planetName, const
 	return results;
 }
 
+QStringList StelLocationMgr::pickLocationIdsByPrefix(const QString& prefix, int maxResults) const
+{
+	return locationIndex.idsWithPrefix(prefix, maxResults);
+}
+
 LocationMap StelLocationMgr::pickLocationsInCountry(const QString country)
 {
 	QMap<QString, StelLocation> results;
@@ -20,6 +20,7 @@
 #define _STELLOCATIONMGR_HPP_
 
 #include "StelLocation.hpp"
+#include "StelLocationIndex.hpp"
 #include <QString>
 #include <QObject>
 #include <QMetaType>
@@ -80,6 +81,9 @@ public:
 
 	//! Find list of locations within @param radiusDegrees of selected (usually screen-clicked) coordinates.
 	LocationMap pickLocationsNearby(const QString planetName, const float longitude, const float latitude, const float radiusDegrees);
+	//! Find the IDs of the locations which start with @param prefix, ignoring case, in alphabetical order.
+	//! @param maxResults the maximum number of IDs to return, or -1 for all
+	QStringList pickLocationIdsByPrefix(const QString& prefix, int maxResults=-1) const;
 	//! Find list of locations in a particular country only.
 	LocationMap pickLocationsInCountry(const QString country);
 
@@ -132,10 +136,14 @@ private:
 
 	//! Load cities from a file
 	static LocationMap loadCities(const QString& fileName, bool isUserLocation);
+	//! Load cities from a binary file and check their time zones, or load them from the location cache
+	//! if it was written for the same file and system.
 	static LocationMap loadCitiesBin(const QString& fileName);
 
 	//! The list of all loaded locations
 	LocationMap locations;
+	//! Index of the locations by position and ID, rebuilt whenever locations changes
+	StelLocationIndex locationIndex;
 	//! A Map which has to be used to replace, system- and Qt-version dependent,
 	//! timezone names from our location database to the code names currently used by Qt.
 	//! Required to avoid https://bugs.launchpad.net/stellarium/+bug/1662132,
@@ -0,0 +1,147 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "StelMinimumFinder.hpp"
+
+#include <cmath>
+
+// Maximum number of iterations of Brent's method
+#define BRENT_MAX_ITERATIONS 100
+
+StelMinimumFinder::Minimum StelMinimumFinder::brentMinimize(const Function& f, double a, double b, double x, double fx, double tolerance, int* evaluations)
+{
+	// See R. P. Brent, Algorithms for Minimization without Derivatives, 1973, chapter 5.
+	// v, w and x are the three best points found, x the best one, used for the parabolic interpolation.
+	static const double goldenRatio = 0.5*(3.-std::sqrt(5.));
+	double w = x, v = x;
+	double fw = fx, fv = fx;
+	double d = 0., e = 0.;
+	int count = 0;
+	for (int i=0; i<BRENT_MAX_ITERATIONS; ++i)
+	{
+		const double middle = 0.5*(a+b);
+		if (std::fabs(x-middle) <= 2.*tolerance-0.5*(b-a))
+			break;
+
+		bool golden = true;
+		if (std::fabs(e) > tolerance)
+		{
+			// Try a parabola through x, v and w
+			double r = (x-w)*(fx-fv);
+			double q = (x-v)*(fx-fw);
+			double p = (x-v)*q-(x-w)*r;
+			q = 2.*(q-r);
+			if (q > 0.)
+				p = -p;
+			q = std::fabs(q);
+			const double previousE = e;
+			e = d;
+			// Accept the parabolic step only if it falls in [a, b] and is less than half of the step before last
+			if (std::fabs(p) < std::fabs(0.5*q*previousE) && p > q*(a-x) && p < q*(b-x))
+			{
+				d = p/q;
+				const double u = x+d;
+				if (u-a < 2.*tolerance || b-u < 2.*tolerance)
+					d = middle>=x ? tolerance : -tolerance;
+				golden = false;
+			}
+		}
+		if (golden)
+		{
+			e = x>=middle ? a-x : b-x;
+			d = goldenRatio*e;
+		}
+
+		const double u = std::fabs(d)>=tolerance ? x+d : x+(d>=0. ? tolerance : -tolerance);
+		const double fu = f(u);
+		++count;
+		if (fu <= fx)
+		{
+			if (u >= x)
+				a = x;
+			else
+				b = x;
+			v = w; fv = fw;
+			w = x; fw = fx;
+			x = u; fx = fu;
+		}
+		else
+		{
+			if (u < x)
+				a = u;
+			else
+				b = u;
+			if (fu <= fw || w == x)
+			{
+				v = w; fv = fw;
+				w = u; fw = fu;
+			}
+			else if (fu <= fv || v == x || v == w)
+			{
+				v = u; fv = fu;
+			}
+		}
+	}
+	if (evaluations)
+		*evaluations += count;
+	Minimum result = {x, fx};
+	return result;
+}
+
+QList<StelMinimumFinder::Minimum> StelMinimumFinder::findMinima(const Function& f, double start, double stop, double step, double maxValue,
+								double tolerance, const QAtomicInt* cancelled, int* evaluations)
+{
+	QList<Minimum> result;
+	if (!(stop > start) || !(step > 0.))
+		return result;
+
+	// Use a step dividing the interval evenly
+	const int steps = qMax(2, (int)std::ceil((stop-start)/step));
+	const double h = (stop-start)/steps;
+
+	// Values of f at the samples i-2, i-1 and i
+	double f0 = f(start);
+	double f1 = f(start+h);
+	int count = 2;
+	for (int i=2; i<=steps; ++i)
+	{
+		if (cancelled && cancelled->load())
+			break;
+		const double f2 = f(start+i*h);
+		++count;
+		if (f1 < f0 && f1 <= f2)
+		{
+			// Assume that f does not fall faster near the minimum than between the samples
+			const double lowerBound = f1-qMax(f0-f1, f2-f1);
+			if (lowerBound < maxValue)
+			{
+				const double x1 = start+(i-1)*h;
+				const Minimum minimum = brentMinimize(f, x1-h, x1+h, x1, f1, tolerance, &count);
+				if (minimum.value < maxValue)
+					result.append(minimum);
+			}
+		}
+		f0 = f1;
+		f1 = f2;
+	}
+	if (evaluations)
+		*evaluations += count;
+	return result;
+}
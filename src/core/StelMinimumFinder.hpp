@@ -0,0 +1,64 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _STELMINIMUMFINDER_HPP_
+#define _STELMINIMUMFINDER_HPP_
+
+#include <QAtomicInt>
+#include <QList>
+
+#include <functional>
+
+//! @class StelMinimumFinder
+//! Search of the local minima of a function of time, like the angular separation of two bodies.
+//! The function is sampled with a coarse step, each sampled minimum gives an interval of two steps containing
+//! a minimum, which is refined with Brent's method (parabolic interpolation with golden section steps as fallback).
+//! The step only has to be smaller than half of the shortest time between two minima of the function,
+//! so that most of the function evaluations are spent near the minima which are actually wanted.
+class StelMinimumFinder
+{
+public:
+	typedef std::function<double(double)> Function;
+
+	//! A local minimum of a function
+	struct Minimum
+	{
+		double x;
+		double value;
+	};
+
+	//! Find the local minima of f in ]start, stop[ whose value is below maxValue.
+	//! Minima at the ends of the interval are ignored. Intervals between samples which cannot contain a value
+	//! below maxValue, judging from the slopes between the samples, are not refined.
+	//! @param step the maximum sampling step
+	//! @param tolerance the accuracy of the positions of the minima
+	//! @param cancelled if given and set to non zero, the search stops and returns the minima found so far
+	//! @param evaluations if given, the number of evaluations of f is added to it
+	static QList<Minimum> findMinima(const Function& f, double start, double stop, double step, double maxValue,
+					 double tolerance, const QAtomicInt* cancelled=Q_NULLPTR, int* evaluations=Q_NULLPTR);
+
+	//! Find the minimum of f in [a, b] with Brent's method.
+	//! @param x a point of ]a, b[ where f is lower than at a and b
+	//! @param fx the value of f at x
+	//! @param tolerance the accuracy of the position of the minimum
+	static Minimum brentMinimize(const Function& f, double a, double b, double x, double fx, double tolerance, int* evaluations=Q_NULLPTR);
+};
+
+#endif // _STELMINIMUMFINDER_HPP_
@@ -25,6 +25,7 @@
 
 #include <QDebug>
 #include <QString>
+#include <typeinfo>
 
 StelProjector::Mat4dTransform::Mat4dTransform(const Mat4d& m)
     : transfoMat(m),
@@ -478,6 +479,26 @@ Mat4f StelProjector::getProjectionMatrix() const
 	return Mat4f(2.f/viewportXywh[2], 0, 0, 0, 0, 2.f/viewportXywh[3], 0, 0, 0, 0, -1., 0., -(2.f*viewportXywh[0] + viewportXywh[2])/viewportXywh[2], -(2.f*viewportXywh[1] + viewportXywh[3])/viewportXywh[3], 0, 1);
 }
 
+bool StelProjector::isSameProjection(const StelProjector& other) const
+{
+	if (typeid(*this)!=typeid(other) || typeid(*modelViewTransform)!=typeid(*other.modelViewTransform))
+		return false;
+	if (flipHorz!=other.flipHorz || flipVert!=other.flipVert || pixelPerRad!=other.pixelPerRad || maskType!=other.maskType
+	    || zNear!=other.zNear || oneOverZNearMinusZFar!=other.oneOverZNearMinusZFar || !(viewportXywh==other.viewportXywh)
+	    || !(viewportCenter==other.viewportCenter) || !(viewportCenterOffset==other.viewportCenterOffset)
+	    || viewportFovDiameter!=other.viewportFovDiameter || devicePixelsPerPixel!=other.devicePixelsPerPixel
+	    || widthStretch!=other.widthStretch)
+		return false;
+	const Mat4d m = modelViewTransform->getApproximateLinearTransfo();
+	const Mat4d otherM = other.modelViewTransform->getApproximateLinearTransfo();
+	for (int i=0; i<16; ++i)
+	{
+		if (m[i]!=otherM[i])
+			return false;
+	}
+	return true;
+}
+
 StelProjector::StelProjectorMaskType StelProjector::getMaskType(void) const
 {
 	return maskType;
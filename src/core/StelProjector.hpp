@@ -276,6 +276,11 @@ public:
 	//! Get the current projection matrix.
 	Mat4f getProjectionMatrix() const;
 
+	//! Return true if other projects every vector to the same position as this projector,
+	//! i.e. if it is of the same type and has the same parameters and model view transformation.
+	//! Non-linear model view transformations (refraction) are only compared by type and linear part.
+	bool isSameProjection(const StelProjector& other) const;
+
 	///////////////////////////////////////////////////////////////////////////
 	//! Get a string description of a StelProjectorMaskType.
 	static const QString maskTypeToString(StelProjectorMaskType type);
@@ -35,6 +35,7 @@
 #include "Landscape.hpp"
 
 #include <QOpenGLContext>
+#include <QSurfaceFormat>
 #include <QOpenGLShaderProgram>
 #include <QStringList>
 #include <QSettings>
@@ -67,10 +68,17 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	customPlanetMagLimit(0.0),
 	bortleScaleIndex(3),
 	inScale(1.f),
+	vertexArray(Q_NULLPTR),
+	quadVertexArray(Q_NULLPTR),
+	starVertexBuffer(QOpenGLBuffer::VertexBuffer),
+	starCornerBuffer(QOpenGLBuffer::VertexBuffer),
+	starIndexBuffer(QOpenGLBuffer::IndexBuffer),
+	vertexAttribDivisor(Q_NULLPTR),
+	drawArraysInstanced(Q_NULLPTR),
 	starShaderProgram(Q_NULLPTR),
 	starShaderVars(StarShaderVars()),
 	nbPointSources(0),
-	maxPointSources(1000),
+	maxPointSources(4096),
 	maxLum(0.f),
 	oldLum(-1.f),
 	flagLuminanceAdaptation(false),
@@ -127,25 +135,18 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	if (!ok)
 		setAtmospherePressure(1013.0);
 
-	// Initialize buffers for use by gl vertex array	
-	
-	vertexArray = new StarVertex[maxPointSources*6];
-	
-	textureCoordArray = new unsigned char[maxPointSources*6*2];
-	for (unsigned int i=0;i<maxPointSources; ++i)
-	{
-		static const unsigned char texElems[] = {0, 0, 255, 0, 255, 255, 0, 0, 255, 255, 0, 255};
-		unsigned char* elem = &textureCoordArray[i*6*2];
-		memcpy(elem, texElems, 12);
-	}
+	// Initialize buffers for use by gl vertex array
+	// The GL buffer objects are created in init(), 4 vertices per source must fit in 16 bit indices.
+	Q_ASSERT(maxPointSources*4<=65536);
+	vertexArray = new StarVertex[maxPointSources];
 }
 
 StelSkyDrawer::~StelSkyDrawer()
 {
 	delete[] vertexArray;
 	vertexArray = Q_NULLPTR;
-	delete[] textureCoordArray;
-	textureCoordArray = Q_NULLPTR;
+	delete[] quadVertexArray;
+	quadVertexArray = Q_NULLPTR;
 	
 	delete starShaderProgram;
 	starShaderProgram = Q_NULLPTR;
@@ -164,17 +165,20 @@ void StelSkyDrawer::init()
 
 	// Create shader program
 	QOpenGLShader vshader(QOpenGLShader::Vertex);
+	// The halo quad is expanded here from the center and radius of the source,
+	// corner is one of (-1,-1), (1,-1), (-1,1), (1,1).
 	const char *vsrc =
 		"attribute mediump vec2 pos;\n"
-		"attribute mediump vec2 texCoord;\n"
+		"attribute mediump float radius;\n"
+		"attribute mediump vec2 corner;\n"
 		"attribute mediump vec3 color;\n"
 		"uniform mediump mat4 projectionMatrix;\n"
 		"varying mediump vec2 texc;\n"
 		"varying mediump vec3 outColor;\n"
 		"void main(void)\n"
 		"{\n"
-		"    gl_Position = projectionMatrix * vec4(pos.x, pos.y, 0, 1);\n"
-		"    texc = texCoord;\n"
+		"    gl_Position = projectionMatrix * vec4(pos + corner*radius, 0, 1);\n"
+		"    texc = corner*0.5 + 0.5;\n"
 		"    outColor = color;\n"
 		"}\n";
 	vshader.compileSourceCode(vsrc);
@@ -197,14 +201,92 @@ void StelSkyDrawer::init()
 	starShaderProgram->addShader(&fshader);
 	StelPainter::linkProg(starShaderProgram, "starShader");
 	starShaderVars.projectionMatrix = starShaderProgram->uniformLocation("projectionMatrix");
-	starShaderVars.texCoord = starShaderProgram->attributeLocation("texCoord");
+	starShaderVars.corner = starShaderProgram->attributeLocation("corner");
 	starShaderVars.pos = starShaderProgram->attributeLocation("pos");
+	starShaderVars.radius = starShaderProgram->attributeLocation("radius");
 	starShaderVars.color = starShaderProgram->attributeLocation("color");
 	starShaderVars.texture = starShaderProgram->uniformLocation("tex");
 
+	initPointSourceBuffers();
+
 	update(0);
 }
 
+void StelSkyDrawer::initPointSourceBuffers()
+{
+	// Instanced drawing needs OpenGL 3.3, OpenGL ES 3.0 or one of the extensions
+	QOpenGLContext* ctx = QOpenGLContext::currentContext();
+	const QSurfaceFormat format = ctx->format();
+	QList<QByteArray> suffixes;
+	if (ctx->isOpenGLES())
+	{
+		if (format.majorVersion()>=3)
+			suffixes << "";
+		if (ctx->hasExtension("GL_EXT_instanced_arrays"))
+			suffixes << "EXT";
+		if (ctx->hasExtension("GL_ANGLE_instanced_arrays"))
+			suffixes << "ANGLE";
+	}
+	else
+	{
+		if (format.version()>=qMakePair(3, 3))
+			suffixes << "";
+		if (ctx->hasExtension("GL_ARB_instanced_arrays") && ctx->hasExtension("GL_ARB_draw_instanced"))
+			suffixes << "ARB";
+	}
+	foreach (const QByteArray& suffix, suffixes)
+	{
+		vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorFunc>(ctx->getProcAddress("glVertexAttribDivisor"+suffix));
+		drawArraysInstanced = reinterpret_cast<DrawArraysInstancedFunc>(ctx->getProcAddress("glDrawArraysInstanced"+suffix));
+		if (vertexAttribDivisor && drawArraysInstanced)
+			break;
+	}
+	if (!vertexAttribDivisor || !drawArraysInstanced)
+	{
+		vertexAttribDivisor = Q_NULLPTR;
+		drawArraysInstanced = Q_NULLPTR;
+	}
+
+	static const GLfloat corners[] = {-1.f, -1.f, 1.f, -1.f, -1.f, 1.f, 1.f, 1.f};
+	starCornerBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	starCornerBuffer.create();
+	starCornerBuffer.bind();
+	if (drawArraysInstanced)
+	{
+		// One quad, drawn as triangle strip for each instance
+		starCornerBuffer.allocate(corners, sizeof(corners));
+		starCornerBuffer.release();
+	}
+	else
+	{
+		QVector<GLfloat> quadCorners;
+		quadCorners.reserve(maxPointSources*8);
+		for (unsigned int i=0; i<maxPointSources; ++i)
+			for (int j=0; j<8; ++j)
+				quadCorners.append(corners[j]);
+		starCornerBuffer.allocate(quadCorners.constData(), quadCorners.size()*sizeof(GLfloat));
+		starCornerBuffer.release();
+
+		QVector<GLushort> indices;
+		indices.reserve(maxPointSources*6);
+		for (unsigned int i=0; i<maxPointSources; ++i)
+		{
+			const GLushort first = i*4;
+			indices << first << first+1 << first+2 << first+2 << first+1 << first+3;
+		}
+		starIndexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+		starIndexBuffer.create();
+		starIndexBuffer.bind();
+		starIndexBuffer.allocate(indices.constData(), indices.size()*sizeof(GLushort));
+		starIndexBuffer.release();
+
+		quadVertexArray = new StarVertex[maxPointSources*4];
+	}
+
+	starVertexBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+	starVertexBuffer.create();
+}
+
 void StelSkyDrawer::update(double)
 {
 	float fov = core->getMovementMgr()->getCurrentFov();
@@ -398,39 +480,74 @@ void StelSkyDrawer::postDrawPointSource(StelPainter* sPainter)
 	const Mat4f& m = sPainter->getProjector()->getProjectionMatrix();
 	const QMatrix4x4 qMat(m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]);
 	
-	Q_ASSERT(sizeof(StarVertex)==12);
-	
+	Q_ASSERT(sizeof(StarVertex)==16);
+
+	// Upload the records, with instancing once per source, else once per quad corner.
+	// Allocating the full size again orphans the previous storage of the buffer.
+	starVertexBuffer.bind();
+	if (drawArraysInstanced)
+	{
+		starVertexBuffer.allocate(maxPointSources*sizeof(StarVertex));
+		starVertexBuffer.write(0, vertexArray, nbPointSources*sizeof(StarVertex));
+	}
+	else
+	{
+		for (unsigned int i=0; i<nbPointSources; ++i)
+		{
+			StarVertex* quad = &quadVertexArray[i*4];
+			quad[0] = quad[1] = quad[2] = quad[3] = vertexArray[i];
+		}
+		starVertexBuffer.allocate(maxPointSources*4*sizeof(StarVertex));
+		starVertexBuffer.write(0, quadVertexArray, nbPointSources*4*sizeof(StarVertex));
+	}
+
 	starShaderProgram->bind();
-	starShaderProgram->setAttributeArray(starShaderVars.pos, GL_FLOAT, (GLfloat*)vertexArray, 2, 12);
+	starShaderProgram->setAttributeBuffer(starShaderVars.pos, GL_FLOAT, 0, 2, sizeof(StarVertex));
 	starShaderProgram->enableAttributeArray(starShaderVars.pos);
-	starShaderProgram->setAttributeArray(starShaderVars.color, GL_UNSIGNED_BYTE, (GLubyte*)&(vertexArray[0].color), 3, 12);
+	starShaderProgram->setAttributeBuffer(starShaderVars.radius, GL_FLOAT, 8, 1, sizeof(StarVertex));
+	starShaderProgram->enableAttributeArray(starShaderVars.radius);
+	starShaderProgram->setAttributeBuffer(starShaderVars.color, GL_UNSIGNED_BYTE, 12, 3, sizeof(StarVertex));
 	starShaderProgram->enableAttributeArray(starShaderVars.color);
+	starVertexBuffer.release();
+	starCornerBuffer.bind();
+	starShaderProgram->setAttributeBuffer(starShaderVars.corner, GL_FLOAT, 0, 2, 0);
+	starShaderProgram->enableAttributeArray(starShaderVars.corner);
+	starCornerBuffer.release();
 	starShaderProgram->setUniformValue(starShaderVars.projectionMatrix, qMat);
-	starShaderProgram->setAttributeArray(starShaderVars.texCoord, GL_UNSIGNED_BYTE, (GLubyte*)textureCoordArray, 2, 0);
-	starShaderProgram->enableAttributeArray(starShaderVars.texCoord);
-	
-	glDrawArrays(GL_TRIANGLES, 0, nbPointSources*6);
+
+	if (drawArraysInstanced)
+	{
+		vertexAttribDivisor(starShaderVars.pos, 1);
+		vertexAttribDivisor(starShaderVars.radius, 1);
+		vertexAttribDivisor(starShaderVars.color, 1);
+		drawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, nbPointSources);
+		// The other shaders use the same attribute locations without instancing
+		vertexAttribDivisor(starShaderVars.pos, 0);
+		vertexAttribDivisor(starShaderVars.radius, 0);
+		vertexAttribDivisor(starShaderVars.color, 0);
+	}
+	else
+	{
+		starIndexBuffer.bind();
+		glDrawElements(GL_TRIANGLES, nbPointSources*6, GL_UNSIGNED_SHORT, Q_NULLPTR);
+		starIndexBuffer.release();
+	}
 	
 	starShaderProgram->disableAttributeArray(starShaderVars.pos);
+	starShaderProgram->disableAttributeArray(starShaderVars.radius);
 	starShaderProgram->disableAttributeArray(starShaderVars.color);
-	starShaderProgram->disableAttributeArray(starShaderVars.texCoord);
+	starShaderProgram->disableAttributeArray(starShaderVars.corner);
 	starShaderProgram->release();
 	
 	nbPointSources = 0;
 }
 
-// Draw a point source halo.
-bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const RCMag& rcMag, const Vec3f& color, bool checkInScreen, float twinkleFactor)
+// Store a point source halo in the buffers, drawing them if they are full.
+inline bool StelSkyDrawer::addPointSource(StelPainter* sPainter, const Vec2f& win, const RCMag& rcMag, const Vec3f& color, float twinkleFactor)
 {
-	Q_ASSERT(sPainter);
-
 	if (rcMag.radius<=0.f)
 		return false;
 
-	Vec3f win;
-	if (!(checkInScreen ? sPainter->getProjector()->projectCheck(v, win) : sPainter->getProjector()->project(v, win)))
-		return false;
-
 	const float radius = rcMag.radius;
 	// Random coef for star twinkling. twinkleFactor can introduce height-dependent twinkling.
 	const float tw = (flagStarTwinkle && (flagHasAtmosphere || flagForcedTwinkle)) ? (1.f-twinkleFactor*twinkleAmount*qrand()/RAND_MAX)*rcMag.luminance : rcMag.luminance;
@@ -454,14 +571,11 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 	starColor[1] = (unsigned char)std::min((int)(color[1]*tw*255+0.5f), 255);
 	starColor[2] = (unsigned char)std::min((int)(color[2]*tw*255+0.5f), 255);
 	
-	// Store the drawing instructions in the vertex arrays
-	StarVertex* vx = &(vertexArray[nbPointSources*6]);
-	vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]-radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
+	// Store the drawing instructions in the vertex arrays, the quad is expanded in the vertex shader
+	StarVertex* vx = &(vertexArray[nbPointSources]);
+	vx->pos = win;
+	vx->radius = radius;
+	memcpy(vx->color, starColor, 3);
 
 	++nbPointSources;
 	if (nbPointSources>=maxPointSources)
@@ -472,6 +586,34 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 	return true;
 }
 
+// Draw a point source halo.
+bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const RCMag& rcMag, const Vec3f& color, bool checkInScreen, float twinkleFactor)
+{
+	Q_ASSERT(sPainter);
+
+	if (rcMag.radius<=0.f)
+		return false;
+
+	const StelProjectorP prj = sPainter->getProjector();
+	Vec3f win;
+	if (!(checkInScreen ? prj->projectCheck(v, win) : prj->project(v, win)))
+		return false;
+
+	return addPointSource(sPainter, Vec2f(win[0], win[1]), rcMag, color, twinkleFactor);
+}
+
+int StelSkyDrawer::drawPointSources(StelPainter* sPainter, const PointSource* sources, int count, const RCMag* rcMagTable)
+{
+	Q_ASSERT(sPainter);
+	int drawn = 0;
+	for (const PointSource* s=sources; s<sources+count; ++s)
+	{
+		if (addPointSource(sPainter, s->win, rcMagTable[s->magIndex], colorTable[s->bV], s->twinkleFactor))
+			++drawn;
+	}
+	return drawn;
+}
+
 // Draw's the Sun's corona during a solar eclipse on Earth.
 void StelSkyDrawer::drawSunCorona(StelPainter* painter, const Vec3f& v, float radius, const Vec3f& color, const float alpha)
 {
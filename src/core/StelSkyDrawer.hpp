@@ -27,6 +27,7 @@
 #include "StelOpenGL.hpp"
 
 #include <QObject>
+#include <QOpenGLBuffer>
 
 class StelToneReproducer;
 class StelCore;
@@ -105,6 +106,24 @@ public:
 
 	bool drawPointSource(StelPainter* sPainter, const Vec3f& v, const RCMag &rcMag, const Vec3f& bcolor, bool checkInScreen=false, float twinkleFactor=1.0f);
 
+	//! Compact description of an already projected point source for drawPointSources()
+	struct PointSource
+	{
+		Vec2f win;			//!< position in window coordinates, as computed by StelProjector::project()
+		float twinkleFactor;		//!< see drawPointSource()
+		unsigned short magIndex;	//!< index of the source in the RCMag table
+		unsigned char bV;		//!< B-V color index, see indexToColor()
+	};
+
+	//! Draw many point source halos. Same as calling drawPointSource() for each of them, without the per-call overhead.
+	//! The sources are already projected, so that callers can keep the projected positions as long as the view does not change.
+	//! @param sPainter the StelPainter to use for drawing.
+	//! @param sources the sources to draw.
+	//! @param count the number of sources.
+	//! @param rcMagTable the radius and luminance for each magnitude index, as computed by computeRCMag()
+	//! @return the number of sources which were actually drawn
+	int drawPointSources(StelPainter* sPainter, const PointSource* sources, int count, const RCMag* rcMagTable);
+
 	void drawSunCorona(StelPainter* painter, const Vec3f& v, float radius, const Vec3f& color, const float alpha);
 
 	//! Terminate drawing of a 3D model, draw the halo
@@ -423,25 +442,47 @@ private:
 	//! The scaling applied to input luminance before they are converted by the StelToneReproducer
 	float inScale;
 
+	//! Store a point source halo at the projected position win in the buffers, see drawPointSource()
+	inline bool addPointSource(StelPainter* sPainter, const Vec2f& win, const RCMag& rcMag, const Vec3f& color, float twinkleFactor);
+
+	//! Create the GL buffers for the point sources and find out whether instanced drawing can be used
+	void initPointSourceBuffers();
+
 	// Variables used for GL optimization when displaying point sources
-	//! Vertex format for a point source.
-	//! Texture pos is stored in another separately.
+	//! Record for a point source as uploaded to the GPU.
+	//! The quad of the halo is expanded from it in the vertex shader.
 	struct StarVertex {
 		Vec2f pos;
+		float radius;
 		unsigned char color[4];
 	};
 	
-	//! Buffer for storing the vertex array data
+	//! Buffer for storing the point source records
 	StarVertex* vertexArray;
-
-	//! Buffer for storing the texture coordinate array data.
-	unsigned char* textureCoordArray;
+	//! The records repeated for each corner of the quads, if instanced drawing is not supported
+	StarVertex* quadVertexArray;
+
+	//! Buffer object for the point source records. It is orphaned before each upload,
+	//! so that the driver does not need to wait for the previous draw call.
+	QOpenGLBuffer starVertexBuffer;
+	//! Static quad corners: 4 in total with instanced drawing, else 4 per point source
+	QOpenGLBuffer starCornerBuffer;
+	//! Static indices for the triangles of the quads, if instanced drawing is not supported
+	QOpenGLBuffer starIndexBuffer;
+
+	typedef void (QOPENGLF_APIENTRYP VertexAttribDivisorFunc)(GLuint index, GLuint divisor);
+	typedef void (QOPENGLF_APIENTRYP DrawArraysInstancedFunc)(GLenum mode, GLint first, GLsizei count, GLsizei primcount);
+	//! glVertexAttribDivisor() and glDrawArraysInstanced(), or their ARB/EXT/ANGLE variants.
+	//! Both are Q_NULLPTR if instanced drawing is not supported.
+	VertexAttribDivisorFunc vertexAttribDivisor;
+	DrawArraysInstancedFunc drawArraysInstanced;
 	
 	class QOpenGLShaderProgram* starShaderProgram;
 	struct StarShaderVars {
 		int projectionMatrix;
-		int texCoord;
+		int corner;
 		int pos;
+		int radius;
 		int color;
 		int texture;
 	};
@@ -29,6 +29,8 @@
 #include <QDebug>
 #include <QSettings>
 #include <QOpenGLShaderProgram>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 inline bool myisnan(double value)
 {
@@ -252,6 +254,40 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
 	skyb.setDate(year, month, moonPhase, moonMagnitude);
 
+	// Compute the sky color for every point of the grid, in bands of rows on the global thread pool.
+	// Each band sums its luminances, which are added in band order for a reproducible average.
+	const int nbPoints = (1+skyResolutionX)*(1+skyResolutionY);
+	const int rowsPerBand = qMax(1, (1+skyResolutionY)/(4*QThreadPool::globalInstance()->maxThreadCount()));
+	QVector<GridBand> bands;
+	for (int row=0; row<=skyResolutionY; row+=rowsPerBand)
+	{
+		GridBand band;
+		band.begin = row*(1+skyResolutionX);
+		band.end = qMin(nbPoints, (row+rowsPerBand)*(1+skyResolutionX));
+		band.sumLuminance = 0.f;
+		bands.append(band);
+	}
+	const StelProjector* projector = prj.data();
+	QtConcurrent::blockingMap(bands, [this, projector, &sunPos, &moon_pos](GridBand& band) {
+		band.sumLuminance = computeGridColors(projector, sunPos, moon_pos, band.begin, band.end);
+	});
+
+	// Variables used to compute the average sky luminance
+	float sum_lum = 0.f;
+	foreach (const GridBand& band, bands)
+		sum_lum += band.sumLuminance;
+
+	colorGridBuffer.bind();
+	colorGridBuffer.write(0, colorGrid, (1+skyResolutionX)*(1+skyResolutionY)*4*4);
+	colorGridBuffer.release();
+	
+	// Update average luminance
+	if (!overrideAverageLuminance)
+		averageLuminance = sum_lum/((1+skyResolutionX)*(1+skyResolutionY));
+}
+
+float Atmosphere::computeGridColors(const StelProjector* prj, const float sunPos[3], const float moon_pos[3], int begin, int end)
+{
 	// Variables used to compute the average sky luminance
 	float sum_lum = 0.f;
 
@@ -259,7 +295,7 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 	float lumi;
 
 	// Compute the sky color for every point above the ground
-	for (int i=0; i<(1+skyResolutionX)*(1+skyResolutionY); ++i)
+	for (int i=begin; i<end; ++i)
 	{
 		const Vec2f &v(posGrid[i]);
 		prj->unProject(v[0],v[1],point);
@@ -302,14 +338,7 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 		// Store the back projected position + luminance in the input color to the shader
 		colorGrid[i].set(point[0], point[1], point[2], lumi);
 	}
-	
-	colorGridBuffer.bind();
-	colorGridBuffer.write(0, colorGrid, (1+skyResolutionX)*(1+skyResolutionY)*4*4);
-	colorGridBuffer.release();
-	
-	// Update average luminance
-	if (!overrideAverageLuminance)
-		averageLuminance = sum_lum/((1+skyResolutionX)*(1+skyResolutionY));
+	return sum_lum;
 }
 
 // override computable luminance. This is for special operations only, e.g. for scripting of brightness-balanced image export.
@@ -80,6 +80,18 @@ public:
 	float getLightPollutionLuminance() const { return lightPollutionLuminance; }
 
 private:
+	//! A range of points of the grid, computed as one work item
+	struct GridBand
+	{
+		int begin, end;
+		float sumLuminance;
+	};
+
+	//! Compute the position and luminance of the grid points [begin, end).
+	//! Only reads the models, so that disjoint ranges can be computed in parallel.
+	//! @return the sum of the luminances of the points
+	float computeGridColors(const StelProjector* prj, const float sunPos[3], const float moon_pos[3], int begin, int end);
+
 	Vec4i viewport;
 	Skylight sky;
 	Skybright skyb;
@@ -0,0 +1,326 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "ChebyshevEphemeris.hpp"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QVector>
+
+#include <cmath>
+
+namespace
+{
+	//! Number of segments allocated together
+	const int SEGMENTS_PER_BLOCK = 256;
+	//! Marks the segments which did not reach the tolerance
+	const double failedSegment[1] = {0.};
+	const quint32 FILE_MAGIC = 0x43484542; // "CHEB"
+	const qint32 FILE_VERSION = 1;
+	//! Points of the segments (in [-1,1]) where the fit is compared to the theory, between the nodes
+	const double checkPoints[] = {-0.97, -0.61, -0.18, 0.27, 0.66, 0.98};
+}
+
+struct ChebyshevEphemeris::Block
+{
+	QAtomicPointer<const double> segments[SEGMENTS_PER_BLOCK];
+};
+
+ChebyshevEphemeris::ChebyshevEphemeris(PositionFunction theory, const QString& name, double segmentLength, double windowStart, double windowEnd, double tolerance)
+	: theory(theory)
+	, name(name)
+	, segmentLength(segmentLength)
+	, tolerance(tolerance)
+	, firstSegment(0)
+	, segmentCount(0)
+	, blockCount(0)
+	, blocks(Q_NULLPTR)
+	, modified(0)
+	, warned(0)
+{
+	Q_ASSERT(segmentLength>0.);
+	if (windowEnd>windowStart)
+	{
+		firstSegment=static_cast<qint64>(std::floor(windowStart/segmentLength));
+		segmentCount=static_cast<int>(static_cast<qint64>(std::ceil(windowEnd/segmentLength))-firstSegment);
+		blockCount=(segmentCount+SEGMENTS_PER_BLOCK-1)/SEGMENTS_PER_BLOCK;
+		blocks=new QAtomicPointer<Block>[blockCount];
+	}
+}
+
+ChebyshevEphemeris::~ChebyshevEphemeris()
+{
+	for (int b=0; b<blockCount; ++b)
+	{
+		Block* block=blocks[b].load();
+		if (!block)
+			continue;
+		for (int i=0; i<SEGMENTS_PER_BLOCK; ++i)
+		{
+			const double* coefficients=block->segments[i].load();
+			if (coefficients!=failedSegment)
+				delete[] coefficients;
+		}
+		delete block;
+	}
+	delete[] blocks;
+}
+
+double ChebyshevEphemeris::segmentLengthForPeriod(double period)
+{
+	// Eight segments per revolution keep the degree 12 fits well below the tolerance.
+	// Long segments are limited because the slow terms of the theories still need to be followed.
+	const double maxLength=8.;
+	if (period<=0.)
+		return maxLength;
+	return qMin(std::fabs(period)/8., maxLength);
+}
+
+void ChebyshevEphemeris::position(double JDE, double xyz[3])
+{
+	const double s=JDE/segmentLength;
+	const qint64 k=static_cast<qint64>(std::floor(s));
+	const qint64 index=k-firstSegment;
+	if (index>=0 && index<segmentCount)
+	{
+		const double* coefficients=segment(static_cast<int>(index));
+		if (coefficients!=failedSegment)
+		{
+			evaluate(coefficients, 2.*(s-k)-1., xyz);
+			return;
+		}
+	}
+	theory(JDE, xyz, Q_NULLPTR);
+}
+
+const double* ChebyshevEphemeris::segment(int index)
+{
+	Block* block=blocks[index/SEGMENTS_PER_BLOCK].loadAcquire();
+	if (block)
+	{
+		const double* coefficients=block->segments[index%SEGMENTS_PER_BLOCK].loadAcquire();
+		if (coefficients)
+			return coefficients;
+	}
+	const double* coefficients=fit((firstSegment+index)*segmentLength);
+	if (!coefficients)
+	{
+		if (warned.testAndSetRelaxed(0, 1))
+			qWarning() << "ChebyshevEphemeris: some segments of" << name << "do not reach the tolerance, the theory is used there.";
+		coefficients=failedSegment;
+	}
+	else
+		modified.storeRelease(1);
+	return storeSegment(index, coefficients);
+}
+
+const double* ChebyshevEphemeris::storeSegment(int index, const double* coefficients)
+{
+	QAtomicPointer<Block>& blockPtr=blocks[index/SEGMENTS_PER_BLOCK];
+	Block* block=blockPtr.loadAcquire();
+	if (!block)
+	{
+		Block* newBlock=new Block;
+		if (blockPtr.testAndSetOrdered(Q_NULLPTR, newBlock))
+			block=newBlock;
+		else
+		{
+			delete newBlock;
+			block=blockPtr.loadAcquire();
+		}
+	}
+	QAtomicPointer<const double>& segmentPtr=block->segments[index%SEGMENTS_PER_BLOCK];
+	if (segmentPtr.testAndSetOrdered(Q_NULLPTR, coefficients))
+		return coefficients;
+	// Another thread stored the same segment first.
+	if (coefficients!=failedSegment)
+		delete[] coefficients;
+	return segmentPtr.loadAcquire();
+}
+
+double* ChebyshevEphemeris::fit(double start) const
+{
+	// Interpolation at the Chebyshev nodes, the coefficients are given by a discrete cosine transform.
+	const int n=COEFFICIENTS;
+	double values[COEFFICIENTS][3];
+	for (int j=0; j<n; ++j)
+	{
+		const double x=std::cos(M_PI*(j+0.5)/n);
+		theory(start+0.5*segmentLength*(x+1.), values[j], Q_NULLPTR);
+	}
+	double* coefficients=new double[3*COEFFICIENTS];
+	for (int i=0; i<3; ++i)
+	{
+		for (int k=0; k<n; ++k)
+		{
+			double sum=0.;
+			for (int j=0; j<n; ++j)
+				sum+=values[j][i]*std::cos(M_PI*k*(j+0.5)/n);
+			coefficients[i*COEFFICIENTS+k]=(k==0 ? 1. : 2.)*sum/n;
+		}
+	}
+
+	for (unsigned int i=0; i<sizeof(checkPoints)/sizeof(checkPoints[0]); ++i)
+	{
+		const double x=checkPoints[i];
+		double expected[3], fitted[3];
+		theory(start+0.5*segmentLength*(x+1.), expected, Q_NULLPTR);
+		evaluate(coefficients, x, fitted);
+		const double distance=std::sqrt(expected[0]*expected[0]+expected[1]*expected[1]+expected[2]*expected[2]);
+		const double dx=fitted[0]-expected[0], dy=fitted[1]-expected[1], dz=fitted[2]-expected[2];
+		if (!(std::sqrt(dx*dx+dy*dy+dz*dz)<=tolerance*distance))
+		{
+			delete[] coefficients;
+			return Q_NULLPTR;
+		}
+	}
+	return coefficients;
+}
+
+void ChebyshevEphemeris::evaluate(const double* coefficients, double x, double xyz[3])
+{
+	// Clenshaw recurrence
+	for (int i=0; i<3; ++i)
+	{
+		const double* c=coefficients+i*COEFFICIENTS;
+		double b1=0., b2=0.;
+		for (int k=COEFFICIENTS-1; k>0; --k)
+		{
+			const double b=2.*x*b1-b2+c[k];
+			b2=b1;
+			b1=b;
+		}
+		xyz[i]=x*b1-b2+c[0];
+	}
+}
+
+void ChebyshevEphemeris::prefill(double start, double end, const QAtomicInt* cancelled)
+{
+	const qint64 first=qMax(static_cast<qint64>(std::floor(start/segmentLength))-firstSegment, Q_INT64_C(0));
+	const qint64 last=qMin(static_cast<qint64>(std::ceil(end/segmentLength))-firstSegment, static_cast<qint64>(segmentCount));
+	for (qint64 index=first; index<last; ++index)
+	{
+		if (cancelled && cancelled->load())
+			return;
+		segment(static_cast<int>(index));
+	}
+}
+
+int ChebyshevEphemeris::getFittedSegmentCount() const
+{
+	int count=0;
+	for (int b=0; b<blockCount; ++b)
+	{
+		const Block* block=blocks[b].loadAcquire();
+		if (!block)
+			continue;
+		for (int i=0; i<SEGMENTS_PER_BLOCK; ++i)
+			if (block->segments[i].loadAcquire())
+				++count;
+	}
+	return count;
+}
+
+bool ChebyshevEphemeris::save(const QString& fileName, const QString& stamp) const
+{
+	QDir().mkpath(QFileInfo(fileName).absolutePath());
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning() << "ChebyshevEphemeris: cannot write" << QDir::toNativeSeparators(fileName);
+		return false;
+	}
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_5_2);
+	out << FILE_MAGIC << FILE_VERSION << stamp << segmentLength << static_cast<qint32>(COEFFICIENTS);
+
+	QVector<qint64> fitted;
+	for (int b=0; b<blockCount; ++b)
+	{
+		const Block* block=blocks[b].loadAcquire();
+		if (!block)
+			continue;
+		for (int i=0; i<SEGMENTS_PER_BLOCK; ++i)
+		{
+			const double* coefficients=block->segments[i].loadAcquire();
+			if (coefficients && coefficients!=failedSegment)
+				fitted << static_cast<qint64>(b)*SEGMENTS_PER_BLOCK+i;
+		}
+	}
+	out << static_cast<qint32>(fitted.size());
+	for (qint64 index : fitted)
+	{
+		const double* coefficients=blocks[index/SEGMENTS_PER_BLOCK].loadAcquire()->segments[index%SEGMENTS_PER_BLOCK].loadAcquire();
+		out << firstSegment+index;
+		for (int i=0; i<3*COEFFICIENTS; ++i)
+			out << coefficients[i];
+	}
+	if (out.status()!=QDataStream::Ok || !file.commit())
+	{
+		qWarning() << "ChebyshevEphemeris: cannot write" << QDir::toNativeSeparators(fileName);
+		return false;
+	}
+	modified.storeRelease(0);
+	return true;
+}
+
+bool ChebyshevEphemeris::load(const QString& fileName, const QString& stamp)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_5_2);
+	quint32 magic;
+	qint32 version, coefficientCount, count;
+	QString fileStamp;
+	double fileSegmentLength;
+	in >> magic >> version;
+	if (magic!=FILE_MAGIC || version!=FILE_VERSION)
+		return false;
+	in >> fileStamp >> fileSegmentLength >> coefficientCount >> count;
+	if (in.status()!=QDataStream::Ok || fileStamp!=stamp || fileSegmentLength!=segmentLength || coefficientCount!=COEFFICIENTS || count<0)
+		return false;
+
+	for (qint32 n=0; n<count; ++n)
+	{
+		qint64 k;
+		in >> k;
+		double* coefficients=new double[3*COEFFICIENTS];
+		for (int i=0; i<3*COEFFICIENTS; ++i)
+			in >> coefficients[i];
+		if (in.status()!=QDataStream::Ok)
+		{
+			delete[] coefficients;
+			qWarning() << "ChebyshevEphemeris: truncated file" << QDir::toNativeSeparators(fileName);
+			return false;
+		}
+		const qint64 index=k-firstSegment;
+		if (index>=0 && index<segmentCount)
+			storeSegment(static_cast<int>(index), coefficients);
+		else
+			delete[] coefficients;
+	}
+	return true;
+}
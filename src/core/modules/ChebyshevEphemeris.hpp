@@ -0,0 +1,107 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _CHEBYSHEVEPHEMERIS_HPP_
+#define _CHEBYSHEVEPHEMERIS_HPP_
+
+#include <QAtomicPointer>
+#include <QAtomicInt>
+#include <QString>
+
+//! @class ChebyshevEphemeris
+//! Cache of the positions given by an ephemeris theory (VSOP87, ELP82B, DE430/431, the theories of the planetary
+//! satellites...) for one body, as Chebyshev polynomials fitted over segments of fixed length.
+//! The segments are on a fixed grid of dates and are fitted when a date in them is first requested
+//! (or in advance with prefill()), inside a window of dates given at creation. Outside the window,
+//! or where the fit does not reproduce the theory to the required accuracy, the theory is evaluated directly.
+//! A position from a fitted segment only costs a few dozen multiply-adds instead of the evaluation of the series.
+//! The fitted segments can be saved to and loaded from a file, so that they are kept between sessions.
+//! All methods may be called from several threads at once: segments are published atomically and never change afterwards.
+class ChebyshevEphemeris
+{
+public:
+	//! Signature of the position functions of the theories, see posFuncType in Planet.hpp
+	typedef void (*PositionFunction)(double, double*, void*);
+
+	//! Number of coefficients of each coordinate of a segment (degree+1)
+	static const int COEFFICIENTS = 13;
+
+	//! @param theory the theory, called with a Q_NULLPTR user data pointer
+	//! @param name a name for the messages, usually the English name of the body
+	//! @param segmentLength the length of the segments in days
+	//! @param windowStart, windowEnd the dates (JDE) between which the positions are cached
+	//! @param tolerance the maximum difference to the theory of the fitted positions, relative to the distance to the centre.
+	//! It is checked at six dates between the nodes of each segment, not over the whole segment. The default
+	//! (about 0.2 arc seconds) is below the accuracy of the theories, some of which interpolate their own terms.
+	ChebyshevEphemeris(PositionFunction theory, const QString& name, double segmentLength, double windowStart, double windowEnd, double tolerance=1e-6);
+	~ChebyshevEphemeris();
+
+	//! Compute the position of the body at JDE, like the theory.
+	void position(double JDE, double xyz[3]);
+
+	//! Fit all segments of the window between start and end which are not fitted yet.
+	//! @param cancelled if given, stop as soon as it is set
+	void prefill(double start, double end, const QAtomicInt* cancelled=Q_NULLPTR);
+
+	//! Write the fitted segments to fileName.
+	//! @param stamp identifies the theory and the program, the file is only read back with the same stamp
+	bool save(const QString& fileName, const QString& stamp) const;
+	//! Read the segments from fileName written with the same stamp and segment length, for the part of the window they cover.
+	bool load(const QString& fileName, const QString& stamp);
+
+	//! Whether segments have been fitted since the last save() or load().
+	bool isModified() const {return modified.load()!=0;}
+	//! Get the number of fitted segments, including those which did not reach the tolerance.
+	int getFittedSegmentCount() const;
+
+	PositionFunction getTheory() const {return theory;}
+	const QString& getName() const {return name;}
+	double getSegmentLength() const {return segmentLength;}
+
+	//! Get a segment length (days) suited to a body with the given orbital period (days), or 0 if unknown.
+	static double segmentLengthForPeriod(double period);
+
+private:
+	//! Segments of the window, allocated by block of SEGMENTS_PER_BLOCK when the first segment of the block is fitted.
+	//! A segment is Q_NULLPTR until fitted, then points to 3*COEFFICIENTS coefficients, or to failedSegment.
+	struct Block;
+
+	//! Get the segment with index (from the start of the window), fitting it if needed.
+	const double* segment(int index);
+	//! Publish the coefficients of a segment, unless another thread was faster. Takes ownership of coefficients.
+	const double* storeSegment(int index, const double* coefficients);
+	//! Fit the segment starting at start, or return Q_NULLPTR if it does not reach the tolerance.
+	double* fit(double start) const;
+	static void evaluate(const double* coefficients, double x, double xyz[3]);
+
+	PositionFunction theory;
+	QString name;
+	double segmentLength;
+	double tolerance;
+	//! Index on the grid of all dates of the first segment of the window
+	qint64 firstSegment;
+	int segmentCount;
+	int blockCount;
+	QAtomicPointer<Block>* blocks;
+	mutable QAtomicInt modified;
+	QAtomicInt warned;
+};
+
+#endif // _CHEBYSHEVEPHEMERIS_HPP_
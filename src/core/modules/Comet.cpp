@@ -302,18 +302,18 @@ double Comet::getSiderealPeriod() const
 	return period;
 }
 
-float Comet::getVMagnitude(const StelCore* core) const
+float Comet::computeVMagnitude(const MagnitudeGeometry& geometry) const
 {
 	//If the two parameter system is not used,
 	//use the default radius/albedo mechanism
 	if (slopeParameter < 0)
 	{
-		return Planet::getVMagnitude(core);
+		return Planet::computeVMagnitude(geometry);
 	}
 
 	//Calculate distances
-	const Vec3d& observerHeliocentricPosition = core->getObserverHeliocentricEclipticPos();
-	const Vec3d& cometHeliocentricPosition = getHeliocentricEclipticPos();
+	const Vec3d& observerHeliocentricPosition = geometry.observerHelioPos;
+	const Vec3d& cometHeliocentricPosition = geometry.planetHelioPos;
 	const double cometSunDistance = cometHeliocentricPosition.length();
 	const double observerCometDistance = (observerHeliocentricPosition - cometHeliocentricPosition).length();
 
@@ -0,0 +1,227 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "EphemerisContext.hpp"
+#include "SolarSystem.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelObserver.hpp"
+#include "StelSkyDrawer.hpp"
+#include "StelUtils.hpp"
+
+#include <cmath>
+
+// Light time in days per AU
+#define LIGHT_TIME_PER_AU (AU / (SPEED_OF_LIGHT * 86400.))
+
+EphemerisContext::EphemerisContext()
+	: core(Q_NULLPTR)
+	, flagTopocentric(false)
+	, flagLightTravelTime(false)
+	, flagAtmosphere(false)
+	, observerRho(0.)
+	, observerSigma(0.)
+{
+}
+
+EphemerisContext::EphemerisContext(StelCore* core)
+	: core(core)
+	, homePlanet(core->getCurrentPlanet())
+	, location(core->getCurrentLocation())
+	, flagTopocentric(core->getUseTopocentricCoordinates())
+	, flagAtmosphere(core->getSkyDrawer()->getFlagHasAtmosphere())
+	, refraction(core->getSkyDrawer()->getRefraction())
+	, extinction(core->getSkyDrawer()->getExtinction())
+{
+	setSolarSystem(GETSTELMODULE(SolarSystem));
+
+	// See StelCore::updateTransformMatrices()
+	const StelObserver* observer = core->getCurrentObserver();
+	const Vec3d offset = observer->getTopographicOffsetFromCenter();
+	observerSigma = location.latitude*M_PI/180.0 - offset.v[2];
+	observerRho = observer->getDistanceFromCenter();
+}
+
+EphemerisContext::EphemerisContext(const SolarSystem* ssystem, const PlanetP& homePlanet)
+	: core(Q_NULLPTR)
+	, homePlanet(homePlanet)
+	, flagTopocentric(false)
+	, flagAtmosphere(false)
+	, observerRho(0.)
+	, observerSigma(0.)
+{
+	location.planetName = homePlanet->getEnglishName();
+	setSolarSystem(ssystem);
+}
+
+void EphemerisContext::setSolarSystem(const SolarSystem* ssystem)
+{
+	sun = ssystem->getSun();
+	earth = ssystem->getEarth();
+	flagLightTravelTime = ssystem->getFlagLightTravelTime();
+	foreach (const PlanetP& p, ssystem->getAllPlanets())
+	{
+		if (p->getParent()==homePlanet)
+			homeSatellites.append(p);
+	}
+}
+
+double EphemerisContext::getJDE(double JD) const
+{
+	if (!core)
+		return JD;
+	return JD + core->computeDeltaT(JD)/86400.;
+}
+
+// Same as StelCore::matAltAzToHeliocentricEclipticJ2000 without the translations
+Mat4d EphemerisContext::getAltAzToVsop87(double JD, double JDE) const
+{
+	double lat = qBound(-90., (double)location.latitude, 90.);
+	const Mat4d altAzToEquinoxEqu = Mat4d::zrotation((homePlanet->getSiderealTime(JD, JDE)+location.longitude)*M_PI/180.)
+				       * Mat4d::yrotation((90.-lat)*M_PI/180.);
+	return homePlanet->computeRotEquatorialToVsop87(JDE) * altAzToEquinoxEqu;
+}
+
+Mat4d EphemerisContext::getJ2000ToAltAz(double JD) const
+{
+	return getAltAzToVsop87(JD, getJDE(JD)).transpose() * StelCore::matJ2000ToVsop87;
+}
+
+Vec3d EphemerisContext::j2000ToAltAz(const Vec3d& j2000Pos, double JD, bool withRefraction) const
+{
+	Vec3d r = getJ2000ToAltAz(JD).multiplyWithoutTranslation(j2000Pos);
+	if (withRefraction && flagAtmosphere)
+		refraction.forward(r);
+	return r;
+}
+
+Vec3d EphemerisContext::getObserverHeliocentricEclipticPos(double JD, double JDE, const Vec3d& homePlanetPos) const
+{
+	if (!flagTopocentric)
+		return homePlanetPos;
+	return homePlanetPos + getAltAzToVsop87(JD, JDE).multiplyWithoutTranslation(Vec3d(observerRho*std::sin(observerSigma), 0., observerRho*std::cos(observerSigma)));
+}
+
+Vec3d EphemerisContext::getObserverHeliocentricEclipticPos(double JD) const
+{
+	const double JDE = getJDE(JD);
+	return getObserverHeliocentricEclipticPos(JD, JDE, homePlanet->computeHeliocentricEclipticPos(JDE));
+}
+
+// Same corrections as SolarSystem::computePositions()
+Vec3d EphemerisContext::getApparentHeliocentricPos(const Planet* planet, double JDE, const Vec3d& homePlanetPos, double* lightTimeJDE) const
+{
+	if (!flagLightTravelTime)
+	{
+		*lightTimeJDE = JDE;
+		return planet->computeHeliocentricEclipticPos(JDE);
+	}
+	if (planet==sun.data())
+	{
+		*lightTimeJDE = JDE - homePlanetPos.length()*LIGHT_TIME_PER_AU;
+		return homePlanetPos - homePlanet->computeHeliocentricEclipticPos(*lightTimeJDE);
+	}
+	const Vec3d pos = planet->computeHeliocentricEclipticPos(JDE);
+	*lightTimeJDE = JDE - (pos-homePlanetPos).length()*LIGHT_TIME_PER_AU;
+	return planet->computeHeliocentricEclipticPos(*lightTimeJDE);
+}
+
+Vec3d EphemerisContext::getJ2000EquatorialPos(const Planet* planet, double JD) const
+{
+	const double JDE = getJDE(JD);
+	const Vec3d homePlanetPos = homePlanet->computeHeliocentricEclipticPos(JDE);
+	double lightTimeJDE;
+	const Vec3d pos = getApparentHeliocentricPos(planet, JDE, homePlanetPos, &lightTimeJDE);
+	return StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(pos - getObserverHeliocentricEclipticPos(JD, JDE, homePlanetPos));
+}
+
+Vec3d EphemerisContext::getEquinoxEquatorialPos(const Planet* planet, double JD) const
+{
+	const double JDE = getJDE(JD);
+	const Vec3d homePlanetPos = homePlanet->computeHeliocentricEclipticPos(JDE);
+	double lightTimeJDE;
+	const Vec3d pos = getApparentHeliocentricPos(planet, JDE, homePlanetPos, &lightTimeJDE);
+	const Mat4d vsop87ToEquinoxEqu = homePlanet->computeRotEquatorialToVsop87(JDE).transpose();
+	return vsop87ToEquinoxEqu.multiplyWithoutTranslation(pos - getObserverHeliocentricEclipticPos(JD, JDE, homePlanetPos));
+}
+
+double EphemerisContext::computeEclipseFactor(double JDE, const Vec3d& observerPos, const Vec3d& homePlanetPos) const
+{
+	double lightTimeJDE;
+	const Vec3d sunPos = getApparentHeliocentricPos(sun.data(), JDE, homePlanetPos, &lightTimeJDE);
+	double illumination = 1.;
+	foreach (const PlanetP& p, homeSatellites)
+	{
+		const Vec3d pos = getApparentHeliocentricPos(p.data(), JDE, homePlanetPos, &lightTimeJDE);
+		illumination = qMin(illumination, SolarSystem::computeEclipseIllumination(sunPos, sun->getRadius(), observerPos, pos, p->getRadius()));
+	}
+	return illumination;
+}
+
+EphemerisContext::BodyState EphemerisContext::computeState(const Planet* planet, double JD) const
+{
+	BodyState state;
+	state.JD = JD;
+	state.JDE = getJDE(JD);
+	const Vec3d homePlanetPos = homePlanet->computeHeliocentricEclipticPos(state.JDE);
+	state.observerHeliocentricPos = getObserverHeliocentricEclipticPos(JD, state.JDE, homePlanetPos);
+
+	double lightTimeJDE;
+	const Vec3d apparentPos = getApparentHeliocentricPos(planet, state.JDE, homePlanetPos, &lightTimeJDE);
+	// The Sun stays at the origin for phase and magnitude, only its apparent direction is corrected.
+	state.heliocentricPos = (planet==sun.data()) ? Vec3d(0.) : apparentPos;
+	state.j2000Pos = StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(apparentPos - state.observerHeliocentricPos);
+	state.distance = state.j2000Pos.length();
+
+	const Mat4d j2000ToAltAz = getAltAzToVsop87(JD, state.JDE).transpose() * StelCore::matJ2000ToVsop87;
+	state.altAzPosGeometric = j2000ToAltAz.multiplyWithoutTranslation(state.j2000Pos);
+	state.altAzPosAuto = state.altAzPosGeometric;
+	if (flagAtmosphere)
+		refraction.forward(state.altAzPosAuto);
+
+	// Phase and elongation as in Planet::getPhaseAngle(), Planet::getPhase() and Planet::getElongation()
+	const double observerRq = state.observerHeliocentricPos.lengthSquared();
+	const double planetRq = state.heliocentricPos.lengthSquared();
+	const double observerPlanetRq = (state.observerHeliocentricPos - state.heliocentricPos).lengthSquared();
+	const double cos_chi = (observerPlanetRq + planetRq - observerRq)/(2.0*std::sqrt(observerPlanetRq*planetRq));
+	state.phaseAngle = std::acos(cos_chi);
+	state.phase = 0.5f * qAbs(1.f + cos_chi);
+	state.elongation = std::acos((observerPlanetRq + observerRq - planetRq)/(2.0*std::sqrt(observerPlanetRq*observerRq)));
+
+	Planet::MagnitudeGeometry geometry;
+	geometry.observerHelioPos = state.observerHeliocentricPos;
+	geometry.planetHelioPos = state.heliocentricPos;
+	geometry.parentHelioPos = planet->getParent() ? planet->getParent()->computeHeliocentricEclipticPos(lightTimeJDE) : Vec3d(0.);
+	geometry.earthHelioPos = earth->computeHeliocentricEclipticPos(state.JDE);
+	geometry.JDE = state.JDE;
+	geometry.observerOnEarth = (location.planetName=="Earth");
+	geometry.eclipseFactor = (planet==sun.data()) ? computeEclipseFactor(state.JDE, state.observerHeliocentricPos, homePlanetPos) : 1.;
+	state.vMagnitude = planet->computeVMagnitude(geometry);
+
+	// See StelObject::getVMagnitudeWithExtinction()
+	state.vMagnitudeWithExtinction = state.vMagnitude;
+	if (flagAtmosphere)
+	{
+		Vec3d altAzPos = state.altAzPosGeometric;
+		altAzPos.normalize();
+		extinction.forward(altAzPos, &state.vMagnitudeWithExtinction);
+	}
+	return state;
+}
@@ -0,0 +1,136 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _EPHEMERISCONTEXT_HPP_
+#define _EPHEMERISCONTEXT_HPP_
+
+#include "Planet.hpp"
+#include "RefractionExtinction.hpp"
+#include "StelLocation.hpp"
+#include "VecMath.hpp"
+
+#include <QList>
+
+class SolarSystem;
+class StelCore;
+
+//! @class EphemerisContext
+//! Computes positions, magnitudes and horizontal coordinates of solar system bodies at arbitrary dates
+//! without changing the state of the bodies, of SolarSystem or of StelCore.
+//! The context copies the observer location, the correction settings and the atmosphere of the core when it is created,
+//! and only computes the requested body and its parents for each date. Tools sampling many dates (AstroCalc graphs,
+//! ephemerides, phenomena searches) therefore do not have to call StelCore::setJD() and StelCore::update() for each
+//! sample, and the sky view is left untouched. All methods are const and may be called from several threads at once,
+//! as the ephemeris, precession and nutation caches they use are kept per thread. The bodies must not be reloaded
+//! meanwhile, see SolarSystem::solarSystemDataAboutToReload() and SolarSystem::getReloadLock().
+//! The observer is assumed to stay at the same location of the same planet for all dates.
+class EphemerisContext
+{
+public:
+	//! Apparent circumstances of a body at a date
+	struct BodyState
+	{
+		double JD;
+		double JDE;
+		//! Heliocentric ecliptic position of the body (AU), corrected for light time if enabled
+		Vec3d heliocentricPos;
+		//! Heliocentric ecliptic position of the observer (AU)
+		Vec3d observerHeliocentricPos;
+		//! Position relative to the observer in equatorial J2000 coordinates (AU), see Planet::getJ2000EquatorialPos()
+		Vec3d j2000Pos;
+		//! Horizontal position without refraction
+		Vec3d altAzPosGeometric;
+		//! Horizontal position with refraction if the atmosphere is enabled, see StelObject::getAltAzPosAuto()
+		Vec3d altAzPosAuto;
+		//! Distance from the observer (AU)
+		double distance;
+		double phaseAngle;
+		float phase;
+		double elongation;
+		float vMagnitude;
+		float vMagnitudeWithExtinction;
+	};
+
+	//! Create an invalid context, to be assigned later.
+	EphemerisContext();
+	//! Create a context for the current observer and settings of core.
+	explicit EphemerisContext(StelCore* core);
+	//! Create a context for an observer at the center of homePlanet, without atmosphere and without DeltaT (JDE = JD).
+	//! The light time correction follows the setting of ssystem. Used where no StelCore is available, e.g. in unit tests.
+	EphemerisContext(const SolarSystem* ssystem, const PlanetP& homePlanet);
+
+	bool isValid() const {return !homePlanet.isNull();}
+
+	//! Get the planet of the observer.
+	const Planet* getHomePlanet() const {return homePlanet.data();}
+
+	//! Get the JDE (TT) corresponding to JD (UT), using the DeltaT algorithm of the core if there is one.
+	double getJDE(double JD) const;
+
+	//! Get the heliocentric ecliptic position of the observer at JD, including the topocentric offset if enabled.
+	Vec3d getObserverHeliocentricEclipticPos(double JD) const;
+
+	//! Get the matrix transforming equatorial J2000 coordinates to horizontal coordinates at JD.
+	Mat4d getJ2000ToAltAz(double JD) const;
+
+	//! Transform equatorial J2000 coordinates to horizontal coordinates at JD, with refraction if withRefraction
+	//! is true and the atmosphere is enabled.
+	Vec3d j2000ToAltAz(const Vec3d& j2000Pos, double JD, bool withRefraction) const;
+
+	//! Get the position of a body relative to the observer at JD in equatorial J2000 coordinates (AU).
+	//! This is faster than computeState() when only positions are needed.
+	Vec3d getJ2000EquatorialPos(const Planet* planet, double JD) const;
+
+	//! Get the position of a body relative to the observer at JD in equatorial coordinates of date (AU),
+	//! see StelObject::getEquinoxEquatorialPos().
+	Vec3d getEquinoxEquatorialPos(const Planet* planet, double JD) const;
+
+	//! Compute all circumstances of a body at JD.
+	BodyState computeState(const Planet* planet, double JD) const;
+
+private:
+	//! Get the light time corrected heliocentric position of a body for an observer whose planet is at
+	//! homePlanetPos at JDE. For the Sun this is the position used for rendering, see SolarSystem::getLightTimeSunPosition().
+	Vec3d getApparentHeliocentricPos(const Planet* planet, double JDE, const Vec3d& homePlanetPos, double* lightTimeJDE) const;
+	Vec3d getObserverHeliocentricEclipticPos(double JD, double JDE, const Vec3d& homePlanetPos) const;
+	Mat4d getAltAzToVsop87(double JD, double JDE) const;
+	//! Fraction of the solar disk visible to the observer, only taking the satellites of the observer's planet into account.
+	double computeEclipseFactor(double JDE, const Vec3d& observerPos, const Vec3d& homePlanetPos) const;
+	//! Copy the bodies and the light time setting of ssystem.
+	void setSolarSystem(const SolarSystem* ssystem);
+
+	//! May be null, see EphemerisContext(const SolarSystem*, const PlanetP&)
+	StelCore* core;
+	PlanetP homePlanet;
+	PlanetP sun;
+	PlanetP earth;
+	//! Satellites of the observer's planet, which may eclipse the Sun
+	QList<PlanetP> homeSatellites;
+	StelLocation location;
+	bool flagTopocentric;
+	bool flagLightTravelTime;
+	bool flagAtmosphere;
+	//! Topocentric offset of the observer from the center of its planet, see StelCore::updateTransformMatrices()
+	double observerRho;
+	double observerSigma;
+	Refraction refraction;
+	Extinction extinction;
+};
+
+#endif // _EPHEMERISCONTEXT_HPP_
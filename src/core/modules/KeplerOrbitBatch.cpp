@@ -0,0 +1,439 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "KeplerOrbitBatch.hpp"
+#include "Orbit.hpp"
+
+#include <cmath>
+#include <QVarLengthArray>
+#include <QtConcurrent>
+
+#if defined(__AVX__)
+ #include <immintrin.h>
+ #define KEPLER_BATCH_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define KEPLER_BATCH_SSE2
+#endif
+
+// Same as in Orbit.cpp
+#define GAUSS_GRAV_CONST (0.01720209895*0.01720209895)
+
+// Orbits per work unit. Also bounds the temporary arrays of computeChunk().
+#define KEPLER_BATCH_CHUNK_SIZE 1024
+
+namespace
+{
+	// Cody-Waite reduction of x by k*pi/2, and the minimax polynomials for [-pi/4, pi/4], from the Cephes library
+	const double DP1 = 1.57079625129699707031;
+	const double DP2 = 7.54978941586159635336E-8;
+	const double DP3 = 5.39030285815811905290E-15;
+	const double sinCoeff[6] = {
+		 1.58962301576546568060E-10,
+		-2.50507477628578072866E-8,
+		 2.75573136213857245213E-6,
+		-1.98412698295895385996E-4,
+		 8.33333333332211858878E-3,
+		-1.66666666666666307295E-1 };
+	const double cosCoeff[6] = {
+		-1.13585365213876817300E-11,
+		 2.08757008419747316778E-9,
+		-2.75573141792967388112E-7,
+		 2.48015872888517045348E-5,
+		-1.38888888888730564116E-3,
+		 4.16666666666665929218E-2 };
+
+	//! One double per "register", used for the remainders of the SIMD loops and without SIMD support.
+	struct ScalarOps
+	{
+		typedef double V;
+		typedef bool Mask;
+		static const int width = 1;
+		static inline V load(const double* p) { return *p; }
+		static inline void store(double* p, V v) { *p = v; }
+		static inline V set1(double d) { return d; }
+		static inline V add(V a, V b) { return a+b; }
+		static inline V sub(V a, V b) { return a-b; }
+		static inline V mul(V a, V b) { return a*b; }
+		static inline V div(V a, V b) { return a/b; }
+		static inline V sqrt(V a) { return std::sqrt(a); }
+		static inline V abs(V a) { return std::fabs(a); }
+		static inline V neg(V a) { return -a; }
+		static inline Mask isNegative(V a) { return a<0.; }
+		static inline V select(Mask m, V a, V b) { return m ? a : b; }
+		//! Round to the nearest integer, and return the quadrant masks for k*pi/2.
+		static inline V quadrant(V y, Mask& swap, Mask& negSin, Mask& negCos)
+		{
+			const double k = std::floor(y+0.5);
+			const int ki = static_cast<int>(k);
+			swap = (ki & 1) != 0;
+			negSin = (ki & 2) != 0;
+			negCos = ((ki+1) & 2) != 0;
+			return k;
+		}
+	};
+
+#if defined(KEPLER_BATCH_SSE2) || defined(KEPLER_BATCH_AVX)
+	//! Quadrant masks for 32-bit integers k in an SSE2 register.
+	inline void quadrantMasks32(__m128i k, __m128i& swap, __m128i& negSin, __m128i& negCos)
+	{
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		swap   = _mm_cmpeq_epi32(_mm_and_si128(k, one), one);
+		negSin = _mm_cmpeq_epi32(_mm_and_si128(k, two), two);
+		negCos = _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(k, one), two), two);
+	}
+#endif
+
+#if defined(KEPLER_BATCH_SSE2)
+	struct SimdOps
+	{
+		typedef __m128d V;
+		typedef __m128d Mask;
+		static const int width = 2;
+		static inline V load(const double* p) { return _mm_loadu_pd(p); }
+		static inline void store(double* p, V v) { _mm_storeu_pd(p, v); }
+		static inline V set1(double d) { return _mm_set1_pd(d); }
+		static inline V add(V a, V b) { return _mm_add_pd(a, b); }
+		static inline V sub(V a, V b) { return _mm_sub_pd(a, b); }
+		static inline V mul(V a, V b) { return _mm_mul_pd(a, b); }
+		static inline V div(V a, V b) { return _mm_div_pd(a, b); }
+		static inline V sqrt(V a) { return _mm_sqrt_pd(a); }
+		static inline V abs(V a) { return _mm_andnot_pd(_mm_set1_pd(-0.), a); }
+		static inline V neg(V a) { return _mm_xor_pd(_mm_set1_pd(-0.), a); }
+		static inline Mask isNegative(V a) { return _mm_cmplt_pd(a, _mm_setzero_pd()); }
+		static inline V select(Mask m, V a, V b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+		static inline V quadrant(V y, Mask& swap, Mask& negSin, Mask& negCos)
+		{
+			// Adding and subtracting 1.5*2^52 rounds to the nearest integer (SSE4.1 has no equivalent in SSE2).
+			const __m128d magic = _mm_set1_pd(6755399441055744.0);
+			const __m128d k = _mm_sub_pd(_mm_add_pd(y, magic), magic);
+			__m128i s, ns, nc;
+			quadrantMasks32(_mm_cvtpd_epi32(k), s, ns, nc);
+			// Two 32-bit masks in the low half, widen them to 64 bit.
+			swap   = _mm_castsi128_pd(_mm_unpacklo_epi32(s, s));
+			negSin = _mm_castsi128_pd(_mm_unpacklo_epi32(ns, ns));
+			negCos = _mm_castsi128_pd(_mm_unpacklo_epi32(nc, nc));
+			return k;
+		}
+	};
+#elif defined(KEPLER_BATCH_AVX)
+	struct SimdOps
+	{
+		typedef __m256d V;
+		typedef __m256d Mask;
+		static const int width = 4;
+		static inline V load(const double* p) { return _mm256_loadu_pd(p); }
+		static inline void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+		static inline V set1(double d) { return _mm256_set1_pd(d); }
+		static inline V add(V a, V b) { return _mm256_add_pd(a, b); }
+		static inline V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+		static inline V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+		static inline V div(V a, V b) { return _mm256_div_pd(a, b); }
+		static inline V sqrt(V a) { return _mm256_sqrt_pd(a); }
+		static inline V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.), a); }
+		static inline V neg(V a) { return _mm256_xor_pd(_mm256_set1_pd(-0.), a); }
+		static inline Mask isNegative(V a) { return _mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_LT_OQ); }
+		static inline V select(Mask m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+		static inline V quadrant(V y, Mask& swap, Mask& negSin, Mask& negCos)
+		{
+			const __m256d k = _mm256_round_pd(y, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m128i s, ns, nc;
+			quadrantMasks32(_mm256_cvtpd_epi32(k), s, ns, nc);
+			swap   = widen(s);
+			negSin = widen(ns);
+			negCos = widen(nc);
+			return k;
+		}
+		//! Four 32-bit masks to four 64-bit masks
+		static inline __m256d widen(__m128i m)
+		{
+			const __m256i lo = _mm256_castsi128_si256(_mm_unpacklo_epi32(m, m));
+			return _mm256_castsi256_pd(_mm256_insertf128_si256(lo, _mm_unpackhi_epi32(m, m), 1));
+		}
+	};
+#else
+	typedef ScalarOps SimdOps;
+#endif
+
+	template<class Ops> inline typename Ops::V polynomial(typename Ops::V z, const double* c)
+	{
+		typename Ops::V p = Ops::set1(c[0]);
+		for (int i=1; i<6; ++i)
+			p = Ops::add(Ops::mul(p, z), Ops::set1(c[i]));
+		return p;
+	}
+
+	template<class Ops> inline void sinCos(typename Ops::V x, typename Ops::V& s, typename Ops::V& c)
+	{
+		typedef typename Ops::V V;
+		typename Ops::Mask swap, negSin, negCos;
+		const V k = Ops::quadrant(Ops::mul(x, Ops::set1(2.0/M_PI)), swap, negSin, negCos);
+		V r = Ops::sub(x, Ops::mul(k, Ops::set1(DP1)));
+		r = Ops::sub(r, Ops::mul(k, Ops::set1(DP2)));
+		r = Ops::sub(r, Ops::mul(k, Ops::set1(DP3)));
+		const V z = Ops::mul(r, r);
+		const V sr = Ops::add(r, Ops::mul(Ops::mul(r, z), polynomial<Ops>(z, sinCoeff)));
+		const V cr = Ops::add(Ops::sub(Ops::set1(1.0), Ops::mul(Ops::set1(0.5), z)),
+				      Ops::mul(Ops::mul(z, z), polynomial<Ops>(z, cosCoeff)));
+		s = Ops::select(swap, cr, sr);
+		c = Ops::select(swap, sr, cr);
+		s = Ops::select(negSin, Ops::neg(s), s);
+		c = Ops::select(negCos, Ops::neg(c), c);
+	}
+
+	//! Solve Kepler's equation for Ops::width orbits with the given method, return sin(E) and cos(E).
+	template<class Ops> inline void solveKepler(int method, typename Ops::V M, typename Ops::V e,
+						     typename Ops::V& sinE, typename Ops::V& cosE)
+	{
+		typedef typename Ops::V V;
+		const V one = Ops::set1(1.0);
+		V E = M;
+		V s, c;
+		switch (method)
+		{
+			case 0: // FixedPoint, see SolveKeplerFunc1
+				for (int i=0; i<5; ++i)
+				{
+					sinCos<Ops>(E, s, c);
+					E = Ops::add(M, Ops::mul(e, s));
+				}
+				break;
+			case 1: // Newton, see SolveKeplerFunc2
+				for (int i=0; i<6; ++i)
+				{
+					sinCos<Ops>(E, s, c);
+					const V f = Ops::sub(Ops::add(M, Ops::mul(e, s)), E);
+					E = Ops::add(E, Ops::div(f, Ops::sub(one, Ops::mul(e, c))));
+				}
+				break;
+			default: // Laguerre-Conway, see SolveKeplerLaguerreConway and InitEll(). As e<1, sign(f1) is 1.
+			{
+				// M is in [0, 2pi), i.e. sign(sin(M)) is 1 for M<pi
+				const V step = Ops::mul(Ops::set1(0.85), e);
+				E = Ops::add(M, Ops::select(Ops::isNegative(Ops::sub(M, Ops::set1(M_PI))), step, Ops::neg(step)));
+				for (int i=0; i<8; ++i)
+				{
+					sinCos<Ops>(E, s, c);
+					const V f2 = Ops::mul(e, s);
+					const V f = Ops::sub(Ops::sub(E, f2), M);
+					const V f1 = Ops::sub(one, Ops::mul(e, c));
+					const V root = Ops::sqrt(Ops::abs(Ops::sub(Ops::mul(Ops::set1(16.0), Ops::mul(f1, f1)),
+										  Ops::mul(Ops::set1(20.0), Ops::mul(f, f2)))));
+					E = Ops::sub(E, Ops::div(Ops::mul(Ops::set1(5.0), f), Ops::add(f1, root)));
+				}
+			}
+		}
+		sinCos<Ops>(E, sinE, cosE);
+	}
+
+	void solveKepler(int method, const double* M, const double* e, double* sinE, double* cosE, int count)
+	{
+		int i=0;
+		for (; i+SimdOps::width<=count; i+=SimdOps::width)
+		{
+			SimdOps::V s, c;
+			solveKepler<SimdOps>(method, SimdOps::load(M+i), SimdOps::load(e+i), s, c);
+			SimdOps::store(sinE+i, s);
+			SimdOps::store(cosE+i, c);
+		}
+		for (; i<count; ++i)
+			solveKepler<ScalarOps>(method, M[i], e[i], sinE[i], cosE[i]);
+	}
+
+	//! Rotate v with the row-major matrix of EllipticalOrbit and CometOrbit.
+	inline void rotate(const double* m, const double* v, double* out)
+	{
+		out[0] = m[0]*v[0] + m[1]*v[1] + m[2]*v[2];
+		out[1] = m[3]*v[0] + m[4]*v[1] + m[5]*v[2];
+		out[2] = m[6]*v[0] + m[7]*v[1] + m[8]*v[2];
+	}
+}
+
+void KeplerOrbitBatch::OrbitGroup::append(int slotNumber, double M0, double n, double t0, double ecc, double semiMajorAxis,
+					  double semiMinorAxis, const double P[3], const double Q[3])
+{
+	slot.append(slotNumber);
+	meanAnomalyAtEpoch.append(M0);
+	meanMotion.append(n);
+	epoch.append(t0);
+	e.append(ecc);
+	a.append(semiMajorAxis);
+	b.append(semiMinorAxis);
+	px.append(P[0]); py.append(P[1]); pz.append(P[2]);
+	qx.append(Q[0]); qy.append(Q[1]); qz.append(Q[2]);
+}
+
+void KeplerOrbitBatch::clear()
+{
+	for (int i=0; i<GroupCount; ++i)
+		groups[i] = OrbitGroup();
+	slotCount = 0;
+}
+
+int KeplerOrbitBatch::add(EllipticalOrbit* orbit)
+{
+	const double e = orbit->eccentricity;
+	if (!(e>=0. && e<1.) || orbit->period<=0.)
+		return -1;
+
+	OrbitGroup& group = groups[e<0.2 ? EllipticalFixedPoint : (e<0.9 ? EllipticalNewton : EllipticalLaguerreConway)];
+	const double a = orbit->pericenterDistance / (1.0 - e);
+	// Axes of the orbital plane, see EllipticalOrbit::positionAtE()
+	const Mat4d R = (Mat4d::zrotation(orbit->ascendingNode) *
+			 Mat4d::xrotation(orbit->inclination) *
+			 Mat4d::zrotation(orbit->argOfPeriapsis));
+	const Vec3d P0 = R * Vec3d(1., 0., 0.);
+	const Vec3d Q0 = R * Vec3d(0., 1., 0.);
+	double P[3], Q[3];
+	rotate(orbit->rotateToVsop87, P0, P);
+	rotate(orbit->rotateToVsop87, Q0, Q);
+	group.append(slotCount, orbit->meanAnomalyAtEpoch, 2.0*M_PI/orbit->period, orbit->epoch, e, a, a*std::sqrt(1.-e*e), P, Q);
+	group.ellipticalOrbits.append(orbit);
+	return slotCount++;
+}
+
+int KeplerOrbitBatch::add(CometOrbit* orbit)
+{
+	const double e = orbit->e;
+	if (!(e>=0. && e<1.))
+		return -1;
+
+	OrbitGroup& group = groups[CometLaguerreConway];
+	// Axes of the orbital plane, see Init3D() in Orbit.cpp
+	const double cw = cos(orbit->w);
+	const double sw = sin(orbit->w);
+	const double cOm = cos(orbit->Om);
+	const double sOm = sin(orbit->Om);
+	const double ci = cos(orbit->i);
+	const double si = sin(orbit->i);
+	const double P0[3] = { -sw*sOm*ci+cw*cOm, sw*cOm*ci+cw*sOm, sw*si };
+	const double Q0[3] = { -cw*sOm*ci-sw*cOm, cw*cOm*ci-sw*sOm, cw*si };
+	double P[3], Q[3];
+	rotate(orbit->rotateToVsop87, P0, P);
+	rotate(orbit->rotateToVsop87, Q0, Q);
+	// See InitEll(): rCosNu=a*(cos(E)-e), rSinNu=h1*sin(E)
+	const double q = orbit->q;
+	group.append(slotCount, 0., orbit->n, orbit->t0, e, q/(1.0-e), q*std::sqrt((1.0+e)/(1.0-e)), P, Q);
+	group.cometOrbits.append(orbit);
+	group.sqrtMuP.append(std::sqrt(GAUSS_GRAV_CONST/(q*(1.0+e))));
+	group.upx.append(P0[0]); group.upy.append(P0[1]); group.upz.append(P0[2]);
+	group.uqx.append(Q0[0]); group.uqy.append(Q0[1]); group.uqz.append(Q0[2]);
+	return slotCount++;
+}
+
+const char* KeplerOrbitBatch::instructionSet()
+{
+#if defined(KEPLER_BATCH_AVX)
+	return "AVX";
+#elif defined(KEPLER_BATCH_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+void KeplerOrbitBatch::computeChunk(const Chunk& chunk, const double* JDE, double commonJDE)
+{
+	const OrbitGroup& group = *chunk.group;
+	const int begin = chunk.begin;
+	const int count = chunk.end-begin;
+	Q_ASSERT(count<=KEPLER_BATCH_CHUNK_SIZE);
+	QVarLengthArray<double, KEPLER_BATCH_CHUNK_SIZE> M(count), sinE(count), cosE(count);
+	const double* e = group.e.constData()+begin;
+
+	// Mean anomaly, reduced to [0, 2pi)
+	for (int i=0; i<count; ++i)
+	{
+		const int j = begin+i;
+		const double t = JDE ? JDE[group.slot.at(j)] : commonJDE;
+		const double m = group.meanAnomalyAtEpoch.at(j) + (t-group.epoch.at(j))*group.meanMotion.at(j);
+		M[i] = m - 2.0*M_PI*std::floor(m/(2.0*M_PI));
+	}
+
+	solveKepler(chunk.type==EllipticalFixedPoint ? 0 : (chunk.type==EllipticalNewton ? 1 : 2), M.constData(), e, sinE.data(), cosE.data(), count);
+
+	for (int i=0; i<count; ++i)
+	{
+		const int j = begin+i;
+		const double t = JDE ? JDE[group.slot.at(j)] : commonJDE;
+		const double x = group.a.at(j)*(cosE[i]-e[i]);
+		const double y = group.b.at(j)*sinE[i];
+		const Vec3d pos(group.px.at(j)*x + group.qx.at(j)*y,
+				group.py.at(j)*x + group.qy.at(j)*y,
+				group.pz.at(j)*x + group.qz.at(j)*y);
+		if (chunk.type!=CometLaguerreConway)
+		{
+			EllipticalOrbit* orbit = group.ellipticalOrbits.at(j);
+			orbit->cachedPosition = pos;
+			orbit->cachedJDE = t;
+		}
+		else
+		{
+			// Velocity as in Init3D(), in the unrotated frame
+			CometOrbit* orbit = group.cometOrbits.at(j);
+			const double r = std::sqrt(x*x+y*y);
+			const double sinNu = y/r;
+			const double cosNu = x/r;
+			const double f = group.sqrtMuP.at(j);
+			orbit->cachedVelocity.set(f*((e[i]+cosNu)*group.uqx.at(j) - sinNu*group.upx.at(j)),
+						  f*((e[i]+cosNu)*group.uqy.at(j) - sinNu*group.upy.at(j)),
+						  f*((e[i]+cosNu)*group.uqz.at(j) - sinNu*group.upz.at(j)));
+			orbit->cachedPosition = pos;
+			orbit->cachedJDE = t;
+		}
+	}
+}
+
+QVector<KeplerOrbitBatch::Chunk> KeplerOrbitBatch::makeChunks()
+{
+	QVector<Chunk> chunks;
+	for (int i=0; i<GroupCount; ++i)
+	{
+		const int n = groups[i].slot.size();
+		for (int begin=0; begin<n; begin+=KEPLER_BATCH_CHUNK_SIZE)
+		{
+			Chunk chunk = { static_cast<GroupType>(i), &groups[i], begin, qMin(begin+KEPLER_BATCH_CHUNK_SIZE, n) };
+			chunks.append(chunk);
+		}
+	}
+	return chunks;
+}
+
+void KeplerOrbitBatch::computePositions(double JDE, bool useThreads)
+{
+	QVector<Chunk> chunks = makeChunks();
+	if (useThreads && chunks.size()>1)
+		QtConcurrent::blockingMap(chunks, [JDE](const Chunk& c) { computeChunk(c, Q_NULLPTR, JDE); });
+	else
+		foreach (const Chunk& c, chunks)
+			computeChunk(c, Q_NULLPTR, JDE);
+}
+
+void KeplerOrbitBatch::computePositions(const QVector<double>& JDE, bool useThreads)
+{
+	Q_ASSERT(JDE.size()>=slotCount);
+	const double* t = JDE.constData();
+	QVector<Chunk> chunks = makeChunks();
+	if (useThreads && chunks.size()>1)
+		QtConcurrent::blockingMap(chunks, [t](const Chunk& c) { computeChunk(c, t, 0.); });
+	else
+		foreach (const Chunk& c, chunks)
+			computeChunk(c, t, 0.);
+}
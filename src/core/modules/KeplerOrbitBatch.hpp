@@ -0,0 +1,105 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _KEPLERORBITBATCH_HPP_
+#define _KEPLERORBITBATCH_HPP_
+
+#include <QVector>
+
+class EllipticalOrbit;
+class CometOrbit;
+
+//! @class KeplerOrbitBatch
+//! Structure-of-arrays copy of the closed Keplerian orbits of many minor planets and comets.
+//! Kepler's equation is solved for all orbits in one pass, with AVX or SSE2 instructions if the
+//! compiler targets them, else with a scalar loop. The results are stored in the position caches
+//! of the orbit objects, so that the following EllipticalOrbit::positionAtTimevInVSOP87Coordinates()
+//! or CometOrbit::positionAtTimevInVSOP87Coordinates() call for exactly the same JDE just returns them.
+//! The solver for each orbit is the same as in EllipticalOrbit::eccentricAnomaly() and InitEll().
+//! Parabolic and hyperbolic orbits are rejected by add() and are always computed individually.
+class KeplerOrbitBatch
+{
+public:
+	KeplerOrbitBatch() : slotCount(0) {}
+
+	//! Remove all orbits.
+	void clear();
+	//! Add an orbit.
+	//! @return the slot number of the orbit, or -1 if the orbit cannot be handled by the batch.
+	int add(EllipticalOrbit* orbit);
+	//! Add an orbit.
+	//! @return the slot number of the orbit, or -1 if the orbit cannot be handled by the batch.
+	int add(CometOrbit* orbit);
+	//! Number of orbits in the batch, i.e. the number of slots.
+	int size() const { return slotCount; }
+
+	//! Compute the positions of all orbits for the same date.
+	//! @param useThreads split the work into chunks for the global thread pool.
+	void computePositions(double JDE, bool useThreads=false);
+	//! Compute the positions of all orbits for individual dates.
+	//! @param JDE dates, indexed by the slot numbers returned by add().
+	//! @param useThreads split the work into chunks for the global thread pool.
+	void computePositions(const QVector<double>& JDE, bool useThreads=false);
+
+	//! The instruction set used to solve Kepler's equation, "AVX", "SSE2" or "scalar".
+	static const char* instructionSet();
+
+private:
+	//! Orbits are grouped by the solver of EllipticalOrbit::eccentricAnomaly() and InitEll() which they need.
+	enum GroupType
+	{
+		EllipticalFixedPoint,		//!< 5 iterations of E=M+e*sin(E), for e<0.2
+		EllipticalNewton,		//!< 6 Newton iterations, for 0.2<=e<0.9
+		EllipticalLaguerreConway,	//!< 8 Laguerre-Conway iterations, for 0.9<=e<1
+		CometLaguerreConway,		//!< 8 Laguerre-Conway iterations, for all comets with e<1
+		GroupCount
+	};
+
+	struct OrbitGroup
+	{
+		void append(int slot, double M0, double n, double t0, double ecc, double a, double b,
+			    const double P[3], const double Q[3]);
+
+		QVector<int> slot;
+		QVector<double> meanAnomalyAtEpoch, meanMotion, epoch;
+		QVector<double> e, a, b;                // x=a*(cos(E)-e), y=b*sin(E) in the orbital plane
+		QVector<double> px, py, pz, qx, qy, qz; // axes of the orbital plane, rotated to VSOP87
+		QVector<EllipticalOrbit*> ellipticalOrbits;
+		// Comets only: the velocity vector is computed in the unrotated frame, see CometOrbit
+		QVector<CometOrbit*> cometOrbits;
+		QVector<double> sqrtMuP, upx, upy, upz, uqx, uqy, uqz;
+	};
+
+	struct Chunk
+	{
+		GroupType type;
+		OrbitGroup* group;
+		int begin, end;
+	};
+
+	QVector<Chunk> makeChunks();
+	//! Solve and store the results for the orbits [begin, end) of the chunk.
+	//! @param JDE per-slot dates, or Q_NULLPTR to use commonJDE for all.
+	static void computeChunk(const Chunk& chunk, const double* JDE, double commonJDE);
+
+	OrbitGroup groups[GroupCount];
+	int slotCount;
+};
+
+#endif // _KEPLERORBITBATCH_HPP_
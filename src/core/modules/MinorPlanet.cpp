@@ -362,20 +362,20 @@ double MinorPlanet::getSiderealPeriod() const
 	return period;
 }
 
-float MinorPlanet::getVMagnitude(const StelCore* core) const
+float MinorPlanet::computeVMagnitude(const MagnitudeGeometry& geometry) const
 {
 	//If the H-G system is not used, use the default radius/albedo mechanism
 	if (slopeParameter < 0)
 	{
-		return Planet::getVMagnitude(core);
+		return Planet::computeVMagnitude(geometry);
 	}
 
 	//Calculate phase angle
 	//(Code copied from Planet::getVMagnitude())
 	//(this is actually vector subtraction + the cosine theorem :))
-	const Vec3d& observerHelioPos = core->getObserverHeliocentricEclipticPos();
+	const Vec3d& observerHelioPos = geometry.observerHelioPos;
 	const float observerRq = observerHelioPos.lengthSquared();
-	const Vec3d& planetHelioPos = getHeliocentricEclipticPos();
+	const Vec3d& planetHelioPos = geometry.planetHelioPos;
 	const float planetRq = planetHelioPos.lengthSquared();
 	const float observerPlanetRq = (observerHelioPos - planetHelioPos).lengthSquared();
 	const float cos_chi = (observerPlanetRq + planetRq - observerRq)/(2.0*std::sqrt(observerPlanetRq*planetRq));
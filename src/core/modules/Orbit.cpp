@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <limits>
 #include <QDebug>
 
 using namespace std;
@@ -225,7 +226,8 @@ CometOrbit::CometOrbit(double pericenterDistance,
 	  t0(timeAtPerihelion),
 	  n(meanMotion),
 	  updateTails(true),
-	  orbitGood(orbitGoodDays)
+	  orbitGood(orbitGoodDays),
+	  cachedJDE(std::numeric_limits<double>::quiet_NaN())
 {
 	// GZ MAKE SURE THIS IS ALWAYS 0/0/0. ==> OK.
 	//qDebug() << "parentRotObliquity" << parentRotObliquity << "parentRotAscendingnode" << parentRotAscendingnode << "parentRotJ2000Longitude" << parentRotJ2000Longitude;
@@ -251,6 +253,19 @@ CometOrbit::CometOrbit(double pericenterDistance,
 
 void CometOrbit::positionAtTimevInVSOP87Coordinates(double JDE, double *v, bool updateVelocityVector)
 {
+	if (JDE == cachedJDE)
+	{
+		v[0] = cachedPosition[0];
+		v[1] = cachedPosition[1];
+		v[2] = cachedPosition[2];
+		if (updateVelocityVector)
+		{
+			rdot = cachedVelocity;
+			updateTails=true;
+		}
+		return;
+	}
+
 	JDE -= t0;
 	double rCosNu,rSinNu;
 	if (e < 1.0) InitEll(q,n,e,JDE,rCosNu,rSinNu); // Laguerre-Conway seems stable enough to go for <1.0.
@@ -273,6 +288,20 @@ void CometOrbit::positionAtTimevInVSOP87Coordinates(double JDE, double *v, bool
 	}
 }
 
+void CometOrbit::uncachedPositionAtTimevInVSOP87Coordinates(double JDE, double *v) const
+{
+	JDE -= t0;
+	double rCosNu,rSinNu;
+	if (e < 1.0) InitEll(q,n,e,JDE,rCosNu,rSinNu);
+	else if (e > 1.0) InitHyp(q,n,e,JDE,rCosNu,rSinNu);
+	else InitPar(q,n,JDE,rCosNu,rSinNu);
+	double p0,p1,p2, s0, s1, s2;
+	Init3D(i,Om,w,rCosNu,rSinNu,p0,p1,p2, s0, s1, s2);
+	v[0] = rotateToVsop87[0]*p0 + rotateToVsop87[1]*p1 + rotateToVsop87[2]*p2;
+	v[1] = rotateToVsop87[3]*p0 + rotateToVsop87[4]*p1 + rotateToVsop87[5]*p2;
+	v[2] = rotateToVsop87[6]*p0 + rotateToVsop87[7]*p1 + rotateToVsop87[8]*p2;
+}
+
 
 
 EllipticalOrbit::EllipticalOrbit(double pericenterDistance,
@@ -293,7 +322,8 @@ EllipticalOrbit::EllipticalOrbit(double pericenterDistance,
 	  argOfPeriapsis(argOfPeriapsis),
 	  meanAnomalyAtEpoch(meanAnomalyAtEpoch),
 	  period(period),
-	  epoch(epoch)
+	  epoch(epoch),
+	  cachedJDE(std::numeric_limits<double>::quiet_NaN())
 {
 	const double c_obl = cos(parentRotObliquity);
 	const double s_obl = sin(parentRotObliquity);
@@ -504,6 +534,18 @@ Vec3d EllipticalOrbit::positionAtTime(const double JDE) const
 //}
 
 void EllipticalOrbit::positionAtTimevInVSOP87Coordinates(const double JDE, double* v) const
+{
+	if (JDE == cachedJDE)
+	{
+		v[0] = cachedPosition[0];
+		v[1] = cachedPosition[1];
+		v[2] = cachedPosition[2];
+		return;
+	}
+	uncachedPositionAtTimevInVSOP87Coordinates(JDE, v);
+}
+
+void EllipticalOrbit::uncachedPositionAtTimevInVSOP87Coordinates(const double JDE, double* v) const
 {
 	Vec3d pos = positionAtTime(JDE);
 	v[0] = rotateToVsop87[0]*pos[0] + rotateToVsop87[1]*pos[1] + rotateToVsop87[2]*pos[2];
@@ -52,6 +52,8 @@ public:
 	// In order to rotate to VSOP87
 	// parentRotObliquity and parentRotAscendingnode must be supplied.
 	void positionAtTimevInVSOP87Coordinates(const double JDE, double* v) const;
+	// Same without the position precomputed by KeplerOrbitBatch, safe to call from any thread.
+	void uncachedPositionAtTimevInVSOP87Coordinates(const double JDE, double* v) const;
 
 	// Original one
 	Vec3d positionAtTime(const double JDE) const;
@@ -60,6 +62,7 @@ public:
 	virtual void sample(double, double, int, OrbitSampleProc&) const;
 
 private:
+	friend class KeplerOrbitBatch;
 	//! returns eccentric anomaly E for Mean anomaly M
 	double eccentricAnomaly(const double M) const;
 	Vec3d positionAtE(const double E) const;
@@ -73,6 +76,9 @@ private:
 	double period;
 	double epoch;
 	double rotateToVsop87[9];
+	// Position precomputed by KeplerOrbitBatch, valid for cachedJDE only.
+	mutable double cachedJDE;
+	mutable Vec3d cachedPosition;
 };
 
 
@@ -93,6 +99,8 @@ public:
 	// Compute the orbit for a specified Julian day and return a "stellarium compliant" function
 	// GZ: new optional variable: updateVelocityVector, true required for dust tail orientation!
 	void positionAtTimevInVSOP87Coordinates(double JDE, double* v, bool updateVelocityVector=true);
+	// Compute the position only, without using or changing the cached position and velocity. Safe to call from any thread.
+	void uncachedPositionAtTimevInVSOP87Coordinates(double JDE, double* v) const;
 	// updating the tails is a bit expensive. try not to overdo it.
 	bool getUpdateTails() const { return updateTails; }
 	void setUpdateTails(const bool update){ updateTails=update; }
@@ -102,6 +110,7 @@ public:
 	double getEccentricity() const { return e; }
 	bool objectDateValid(const double JDE) const { return (fabs(t0-JDE)<orbitGood); }
 private:
+	friend class KeplerOrbitBatch;
 	const double q;  //! perihel distance
 	const double e;  //! eccentricity
 	const double i;  //! inclination
@@ -113,9 +122,16 @@ private:
 	double rotateToVsop87[9]; //! Rotation matrix
 	bool updateTails; //! flag to signal that tails must be recomputed.
 	const double orbitGood; //! orb. elements are only valid for this time from perihel [days]. Don't draw the object outside.
+	double cachedJDE; //! Position and velocity precomputed by KeplerOrbitBatch, valid for cachedJDE only.
+	Vec3d cachedPosition;
+	Vec3d cachedVelocity;
 };
 
 
+//! Position functions of the bodies moving on an EllipticalOrbit or a CometOrbit, used as Planet coordFunc with the orbit as user data.
+void ellipticalOrbitPosFunc(double JDE, double xyz[3], void* orbitPtr);
+void cometOrbitPosFunc(double JDE, double xyz[3], void* orbitPtr);
+
 class OrbitSampleProc
 {
  public:
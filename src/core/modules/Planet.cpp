@@ -27,6 +27,7 @@
 #include "LandscapeMgr.hpp"
 #include "Planet.hpp"
 #include "Orbit.hpp"
+#include "ChebyshevEphemeris.hpp"
 #include "planetsephems/precession.h"
 #include "StelObserver.hpp"
 #include "StelProjector.hpp"
@@ -213,6 +214,7 @@ Planet::Planet(const QString& englishName,
 	  lastJDE(J2000),
 	  coordFunc(coordFunc),
 	  orbitPtr(anOrbitPtr),
+	  ephemerisCache(Q_NULLPTR),
 	  osculatingFunc(osculatingFunc),
 	  parent(Q_NULLPTR),
 	  flagLabels(true),
@@ -698,13 +700,44 @@ Vec3d Planet::getJ2000EquatorialPos(const StelCore *core) const
 		return StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(getHeliocentricEclipticPos() - core->getObserverHeliocentricEclipticPos());
 }
 
+Vec3d Planet::computeEclipticPos(const double dateJDE) const
+{
+	// The orbits keep precomputed positions that are only safe to use from the thread updating the scene
+	Vec3d pos;
+	if (coordFunc==&ellipticalOrbitPosFunc)
+		static_cast<const EllipticalOrbit*>(orbitPtr)->uncachedPositionAtTimevInVSOP87Coordinates(dateJDE, pos);
+	else if (coordFunc==&cometOrbitPosFunc)
+		static_cast<const CometOrbit*>(orbitPtr)->uncachedPositionAtTimevInVSOP87Coordinates(dateJDE, pos);
+	else
+		computeCoordinates(dateJDE, pos);
+	return pos;
+}
+
+void Planet::computeCoordinates(const double dateJDE, double xyz[3]) const
+{
+	if (ephemerisCache)
+		ephemerisCache->position(dateJDE, xyz);
+	else
+		coordFunc(dateJDE, xyz, orbitPtr);
+}
+
+Vec3d Planet::computeHeliocentricEclipticPos(const double dateJDE) const
+{
+	if (!parent)
+		return Vec3d(0.);
+	Vec3d pos = computeEclipticPos(dateJDE);
+	for (const Planet* pp=parent.data(); pp->parent; pp=pp->parent.data())
+		pos += pp->computeEclipticPos(dateJDE);
+	return pos;
+}
+
 // Compute the position in the parent Planet coordinate system
 // Actually call the provided function to compute the ecliptical position
 void Planet::computePositionWithoutOrbits(const double dateJDE)
 {
 	if (fabs(lastJDE-dateJDE)>deltaJDE)
 	{
-		coordFunc(dateJDE, eclipticPos, orbitPtr);
+		computeCoordinates(dateJDE, eclipticPos);
 		lastJDE = dateJDE;
 	}
 }
@@ -780,7 +813,9 @@ void Planet::computePosition(const double dateJDE)
 {
 	// Make sure the parent position is computed for the dateJDE, otherwise
 	// getHeliocentricPos() would return incorrect values.
-	if (parent)
+	// The Sun is the origin of the heliocentric frame and needs no update. Skipping it also
+	// keeps the parallel update in SolarSystem::computePositions() from writing to the shared Sun.
+	if (parent && parent->parent)
 		parent->computePositionWithoutOrbits(dateJDE);
 
 	if (orbitFader.getInterstate()>0.000001 && deltaOrbitJDE > 0 && (fabs(lastOrbitJDE-dateJDE)>deltaOrbitJDE || !orbitCached))
@@ -821,7 +856,7 @@ void Planet::computePosition(const double dateJDE)
 					}
 					else
 					{
-						coordFunc(calc_date, eclipticPos, orbitPtr);
+						computeCoordinates(calc_date, eclipticPos);
 					}
 					orbitP[d] = eclipticPos;
 					orbit[d] = getHeliocentricEclipticPos();
@@ -851,7 +886,7 @@ void Planet::computePosition(const double dateJDE)
 					}
 					else
 					{
-						coordFunc(calc_date, eclipticPos, orbitPtr);
+						computeCoordinates(calc_date, eclipticPos);
 					}
 					orbitP[d] = eclipticPos;
 					orbit[d] = getHeliocentricEclipticPos();
@@ -880,7 +915,7 @@ void Planet::computePosition(const double dateJDE)
 				}
 				else
 				{
-					coordFunc(calc_date, eclipticPos, orbitPtr);
+					computeCoordinates(calc_date, eclipticPos);
 				}
 				orbitP[d] = eclipticPos;
 				orbit[d] = getHeliocentricEclipticPos();
@@ -892,7 +927,7 @@ void Planet::computePosition(const double dateJDE)
 
 
 		// calculate actual Planet position
-		coordFunc(dateJDE, eclipticPos, orbitPtr);
+		computeCoordinates(dateJDE, eclipticPos);
 
 		lastJDE = dateJDE;
 
@@ -900,7 +935,7 @@ void Planet::computePosition(const double dateJDE)
 	else if (fabs(lastJDE-dateJDE)>deltaJDE)
 	{
 		// calculate actual Planet position
-		coordFunc(dateJDE, eclipticPos, orbitPtr);
+		computeCoordinates(dateJDE, eclipticPos);
 		if (orbitFader.getInterstate()>0.000001)
 			for( int d=0; d<ORBIT_SEGMENTS; d++ )
 				orbit[d]=getHeliocentricPos(orbitP[d]);
@@ -916,40 +951,54 @@ void Planet::computeTransMatrix(double JD, double JDE)
 {
 	// We have to call with both to correct this for earth with the new model.
 	axisRotation = getSiderealTime(JD, JDE);
+	rotLocalToParent = computeRotLocalToParent(JDE);
+}
 
+Mat4d Planet::computeRotLocalToParent(double JDE) const
+{
 	// Special case - heliocentric coordinates are relative to eclipticJ2000 (VSOP87A XY plane),
 	// not solar equator...
+	if (!parent)
+		return rotLocalToParent;
 
-	if (parent)
+	// We can inject a proper precession plus even nutation matrix in this stage, if available.
+	if (englishName=="Earth")
 	{
-		// We can inject a proper precession plus even nutation matrix in this stage, if available.
-		if (englishName=="Earth")
+		// rotLocalToParent = Mat4d::zrotation(re.ascendingNode - re.precessionRate*(jd-re.epoch)) * Mat4d::xrotation(-getRotObliquity(jd));
+		// We follow Capitaine's (2003) formulation P=Rz(Chi_A)*Rx(-omega_A)*Rz(-psi_A)*Rx(eps_o).
+		// ADS: 2011A&A...534A..22V = A&A 534, A22 (2011): Vondrak, Capitane, Wallace: New Precession Expressions, valid for long time intervals:
+		// See also Hilton et al., Report on Precession and the Ecliptic. Cel.Mech.Dyn.Astr. 94:351-367 (2006), eqn (6) and (21).
+		double eps_A, chi_A, omega_A, psi_A;
+		getPrecessionAnglesVondrak(JDE, &eps_A, &chi_A, &omega_A, &psi_A);
+		// Canonical precession rotations: Nodal rotation psi_A,
+		// then rotation by omega_A, the angle between EclPoleJ2000 and EarthPoleOfDate.
+		// The final rotation by chi_A rotates the equinox (zero degree).
+		// To achieve ecliptical coords of date, you just have now to add a rotX by epsilon_A (obliquity of date).
+
+		Mat4d rot = Mat4d::zrotation(-psi_A) * Mat4d::xrotation(-omega_A) * Mat4d::zrotation(chi_A);
+		// Plus nutation IAU-2000B:
+		if (StelApp::getInstance().getCore()->getUseNutation())
 		{
-			// rotLocalToParent = Mat4d::zrotation(re.ascendingNode - re.precessionRate*(jd-re.epoch)) * Mat4d::xrotation(-getRotObliquity(jd));
-			// We follow Capitaine's (2003) formulation P=Rz(Chi_A)*Rx(-omega_A)*Rz(-psi_A)*Rx(eps_o).
-			// ADS: 2011A&A...534A..22V = A&A 534, A22 (2011): Vondrak, Capitane, Wallace: New Precession Expressions, valid for long time intervals:
-			// See also Hilton et al., Report on Precession and the Ecliptic. Cel.Mech.Dyn.Astr. 94:351-367 (2006), eqn (6) and (21).
-			double eps_A, chi_A, omega_A, psi_A;
-			getPrecessionAnglesVondrak(JDE, &eps_A, &chi_A, &omega_A, &psi_A);
-			// Canonical precession rotations: Nodal rotation psi_A,
-			// then rotation by omega_A, the angle between EclPoleJ2000 and EarthPoleOfDate.
-			// The final rotation by chi_A rotates the equinox (zero degree).
-			// To achieve ecliptical coords of date, you just have now to add a rotX by epsilon_A (obliquity of date).
-
-			rotLocalToParent= Mat4d::zrotation(-psi_A) * Mat4d::xrotation(-omega_A) * Mat4d::zrotation(chi_A);
-			// Plus nutation IAU-2000B:
-			if (StelApp::getInstance().getCore()->getUseNutation())
-			{
-				double deltaEps, deltaPsi;
-				getNutationAngles(JDE, &deltaPsi, &deltaEps);
-				//qDebug() << "deltaEps, arcsec" << deltaEps*180./M_PI*3600. << "deltaPsi" << deltaPsi*180./M_PI*3600.;
-				Mat4d nut2000B=Mat4d::xrotation(eps_A) * Mat4d::zrotation(deltaPsi)* Mat4d::xrotation(-eps_A-deltaEps);
-				rotLocalToParent=rotLocalToParent*nut2000B;
-			}
+			double deltaEps, deltaPsi;
+			getNutationAngles(JDE, &deltaPsi, &deltaEps);
+			//qDebug() << "deltaEps, arcsec" << deltaEps*180./M_PI*3600. << "deltaPsi" << deltaPsi*180./M_PI*3600.;
+			Mat4d nut2000B=Mat4d::xrotation(eps_A) * Mat4d::zrotation(deltaPsi)* Mat4d::xrotation(-eps_A-deltaEps);
+			rot=rot*nut2000B;
 		}
-		else
-			rotLocalToParent = Mat4d::zrotation(re.ascendingNode - re.precessionRate*(JDE-re.epoch)) * Mat4d::xrotation(re.obliquity);
+		return rot;
 	}
+	return Mat4d::zrotation(re.ascendingNode - re.precessionRate*(JDE-re.epoch)) * Mat4d::xrotation(re.obliquity);
+}
+
+Mat4d Planet::computeRotEquatorialToVsop87(const double dateJDE) const
+{
+	Mat4d rval = computeRotLocalToParent(dateJDE);
+	if (parent)
+	{
+		for (PlanetP p=parent;p->parent;p=p->parent)
+			rval = p->computeRotLocalToParent(dateJDE) * rval;
+	}
+	return rval;
 }
 
 Mat4d Planet::getRotEquatorialToVsop87(void) const
@@ -1198,16 +1247,29 @@ float Planet::getMeanOppositionMagnitude() const
 
 // Computation of the visual magnitude (V band) of the planet.
 float Planet::getVMagnitude(const StelCore* core) const
+{
+	const SolarSystem* ssm = GETSTELMODULE(SolarSystem);
+	MagnitudeGeometry geometry;
+	geometry.observerHelioPos = core->getObserverHeliocentricEclipticPos();
+	geometry.planetHelioPos = getHeliocentricEclipticPos();
+	geometry.parentHelioPos = parent ? parent->getHeliocentricEclipticPos() : Vec3d(0.);
+	geometry.earthHelioPos = ssm->getEarth()->getHeliocentricEclipticPos();
+	geometry.JDE = core->getJDE();
+	geometry.observerOnEarth = (core->getCurrentLocation().planetName=="Earth");
+	geometry.eclipseFactor = parent ? 1. : ssm->getEclipseFactor(core);
+	return computeVMagnitude(geometry);
+}
+
+float Planet::computeVMagnitude(const MagnitudeGeometry& geometry) const
 {
 	if (parent == 0)
 	{
 		// Sun, compute the apparent magnitude for the absolute mag (V: 4.83) and observer's distance
 		// Hint: Absolute Magnitude of the Sun in Several Bands: http://mips.as.arizona.edu/~cnaw/sun.html
-		const double distParsec = std::sqrt(core->getObserverHeliocentricEclipticPos().lengthSquared())*AU/PARSEC;
+		const double distParsec = std::sqrt(geometry.observerHelioPos.lengthSquared())*AU/PARSEC;
 
 		// check how much of it is visible
-		const SolarSystem* ssm = GETSTELMODULE(SolarSystem);
-		double shadowFactor = ssm->getEclipseFactor(core);
+		double shadowFactor = geometry.eclipseFactor;
 		// See: Hughes, D. W., Brightness during a solar eclipse // Journal of the British Astronomical Association, vol.110, no.4, p.203-205
 		// URL: http://adsabs.harvard.edu/abs/2000JBAA..110..203H
 		if(shadowFactor < 0.000128)
@@ -1217,9 +1279,9 @@ float Planet::getVMagnitude(const StelCore* core) const
 	}
 
 	// Compute the phase angle i. We need the intermediate results also below, therefore we don't just call getPhaseAngle.
-	const Vec3d& observerHelioPos = core->getObserverHeliocentricEclipticPos();
+	const Vec3d& observerHelioPos = geometry.observerHelioPos;
 	const double observerRq = observerHelioPos.lengthSquared();
-	const Vec3d& planetHelioPos = getHeliocentricEclipticPos();
+	const Vec3d& planetHelioPos = geometry.planetHelioPos;
 	const double planetRq = planetHelioPos.lengthSquared();
 	const double observerPlanetRq = (observerHelioPos - planetHelioPos).lengthSquared();
 	const double cos_chi = (observerPlanetRq + planetRq - observerRq)/(2.0*std::sqrt(observerPlanetRq*planetRq));
@@ -1229,7 +1291,7 @@ float Planet::getVMagnitude(const StelCore* core) const
 	// Check if the satellite is inside the inner shadow of the parent planet:
 	if (parent->parent != 0)
 	{
-		const Vec3d& parentHeliopos = parent->getHeliocentricEclipticPos();
+		const Vec3d& parentHeliopos = geometry.parentHelioPos;
 		const double parent_Rq = parentHeliopos.lengthSquared();
 		const double pos_times_parent_pos = planetHelioPos * parentHeliopos;
 		if (pos_times_parent_pos > parent_Rq)
@@ -1266,7 +1328,7 @@ float Planet::getVMagnitude(const StelCore* core) const
 	}
 
 	// Use empirical formulae for main planets when seen from earth
-	if (core->getCurrentLocation().planetName=="Earth")
+	if (geometry.observerOnEarth)
 	{
 		const double phaseDeg=phaseAngle*180./M_PI;
 		const double d = 5. * log10(std::sqrt(observerPlanetRq*planetRq));
@@ -1312,12 +1374,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=geometry.JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					static SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=geometry.planetHelioPos - geometry.earthHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinx=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1370,12 +1431,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=geometry.JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					static SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=geometry.planetHelioPos - geometry.earthHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinx=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1409,12 +1469,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=geometry.JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=geometry.planetHelioPos - geometry.earthHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinB=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1446,12 +1505,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=geometry.JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					static SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=geometry.planetHelioPos - geometry.earthHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinB=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1482,17 +1540,26 @@ float Planet::getVMagnitude(const StelCore* core) const
 }
 
 double Planet::getAngularSize(const StelCore* core) const
+{
+	return getAngularSizeAtDistance(getJ2000EquatorialPos(core).length());
+}
+
+double Planet::getAngularSizeAtDistance(double distance) const
 {
 	double rad = radius;
 	if (rings)
 		rad = rings->getSize();
-	return std::atan2(rad*sphereScale,getJ2000EquatorialPos(core).length()) * 180./M_PI;
+	return std::atan2(rad*sphereScale,distance) * 180./M_PI;
 }
 
-
 double Planet::getSpheroidAngularSize(const StelCore* core) const
 {
-	return std::atan2(radius*sphereScale,getJ2000EquatorialPos(core).length()) * 180./M_PI;
+	return getSpheroidAngularSizeAtDistance(getJ2000EquatorialPos(core).length());
+}
+
+double Planet::getSpheroidAngularSizeAtDistance(double distance) const
+{
+	return std::atan2(radius*sphereScale,distance) * 180./M_PI;
 }
 
 // Draw the Planet and all the related infos : name, circle etc..
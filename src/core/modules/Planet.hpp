@@ -40,6 +40,7 @@ typedef void (OsculatingFunctType)(double jde0,double jde,double xyz[3]);
 #define J2000 2451545.0
 #define ORBIT_SEGMENTS 360
 
+class ChebyshevEphemeris;
 class StelFont;
 class StelPainter;
 class StelTranslator;
@@ -200,6 +201,10 @@ public:
 	QString getCommonNameI18n(void) const {return nameI18;}
 	//! Get angular semidiameter, degrees. If planet display is artificially enlarged (e.g. Moon upscale), value will also be increased.
 	virtual double getAngularSize(const StelCore* core) const;
+	//! Get angular semidiameter in degrees as seen from the given distance in AU, like getAngularSize().
+	double getAngularSizeAtDistance(double distance) const;
+	//! Same for getSpheroidAngularSize(), without the rings.
+	double getSpheroidAngularSizeAtDistance(double distance) const;
 	virtual bool hasAtmosphere(void) {return atmosphere;}
 	virtual bool hasHalo(void) {return halo;}
 
@@ -276,6 +281,16 @@ public:
 	//! This requires both flavours of JD in cases involving Earth.
 	void computeTransMatrix(double JD, double JDE);
 
+	//! Compute the position in the parent Planet coordinate system at dateJDE, without changing the planet or using its caches.
+	//! This may be called from any thread, see EphemerisContext.
+	Vec3d computeEclipticPos(const double dateJDE) const;
+	//! Compute the position in the parent Planet coordinate system at dateJDE with coordFunc, or with the Chebyshev cache of its theory.
+	void computeCoordinates(const double dateJDE, double xyz[3]) const;
+	//! Compute the heliocentric ecliptic position at dateJDE from the positions of the planet and of its parents, without changing them.
+	Vec3d computeHeliocentricEclipticPos(const double dateJDE) const;
+	//! Compute getRotEquatorialToVsop87() for dateJDE, without changing the planet and its parents.
+	Mat4d computeRotEquatorialToVsop87(const double dateJDE) const;
+
 	//! Get the phase angle (rad) for an observer at pos obsPos in heliocentric coordinates (in AU)
 	double getPhaseAngle(const Vec3d& obsPos) const;
 	//! Get the elongation angle (rad) for an observer at pos obsPos in heliocentric coordinates (in AU)
@@ -285,6 +300,24 @@ public:
 	//! Get the planet phase [0=dark..1=full] for an observer at pos obsPos in heliocentric coordinates (in AU)
 	float getPhase(const Vec3d& obsPos) const;
 
+	//! The heliocentric ecliptic positions (AU) and circumstances used by computeVMagnitude()
+	struct MagnitudeGeometry
+	{
+		Vec3d observerHelioPos;
+		Vec3d planetHelioPos;
+		//! Used for the shadow of the parent on a satellite
+		Vec3d parentHelioPos;
+		//! Used for the rings of Saturn
+		Vec3d earthHelioPos;
+		double JDE;
+		//! The empirical formulae of the planets are used for observers on the Earth
+		bool observerOnEarth;
+		//! Visible fraction of the solar disk, only used for the Sun
+		double eclipseFactor;
+	};
+	//! Compute the visual magnitude for the given positions. getVMagnitude() calls this with the current positions.
+	virtual float computeVMagnitude(const MagnitudeGeometry& geometry) const;
+
 	//! Get the Planet position in the parent Planet ecliptic coordinate in AU
 	Vec3d getEclipticPos() const;
 
@@ -462,6 +495,9 @@ protected:
 
 	void computeModelMatrix(Mat4d &result) const;
 
+	//! Compute rotLocalToParent for JDE, see computeTransMatrix().
+	Mat4d computeRotLocalToParent(double JDE) const;
+
 	Vec3f getCurrentOrbitColor() const;
 	
 	// Return the information string "ready to print" :)
@@ -531,6 +567,7 @@ protected:
 	// The callback for the calculation of the equatorial rect heliocentric position at time JDE.
 	posFuncType coordFunc;
 	void* orbitPtr;               // this is always used with an Orbit object.
+	ChebyshevEphemeris* ephemerisCache; // cache of the positions given by coordFunc, owned by SolarSystem, or Q_NULLPTR
 
 	OsculatingFunctType *const osculatingFunc;
 	QSharedPointer<Planet> parent;           // Planet parent i.e. sun for earth
@@ -37,6 +37,7 @@
 #include "Planet.hpp"
 #include "MinorPlanet.hpp"
 #include "Comet.hpp"
+#include "SolarSystemCache.hpp"
 #include "StelMainView.hpp"
 
 #include "StelSkyDrawer.hpp"
@@ -60,6 +61,10 @@
 #include <QMapIterator>
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QtConcurrent>
 
 SolarSystem::SolarSystem()
 	: shadowPlanetCount(0)
@@ -70,6 +75,7 @@ SolarSystem::SolarSystem()
 	, labelsAmount(false)
 	, flagOrbits(false)
 	, flagLightTravelTime(true)
+	, flagParallelPositions(false)
 	, flagUseObjModels(false)
 	, flagShowObjSelfShadows(true)
 	, flagShow(false)
@@ -83,11 +89,15 @@ SolarSystem::SolarSystem()
 	, ephemerisMagnitudesDisplayed(false)
 	, ephemerisHorizontalCoordinates(false)
 	, allTrails(Q_NULLPTR)
-	, conf(StelApp::getInstance().getSettings())
+	, gui(Q_NULLPTR)
+	, conf(Q_NULLPTR)
+	, reloadCount(0)
+	, keplerBatchDirty(true)
+	, flagEphemerisCache(false)
+	, ephemerisCacheDe430(false)
+	, ephemerisCacheDe431(false)
 {
-	planetNameFont.setPixelSize(StelApp::getInstance().getBaseFontSize());
 	setObjectName("SolarSystem");
-	gui = dynamic_cast<StelGui*>(StelApp::getInstance().getGui());
 }
 
 void SolarSystem::setFontSize(float newFontSize)
@@ -97,6 +107,8 @@ void SolarSystem::setFontSize(float newFontSize)
 
 SolarSystem::~SolarSystem()
 {
+	saveEphemerisCaches();
+
 	// release selected:
 	selected.clear();
 	foreach (Orbit* orb, orbits)
@@ -126,6 +138,10 @@ SolarSystem::~SolarSystem()
 	Comet::comaTexture.clear();
 	Comet::tailTexture.clear();
 
+	// The planets are released, no position function uses the caches any more.
+	qDeleteAll(ephemerisCaches);
+	ephemerisCaches.clear();
+
 	//deinit of SolarSystem is NOT called at app end automatically
 	deinit();
 }
@@ -143,10 +159,15 @@ double SolarSystem::getCallOrder(StelModuleActionName actionName) const
 // Init and load the solar system data
 void SolarSystem::init()
 {
+	conf = StelApp::getInstance().getSettings();
 	Q_ASSERT(conf);
+	planetNameFont.setPixelSize(StelApp::getInstance().getBaseFontSize());
+	gui = dynamic_cast<StelGui*>(StelApp::getInstance().getGui());
 
 	Planet::init();
+	flagEphemerisCache = conf->value("astro/flag_ephemeris_cache", false).toBool();
 	loadPlanets();	// Load planets data
+	setupEphemerisCaches();
 
 	// Compute position and matrix of sun and all the satellites (ie planets)
 	// for the first initialization Q_ASSERT that center is sun center (only impacts on light speed correction)	
@@ -163,6 +184,7 @@ void SolarSystem::init()
 	setLabelsAmount(conf->value("astro/labels_amount", 3.).toFloat());
 	setFlagOrbits(conf->value("astro/flag_planets_orbits").toBool());
 	setFlagLightTravelTime(conf->value("astro/flag_light_travel_time", true).toBool());
+	setFlagParallelPositions(conf->value("astro/flag_parallel_planet_positions", false).toBool());
 	setFlagUseObjModels(conf->value("astro/flag_use_obj_models", false).toBool());
 	setFlagShowObjSelfShadows(conf->value("astro/flag_show_obj_self_shadows", true).toBool());
 	setFlagPointer(conf->value("astro/flag_planets_pointers", true).toBool());
@@ -481,7 +503,70 @@ void SolarSystem::loadPlanets()
 bool SolarSystem::loadPlanets(const QString& filePath)
 {
 	qDebug() << "Loading from :"  << filePath;
+	keplerBatchDirty = true;
+
+	// Parsing the ini file is slow for large sets of minor bodies, so the parsed file is cached.
+	// The cache is used as long as the file keeps its size and modification time. Files with the
+	// same name in several search paths get their own cache.
+	QVector<SolarSystemBodyData> bodies;
+	const QFileInfo fileInfo(filePath);
+	const QByteArray pathHash = QCryptographicHash::hash(fileInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex();
+	const QString cacheFileName = QString("%1/solarsystem/%2-%3.cache").arg(StelFileMgr::getCacheDir(), fileInfo.completeBaseName(), QString(pathHash));
+	const QString cacheStamp = QString("%1|%2|%3|%4").arg(fileInfo.absoluteFilePath()).arg(fileInfo.size())
+				   .arg(fileInfo.lastModified().toMSecsSinceEpoch()).arg(StelUtils::getApplicationVersion());
+	if (!SolarSystemCache::read(cacheFileName, cacheStamp, bodies))
+	{
+		if (!readSolarSystemFile(filePath, bodies))
+			return false;
+		if (!bodies.isEmpty())
+			SolarSystemCache::write(cacheFileName, cacheStamp, bodies);
+	}
+
+	// The bodies loaded from an earlier file may be the parents of the new bodies.
+	QHash<QString, PlanetP> bodiesByName;
+	foreach (const PlanetP& p, systemPlanets)
+	{
+		if (!bodiesByName.contains(p->getEnglishName()))
+			bodiesByName.insert(p->getEnglishName(), p);
+	}
+
 	int readOk = 0;
+	foreach (const SolarSystemBodyData& data, bodies)
+	{
+		PlanetP p = addBody(data, bodiesByName);
+		if (p.isNull())
+			continue;
+		if (!bodiesByName.contains(p->getEnglishName()))
+			bodiesByName.insert(p->getEnglishName(), p);
+		readOk++;
+	}
+
+	if (systemPlanets.isEmpty())
+	{
+		qWarning() << "No Solar System objects loaded from" << QDir::toNativeSeparators(filePath);
+		return false;
+	}
+
+	// special case: load earth shadow texture
+	if (!Planet::texEarthShadow)
+		Planet::texEarthShadow = StelApp::getInstance().getTextureManager().createTexture(StelFileMgr::getInstallationDir()+"/textures/earth-shadow.png");
+
+	// Also comets just have static textures.
+	if (!Comet::comaTexture)
+		Comet::comaTexture = StelApp::getInstance().getTextureManager().createTextureThread(StelFileMgr::getInstallationDir()+"/textures/cometComa.png", StelTexture::StelTextureParams(true, GL_LINEAR, GL_CLAMP_TO_EDGE));
+	//tail textures. We use paraboloid tail bodies, textured like a fisheye sphere, i.e. center=head. The texture should be something like a mottled star to give some structure.
+	if (!Comet::tailTexture)
+		Comet::tailTexture = StelApp::getInstance().getTextureManager().createTextureThread(StelFileMgr::getInstallationDir()+"/textures/cometTail.png", StelTexture::StelTextureParams(true, GL_LINEAR, GL_CLAMP_TO_EDGE));
+
+	if (readOk>0)
+		qDebug() << "Loaded" << readOk << "Solar System bodies";
+
+	return true;
+}
+
+// Read the bodies of a Solar System file, ordered such that each body comes after its parent.
+bool SolarSystem::readSolarSystemFile(const QString& filePath, QVector<SolarSystemBodyData>& bodies)
+{
 	QSettings pd(filePath, StelIniFormat);
 	if (pd.status() != QSettings::NoError)
 	{
@@ -519,7 +604,7 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 	//     i.e. [sun, earth, moon] is fine, but not [sun, moon, earth]
 	//
 	// Stage 3: iterate over the ordered sections decided in stage 2,
-	// creating the planet objects from the QSettings data.
+	// reading the data of each body from the QSettings data.
 
 	// Stage 1 (as described above).
 	QMap<QString, QString> secNameMap;
@@ -571,602 +656,657 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 	// qDebug() << orderedSections;
 
 	// Stage 3 (as described above).
-	//int readOk=0;
-	//int totalPlanets=0;
-
-	// qDebug() << "Adding " << orderedSections.size() << "objects...";
+	bodies.clear();
+	bodies.reserve(orderedSections.size());
 	for (int i = 0;i<orderedSections.size();++i)
 	{
-		// qDebug() << "Processing entry" << orderedSections.at(i);
-
-		//totalPlanets++;
 		const QString secname = orderedSections.at(i);
-		const QString englishName = pd.value(secname+"/name").toString().simplified();
-		const QString strParent = pd.value(secname+"/parent", "Sun").toString(); // Obvious default, keep file entries simple.
-		PlanetP parent;
-		if (strParent!="none")
+		SolarSystemBodyData data;
+		SolarSystemBodyData::Values& v = data.values;
+		data.section = secname;
+		data.englishName = pd.value(secname+"/name").toString().simplified();
+		data.parent = pd.value(secname+"/parent", "Sun").toString(); // Obvious default, keep file entries simple.
+		data.coordFunc = pd.value(secname+"/coord_func").toString();
+		data.type = pd.value(secname+"/type").toString();
+		data.texMap = pd.value(secname+"/tex_map", "nomap.png").toString();
+		data.model = pd.value(secname+"/model").toString();
+		data.provisionalDesignation = pd.value(secname+"/provisional_designation").toString();
+		data.iauMoonNumber = pd.value(secname+"/iau_moon_number", "").toString();
+		data.texRing = pd.value(secname+"/tex_ring").toString();
+
+		// The defaults of some orbital elements depend on the type of orbit
+		const bool ellOrbit = (data.coordFunc=="ell_orbit");
+		v.orbitEpoch = pd.value(secname+"/orbit_Epoch", ellOrbit ? J2000 : -1e100).toDouble();
+		v.orbitEccentricity = pd.value(secname+"/orbit_Eccentricity",0.0).toDouble();
+		v.orbitPericenterDistance = pd.value(secname+"/orbit_PericenterDistance",-1e100).toDouble();
+		v.orbitSemiMajorAxis = pd.value(secname+"/orbit_SemiMajorAxis",-1e100).toDouble();
+		v.orbitMeanMotion = pd.value(secname+"/orbit_MeanMotion",-1e100).toDouble();
+		v.orbitPeriod = pd.value(secname+"/orbit_Period",-1e100).toDouble();
+		v.orbitInclination = pd.value(secname+"/orbit_Inclination").toDouble();
+		v.orbitAscendingNode = pd.value(secname+"/orbit_AscendingNode").toDouble();
+		v.orbitArgOfPericenter = pd.value(secname+"/orbit_ArgOfPericenter", ellOrbit ? -1e100 : 0.).toDouble();
+		v.orbitLongOfPericenter = pd.value(secname+"/orbit_LongOfPericenter").toDouble();
+		v.orbitMeanAnomaly = pd.value(secname+"/orbit_MeanAnomaly",-1e100).toDouble();
+		v.orbitMeanLongitude = pd.value(secname+"/orbit_MeanLongitude").toDouble();
+		v.orbitTimeAtPericenter = pd.value(secname+"/orbit_TimeAtPericenter",-1e100).toDouble();
+		v.orbitGood = pd.value(secname+"/orbit_good", 1000).toDouble();
+		v.orbitVisualizationPeriod = pd.value(secname+"/orbit_visualization_period",0.).toDouble();
+		v.closeOrbit = pd.value(secname+"/closeOrbit", true).toBool();
+
+		v.radius = pd.value(secname+"/radius").toDouble();
+		v.oblateness = pd.value(secname+"/oblateness", 0.0).toDouble();
+		const Vec3f color = StelUtils::strToVec3f(pd.value(secname+"/color", "1.0,1.0,1.0").toString()); // halo color
+		v.color[0] = color[0];
+		v.color[1] = color[1];
+		v.color[2] = color[2];
+		v.albedo = pd.value(secname+"/albedo", 0.25f).toFloat();
+		v.roughness = pd.value(secname+"/roughness",0.9f).toFloat();
+		v.hidden = pd.value(secname+"/hidden", false).toBool();
+		v.atmosphere = pd.value(secname+"/atmosphere", false).toBool();
+		v.halo = pd.value(secname+"/halo", true).toBool(); // GZ new default. Avoids clutter in ssystem.ini.
+		v.minorPlanetNumber = pd.value(secname+"/minor_planet_number", 0).toInt();
+		v.absoluteMagnitude = pd.value(secname+"/absolute_magnitude", -99.).toDouble();
+		v.slopeParameter = pd.value(secname+"/slope_parameter", data.type=="comet" ? 4.0 : 0.15).toDouble();
+		v.outgasIntensity = pd.value(secname+"/outgas_intensity",0.1f).toFloat();
+		v.outgasFalloff = pd.value(secname+"/outgas_falloff", 0.1f).toFloat();
+		v.dustWidthFactor = pd.value(secname+"/dust_widthfactor", 1.5f).toFloat();
+		v.dustLengthFactor = pd.value(secname+"/dust_lengthfactor", 0.4f).toFloat();
+		v.dustBrightnessFactor = pd.value(secname+"/dust_brightnessfactor", 1.5f).toFloat();
+
+		// Set possible default name of the normal map for avoiding yin-yang shaped moon
+		// phase when normal map key not exists. Example: moon_normals.png
+		// Details: https://bugs.launchpad.net/stellarium/+bug/1335609
+		QString normalMapName = "";
+		if (!v.hidden) // no normal maps for invisible objects!
+			normalMapName = data.englishName.toLower().append("_normals.png");
+		data.normalsMap = pd.value(secname+"/normals_map", normalMapName).toString();
+
+		v.rotPeriod = pd.value(secname+"/rot_periode", pd.value(secname+"/orbit_Period", 24.).toDouble()).toDouble();
+		v.rotRotationOffset = pd.value(secname+"/rot_rotation_offset",0.).toDouble();
+		v.rotEpoch = pd.value(secname+"/rot_epoch", J2000).toDouble();
+		v.rotObliquity = pd.value(secname+"/rot_obliquity",0.).toDouble();
+		v.rotAscendingNode = pd.value(secname+"/rot_equator_ascending_node",0.).toDouble();
+		v.rotPoleRA = pd.value(secname+"/rot_pole_ra", 0.).toDouble();
+		v.rotPoleDE = pd.value(secname+"/rot_pole_de", 0.).toDouble();
+		v.rotPrecessionRate = pd.value(secname+"/rot_precession_rate",0.).toDouble();
+
+		v.rings = pd.value(secname+"/rings", 0).toBool();
+		v.ringInnerSize = pd.value(secname+"/ring_inner_size").toDouble();
+		v.ringOuterSize = pd.value(secname+"/ring_outer_size").toDouble();
+
+		bodies.append(data);
+	}
+	return true;
+}
+
+// Create a body from the data of a Solar System file.
+PlanetP SolarSystem::addBody(const SolarSystemBodyData& data, const QHash<QString, PlanetP>& bodiesByName)
+{
+	const SolarSystemBodyData::Values& v = data.values;
+	const QString& secname = data.section;
+	const QString& englishName = data.englishName;
+	PlanetP parent;
+	if (data.parent!="none")
+	{
+		// Look in the other planets the one named with data.parent
+		parent = bodiesByName.value(data.parent);
+		if (parent.isNull())
 		{
-			// Look in the other planets the one named with strParent
-			foreach (const PlanetP& p, systemPlanets)
-			{
-				if (p->getEnglishName()==strParent)
-				{
-					parent = p;
-					break;
-				}
-			}
-			if (parent.isNull())
-			{
-				qWarning() << "ERROR : can't find parent solar system body for " << englishName;
-				//abort();
-				continue;
-			}
+			qWarning() << "ERROR : can't find parent solar system body for " << englishName;
+			//abort();
+			return PlanetP();
 		}
+	}
 
-		const QString funcName = pd.value(secname+"/coord_func").toString();
-		// qDebug() << "englishName:" << englishName << ", parent:" << strParent <<  ", coord_func:" << funcName;
-		posFuncType posfunc=Q_NULLPTR;
-		void* orbitPtr=Q_NULLPTR;
-		OsculatingFunctType *osculatingFunc = Q_NULLPTR;
-		bool closeOrbit = pd.value(secname+"/closeOrbit", true).toBool();
-
-		if (funcName=="ell_orbit")
-		{
-			// GZ TODO: It seems ell_orbit is only used for planet moons. Just assert eccentricity<1 and remove a few extra calculations?
-			// Read the orbital elements
-			const double epoch = pd.value(secname+"/orbit_Epoch",J2000).toDouble();
-			const double eccentricity = pd.value(secname+"/orbit_Eccentricity").toDouble();
-			if (eccentricity >= 1.0) closeOrbit = false;
-			double pericenterDistance = pd.value(secname+"/orbit_PericenterDistance",-1e100).toDouble();
-			double semi_major_axis;
-			if (pericenterDistance <= 0.0) {
-				semi_major_axis = pd.value(secname+"/orbit_SemiMajorAxis",-1e100).toDouble();
-				if (semi_major_axis <= -1e100) {
-					qDebug() << "ERROR: " << englishName
-						 << ": you must provide orbit_PericenterDistance or orbit_SemiMajorAxis";
-					//abort();
-					continue;
-				} else {
-					semi_major_axis /= AU;
-					Q_ASSERT(eccentricity != 1.0); // parabolic orbits have no semi_major_axis
-					pericenterDistance = semi_major_axis * (1.0-eccentricity);
-				}
+	const QString& funcName = data.coordFunc;
+	// qDebug() << "englishName:" << englishName << ", parent:" << data.parent <<  ", coord_func:" << funcName;
+	posFuncType posfunc=Q_NULLPTR;
+	void* orbitPtr=Q_NULLPTR;
+	OsculatingFunctType *osculatingFunc = Q_NULLPTR;
+	bool closeOrbit = v.closeOrbit;
+
+	if (funcName=="ell_orbit")
+	{
+		// GZ TODO: It seems ell_orbit is only used for planet moons. Just assert eccentricity<1 and remove a few extra calculations?
+		// Read the orbital elements
+		const double epoch = v.orbitEpoch;
+		const double eccentricity = v.orbitEccentricity;
+		if (eccentricity >= 1.0) closeOrbit = false;
+		double pericenterDistance = v.orbitPericenterDistance;
+		double semi_major_axis;
+		if (pericenterDistance <= 0.0) {
+			semi_major_axis = v.orbitSemiMajorAxis;
+			if (semi_major_axis <= -1e100) {
+				qDebug() << "ERROR: " << englishName
+					 << ": you must provide orbit_PericenterDistance or orbit_SemiMajorAxis";
+				//abort();
+				return PlanetP();
 			} else {
-				pericenterDistance /= AU;
-				semi_major_axis = (eccentricity == 1.0)
-								? 0.0 // parabolic orbits have no semi_major_axis
-								: pericenterDistance / (1.0-eccentricity);
+				semi_major_axis /= AU;
+				Q_ASSERT(eccentricity != 1.0); // parabolic orbits have no semi_major_axis
+				pericenterDistance = semi_major_axis * (1.0-eccentricity);
 			}
-			double meanMotion = pd.value(secname+"/orbit_MeanMotion",-1e100).toDouble();
-			double period;
-			if (meanMotion <= -1e100) {
-				period = pd.value(secname+"/orbit_Period",-1e100).toDouble();
-				if (period <= -1e100) {
-					meanMotion = (eccentricity == 1.0)
-								? 0.01720209895 * (1.5/pericenterDistance) * std::sqrt(0.5/pericenterDistance)
-								: (semi_major_axis > 0.0)
-								? 0.01720209895 / (semi_major_axis*std::sqrt(semi_major_axis))
-								: 0.01720209895 / (-semi_major_axis*std::sqrt(-semi_major_axis));
-					period = 2.0*M_PI/meanMotion;
-				} else {
-					meanMotion = 2.0*M_PI/period;
-				}
-			} else {
+		} else {
+			pericenterDistance /= AU;
+			semi_major_axis = (eccentricity == 1.0)
+							? 0.0 // parabolic orbits have no semi_major_axis
+							: pericenterDistance / (1.0-eccentricity);
+		}
+		double meanMotion = v.orbitMeanMotion;
+		double period;
+		if (meanMotion <= -1e100) {
+			period = v.orbitPeriod;
+			if (period <= -1e100) {
+				meanMotion = (eccentricity == 1.0)
+							? 0.01720209895 * (1.5/pericenterDistance) * std::sqrt(0.5/pericenterDistance)
+							: (semi_major_axis > 0.0)
+							? 0.01720209895 / (semi_major_axis*std::sqrt(semi_major_axis))
+							: 0.01720209895 / (-semi_major_axis*std::sqrt(-semi_major_axis));
 				period = 2.0*M_PI/meanMotion;
-			}
-			const double inclination = pd.value(secname+"/orbit_Inclination").toDouble()*(M_PI/180.0);
-			const double ascending_node = pd.value(secname+"/orbit_AscendingNode").toDouble()*(M_PI/180.0);
-			double arg_of_pericenter = pd.value(secname+"/orbit_ArgOfPericenter",-1e100).toDouble();
-			double long_of_pericenter;
-			if (arg_of_pericenter <= -1e100) {
-				long_of_pericenter = pd.value(secname+"/orbit_LongOfPericenter").toDouble()*(M_PI/180.0);
-				arg_of_pericenter = long_of_pericenter - ascending_node;
 			} else {
-				arg_of_pericenter *= (M_PI/180.0);
-				long_of_pericenter = arg_of_pericenter + ascending_node;
-			}
-			double mean_anomaly = pd.value(secname+"/orbit_MeanAnomaly",-1e100).toDouble();
-			double mean_longitude;
-			if (mean_anomaly <= -1e100) {
-				mean_longitude = pd.value(secname+"/orbit_MeanLongitude").toDouble()*(M_PI/180.0);
-				mean_anomaly = mean_longitude - long_of_pericenter;
-			} else {
-				mean_anomaly *= (M_PI/180.0);
-				mean_longitude = mean_anomaly + long_of_pericenter;
+				meanMotion = 2.0*M_PI/period;
 			}
+		} else {
+			period = 2.0*M_PI/meanMotion;
+		}
+		const double inclination = v.orbitInclination*(M_PI/180.0);
+		const double ascending_node = v.orbitAscendingNode*(M_PI/180.0);
+		double arg_of_pericenter = v.orbitArgOfPericenter;
+		double long_of_pericenter;
+		if (arg_of_pericenter <= -1e100) {
+			long_of_pericenter = v.orbitLongOfPericenter*(M_PI/180.0);
+			arg_of_pericenter = long_of_pericenter - ascending_node;
+		} else {
+			arg_of_pericenter *= (M_PI/180.0);
+			long_of_pericenter = arg_of_pericenter + ascending_node;
+		}
+		double mean_anomaly = v.orbitMeanAnomaly;
+		double mean_longitude;
+		if (mean_anomaly <= -1e100) {
+			mean_longitude = v.orbitMeanLongitude*(M_PI/180.0);
+			mean_anomaly = mean_longitude - long_of_pericenter;
+		} else {
+			mean_anomaly *= (M_PI/180.0);
+			mean_longitude = mean_anomaly + long_of_pericenter;
+		}
 
-			// when the parent is the sun use ecliptic rather than sun equator:
-			const double parentRotObliquity = parent->getParent()
-											  ? parent->getRotObliquity(2451545.0)
-											  : 0.0;
-			const double parent_rot_asc_node = parent->getParent()
-											  ? parent->getRotAscendingNode()
-											  : 0.0;
-			double parent_rot_j2000_longitude = 0.0;
-			if (parent->getParent()) {
-				const double c_obl = cos(parentRotObliquity);
-				const double s_obl = sin(parentRotObliquity);
-				const double c_nod = cos(parent_rot_asc_node);
-				const double s_nod = sin(parent_rot_asc_node);
-				const Vec3d OrbitAxis0( c_nod,       s_nod,        0.0);
-				const Vec3d OrbitAxis1(-s_nod*c_obl, c_nod*c_obl,s_obl);
-				const Vec3d OrbitPole(  s_nod*s_obl,-c_nod*s_obl,c_obl);
-				const Vec3d J2000Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(Vec3d(0,0,1)));
-				Vec3d J2000NodeOrigin(J2000Pole^OrbitPole);
-				J2000NodeOrigin.normalize();
-				parent_rot_j2000_longitude = atan2(J2000NodeOrigin*OrbitAxis1,J2000NodeOrigin*OrbitAxis0);
-			}
+		// when the parent is the sun use ecliptic rather than sun equator:
+		const double parentRotObliquity = parent->getParent()
+										  ? parent->getRotObliquity(2451545.0)
+										  : 0.0;
+		const double parent_rot_asc_node = parent->getParent()
+										  ? parent->getRotAscendingNode()
+										  : 0.0;
+		double parent_rot_j2000_longitude = 0.0;
+		if (parent->getParent()) {
+			const double c_obl = cos(parentRotObliquity);
+			const double s_obl = sin(parentRotObliquity);
+			const double c_nod = cos(parent_rot_asc_node);
+			const double s_nod = sin(parent_rot_asc_node);
+			const Vec3d OrbitAxis0( c_nod,       s_nod,        0.0);
+			const Vec3d OrbitAxis1(-s_nod*c_obl, c_nod*c_obl,s_obl);
+			const Vec3d OrbitPole(  s_nod*s_obl,-c_nod*s_obl,c_obl);
+			const Vec3d J2000Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(Vec3d(0,0,1)));
+			Vec3d J2000NodeOrigin(J2000Pole^OrbitPole);
+			J2000NodeOrigin.normalize();
+			parent_rot_j2000_longitude = atan2(J2000NodeOrigin*OrbitAxis1,J2000NodeOrigin*OrbitAxis0);
+		}
 
-			// Create an elliptical orbit
-			EllipticalOrbit *orb = new EllipticalOrbit(pericenterDistance,
-								   eccentricity,
-								   inclination,
-								   ascending_node,
-								   arg_of_pericenter,
-								   mean_anomaly,
-								   period,
-								   epoch,
-								   parentRotObliquity,
-								   parent_rot_asc_node,
-								   parent_rot_j2000_longitude);
-			orbits.push_back(orb);
-
-			orbitPtr = orb;
-			posfunc = &ellipticalOrbitPosFunc;
+		// Create an elliptical orbit
+		EllipticalOrbit *orb = new EllipticalOrbit(pericenterDistance,
+							   eccentricity,
+							   inclination,
+							   ascending_node,
+							   arg_of_pericenter,
+							   mean_anomaly,
+							   period,
+							   epoch,
+							   parentRotObliquity,
+							   parent_rot_asc_node,
+							   parent_rot_j2000_longitude);
+		orbits.push_back(orb);
+
+		orbitPtr = orb;
+		posfunc = &ellipticalOrbitPosFunc;
+	}
+	else if (funcName=="comet_orbit")
+	{
+		// Read the orbital elements
+		// orbit_PericenterDistance,orbit_SemiMajorAxis: given in AU
+		// orbit_MeanMotion: given in degrees/day
+		// orbit_Period: given in days
+		// orbit_TimeAtPericenter,orbit_Epoch: JD
+		// orbit_MeanAnomaly,orbit_Inclination,orbit_ArgOfPericenter,orbit_AscendingNode: given in degrees
+		const double eccentricity = v.orbitEccentricity;
+		if (eccentricity >= 1.0) closeOrbit = false;
+		double pericenterDistance = v.orbitPericenterDistance;
+		double semi_major_axis;
+		if (pericenterDistance <= 0.0) {
+			semi_major_axis = v.orbitSemiMajorAxis;
+			if (semi_major_axis <= -1e100) {
+				qWarning() << "ERROR: " << englishName
+					   << ": you must provide orbit_PericenterDistance or orbit_SemiMajorAxis";
+				//abort();
+				return PlanetP();
+			} else {
+				Q_ASSERT(eccentricity != 1.0); // parabolic orbits have no semi_major_axis
+				pericenterDistance = semi_major_axis * (1.0-eccentricity);
+			}
+		} else {
+			semi_major_axis = (eccentricity == 1.0)
+							? 0.0 // parabolic orbits have no semi_major_axis
+							: pericenterDistance / (1.0-eccentricity);
 		}
-		else if (funcName=="comet_orbit")
-		{
-			// Read the orbital elements
-			// orbit_PericenterDistance,orbit_SemiMajorAxis: given in AU
-			// orbit_MeanMotion: given in degrees/day
-			// orbit_Period: given in days
-			// orbit_TimeAtPericenter,orbit_Epoch: JD
-			// orbit_MeanAnomaly,orbit_Inclination,orbit_ArgOfPericenter,orbit_AscendingNode: given in degrees
-			const double eccentricity = pd.value(secname+"/orbit_Eccentricity",0.0).toDouble();
-			if (eccentricity >= 1.0) closeOrbit = false;
-			double pericenterDistance = pd.value(secname+"/orbit_PericenterDistance",-1e100).toDouble();
-			double semi_major_axis;
-			if (pericenterDistance <= 0.0) {
-				semi_major_axis = pd.value(secname+"/orbit_SemiMajorAxis",-1e100).toDouble();
-				if (semi_major_axis <= -1e100) {
+		double meanMotion = v.orbitMeanMotion;
+		if (meanMotion <= -1e100) {
+			const double period = v.orbitPeriod;
+			if (period <= -1e100) {
+				if (parent->getParent()) {
 					qWarning() << "ERROR: " << englishName
-						   << ": you must provide orbit_PericenterDistance or orbit_SemiMajorAxis";
-					//abort();
-					continue;
+						   << ": when the parent body is not the sun, you must provide "
+						   << "either orbit_MeanMotion or orbit_Period";
 				} else {
-					Q_ASSERT(eccentricity != 1.0); // parabolic orbits have no semi_major_axis
-					pericenterDistance = semi_major_axis * (1.0-eccentricity);
+					// in case of parent=sun: use Gaussian gravitational constant
+					// for calculating meanMotion:
+					//meanMotion = (eccentricity >= 0.9999 && eccentricity <= 1.0)
+					//			? 0.01720209895 * (1.5/pericenterDistance) * sqrt(0.5/pericenterDistance)
+					//			: (semi_major_axis > 0.0)
+					//			? 0.01720209895 / (semi_major_axis*sqrt(semi_major_axis))
+					//			: 0.01720209895 / (-semi_major_axis*sqrt(-semi_major_axis));
+					meanMotion = (eccentricity == 1.0)
+								? 0.01720209895 * (1.5/pericenterDistance) * std::sqrt(0.5/pericenterDistance)  // GZ: This is Heafner's W / dt
+								: 0.01720209895 / (fabs(semi_major_axis)*std::sqrt(fabs(semi_major_axis)));
 				}
 			} else {
-				semi_major_axis = (eccentricity == 1.0)
-								? 0.0 // parabolic orbits have no semi_major_axis
-								: pericenterDistance / (1.0-eccentricity);
+				meanMotion = 2.0*M_PI/period;
 			}
-			double meanMotion = pd.value(secname+"/orbit_MeanMotion",-1e100).toDouble();
-			if (meanMotion <= -1e100) {
-				const double period = pd.value(secname+"/orbit_Period",-1e100).toDouble();
-				if (period <= -1e100) {
-					if (parent->getParent()) {
-						qWarning() << "ERROR: " << englishName
-							   << ": when the parent body is not the sun, you must provide "
-							   << "either orbit_MeanMotion or orbit_Period";
-					} else {
-						// in case of parent=sun: use Gaussian gravitational constant
-						// for calculating meanMotion:
-						//meanMotion = (eccentricity >= 0.9999 && eccentricity <= 1.0)
-						//			? 0.01720209895 * (1.5/pericenterDistance) * sqrt(0.5/pericenterDistance)
-						//			: (semi_major_axis > 0.0)
-						//			? 0.01720209895 / (semi_major_axis*sqrt(semi_major_axis))
-						//			: 0.01720209895 / (-semi_major_axis*sqrt(-semi_major_axis));
-						meanMotion = (eccentricity == 1.0)
-									? 0.01720209895 * (1.5/pericenterDistance) * std::sqrt(0.5/pericenterDistance)  // GZ: This is Heafner's W / dt
-									: 0.01720209895 / (fabs(semi_major_axis)*std::sqrt(fabs(semi_major_axis)));
-					}
-				} else {
-					meanMotion = 2.0*M_PI/period;
-				}
+		} else {
+			meanMotion *= (M_PI/180.0);
+		}
+		double time_at_pericenter = v.orbitTimeAtPericenter;
+		if (time_at_pericenter <= -1e100) {
+			const double epoch = v.orbitEpoch;
+			double mean_anomaly = v.orbitMeanAnomaly;
+			if (epoch <= -1e100 || mean_anomaly <= -1e100) {
+				qWarning() << "ERROR: " << englishName
+					   << ": when you do not provide orbit_TimeAtPericenter, you must provide both "
+					   << "orbit_Epoch and orbit_MeanAnomaly";
+				//abort();
+				return PlanetP();
 			} else {
-				meanMotion *= (M_PI/180.0);
-			}
-			double time_at_pericenter = pd.value(secname+"/orbit_TimeAtPericenter",-1e100).toDouble();
-			if (time_at_pericenter <= -1e100) {
-				const double epoch = pd.value(secname+"/orbit_Epoch",-1e100).toDouble();
-				double mean_anomaly = pd.value(secname+"/orbit_MeanAnomaly",-1e100).toDouble();
-				if (epoch <= -1e100 || mean_anomaly <= -1e100) {
-					qWarning() << "ERROR: " << englishName
-						   << ": when you do not provide orbit_TimeAtPericenter, you must provide both "
-						   << "orbit_Epoch and orbit_MeanAnomaly";
-					//abort();
-					continue;
-				} else {
-					mean_anomaly *= (M_PI/180.0);
-					time_at_pericenter = epoch - mean_anomaly / meanMotion;
-				}
+				mean_anomaly *= (M_PI/180.0);
+				time_at_pericenter = epoch - mean_anomaly / meanMotion;
 			}
-			const double orbitGoodDays=pd.value(secname+"/orbit_good", 1000).toDouble();
-			const double inclination = pd.value(secname+"/orbit_Inclination").toDouble()*(M_PI/180.0);
-			const double arg_of_pericenter = pd.value(secname+"/orbit_ArgOfPericenter").toDouble()*(M_PI/180.0);
-			const double ascending_node = pd.value(secname+"/orbit_AscendingNode").toDouble()*(M_PI/180.0);
-			const double parentRotObliquity = parent->getParent() ? parent->getRotObliquity(2451545.0) : 0.0;
-			const double parent_rot_asc_node = parent->getParent() ? parent->getRotAscendingNode() : 0.0;
-			double parent_rot_j2000_longitude = 0.0;
-						if (parent->getParent()) {
-							const double c_obl = cos(parentRotObliquity);
-							const double s_obl = sin(parentRotObliquity);
-							const double c_nod = cos(parent_rot_asc_node);
-							const double s_nod = sin(parent_rot_asc_node);
-							const Vec3d OrbitAxis0( c_nod,       s_nod,        0.0);
-							const Vec3d OrbitAxis1(-s_nod*c_obl, c_nod*c_obl,s_obl);
-							const Vec3d OrbitPole(  s_nod*s_obl,-c_nod*s_obl,c_obl);
-							const Vec3d J2000Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(Vec3d(0,0,1)));
-							Vec3d J2000NodeOrigin(J2000Pole^OrbitPole);
-							J2000NodeOrigin.normalize();
-							parent_rot_j2000_longitude = atan2(J2000NodeOrigin*OrbitAxis1,J2000NodeOrigin*OrbitAxis0);
-						}
-			//qDebug() << "Creating CometOrbit for" << englishName;
-			CometOrbit *orb = new CometOrbit(pericenterDistance,
-							 eccentricity,
-							 inclination,
-							 ascending_node,
-							 arg_of_pericenter,
-							 time_at_pericenter,
-							 orbitGoodDays,
-							 meanMotion,
-							 parentRotObliquity,
-							 parent_rot_asc_node,
-							 parent_rot_j2000_longitude);
-			orbits.push_back(orb);
-			orbitPtr = orb;
-			posfunc = &cometOrbitPosFunc;
 		}
+		const double orbitGoodDays=v.orbitGood;
+		const double inclination = v.orbitInclination*(M_PI/180.0);
+		const double arg_of_pericenter = v.orbitArgOfPericenter*(M_PI/180.0);
+		const double ascending_node = v.orbitAscendingNode*(M_PI/180.0);
+		const double parentRotObliquity = parent->getParent() ? parent->getRotObliquity(2451545.0) : 0.0;
+		const double parent_rot_asc_node = parent->getParent() ? parent->getRotAscendingNode() : 0.0;
+		double parent_rot_j2000_longitude = 0.0;
+					if (parent->getParent()) {
+						const double c_obl = cos(parentRotObliquity);
+						const double s_obl = sin(parentRotObliquity);
+						const double c_nod = cos(parent_rot_asc_node);
+						const double s_nod = sin(parent_rot_asc_node);
+						const Vec3d OrbitAxis0( c_nod,       s_nod,        0.0);
+						const Vec3d OrbitAxis1(-s_nod*c_obl, c_nod*c_obl,s_obl);
+						const Vec3d OrbitPole(  s_nod*s_obl,-c_nod*s_obl,c_obl);
+						const Vec3d J2000Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(Vec3d(0,0,1)));
+						Vec3d J2000NodeOrigin(J2000Pole^OrbitPole);
+						J2000NodeOrigin.normalize();
+						parent_rot_j2000_longitude = atan2(J2000NodeOrigin*OrbitAxis1,J2000NodeOrigin*OrbitAxis0);
+					}
+		//qDebug() << "Creating CometOrbit for" << englishName;
+		CometOrbit *orb = new CometOrbit(pericenterDistance,
+						 eccentricity,
+						 inclination,
+						 ascending_node,
+						 arg_of_pericenter,
+						 time_at_pericenter,
+						 orbitGoodDays,
+						 meanMotion,
+						 parentRotObliquity,
+						 parent_rot_asc_node,
+						 parent_rot_j2000_longitude);
+		orbits.push_back(orb);
+		orbitPtr = orb;
+		posfunc = &cometOrbitPosFunc;
+	}
 
-		else if (funcName=="sun_special")
-			posfunc = &get_sun_helio_coordsv;
+	else if (funcName=="sun_special")
+		posfunc = &get_sun_helio_coordsv;
 
-		else if (funcName=="mercury_special") {
-			posfunc = &get_mercury_helio_coordsv;
-			osculatingFunc = &get_mercury_helio_osculating_coords;
-		}
+	else if (funcName=="mercury_special") {
+		posfunc = &get_mercury_helio_coordsv;
+		osculatingFunc = &get_mercury_helio_osculating_coords;
+	}
 
-		else if (funcName=="venus_special") {
-			posfunc = &get_venus_helio_coordsv;
-			osculatingFunc = &get_venus_helio_osculating_coords;
-		}
+	else if (funcName=="venus_special") {
+		posfunc = &get_venus_helio_coordsv;
+		osculatingFunc = &get_venus_helio_osculating_coords;
+	}
 
-		else if (funcName=="earth_special") {
-			posfunc = &get_earth_helio_coordsv;
-			osculatingFunc = &get_earth_helio_osculating_coords;
-		}
+	else if (funcName=="earth_special") {
+		posfunc = &get_earth_helio_coordsv;
+		osculatingFunc = &get_earth_helio_osculating_coords;
+	}
 
-		else if (funcName=="lunar_special")
-			posfunc = &get_lunar_parent_coordsv;
+	else if (funcName=="lunar_special")
+		posfunc = &get_lunar_parent_coordsv;
 
-		else if (funcName=="mars_special") {
-			posfunc = &get_mars_helio_coordsv;
-			osculatingFunc = &get_mars_helio_osculating_coords;
-		}
+	else if (funcName=="mars_special") {
+		posfunc = &get_mars_helio_coordsv;
+		osculatingFunc = &get_mars_helio_osculating_coords;
+	}
 
-		else if (funcName=="phobos_special")
-			posfunc = &get_phobos_parent_coordsv;
+	else if (funcName=="phobos_special")
+		posfunc = &get_phobos_parent_coordsv;
 
-		else if (funcName=="deimos_special")
-			posfunc = &get_deimos_parent_coordsv;
+	else if (funcName=="deimos_special")
+		posfunc = &get_deimos_parent_coordsv;
 
-		else if (funcName=="jupiter_special") {
-			posfunc = &get_jupiter_helio_coordsv;
-			osculatingFunc = &get_jupiter_helio_osculating_coords;
-		}
+	else if (funcName=="jupiter_special") {
+		posfunc = &get_jupiter_helio_coordsv;
+		osculatingFunc = &get_jupiter_helio_osculating_coords;
+	}
 
-		else if (funcName=="europa_special")
-			posfunc = &get_europa_parent_coordsv;
+	else if (funcName=="europa_special")
+		posfunc = &get_europa_parent_coordsv;
 
-		else if (funcName=="calisto_special")
-			posfunc = &get_callisto_parent_coordsv;
+	else if (funcName=="calisto_special")
+		posfunc = &get_callisto_parent_coordsv;
 
-		else if (funcName=="io_special")
-			posfunc = &get_io_parent_coordsv;
+	else if (funcName=="io_special")
+		posfunc = &get_io_parent_coordsv;
 
-		else if (funcName=="ganymede_special")
-			posfunc = &get_ganymede_parent_coordsv;
+	else if (funcName=="ganymede_special")
+		posfunc = &get_ganymede_parent_coordsv;
 
-		else if (funcName=="saturn_special") {
-			posfunc = &get_saturn_helio_coordsv;
-			osculatingFunc = &get_saturn_helio_osculating_coords;
-		}
+	else if (funcName=="saturn_special") {
+		posfunc = &get_saturn_helio_coordsv;
+		osculatingFunc = &get_saturn_helio_osculating_coords;
+	}
 
-		else if (funcName=="mimas_special")
-			posfunc = &get_mimas_parent_coordsv;
+	else if (funcName=="mimas_special")
+		posfunc = &get_mimas_parent_coordsv;
 
-		else if (funcName=="enceladus_special")
-			posfunc = &get_enceladus_parent_coordsv;
+	else if (funcName=="enceladus_special")
+		posfunc = &get_enceladus_parent_coordsv;
 
-		else if (funcName=="tethys_special")
-			posfunc = &get_tethys_parent_coordsv;
+	else if (funcName=="tethys_special")
+		posfunc = &get_tethys_parent_coordsv;
 
-		else if (funcName=="dione_special")
-			posfunc = &get_dione_parent_coordsv;
+	else if (funcName=="dione_special")
+		posfunc = &get_dione_parent_coordsv;
 
-		else if (funcName=="rhea_special")
-			posfunc = &get_rhea_parent_coordsv;
+	else if (funcName=="rhea_special")
+		posfunc = &get_rhea_parent_coordsv;
 
-		else if (funcName=="titan_special")
-			posfunc = &get_titan_parent_coordsv;
+	else if (funcName=="titan_special")
+		posfunc = &get_titan_parent_coordsv;
 
-		else if (funcName=="iapetus_special")
-			posfunc = &get_iapetus_parent_coordsv;
+	else if (funcName=="iapetus_special")
+		posfunc = &get_iapetus_parent_coordsv;
 
-		else if (funcName=="hyperion_special")
-			posfunc = &get_hyperion_parent_coordsv;
+	else if (funcName=="hyperion_special")
+		posfunc = &get_hyperion_parent_coordsv;
 
-		else if (funcName=="uranus_special") {
-			posfunc = &get_uranus_helio_coordsv;
-			osculatingFunc = &get_uranus_helio_osculating_coords;
-		}
+	else if (funcName=="uranus_special") {
+		posfunc = &get_uranus_helio_coordsv;
+		osculatingFunc = &get_uranus_helio_osculating_coords;
+	}
 
-		else if (funcName=="miranda_special")
-			posfunc = &get_miranda_parent_coordsv;
+	else if (funcName=="miranda_special")
+		posfunc = &get_miranda_parent_coordsv;
 
-		else if (funcName=="ariel_special")
-			posfunc = &get_ariel_parent_coordsv;
+	else if (funcName=="ariel_special")
+		posfunc = &get_ariel_parent_coordsv;
 
-		else if (funcName=="umbriel_special")
-			posfunc = &get_umbriel_parent_coordsv;
+	else if (funcName=="umbriel_special")
+		posfunc = &get_umbriel_parent_coordsv;
 
-		else if (funcName=="titania_special")
-			posfunc = &get_titania_parent_coordsv;
+	else if (funcName=="titania_special")
+		posfunc = &get_titania_parent_coordsv;
 
-		else if (funcName=="oberon_special")
-			posfunc = &get_oberon_parent_coordsv;
+	else if (funcName=="oberon_special")
+		posfunc = &get_oberon_parent_coordsv;
 
-		else if (funcName=="neptune_special") {
-			posfunc = &get_neptune_helio_coordsv;
-			osculatingFunc = &get_neptune_helio_osculating_coords;
-		}
+	else if (funcName=="neptune_special") {
+		posfunc = &get_neptune_helio_coordsv;
+		osculatingFunc = &get_neptune_helio_osculating_coords;
+	}
 
-		else if (funcName=="pluto_special")
-			posfunc = &get_pluto_helio_coordsv;
+	else if (funcName=="pluto_special")
+		posfunc = &get_pluto_helio_coordsv;
 
 
-		if (posfunc==Q_NULLPTR)
-		{
-			qCritical() << "ERROR in section " << secname << ": can't find posfunc " << funcName << " for " << englishName;
-			exit(-1);
-		}
+	if (posfunc==Q_NULLPTR)
+	{
+		qCritical() << "ERROR in section " << secname << ": can't find posfunc " << funcName << " for " << englishName;
+		exit(-1);
+	}
 
-		// Create the Solar System body and add it to the list
-		QString type = pd.value(secname+"/type").toString();
+	// Create the Solar System body and add it to the list
+	QString type = data.type;
 
-		//TODO: Refactor the subclass selection to reduce duplicate code mess here,
-		// by at least using this base class pointer and using setXXX functions instead of mega-constructors
-		// that have to pass most of it on to the Planet class
-		PlanetP p;
+	//TODO: Refactor the subclass selection to reduce duplicate code mess here,
+	// by at least using this base class pointer and using setXXX functions instead of mega-constructors
+	// that have to pass most of it on to the Planet class
+	PlanetP p;
 
-		// New class objects, named "plutino", "cubewano", "dwarf planet", "SDO", "OCO", has properties
-		// similar to asteroids and we should calculate their positions like for asteroids. Dwarf planets
-		// have one exception: Pluto - we should use special function for calculation of orbit of Pluto.
-		if ((type == "asteroid" || type == "dwarf planet" || type == "cubewano" || type == "plutino" || type == "scattered disc object" || type == "Oort cloud object") && !englishName.contains("Pluto"))
-		{
-			minorBodies << englishName;
-			p = PlanetP(new MinorPlanet(englishName,
-						    pd.value(secname+"/radius").toDouble()/AU,
-						    pd.value(secname+"/oblateness", 0.0).toDouble(),
-						    StelUtils::strToVec3f(pd.value(secname+"/color", "1.0,1.0,1.0").toString()), // halo color
-						    pd.value(secname+"/albedo", 0.25f).toFloat(),
-						    pd.value(secname+"/roughness",0.9f).toFloat(),
-						    pd.value(secname+"/tex_map", "nomap.png").toString(),
-						    pd.value(secname+"/model").toString(),
-						    posfunc,
-						    orbitPtr,
-						    osculatingFunc,
-						    closeOrbit,
-						    pd.value(secname+"/hidden", false).toBool(),
-						    type));
-
-			QSharedPointer<MinorPlanet> mp =  p.dynamicCast<MinorPlanet>();
-
-			//Number
-			int minorPlanetNumber = pd.value(secname+"/minor_planet_number", 0).toInt();
-			if (minorPlanetNumber)
-			{
-				mp->setMinorPlanetNumber(minorPlanetNumber);
-			}
+	// New class objects, named "plutino", "cubewano", "dwarf planet", "SDO", "OCO", has properties
+	// similar to asteroids and we should calculate their positions like for asteroids. Dwarf planets
+	// have one exception: Pluto - we should use special function for calculation of orbit of Pluto.
+	if ((type == "asteroid" || type == "dwarf planet" || type == "cubewano" || type == "plutino" || type == "scattered disc object" || type == "Oort cloud object") && !englishName.contains("Pluto"))
+	{
+		minorBodies << englishName;
+		p = PlanetP(new MinorPlanet(englishName,
+					    v.radius/AU,
+					    v.oblateness,
+					    Vec3f(v.color[0], v.color[1], v.color[2]), // halo color
+					    v.albedo,
+					    v.roughness,
+					    data.texMap,
+					    data.model,
+					    posfunc,
+					    orbitPtr,
+					    osculatingFunc,
+					    closeOrbit,
+					    v.hidden,
+					    type));
 
-			//Provisional designation
-			QString provisionalDesignation = pd.value(secname+"/provisional_designation").toString();
-			if (!provisionalDesignation.isEmpty())
-			{
-				mp->setProvisionalDesignation(provisionalDesignation);
-			}
+		QSharedPointer<MinorPlanet> mp =  p.dynamicCast<MinorPlanet>();
 
-			//H-G magnitude system
-			double magnitude = pd.value(secname+"/absolute_magnitude", -99).toDouble();
-			double slope = pd.value(secname+"/slope_parameter", 0.15).toDouble();
-			if (magnitude > -99)
-			{
-				if (slope >= 0 && slope <= 1)
-				{
-					mp->setAbsoluteMagnitudeAndSlope(magnitude, slope);
-				}
-				else
-				{
-					mp->setAbsoluteMagnitudeAndSlope(magnitude, 0.15);
-				}
-			}
-
-			mp->setSemiMajorAxis(pd.value(secname+"/orbit_SemiMajorAxis", 0).toDouble());
+		//Number
+		int minorPlanetNumber = v.minorPlanetNumber;
+		if (minorPlanetNumber)
+		{
+			mp->setMinorPlanetNumber(minorPlanetNumber);
+		}
 
-			systemMinorBodies.push_back(p);
+		//Provisional designation
+		QString provisionalDesignation = data.provisionalDesignation;
+		if (!provisionalDesignation.isEmpty())
+		{
+			mp->setProvisionalDesignation(provisionalDesignation);
 		}
-		else if (type == "comet")
+
+		//H-G magnitude system
+		double magnitude = v.absoluteMagnitude;
+		double slope = v.slopeParameter;
+		if (magnitude > -99)
 		{
-			minorBodies << englishName;
-			p = PlanetP(new Comet(englishName,
-					      pd.value(secname+"/radius").toDouble()/AU,
-					      pd.value(secname+"/oblateness", 0.0).toDouble(),
-					      StelUtils::strToVec3f(pd.value(secname+"/color", "1.0,1.0,1.0").toString()), // halo color
-					      pd.value(secname+"/albedo", 0.25f).toFloat(),
-					      pd.value(secname+"/roughness",0.9f).toFloat(),
-					      pd.value(secname+"/outgas_intensity",0.1f).toFloat(),
-					      pd.value(secname+"/outgas_falloff", 0.1f).toFloat(),
-					      pd.value(secname+"/tex_map", "nomap.png").toString(),
-					      pd.value(secname+"/model").toString(),
-					      posfunc,
-					      orbitPtr,
-					      osculatingFunc,
-					      closeOrbit,
-					      pd.value(secname+"/hidden", false).toBool(),
-					      type,
-					      pd.value(secname+"/dust_widthfactor", 1.5f).toFloat(),
-					      pd.value(secname+"/dust_lengthfactor", 0.4f).toFloat(),
-					      pd.value(secname+"/dust_brightnessfactor", 1.5f).toFloat()
-					      ));
-
-			QSharedPointer<Comet> mp =  p.dynamicCast<Comet>();
-
-			//g,k magnitude system
-			double magnitude = pd.value(secname+"/absolute_magnitude", -99).toDouble();
-			double slope = pd.value(secname+"/slope_parameter", 4.0).toDouble();
-			if (magnitude > -99)
+			if (slope >= 0 && slope <= 1)
 			{
-				if (slope >= 0 && slope <= 20)
-				{
-					mp->setAbsoluteMagnitudeAndSlope(magnitude, slope);
-				}
-				else
-				{
-					mp->setAbsoluteMagnitudeAndSlope(magnitude, 4.0);
-				}
+				mp->setAbsoluteMagnitudeAndSlope(magnitude, slope);
 			}
-
-			const double eccentricity = pd.value(secname+"/orbit_Eccentricity",0.0).toDouble();
-			const double pericenterDistance = pd.value(secname+"/orbit_PericenterDistance",-1e100).toDouble();
-			if (eccentricity<1 && pericenterDistance>0)
+			else
 			{
-				mp->setSemiMajorAxis(pericenterDistance / (1.0-eccentricity));
+				mp->setAbsoluteMagnitudeAndSlope(magnitude, 0.15);
 			}
-			systemMinorBodies.push_back(p);
 		}
-		else
+
+		mp->setSemiMajorAxis(v.orbitSemiMajorAxis>-1e100 ? v.orbitSemiMajorAxis : 0.);
+
+		systemMinorBodies.push_back(p);
+	}
+	else if (type == "comet")
+	{
+		minorBodies << englishName;
+		p = PlanetP(new Comet(englishName,
+				      v.radius/AU,
+				      v.oblateness,
+				      Vec3f(v.color[0], v.color[1], v.color[2]), // halo color
+				      v.albedo,
+				      v.roughness,
+				      v.outgasIntensity,
+				      v.outgasFalloff,
+				      data.texMap,
+				      data.model,
+				      posfunc,
+				      orbitPtr,
+				      osculatingFunc,
+				      closeOrbit,
+				      v.hidden,
+				      type,
+				      v.dustWidthFactor,
+				      v.dustLengthFactor,
+				      v.dustBrightnessFactor
+				      ));
+
+		QSharedPointer<Comet> mp =  p.dynamicCast<Comet>();
+
+		//g,k magnitude system
+		double magnitude = v.absoluteMagnitude;
+		double slope = v.slopeParameter;
+		if (magnitude > -99)
 		{
-			// Set possible default name of the normal map for avoiding yin-yang shaped moon
-			// phase when normal map key not exists. Example: moon_normals.png
-			// Details: https://bugs.launchpad.net/stellarium/+bug/1335609
-			QString normalMapName = "";
-			if (!pd.value(secname+"/hidden", false).toBool()) // no normal maps for invisible objects!
-				normalMapName = englishName.toLower().append("_normals.png");
-			p = PlanetP(new Planet(englishName,
-					       pd.value(secname+"/radius").toDouble()/AU,
-					       pd.value(secname+"/oblateness", 0.0).toDouble(),
-					       StelUtils::strToVec3f(pd.value(secname+"/color", "1.0,1.0,1.0").toString()), // halo color
-					       pd.value(secname+"/albedo", 0.25f).toFloat(),
-					       pd.value(secname+"/roughness",0.9f).toFloat(),
-					       pd.value(secname+"/tex_map", "nomap.png").toString(),
-					       pd.value(secname+"/normals_map", normalMapName).toString(),
-					       pd.value(secname+"/model").toString(),
-					       posfunc,
-					       orbitPtr,
-					       osculatingFunc,
-					       closeOrbit,
-					       pd.value(secname+"/hidden", false).toBool(),
-					       pd.value(secname+"/atmosphere", false).toBool(),
-					       pd.value(secname+"/halo", true).toBool(),          // GZ new default. Avoids clutter in ssystem.ini.
-					       type));
-			p->absoluteMagnitude = pd.value(secname+"/absolute_magnitude", -99.).toDouble();
-
-			// Moon designation (planet index + IAU moon number)
-			QString moonDesignation = pd.value(secname+"/iau_moon_number", "").toString();
-			if (!moonDesignation.isEmpty())
+			if (slope >= 0 && slope <= 20)
+			{
+				mp->setAbsoluteMagnitudeAndSlope(magnitude, slope);
+			}
+			else
 			{
-				p->setIAUMoonNumber(moonDesignation);
+				mp->setAbsoluteMagnitudeAndSlope(magnitude, 4.0);
 			}
 		}
 
-
-		if (!parent.isNull())
+		const double eccentricity = v.orbitEccentricity;
+		const double pericenterDistance = v.orbitPericenterDistance;
+		if (eccentricity<1 && pericenterDistance>0)
 		{
-			parent->satellites.append(p);
-			p->parent = parent;
+			mp->setSemiMajorAxis(pericenterDistance / (1.0-eccentricity));
 		}
-		if (secname=="earth") earth = p;
-		if (secname=="sun") sun = p;
-		if (secname=="moon") moon = p;
-
-		double rotObliquity = pd.value(secname+"/rot_obliquity",0.).toDouble()*(M_PI/180.0);
-		double rotAscNode = pd.value(secname+"/rot_equator_ascending_node",0.).toDouble()*(M_PI/180.0);
+		systemMinorBodies.push_back(p);
+	}
+	else
+	{
+		p = PlanetP(new Planet(englishName,
+				       v.radius/AU,
+				       v.oblateness,
+				       Vec3f(v.color[0], v.color[1], v.color[2]), // halo color
+				       v.albedo,
+				       v.roughness,
+				       data.texMap,
+				       data.normalsMap,
+				       data.model,
+				       posfunc,
+				       orbitPtr,
+				       osculatingFunc,
+				       closeOrbit,
+				       v.hidden,
+				       v.atmosphere,
+				       v.halo,          // GZ new default. Avoids clutter in ssystem.ini.
+				       type));
+		p->absoluteMagnitude = v.absoluteMagnitude;
+
+		// Moon designation (planet index + IAU moon number)
+		QString moonDesignation = data.iauMoonNumber;
+		if (!moonDesignation.isEmpty())
+		{
+			p->setIAUMoonNumber(moonDesignation);
+		}
+	}
 
-		// Use more common planet North pole data if available
-		// NB: N pole as defined by IAU (NOT right hand rotation rule)
-		// NB: J2000 epoch
-		double J2000NPoleRA = pd.value(secname+"/rot_pole_ra", 0.).toDouble()*M_PI/180.;
-		double J2000NPoleDE = pd.value(secname+"/rot_pole_de", 0.).toDouble()*M_PI/180.;
 
-		if(J2000NPoleRA || J2000NPoleDE)
-		{
-			Vec3d J2000NPole;
-			StelUtils::spheToRect(J2000NPoleRA,J2000NPoleDE,J2000NPole);
+	if (!parent.isNull())
+	{
+		parent->satellites.append(p);
+		p->parent = parent;
+	}
+	if (secname=="earth") earth = p;
+	if (secname=="sun") sun = p;
+	if (secname=="moon") moon = p;
 
-			Vec3d vsop87Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(J2000NPole));
+	double rotObliquity = v.rotObliquity*(M_PI/180.0);
+	double rotAscNode = v.rotAscendingNode*(M_PI/180.0);
 
-			double ra, de;
-			StelUtils::rectToSphe(&ra, &de, vsop87Pole);
+	// Use more common planet North pole data if available
+	// NB: N pole as defined by IAU (NOT right hand rotation rule)
+	// NB: J2000 epoch
+	double J2000NPoleRA = v.rotPoleRA*M_PI/180.;
+	double J2000NPoleDE = v.rotPoleDE*M_PI/180.;
 
-			rotObliquity = (M_PI_2 - de);
-			rotAscNode = (ra + M_PI_2);
+	if(J2000NPoleRA || J2000NPoleDE)
+	{
+		Vec3d J2000NPole;
+		StelUtils::spheToRect(J2000NPoleRA,J2000NPoleDE,J2000NPole);
 
-			// qDebug() << "\tCalculated rotational obliquity: " << rotObliquity*180./M_PI << endl;
-			// qDebug() << "\tCalculated rotational ascending node: " << rotAscNode*180./M_PI << endl;
-		}
+		Vec3d vsop87Pole(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(J2000NPole));
 
-		p->setRotationElements(
-			pd.value(secname+"/rot_periode", pd.value(secname+"/orbit_Period", 24.).toDouble()).toDouble()/24.,
-			pd.value(secname+"/rot_rotation_offset",0.).toDouble(),
-			pd.value(secname+"/rot_epoch", J2000).toDouble(),
-			rotObliquity,
-			rotAscNode,
-			pd.value(secname+"/rot_precession_rate",0.).toDouble()*M_PI/(180*36525),
-			pd.value(secname+"/orbit_visualization_period",0.).toDouble());
-
-
-		if (pd.value(secname+"/rings", 0).toBool()) {
-			const double rMin = pd.value(secname+"/ring_inner_size").toDouble()/AU;
-			const double rMax = pd.value(secname+"/ring_outer_size").toDouble()/AU;
-			Ring *r = new Ring(rMin,rMax,pd.value(secname+"/tex_ring").toString());
-			p->setRings(r);
-		}
+		double ra, de;
+		StelUtils::rectToSphe(&ra, &de, vsop87Pole);
 
-		systemPlanets.push_back(p);
-		readOk++;
-	}
+		rotObliquity = (M_PI_2 - de);
+		rotAscNode = (ra + M_PI_2);
 
-	if (systemPlanets.isEmpty())
-	{
-		qWarning() << "No Solar System objects loaded from" << QDir::toNativeSeparators(filePath);
-		return false;
+		// qDebug() << "\tCalculated rotational obliquity: " << rotObliquity*180./M_PI << endl;
+		// qDebug() << "\tCalculated rotational ascending node: " << rotAscNode*180./M_PI << endl;
 	}
 
-	// special case: load earth shadow texture
-	if (!Planet::texEarthShadow)
-		Planet::texEarthShadow = StelApp::getInstance().getTextureManager().createTexture(StelFileMgr::getInstallationDir()+"/textures/earth-shadow.png");
+	p->setRotationElements(
+		v.rotPeriod/24.,
+		v.rotRotationOffset,
+		v.rotEpoch,
+		rotObliquity,
+		rotAscNode,
+		v.rotPrecessionRate*M_PI/(180*36525),
+		v.orbitVisualizationPeriod);
 
-	// Also comets just have static textures.
-	if (!Comet::comaTexture)
-		Comet::comaTexture = StelApp::getInstance().getTextureManager().createTextureThread(StelFileMgr::getInstallationDir()+"/textures/cometComa.png", StelTexture::StelTextureParams(true, GL_LINEAR, GL_CLAMP_TO_EDGE));
-	//tail textures. We use paraboloid tail bodies, textured like a fisheye sphere, i.e. center=head. The texture should be something like a mottled star to give some structure.
-	if (!Comet::tailTexture)
-		Comet::tailTexture = StelApp::getInstance().getTextureManager().createTextureThread(StelFileMgr::getInstallationDir()+"/textures/cometTail.png", StelTexture::StelTextureParams(true, GL_LINEAR, GL_CLAMP_TO_EDGE));
 
-	if (readOk>0)
-		qDebug() << "Loaded" << readOk << "Solar System bodies";
+	if (v.rings) {
+		const double rMin = v.ringInnerSize/AU;
+		const double rMax = v.ringOuterSize/AU;
+		Ring *r = new Ring(rMin,rMax,data.texRing);
+		p->setRings(r);
+	}
 
-	return true;
+	systemPlanets.push_back(p);
+	return p;
 }
 
 // Compute the position for every elements of the solar system.
 // The order is not important since the position is computed relatively to the mother body
 void SolarSystem::computePositions(double dateJDE, PlanetP observerPlanet)
 {
+	const double dateJD=dateJDE - (StelApp::getInstance().getCore()->computeDeltaT(dateJDE))/86400.0;
+	computePositions(dateJD, dateJDE, observerPlanet);
+}
+
+void SolarSystem::computePositions(double dateJD, double dateJDE, PlanetP observerPlanet)
+{
+	updateKeplerBatch();
+	if (flagParallelPositions)
+	{
+		computePositionsParallel(dateJD, dateJDE, observerPlanet);
+		return;
+	}
+
 	if (flagLightTravelTime)
 	{
+		prefetchKeplerPositions(dateJDE);
 		foreach (PlanetP p, systemPlanets)
 		{
 			p->computePositionWithoutOrbits(dateJDE);
@@ -1185,6 +1325,7 @@ void SolarSystem::computePositions(double dateJDE, PlanetP observerPlanet)
 		// We must reset observerPlanet for the next step!
 		observerPlanet->computePosition(dateJDE);
 		// END HACK FOR SOLAR LIGHT TIME/ABERRATION
+		prefetchKeplerPositions(dateJDE, obsPosJDE);
 		foreach (PlanetP p, systemPlanets)
 		{
 			const double light_speed_correction = (p->getHeliocentricEclipticPos()-obsPosJDE).length() * (AU / (SPEED_OF_LIGHT * 86400.));
@@ -1193,21 +1334,20 @@ void SolarSystem::computePositions(double dateJDE, PlanetP observerPlanet)
 	}
 	else
 	{
+		prefetchKeplerPositions(dateJDE);
 		foreach (PlanetP p, systemPlanets)
 		{
 			p->computePosition(dateJDE);
 		}
 		lightTimeSunPosition.set(0.,0.,0.);
 	}
-	computeTransMatrices(dateJDE, observerPlanet->getHeliocentricEclipticPos());
+	computeTransMatrices(dateJD, dateJDE, observerPlanet->getHeliocentricEclipticPos());
 }
 
 // Compute the transformation matrix for every elements of the solar system.
 // The elements have to be ordered hierarchically, eg. it's important to compute earth before moon.
-void SolarSystem::computeTransMatrices(double dateJDE, const Vec3d& observerPos)
+void SolarSystem::computeTransMatrices(double dateJD, double dateJDE, const Vec3d& observerPos)
 {
-	double dateJD=dateJDE - (StelApp::getInstance().getCore()->computeDeltaT(dateJDE))/86400.0;
-
 	if (flagLightTravelTime)
 	{
 		foreach (PlanetP p, systemPlanets)
@@ -1225,6 +1365,264 @@ void SolarSystem::computeTransMatrices(double dateJDE, const Vec3d& observerPos)
 	}
 }
 
+// Number of minor bodies handled by one parallel task. Small enough to balance the load between threads,
+// large enough that the scheduling overhead does not dominate the Kepler equation solving.
+#define PARALLEL_POSITIONS_CHUNK_SIZE 256
+
+QVector<QVector<Planet*> > SolarSystem::getIndependentPlanetGroups() const
+{
+	QVector<QVector<Planet*> > groups;
+	QHash<const Planet*, int> subsystemGroup; // planet with satellites -> index in groups
+	QVector<Planet*> chunk;
+	chunk.reserve(PARALLEL_POSITIONS_CHUNK_SIZE);
+
+	foreach (const PlanetP& p, systemPlanets)
+	{
+		Planet* planet = p.data();
+		if (!planet->parent)
+			continue; // the Sun
+
+		// Find the body directly orbiting the Sun.
+		const Planet* root = planet;
+		while (root->parent->parent)
+			root = root->parent.data();
+
+		if (root == planet && planet->satellites.isEmpty())
+		{
+			chunk.append(planet);
+			if (chunk.size() == PARALLEL_POSITIONS_CHUNK_SIZE)
+			{
+				groups.append(chunk);
+				chunk.clear();
+			}
+			continue;
+		}
+
+		QHash<const Planet*, int>::const_iterator it = subsystemGroup.constFind(root);
+		if (it == subsystemGroup.constEnd())
+		{
+			it = subsystemGroup.insert(root, groups.size());
+			groups.append(QVector<Planet*>());
+		}
+		groups[it.value()].append(planet);
+	}
+	if (!chunk.isEmpty())
+		groups.append(chunk);
+
+	return groups;
+}
+
+// Same as the serial code path in computePositions() and computeTransMatrices(), but every group
+// returned by getIndependentPlanetGroups() is handled by one task of the global thread pool.
+// Within a group the bodies are processed in the order of systemPlanets, so parents are always done before their satellites.
+// The ephemeris functions keep one cache per thread (see EphemWrapper), the satellite theories (L1, TASS17, ...)
+// are only used by the group of their planet.
+void SolarSystem::computePositionsParallel(double dateJD, double dateJDE, PlanetP observerPlanet)
+{
+	QVector<QVector<Planet*> > groups = getIndependentPlanetGroups();
+
+	sun->computePosition(dateJDE);
+
+	if (flagLightTravelTime)
+	{
+		prefetchKeplerPositions(dateJDE);
+		QtConcurrent::blockingMap(groups, [dateJDE](const QVector<Planet*>& group) {
+			foreach (Planet* p, group)
+				p->computePositionWithoutOrbits(dateJDE);
+		});
+
+		// Solar light time correction, see computePositions().
+		const Vec3d obsPosJDE=observerPlanet->getHeliocentricEclipticPos();
+		const double obsDist=obsPosJDE.length();
+		observerPlanet->computePosition(dateJDE-obsDist * (AU / (SPEED_OF_LIGHT * 86400.)));
+		const Vec3d obsPosJDEbefore=observerPlanet->getHeliocentricEclipticPos();
+		lightTimeSunPosition=obsPosJDE-obsPosJDEbefore;
+		observerPlanet->computePosition(dateJDE);
+
+		prefetchKeplerPositions(dateJDE, obsPosJDE);
+		QtConcurrent::blockingMap(groups, [dateJDE, obsPosJDE](const QVector<Planet*>& group) {
+			foreach (Planet* p, group)
+			{
+				const double light_speed_correction = (p->getHeliocentricEclipticPos()-obsPosJDE).length() * (AU / (SPEED_OF_LIGHT * 86400.));
+				p->computePosition(dateJDE-light_speed_correction);
+			}
+		});
+
+		const Vec3d observerPos = observerPlanet->getHeliocentricEclipticPos();
+		const double sunLightTime = observerPos.length() * (AU / (SPEED_OF_LIGHT * 86400));
+		sun->computeTransMatrix(dateJD-sunLightTime, dateJDE-sunLightTime);
+		QtConcurrent::blockingMap(groups, [dateJD, dateJDE, observerPos](const QVector<Planet*>& group) {
+			foreach (Planet* p, group)
+			{
+				const double light_speed_correction = (p->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
+				p->computeTransMatrix(dateJD-light_speed_correction, dateJDE-light_speed_correction);
+			}
+		});
+	}
+	else
+	{
+		prefetchKeplerPositions(dateJDE);
+		sun->computeTransMatrix(dateJD, dateJDE);
+		QtConcurrent::blockingMap(groups, [dateJD, dateJDE](const QVector<Planet*>& group) {
+			foreach (Planet* p, group)
+			{
+				p->computePosition(dateJDE);
+				p->computeTransMatrix(dateJD, dateJDE);
+			}
+		});
+		lightTimeSunPosition.set(0.,0.,0.);
+	}
+}
+
+void SolarSystem::updateKeplerBatch()
+{
+	if (!keplerBatchDirty)
+		return;
+
+	keplerBatch.clear();
+	keplerBatchPlanets.clear();
+	foreach (const PlanetP& p, systemPlanets)
+	{
+		// Only bodies orbiting the Sun: the light time of a satellite depends on the corrected position
+		// of its parent, which is not known in advance.
+		if (!p->parent || p->parent->parent)
+			continue;
+
+		int slot = -1;
+		if (p->coordFunc == &ellipticalOrbitPosFunc)
+			slot = keplerBatch.add(static_cast<EllipticalOrbit*>(p->orbitPtr));
+		else if (p->coordFunc == &cometOrbitPosFunc)
+			slot = keplerBatch.add(static_cast<CometOrbit*>(p->orbitPtr));
+		if (slot >= 0)
+		{
+			Q_ASSERT(slot == keplerBatchPlanets.size());
+			keplerBatchPlanets.append(p.data());
+		}
+	}
+	keplerBatchJDE.resize(keplerBatchPlanets.size());
+	keplerBatchDirty = false;
+}
+
+void SolarSystem::prefetchKeplerPositions(double dateJDE)
+{
+	for (int i=0; i<keplerBatchPlanets.size(); ++i)
+	{
+		const Planet* p = keplerBatchPlanets.at(i);
+		// Same test as in Planet::computePosition(): while the date moves less than deltaJDE (e.g. when the time is stopped),
+		// no body is recomputed and solving the batch would be wasted.
+		if (fabs(p->lastJDE-dateJDE)>p->deltaJDE)
+		{
+			keplerBatch.computePositions(dateJDE, flagParallelPositions);
+			return;
+		}
+	}
+}
+
+// The dates must be computed exactly like in computePositions(), else the orbit caches are missed
+// and the positions are simply computed again one by one.
+void SolarSystem::prefetchKeplerPositions(double dateJDE, const Vec3d& observerPos)
+{
+	for (int i=0; i<keplerBatchPlanets.size(); ++i)
+	{
+		const double light_speed_correction = (keplerBatchPlanets.at(i)->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400.));
+		keplerBatchJDE[i] = dateJDE-light_speed_correction;
+	}
+	for (int i=0; i<keplerBatchPlanets.size(); ++i)
+	{
+		const Planet* p = keplerBatchPlanets.at(i);
+		if (fabs(p->lastJDE-keplerBatchJDE.at(i))>p->deltaJDE)
+		{
+			keplerBatch.computePositions(keplerBatchJDE, flagParallelPositions);
+			return;
+		}
+	}
+}
+
+QString SolarSystem::getEphemerisTheoryKey()
+{
+	StelCore* core=StelApp::getInstance().getCore();
+	QString key="vsop87";
+	if (core->de430IsActive())
+		key+="-de430";
+	if (core->de431IsActive())
+		key+="-de431";
+	return key;
+}
+
+static QString ephemerisCacheFileName(const QString& theoryKey, const QString& englishName)
+{
+	return StelFileMgr::getCacheDir()+"/ephemeris/"+theoryKey+"/"+englishName+".cheb";
+}
+
+static QString ephemerisCacheStamp(const QString& theoryKey, const QString& englishName)
+{
+	return QString("%1 %2 %3").arg(StelUtils::getApplicationVersion(), theoryKey, englishName);
+}
+
+void SolarSystem::setupEphemerisCaches()
+{
+	if (!flagEphemerisCache)
+		return;
+
+	// Stop filling the caches of the previous theory
+	ephemerisCachePrefillCancelled.store(1);
+	ephemerisCachePrefill.waitForFinished();
+	ephemerisCachePrefillCancelled.store(0);
+
+	StelCore* core=StelApp::getInstance().getCore();
+	ephemerisCacheDe430=core->de430IsActive();
+	ephemerisCacheDe431=core->de431IsActive();
+	ephemerisCacheTheory=getEphemerisTheoryKey();
+	const double now=StelUtils::getJDFromSystem();
+	const double halfWindow=0.5*365.25*conf->value("astro/ephemeris_cache_years", 200).toDouble();
+	const double prefillDays=conf->value("astro/ephemeris_cache_prefill_days", 366).toDouble();
+
+	QList<ChebyshevEphemeris*> caches;
+	foreach (const PlanetP& p, systemPlanets)
+	{
+		const posFuncType theory=p->coordFunc;
+		if (theory==&ellipticalOrbitPosFunc || theory==&cometOrbitPosFunc || theory==&get_sun_helio_coordsv)
+			continue;
+
+		const QString englishName=p->englishName;
+		ChebyshevEphemeris*& cache=ephemerisCaches[ephemerisCacheTheory+"/"+englishName];
+		if (!cache)
+		{
+			cache=new ChebyshevEphemeris(theory, englishName, ChebyshevEphemeris::segmentLengthForPeriod(p->getSiderealPeriod()), now-halfWindow, now+halfWindow);
+			cache->load(ephemerisCacheFileName(ephemerisCacheTheory, englishName), ephemerisCacheStamp(ephemerisCacheTheory, englishName));
+		}
+		p->ephemerisCache=cache;
+		caches << cache;
+	}
+
+	if (prefillDays>0.)
+	{
+		QAtomicInt* cancelled=&ephemerisCachePrefillCancelled;
+		ephemerisCachePrefill=QtConcurrent::run([caches, now, prefillDays, cancelled]()
+		{
+			foreach (ChebyshevEphemeris* cache, caches)
+				cache->prefill(now-prefillDays, now+prefillDays, cancelled);
+		});
+	}
+}
+
+void SolarSystem::saveEphemerisCaches()
+{
+	ephemerisCachePrefillCancelled.store(1);
+	ephemerisCachePrefill.waitForFinished();
+
+	QHashIterator<QString, ChebyshevEphemeris*> it(ephemerisCaches);
+	while (it.hasNext())
+	{
+		it.next();
+		if (!it.value()->isModified())
+			continue;
+		const QString theoryKey=it.key().section('/', 0, 0);
+		const QString& englishName=it.value()->getName();
+		it.value()->save(ephemerisCacheFileName(theoryKey, englishName), ephemerisCacheStamp(theoryKey, englishName));
+	}
+}
+
 // And sort them from the furthest to the closest to the observer
 struct biggerDistance : public std::binary_function<PlanetP, PlanetP, bool>
 {
@@ -1616,6 +2014,15 @@ void SolarSystem::setFlagLightTravelTime(bool b)
 	}
 }
 
+void SolarSystem::setFlagParallelPositions(bool b)
+{
+	if(b!=flagParallelPositions)
+	{
+		flagParallelPositions = b;
+		emit flagParallelPositionsChanged(b);
+	}
+}
+
 void SolarSystem::setFlagShowObjSelfShadows(bool b)
 {
 	if(b!=flagShowObjSelfShadows)
@@ -1641,6 +2048,14 @@ void SolarSystem::setSelected(PlanetP obj)
 
 void SolarSystem::update(double deltaTime)
 {
+	// The theory changes when DE430 or DE431 is switched on or off.
+	if (flagEphemerisCache)
+	{
+		StelCore* core=StelApp::getInstance().getCore();
+		if (core->de430IsActive()!=ephemerisCacheDe430 || core->de431IsActive()!=ephemerisCacheDe431)
+			setupEphemerisCaches();
+	}
+
 	trailFader.update(deltaTime*1000);
 	if (trailFader.getInterstate()>0.f)
 	{
@@ -2175,6 +2590,11 @@ QStringList SolarSystem::getAllMinorPlanetCommonEnglishNames() const
 // GZ TODO: This could be modified to only delete&reload the minor objects. For now, we really load both parts again like in the 0.10?-0.15 series.
 void SolarSystem::reloadPlanets()
 {
+	// Background jobs may still compute with the orbits which are deleted below
+	emit solarSystemDataAboutToReload();
+	QWriteLocker reloadLocker(&reloadLock);
+	reloadCount++;
+
 	// Save flag states
 	bool flagScaleMoon = getFlagMoonScale();
 	float moonScale = getMoonScale();
@@ -2206,6 +2626,7 @@ void SolarSystem::reloadPlanets()
 	selected.clear();//Release the selected one
 
 	// GZ TODO in case this methods gets converted to only reload minor bodies: Only delete Orbits which are not referenced by some Planet.
+	keplerBatchDirty = true;
 	foreach (Orbit* orb, orbits)
 	{
 		delete orb;
@@ -2236,6 +2657,7 @@ void SolarSystem::reloadPlanets()
 
 	// Re-load the ssystem_major.ini and ssystem_minor.ini file
 	loadPlanets();	
+	setupEphemerisCaches();
 	computePositions(core->getJDE(), getSun());
 	setSelected("");
 	recreateTrails();
@@ -2265,6 +2687,7 @@ void SolarSystem::reloadPlanets()
 	// Restore translations
 	updateI18n();
 
+	reloadLocker.unlock();
 	emit solarSystemDataReloaded();
 }
 
@@ -2382,57 +2805,47 @@ double SolarSystem::getEclipseFactor(const StelCore* core) const
 		planet->computeModelMatrix(trans);
 
 		const Vec3d C = trans * Vec3d(0., 0., 0.);
-		const double radius = planet->getRadius();
-
-		Vec3d v1 = Lp - P3;
-		Vec3d v2 = C - P3;
-
-		const double L = v1.length();
-		const double l = v2.length();
+		const double illumination = computeEclipseIllumination(Lp, RS, P3, C, planet->getRadius());
+		if(illumination < final_illumination)
+			final_illumination = illumination;
+	}
 
-		v1 = v1 / L;
-		v2 = v2 / l;
+	return final_illumination;
+}
 
-		const double R = RS / L;
-		const double r = radius / l;
-		const double d = ( v1 - v2 ).length();
+double SolarSystem::computeEclipseIllumination(const Vec3d& sunPos, double sunRadius, const Vec3d& observerPos, const Vec3d& bodyPos, double bodyRadius)
+{
+	Vec3d v1 = sunPos - observerPos;
+	Vec3d v2 = bodyPos - observerPos;
 
-		if(planet->englishName == "Moon")
-			v1 = planet->getHeliocentricEclipticPos(); // ??? This assignment is dead code!
+	const double L = v1.length();
+	const double l = v2.length();
 
-		double illumination;
+	v1 = v1 / L;
+	v2 = v2 / l;
 
-		if(d >= R + r) // distance too far
-		{
-			illumination = 1.0;
-		}
-		else if(d <= r - R) // umbra
-		{
-			illumination = 0.0;
-		}
-		else if(d <= R - r) // penumbra completely inside
-		{
-			illumination = 1.0 - r * r / (R * R);
-		}
-		else // penumbra partially inside
-		{
-			const double x = (R * R + d * d - r * r) / (2.0 * d);
+	const double R = sunRadius / L;
+	const double r = bodyRadius / l;
+	const double d = ( v1 - v2 ).length();
 
-			const double alpha = std::acos(x / R);
-			const double beta = std::acos((d - x) / r);
+	if(d >= R + r) // distance too far
+		return 1.0;
+	if(d <= r - R) // umbra
+		return 0.0;
+	if(d <= R - r) // penumbra completely inside
+		return 1.0 - r * r / (R * R);
 
-			const double AR = R * R * (alpha - 0.5 * std::sin(2.0 * alpha));
-			const double Ar = r * r * (beta - 0.5 * std::sin(2.0 * beta));
-			const double AS = R * R * 2.0 * std::asin(1.0);
+	// penumbra partially inside
+	const double x = (R * R + d * d - r * r) / (2.0 * d);
 
-			illumination = 1.0 - (AR + Ar) / AS;
-		}
+	const double alpha = std::acos(x / R);
+	const double beta = std::acos((d - x) / r);
 
-		if(illumination < final_illumination)
-			final_illumination = illumination;
-	}
+	const double AR = R * R * (alpha - 0.5 * std::sin(2.0 * alpha));
+	const double Ar = r * r * (beta - 0.5 * std::sin(2.0 * beta));
+	const double AS = R * R * 2.0 * std::asin(1.0);
 
-	return final_illumination;
+	return 1.0 - (AR + Ar) / AS;
 }
 
 bool SolarSystem::removeMinorPlanet(QString name)
@@ -2447,6 +2860,7 @@ bool SolarSystem::removeMinorPlanet(QString name)
 	if (orbPtr)
 		orbits.removeOne(orbPtr);
 	systemPlanets.removeOne(candidate);
+	keplerBatchDirty = true;
 	systemMinorBodies.removeOne(candidate);
 	candidate.clear();
 	return true;
@@ -28,9 +28,14 @@
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "Planet.hpp"
+#include "KeplerOrbitBatch.hpp"
+#include "ChebyshevEphemeris.hpp"
 #include "StelGui.hpp"
 
 #include <QFont>
+#include <QFuture>
+#include <QHash>
+#include <QReadWriteLock>
 
 class Orbit;
 class StelTranslator;
@@ -38,6 +43,7 @@ class StelObject;
 class StelCore;
 class StelProjector;
 class QSettings;
+struct SolarSystemBodyData;
 
 typedef QSharedPointer<Planet> PlanetP;
 
@@ -47,6 +53,9 @@ typedef QSharedPointer<Planet> PlanetP;
 class SolarSystem : public StelObjectModule
 {
 	Q_OBJECT
+	friend class TestEphemerisContext;
+	friend class TestSolarSystemCache;
+	friend class TestComputePositions;
 	Q_PROPERTY(bool labelsDisplayed // This is a "forwarding property" which sets labeling into all planets.
 		   READ getFlagLabels
 		   WRITE setFlagLabels
@@ -95,6 +104,11 @@ class SolarSystem : public StelObjectModule
 		   WRITE setFlagLightTravelTime
 		   NOTIFY flagLightTravelTimeChanged
 		   )
+	Q_PROPERTY(bool flagParallelPositions
+		   READ getFlagParallelPositions
+		   WRITE setFlagParallelPositions
+		   NOTIFY flagParallelPositionsChanged
+		   )
 	Q_PROPERTY(bool flagUseObjModels
 		   READ getFlagUseObjModels
 		   WRITE setFlagUseObjModels
@@ -384,6 +398,12 @@ public slots:
 	//! calculation is used or not.
 	bool getFlagLightTravelTime(void) const {return flagLightTravelTime;}
 
+	//! Set flag which determines if positions of independent groups of solar system bodies
+	//! (each planet with its moons, chunks of minor bodies) are computed in parallel threads.
+	void setFlagParallelPositions(bool b);
+	//! Get the current value of the flag which determines if positions are computed in parallel threads.
+	bool getFlagParallelPositions(void) const {return flagParallelPositions;}
+
 	//! Set flag whether to use OBJ models for rendering, where available
 	void setFlagUseObjModels(bool b) { if(b!=flagUseObjModels) { flagUseObjModels = b; emit flagUseObjModelsChanged(b); } }
 	//! Get the current value of the flag which determines wether to use OBJ models for rendering, where available
@@ -782,6 +802,7 @@ signals:
 	void flagIsolatedOrbitsChanged(bool b);
 	void flagIsolatedTrailsChanged(bool b);
 	void flagLightTravelTimeChanged(bool b);
+	void flagParallelPositionsChanged(bool b);
 	void flagUseObjModelsChanged(bool b);
 	void flagShowObjSelfShadowsChanged(bool b);
 	void flagMoonScaleChanged(bool b);
@@ -820,6 +841,9 @@ signals:
 
 	void orbitColorStyleChanged(QString style) const;
 
+	//! Emitted by reloadPlanets() before any body or orbit is deleted. Receivers must stop
+	//! all background work which uses the bodies before they return, so connect them directly.
+	void solarSystemDataAboutToReload();
 	void solarSystemDataReloaded();
 
 public:
@@ -855,12 +879,21 @@ public:
 
 	//! Reload the planets
 	void reloadPlanets();
+	//! Get the lock which reloadPlanets() holds for writing while it deletes and recreates the bodies.
+	//! Threads other than the main thread hold it for reading while they compute with the bodies.
+	//! They must not wait for the main thread meanwhile, as it may be waiting in reloadPlanets().
+	QReadWriteLock* getReloadLock() {return &reloadLock;}
+	//! Get the number of calls to reloadPlanets(), to check whether bodies obtained earlier still exist.
+	//! Only read it from the main thread or with getReloadLock() held.
+	int getReloadCount() const {return reloadCount;}
 
 	//! New 0.16: delete a planet from the solar system. Writes a warning to log if this is not a minor object.
 	bool removeMinorPlanet(QString name);
 
 	//! Determines relative amount of sun visible from the observer's position.
 	double getEclipseFactor(const StelCore *core) const;
+	//! Fraction of the solar disk visible from observerPos when a body is in front of it, all positions heliocentric in AU.
+	static double computeEclipseIllumination(const Vec3d& sunPos, double sunRadius, const Vec3d& observerPos, const Vec3d& bodyPos, double bodyRadius);
 
 	//! Compute the position and transform matrix for every element of the solar system.
 	//! @param dateJDE the Julian Day in JDE (Ephemeris Time or equivalent)	
@@ -909,9 +942,37 @@ private:
 	//! @return a pointer to a StelObject if found, else Q_NULLPTR
 	StelObjectP search(Vec3d v, const StelCore* core) const;
 
+	//! Same as the public computePositions(), with the date in UT given instead of computed with StelCore::computeDeltaT().
+	void computePositions(double dateJD, double dateJDE, PlanetP observerPlanet);
+
 	//! Compute the transformation matrix for every elements of the solar system.
 	//! observerPos is needed for light travel time computation.
-	void computeTransMatrices(double dateJDE, const Vec3d& observerPos = Vec3d(0.));
+	void computeTransMatrices(double dateJD, double dateJDE, const Vec3d& observerPos = Vec3d(0.));
+
+	//! Split the bodies orbiting the Sun into groups which can be updated independently of each other:
+	//! every planet with satellites forms one group together with all its satellites (in hierarchical order),
+	//! the remaining bodies (minor planets, comets) are cut into chunks of equal size. The Sun is not included.
+	QVector<QVector<Planet*> > getIndependentPlanetGroups() const;
+
+	//! Parallel version of computePositions(), used when flagParallelPositions is set.
+	void computePositionsParallel(double dateJD, double dateJDE, PlanetP observerPlanet);
+
+	//! Rebuild keplerBatch from systemPlanets after bodies have been loaded or removed.
+	void updateKeplerBatch();
+	//! Solve the orbits of keplerBatch for dateJDE, so that the following computePosition() calls
+	//! of these bodies find their results in the caches of the orbit objects.
+	//! Nothing is solved while none of the bodies has moved more than its deltaJDE from its last computed date.
+	void prefetchKeplerPositions(double dateJDE);
+	//! Same for the light time corrected dates used by computePositions(), given the observer position.
+	void prefetchKeplerPositions(double dateJDE, const Vec3d& observerPos);
+
+	//! Key of the theory given by the position functions of the major bodies for the current DE430/DE431 settings.
+	static QString getEphemerisTheoryKey();
+	//! Compute the bodies given by a theory (not the Kepler orbits, which are cheaper) through the Chebyshev caches
+	//! of the current theory, loading them from disk when first used, and fill them around the current date in the background.
+	void setupEphemerisCaches();
+	//! Wait for the background filling of the caches, then write the modified caches to disk.
+	void saveEphemerisCaches();
 
 	//! Draw a nice animated pointer around the object.
 	void drawPointer(const StelCore* core);
@@ -923,8 +984,17 @@ private:
 	void loadPlanets();
 
 	//! Load planet data from the given file
+	//! The parsed file is kept in a SolarSystemCache, which is read instead of the file while the file is unchanged.
 	bool loadPlanets(const QString& filePath);
 
+	//! Read the bodies of a Solar System file, ordered such that each body comes after its parent.
+	static bool readSolarSystemFile(const QString& filePath, QVector<SolarSystemBodyData>& bodies);
+
+	//! Create a body from its data in a Solar System file, and add it to systemPlanets.
+	//! @param bodiesByName the bodies created so far by English name, to find the parent of the body.
+	//! @return the new body, or a null pointer if the data are invalid.
+	PlanetP addBody(const SolarSystemBodyData& data, const QHash<QString, PlanetP>& bodiesByName);
+
 	void recreateTrails();
 
 	//! Set flag who enable display a permanent orbits for objects or not
@@ -966,6 +1036,7 @@ private:
 	// Master settings
 	bool flagOrbits;
 	bool flagLightTravelTime;
+	bool flagParallelPositions;
 	bool flagUseObjModels;
 	bool flagShowObjSelfShadows;
 
@@ -1004,6 +1075,23 @@ private:
 	// note that we must also always compensate to light time travel, so likely each computation has to be done twice,
 	// with current JDE and JDE-lightTime(distance).
 	QList<Orbit*> orbits;           // Pointers on created elliptical orbits. 0.16pre: WHY DO WE NEED THIS???
+	QReadWriteLock reloadLock;
+	int reloadCount;
+
+	//! Closed orbits of the minor bodies and comets orbiting the Sun, solved together in computePositions().
+	KeplerOrbitBatch keplerBatch;
+	QVector<Planet*> keplerBatchPlanets;	// planet for each slot of keplerBatch
+	QVector<double> keplerBatchJDE;		// light time corrected date for each slot
+	bool keplerBatchDirty;			// systemPlanets changed since the last updateKeplerBatch()
+
+	//! Chebyshev caches of the bodies computed by a theory, by "theory key/English name". They are kept until the destructor.
+	QHash<QString, ChebyshevEphemeris*> ephemerisCaches;
+	bool flagEphemerisCache;
+	QString ephemerisCacheTheory;		// theory key of the caches in use
+	bool ephemerisCacheDe430;		// DE430/DE431 settings of ephemerisCacheTheory, checked in update()
+	bool ephemerisCacheDe431;
+	QFuture<void> ephemerisCachePrefill;
+	QAtomicInt ephemerisCachePrefillCancelled;
 };
 
 
@@ -0,0 +1,98 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "SolarSystemCache.hpp"
+#include "StelCacheFile.hpp"
+
+#include <cstring>
+
+// The strings of the records are indices into the string table of the StelCacheFile.
+// The records are in the order of the bodies, i.e. each body comes after its parent.
+namespace
+{
+	const quint32 SOLARSYSTEM_CACHE_MAGIC = 0x53534331; // "SSC1"
+	const quint32 SOLARSYSTEM_CACHE_VERSION = 1;
+
+	enum StringField
+	{
+		Section, EnglishName, Parent, CoordFunc, Type, TexMap, NormalsMap, Model, ProvisionalDesignation, IauMoonNumber, TexRing,
+		StringFieldCount
+	};
+
+	struct Record
+	{
+		quint32 strings[StringFieldCount];
+		SolarSystemBodyData::Values values;
+	};
+
+	QString SolarSystemBodyData::* const stringFields[StringFieldCount] =
+	{
+		&SolarSystemBodyData::section, &SolarSystemBodyData::englishName, &SolarSystemBodyData::parent,
+		&SolarSystemBodyData::coordFunc, &SolarSystemBodyData::type, &SolarSystemBodyData::texMap,
+		&SolarSystemBodyData::normalsMap, &SolarSystemBodyData::model, &SolarSystemBodyData::provisionalDesignation,
+		&SolarSystemBodyData::iauMoonNumber, &SolarSystemBodyData::texRing
+	};
+}
+
+bool SolarSystemCache::write(const QString& fileName, const QString& stamp, const QVector<SolarSystemBodyData>& bodies)
+{
+	StelCacheFile::StringTable strings(stamp);
+	QVector<Record> records;
+	records.reserve(bodies.size());
+	foreach (const SolarSystemBodyData& body, bodies)
+	{
+		Record r;
+		memset(&r, 0, sizeof(Record)); // no uninitialized padding in the file
+		for (int i=0; i<StringFieldCount; ++i)
+			r.strings[i] = strings.intern(body.*stringFields[i]);
+		r.values = body.values;
+		records.append(r);
+	}
+	return StelCacheFile::write(fileName, SOLARSYSTEM_CACHE_MAGIC, SOLARSYSTEM_CACHE_VERSION, strings, records.constData(), records.size(), sizeof(Record));
+}
+
+bool SolarSystemCache::read(const QString& fileName, const QString& stamp, QVector<SolarSystemBodyData>& bodies)
+{
+	bodies.clear();
+	StelCacheFile file;
+	if (!file.read(fileName, SOLARSYSTEM_CACHE_MAGIC, SOLARSYSTEM_CACHE_VERSION, stamp, sizeof(Record)))
+		return false;
+	const QVector<QString>& strings = file.getStrings();
+	const quint32 nbStrings = strings.size();
+	const Record* records = static_cast<const Record*>(file.getRecords());
+
+	bodies.resize(file.getRecordCount());
+	for (int i=0; i<file.getRecordCount(); ++i)
+	{
+		const Record& r = records[i];
+		SolarSystemBodyData& body = bodies[i];
+		for (int j=0; j<StringFieldCount; ++j)
+		{
+			if (r.strings[j]>=nbStrings)
+			{
+				bodies.clear();
+				return false;
+			}
+			body.*stringFields[j] = strings.at(r.strings[j]);
+		}
+		body.values = r.values;
+	}
+	return true;
+}
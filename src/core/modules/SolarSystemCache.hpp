@@ -0,0 +1,115 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _SOLARSYSTEMCACHE_HPP_
+#define _SOLARSYSTEMCACHE_HPP_
+
+#include <QString>
+#include <QVector>
+
+//! @struct SolarSystemBodyData
+//! The content of one section of a Solar System file (ssystem_major.ini or ssystem_minor.ini),
+//! with the defaults of the file format applied. Angles and sizes are in the units of the file.
+struct SolarSystemBodyData
+{
+	QString section;
+	QString englishName;
+	//! Name of the parent body, "none" for the Sun.
+	QString parent;
+	QString coordFunc;
+	QString type;
+	QString texMap;
+	QString normalsMap;
+	QString model;
+	QString provisionalDesignation;
+	QString iauMoonNumber;
+	QString texRing;
+
+	//! Numbers and flags of the section. Orbital elements which are missing from the section
+	//! and have no default for the orbit type of the body are set to -1e100.
+	struct Values
+	{
+		double orbitEpoch;
+		double orbitEccentricity;
+		double orbitPericenterDistance;
+		double orbitSemiMajorAxis;
+		double orbitMeanMotion;
+		double orbitPeriod;
+		double orbitInclination;
+		double orbitAscendingNode;
+		double orbitArgOfPericenter;
+		double orbitLongOfPericenter;
+		double orbitMeanAnomaly;
+		double orbitMeanLongitude;
+		double orbitTimeAtPericenter;
+		double orbitGood;
+		double orbitVisualizationPeriod;
+		double radius;
+		double oblateness;
+		double absoluteMagnitude;
+		double slopeParameter;
+		double rotPeriod;
+		double rotRotationOffset;
+		double rotEpoch;
+		double rotObliquity;
+		double rotAscendingNode;
+		double rotPoleRA;
+		double rotPoleDE;
+		double rotPrecessionRate;
+		double ringInnerSize;
+		double ringOuterSize;
+		float color[3];
+		float albedo;
+		float roughness;
+		float outgasIntensity;
+		float outgasFalloff;
+		float dustWidthFactor;
+		float dustLengthFactor;
+		float dustBrightnessFactor;
+		qint32 minorPlanetNumber;
+		bool closeOrbit;
+		bool hidden;
+		bool atmosphere;
+		bool halo;
+		bool rings;
+	} values;
+};
+
+//! @class SolarSystemCache
+//! Compact binary copy of a Solar System file, written once the file has been parsed and memory mapped on the
+//! next loads instead of parsing the file again, which takes long for large sets of minor bodies (e.g. a full
+//! import of the MPC files). The ini file remains the only file to edit: the cache is only read back with the
+//! stamp it was written with, which identifies the version of the ini file.
+//! Each distinct string is stored once, and the numbers of each body are stored as they are in memory.
+//! The file uses the native byte order and is only meant for the machine which wrote it.
+class SolarSystemCache
+{
+public:
+	//! Write bodies to a cache file.
+	//! @param stamp identifies the source file; the cache is only read back with the same stamp.
+	//! @return false if the file could not be written.
+	static bool write(const QString& fileName, const QString& stamp, const QVector<SolarSystemBodyData>& bodies);
+
+	//! Read bodies from a cache file, replacing the content of bodies.
+	//! @return false if the file is missing, invalid or written with another stamp. bodies is then left empty.
+	static bool read(const QString& fileName, const QString& stamp, QVector<SolarSystemBodyData>& bodies);
+};
+
+#endif // _SOLARSYSTEMCACHE_HPP_
@@ -141,6 +141,14 @@ StarMgr::StarMgr(void)
 	: flagStarName(false)
 	, labelsAmount(0.)
 	, gravityLabel(false)
+	, lazyLoadingMinLevel(-1)
+	, maxLoadedZonesBytes(0)
+	, lastPrefetchGeneration(0)
+	, lastDrawTimeBucket(0)
+	, lastDrawWithExtinction(false)
+	, lastDrawExtinctionCoefficient(0.f)
+	, lastDrawPressure(0.f)
+	, lastDrawTemperature(0.f)
 	, hipIndex(new HipIndexStruct[NR_OF_HIP+1])
 {
 	setObjectName("StarMgr");
@@ -420,6 +428,9 @@ void StarMgr::init()
 		}
 	}
 
+	lazyLoadingMinLevel = conf->value("stars/lazy_loading_min_level", 4).toInt();
+	maxLoadedZonesBytes = conf->value("stars/max_loaded_zones_mb", 256).toLongLong()*1024*1024;
+
 	loadData(starSettings);
 
 	populateStarsDesignations();
@@ -541,7 +552,7 @@ bool StarMgr::checkAndLoadCatalog(const QVariantMap& catDesc)
 		}
 	}
 
-	ZoneArray* z = ZoneArray::create(catalogFilePath, true);
+	ZoneArray* z = ZoneArray::create(catalogFilePath, true, lazyLoadingMinLevel);
 	if (z)
 	{
 		if (z->level<gridLevels.size())
@@ -1102,6 +1113,78 @@ int StarMgr::getMaxSearchLevel() const
 }
 
 
+void StarMgr::prefetchZonesAroundViewport(const StelCore* core, const QVector<SphericalCap>& viewportCaps, int maxSearchLevel)
+{
+	// Only when the view moved, the search would replace the cached search result of the geodesic grid
+	if (lastPrefetchGeneration==zoneDrawCacheState.projectionGeneration)
+		return;
+	lastPrefetchGeneration = zoneDrawCacheState.projectionGeneration;
+
+	bool hasLazyLevel = false;
+	foreach(const ZoneArray* z, gridLevels)
+		hasLazyLevel = hasLazyLevel || (z->level<=maxSearchLevel && z->isLazyLoading());
+	if (!hasLazyLevel)
+		return;
+
+	// Widen the viewport by about the size of a zone of the deepest searched level
+	const double margin = 1.1/(1<<maxSearchLevel);
+	QVector<SphericalCap> caps;
+	foreach (const SphericalCap& cap, viewportCaps)
+	{
+		const double angle = std::acos(qBound(-1., cap.d, 1.)) + margin;
+		caps.append(SphericalCap(cap.n, angle>=M_PI ? -1. : std::cos(angle)));
+	}
+	const GeodesicSearchResult* searchResult = core->getGeodesicGrid(maxSearchLevel)->search(caps, maxSearchLevel);
+
+	foreach(const ZoneArray* z, gridLevels)
+	{
+		if (z->level>maxSearchLevel || !z->isLazyLoading())
+			continue;
+		QVector<int> zones;
+		int zone;
+		for (GeodesicSearchInsideIterator it1(*searchResult,z->level);(zone = it1.next()) >= 0;)
+			zones.append(zone);
+		for (GeodesicSearchBorderIterator it1(*searchResult,z->level);(zone = it1.next()) >= 0;)
+			zones.append(zone);
+		z->prefetchZones(zones);
+	}
+}
+
+void StarMgr::updateZoneDrawCacheState(const StelCore* core, const StelProjectorP& prj, const QVector<SphericalCap>& viewportCaps)
+{
+	++zoneDrawCacheState.frame;
+
+	const StelSkyDrawer* skyDrawer = core->getSkyDrawer();
+	const qint64 timeBucket = (qint64)std::floor(core->getJDE()*86400.);
+	const StelLocation& location = core->getCurrentLocation();
+	const bool withExtinction = skyDrawer->getFlagHasAtmosphere() && skyDrawer->getExtinction().getExtinctionCoefficient()>=0.01f;
+	const float extinctionCoefficient = skyDrawer->getExtinction().getExtinctionCoefficient();
+	const bool starsChanged = zoneDrawCacheState.starsGeneration==0 || timeBucket!=lastDrawTimeBucket
+		|| location.latitude!=lastDrawLocation.latitude || location.longitude!=lastDrawLocation.longitude
+		|| location.altitude!=lastDrawLocation.altitude || location.planetName!=lastDrawLocation.planetName
+		|| withExtinction!=lastDrawWithExtinction || (withExtinction && extinctionCoefficient!=lastDrawExtinctionCoefficient);
+	if (starsChanged)
+	{
+		++zoneDrawCacheState.starsGeneration;
+		lastDrawTimeBucket = timeBucket;
+		lastDrawLocation = location;
+		lastDrawWithExtinction = withExtinction;
+		lastDrawExtinctionCoefficient = extinctionCoefficient;
+	}
+
+	const Refraction& refraction = skyDrawer->getRefraction();
+	if (starsChanged || lastDrawProjector.isNull() || !prj->isSameProjection(*lastDrawProjector)
+	    || refraction.getPressure()!=lastDrawPressure || refraction.getTemperature()!=lastDrawTemperature
+	    || viewportCaps!=lastDrawViewportCaps)
+	{
+		++zoneDrawCacheState.projectionGeneration;
+		lastDrawProjector = prj;
+		lastDrawPressure = refraction.getPressure();
+		lastDrawTemperature = refraction.getTemperature();
+		lastDrawViewportCaps = viewportCaps;
+	}
+}
+
 // Draw all the stars
 void StarMgr::draw(StelCore* core)
 {
@@ -1116,6 +1199,7 @@ void StarMgr::draw(StelCore* core)
 	QVector<SphericalCap> viewportCaps = prj->getViewportConvexPolygon()->getBoundingSphericalCaps();
 	viewportCaps.append(core->getVisibleSkyArea());
 	const GeodesicSearchResult* geodesic_search_result = core->getGeodesicGrid(maxSearchLevel)->search(viewportCaps,maxSearchLevel);
+	updateZoneDrawCacheState(core, prj, viewportCaps);
 
 	// Set temporary static variable for optimization
 	const float names_brightness = labelsFader.getInterstate() * starsFader.getInterstate();
@@ -1170,12 +1254,22 @@ void StarMgr::draw(StelCore* core)
 		int zone;
 		
 		for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, true, rcmag_table, limitMagIndex, core, maxMagStarName, names_brightness, viewportCaps);
+			z->draw(&sPainter, zone, true, rcmag_table, limitMagIndex, core, maxMagStarName, names_brightness, viewportCaps, zoneDrawCacheState);
 		for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, false, rcmag_table, limitMagIndex, core, maxMagStarName,names_brightness, viewportCaps);
+			z->draw(&sPainter, zone, false, rcmag_table, limitMagIndex, core, maxMagStarName,names_brightness, viewportCaps, zoneDrawCacheState);
 	}
 	exit_loop:
 
+	// Forget the zones which left the viewport or are too faint now
+	foreach(const ZoneArray* z, gridLevels)
+		z->releaseDrawCache(zoneDrawCacheState.frame);
+
+	// Keep the stars of lazily loaded catalogs within the budget, the deepest levels give way first
+	qint64 remainingBytes = maxLoadedZonesBytes;
+	foreach(const ZoneArray* z, gridLevels)
+		remainingBytes -= z->trimLoadedZones(qMax(remainingBytes, (qint64)0));
+	prefetchZonesAroundViewport(core, viewportCaps, maxSearchLevel);
+
 	// Finish drawing many stars
 	skyDrawer->postDrawPointSource(&sPainter);
 
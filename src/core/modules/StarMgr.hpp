@@ -27,6 +27,8 @@
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "StelProjectorType.hpp"
+#include "StelLocation.hpp"
+#include "StelSphereGeometry.hpp"
 
 class StelObject;
 class StelToneReproducer;
@@ -64,6 +66,19 @@ typedef struct
 
 typedef QMap<StelObjectP, float> StelACStarData;
 
+//! Tells the zones which of their cached stars are still valid, see ZoneArray::draw().
+//! A generation is incremented by StarMgr each time anything the cached data depend on changes.
+struct ZoneDrawCacheState
+{
+	ZoneDrawCacheState() : frame(0), starsGeneration(0), projectionGeneration(0) {}
+	//! Number of the frame being drawn
+	quint64 frame;
+	//! Changes with the date, the location and the extinction
+	quint64 starsGeneration;
+	//! Changes with the stars and with the projector, refraction and viewport
+	quint64 projectionGeneration;
+};
+
 //! @class StarMgr
 //! Stores the star catalogue data.
 //! Used to render the stars themselves, as well as determine the color table
@@ -392,6 +407,13 @@ private:
 	//! Draw a nice animated pointer around the object.
 	void drawPointer(StelPainter& sPainter, const StelCore* core);
 
+	//! Load the zones of lazily loaded catalogs around the viewport in the background.
+	void prefetchZonesAroundViewport(const StelCore* core, const QVector<SphericalCap>& viewportCaps, int maxSearchLevel);
+
+	//! Advance zoneDrawCacheState to the next frame and invalidate the cached stars
+	//! and projected positions if anything they depend on changed since the last frame.
+	void updateZoneDrawCacheState(const StelCore* core, const StelProjectorP& prj, const QVector<SphericalCap>& viewportCaps);
+
 	void populateHipparcosLists();
 	void populateStarsDesignations();
 
@@ -411,6 +433,21 @@ private:
 	
 	// A ZoneArray per grid level
 	QVector<ZoneArray*> gridLevels;
+
+	// Catalogs from this level on are loaded zone by zone when needed, within the given memory budget
+	int lazyLoadingMinLevel;
+	qint64 maxLoadedZonesBytes;
+	quint64 lastPrefetchGeneration;
+
+	// Per-zone caches of the drawn stars, valid as long as neither the date nor the view change
+	ZoneDrawCacheState zoneDrawCacheState;
+	qint64 lastDrawTimeBucket;		// JDE in seconds
+	StelLocation lastDrawLocation;
+	bool lastDrawWithExtinction;
+	float lastDrawExtinctionCoefficient;
+	StelProjectorP lastDrawProjector;
+	float lastDrawPressure, lastDrawTemperature;
+	QVector<SphericalCap> lastDrawViewportCaps;
 	static void initTriangleFunc(int lev, int index,
 								 const Vec3f &c0,
 								 const Vec3f &c1,
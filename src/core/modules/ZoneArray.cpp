@@ -27,11 +27,24 @@
 #include <QDebug>
 #include <QFile>
 #include <QDir>
+#include <QPair>
+#include <QVarLengthArray>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
 #ifdef Q_OS_WIN
 #include <io.h>
 #include <windows.h>
 #endif
 
+#if defined(__AVX__)
+ #include <immintrin.h>
+ #define ZONE_CULLING_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define ZONE_CULLING_SSE2
+#endif
+
 
 static unsigned int stel_bswap_32(unsigned int val)
 {
@@ -41,6 +54,87 @@ static unsigned int stel_bswap_32(unsigned int val)
 
 static const Vec3f north(0,0,1);
 
+// Write the indices of the stars inside all caps to inside and return their number.
+// The positions (x,y,z) need not be normalized: n*v>=d*|v| is tested instead of n*(v/|v|)>=d.
+// 8 (AVX) or 4 (SSE2) stars are tested at once, and testing stops as soon as all of them are outside a cap.
+static int cullOutsideCaps(const float* x, const float* y, const float* z, int count,
+			   const QVector<SphericalCap>& caps, int* inside)
+{
+	const int nbCaps = caps.size();
+	QVarLengthArray<float, 32> capData(nbCaps*4);
+	for (int c=0;c<nbCaps;++c)
+	{
+		capData[4*c]   = caps.at(c).n[0];
+		capData[4*c+1] = caps.at(c).n[1];
+		capData[4*c+2] = caps.at(c).n[2];
+		capData[4*c+3] = caps.at(c).d;
+	}
+	const float* cap = capData.constData();
+
+	int nbInside = 0;
+	int i = 0;
+#if defined(ZONE_CULLING_AVX)
+	for (;i+8<=count;i+=8)
+	{
+		const __m256 vx = _mm256_loadu_ps(x+i);
+		const __m256 vy = _mm256_loadu_ps(y+i);
+		const __m256 vz = _mm256_loadu_ps(z+i);
+		const __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz)));
+		int mask = 0xff;
+		for (int c=0;c<nbCaps && mask;++c)
+		{
+			const float* k = cap+4*c;
+			const __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, _mm256_set1_ps(k[0])), _mm256_mul_ps(vy, _mm256_set1_ps(k[1]))),
+							 _mm256_mul_ps(vz, _mm256_set1_ps(k[2])));
+			mask &= _mm256_movemask_ps(_mm256_cmp_ps(dot, _mm256_mul_ps(len, _mm256_set1_ps(k[3])), _CMP_GE_OQ));
+		}
+		for (int b=0;b<8;++b)
+		{
+			if (mask & (1<<b))
+				inside[nbInside++] = i+b;
+		}
+	}
+#elif defined(ZONE_CULLING_SSE2)
+	for (;i+4<=count;i+=4)
+	{
+		const __m128 vx = _mm_loadu_ps(x+i);
+		const __m128 vy = _mm_loadu_ps(y+i);
+		const __m128 vz = _mm_loadu_ps(z+i);
+		const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+		int mask = 0xf;
+		for (int c=0;c<nbCaps && mask;++c)
+		{
+			const float* k = cap+4*c;
+			const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(k[0])), _mm_mul_ps(vy, _mm_set1_ps(k[1]))),
+						      _mm_mul_ps(vz, _mm_set1_ps(k[2])));
+			mask &= _mm_movemask_ps(_mm_cmpge_ps(dot, _mm_mul_ps(len, _mm_set1_ps(k[3]))));
+		}
+		for (int b=0;b<4;++b)
+		{
+			if (mask & (1<<b))
+				inside[nbInside++] = i+b;
+		}
+	}
+#endif
+	for (;i<count;++i)
+	{
+		const float len = std::sqrt(x[i]*x[i]+y[i]*y[i]+z[i]*z[i]);
+		bool isVisible = true;
+		for (int c=0;c<nbCaps;++c)
+		{
+			const float* k = cap+4*c;
+			if (x[i]*k[0]+y[i]*k[1]+z[i]*k[2] < len*k[3])
+			{
+				isVisible = false;
+				break;
+			}
+		}
+		if (isVisible)
+			inside[nbInside++] = i;
+	}
+	return nbInside;
+}
+
 void ZoneArray::initTriangle(int index, const Vec3f &c0, const Vec3f &c1, const Vec3f &c2)
 {
 	// initialize center,axis0,axis1:
@@ -90,7 +184,7 @@ static inline int ReadInt(QFile& file, unsigned int &x)
 #endif
 #endif
 
-ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
+ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap, int lazy_loading_min_level)
 {
 	QString dbStr; // for debugging output.
 	QFile* file = new QFile(catalogFilePath);
@@ -165,6 +259,7 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 	}
 	ZoneArray *rval = Q_NULLPTR;
 	dbStr += QString("%1_%2v%3_%4; ").arg(level).arg(type).arg(major).arg(minor);
+	const bool lazy_loading = lazy_loading_min_level>=0 && (int)level>=lazy_loading_min_level;
 
 	switch (type)
 	{
@@ -201,7 +296,7 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 #ifndef _MSC_BUILD
 				Q_ASSERT(sizeof(Star2) == 10);
 #endif
-				rval = new SpecialZoneArray<Star2>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps);
+				rval = new SpecialZoneArray<Star2>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps, lazy_loading);
 				if (rval == Q_NULLPTR)
 				{
 					dbStr += "error - no memory ";
@@ -222,7 +317,7 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 #ifndef _MSC_BUILD
 				Q_ASSERT(sizeof(Star3) == 6);
 #endif
-				rval = new SpecialZoneArray<Star3>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps);
+				rval = new SpecialZoneArray<Star3>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps, lazy_loading);
 				if (rval == Q_NULLPTR)
 				{
 					dbStr += "error - no memory ";
@@ -236,6 +331,8 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 	if (rval && rval->isInitialized())
 	{
 		dbStr += QString("%1").arg(rval->getNrOfStars());
+		if (rval->isLazyLoading())
+			dbStr += " (loaded on demand)";
 		qDebug() << dbStr;
 	}
 	else
@@ -255,11 +352,155 @@ ZoneArray::ZoneArray(const QString& fname, QFile* file, int level, int mag_min,
 			 int mag_range, int mag_steps)
 			: fname(fname), level(level), mag_min(mag_min),
 			  mag_range(mag_range), mag_steps(mag_steps),
-			  star_position_scale(0.0), nr_of_stars(0), zones(Q_NULLPTR), file(file)
+			  star_position_scale(0.0), nr_of_stars(0), zones(Q_NULLPTR), file(file),
+			  lazyLoading(false), lazyMmap(false), starSize(0), useCounter(0), lastTrimUse(0), loadedBytes(0)
 {
 	nr_of_zones = StelGeodesicGrid::nrOfZones(level);	
 }
 
+void ZoneArray::releaseDrawCache(quint64 frame) const
+{
+	for (QHash<int, ZoneDrawCache>::iterator it=drawCache.begin(); it!=drawCache.end();)
+	{
+		if (it->lastFrame!=frame)
+			it = drawCache.erase(it);
+		else
+			++it;
+	}
+}
+
+bool ZoneArray::initLazyLoading(bool use_mmap, int star_size)
+{
+	lazyLoading = true;
+	lazyMmap = use_mmap;
+	starSize = star_size;
+	zoneFileOffset.resize(nr_of_zones);
+	zoneLastUse.fill(0, nr_of_zones);
+	// The stars of all zones follow the zone sizes in the file
+	qint64 offset = file->pos();
+	for (unsigned int z=0;z<nr_of_zones;z++)
+	{
+		zones[z].stars = Q_NULLPTR;
+		zoneFileOffset[z] = offset;
+		offset += (qint64)zones[z].size*star_size;
+	}
+	return offset<=file->size();
+}
+
+bool ZoneArray::loadZone(int index) const
+{
+	if (!lazyLoading)
+		return true;
+	QMutexLocker locker(&pagingMutex);
+	zoneLastUse[index] = ++useCounter;
+	if (zones[index].stars!=Q_NULLPTR || zones[index].size==0)
+		return true;
+	return readZone(index);
+}
+
+void ZoneArray::prefetchZones(const QVector<int>& indices) const
+{
+	if (!lazyLoading || prefetchFuture.isRunning())
+		return;
+	QVector<int> missing;
+	{
+		QMutexLocker locker(&pagingMutex);
+		foreach (int index, indices)
+		{
+			if (zones[index].stars==Q_NULLPTR && zones[index].size>0)
+				missing.append(index);
+		}
+	}
+	if (missing.isEmpty())
+		return;
+	prefetchFuture = QtConcurrent::run([this, missing]()
+	{
+		foreach (int index, missing)
+		{
+			QMutexLocker locker(&pagingMutex);
+			if (zones[index].stars==Q_NULLPTR)
+			{
+				zoneLastUse[index] = ++useCounter;
+				readZone(index);
+			}
+		}
+	});
+}
+
+qint64 ZoneArray::trimLoadedZones(qint64 maxBytes) const
+{
+	if (!lazyLoading)
+		return 0;
+	QMutexLocker locker(&pagingMutex);
+	if (loadedBytes>maxBytes)
+	{
+		// Release the least recently used zones first, but keep those used since the last call,
+		// else the zones of a too large viewport would be read again and again.
+		QVector<QPair<quint64, int> > candidates;
+		for (unsigned int z=0;z<nr_of_zones;z++)
+		{
+			if (zones[z].stars!=Q_NULLPTR && zoneLastUse[z]<=lastTrimUse)
+				candidates.append(qMakePair(zoneLastUse[z], (int)z));
+		}
+		std::sort(candidates.begin(), candidates.end());
+		for (int i=0;i<candidates.size() && loadedBytes>maxBytes;++i)
+			releaseZone(candidates.at(i).second);
+	}
+	lastTrimUse = useCounter;
+	return loadedBytes;
+}
+
+bool ZoneArray::readZone(int index) const
+{
+	ZoneData& z = zones[index];
+	const qint64 size = (qint64)z.size*starSize;
+	uchar* data = Q_NULLPTR;
+	if (lazyMmap)
+	{
+		data = file->map(zoneFileOffset[index], size);
+	}
+	else
+	{
+		data = new uchar[size];
+		if (!file->seek(zoneFileOffset[index]) || !readFile(*file, data, size))
+		{
+			delete[] data;
+			data = Q_NULLPTR;
+		}
+	}
+	if (data == Q_NULLPTR)
+	{
+		qWarning() << "ERROR: ZoneArray(" << level << ")::readZone(" << index << "): "
+			   << QDir::toNativeSeparators(fname) << file->errorString();
+		return false;
+	}
+	z.stars = data;
+	loadedBytes += size;
+	return true;
+}
+
+void ZoneArray::releaseZone(int index) const
+{
+	ZoneData& z = zones[index];
+	if (lazyMmap)
+		file->unmap((uchar*)z.stars);
+	else
+		delete[] (uchar*)z.stars;
+	z.stars = Q_NULLPTR;
+	loadedBytes -= (qint64)z.size*starSize;
+}
+
+void ZoneArray::releaseAllZones()
+{
+	prefetchFuture.waitForFinished();
+	QMutexLocker locker(&pagingMutex);
+	for (unsigned int z=0;z<nr_of_zones;z++)
+	{
+		if (zones[z].stars!=Q_NULLPTR)
+			releaseZone(z);
+	}
+}
+
 bool ZoneArray::readFile(QFile& file, void *data, qint64 size)
 {
 	int parts = 256;
@@ -317,7 +558,7 @@ void SpecialZoneArray<Star>::scaleAxis()
 
 template<class Star>
 SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mmap,
-					 int level, int mag_min, int mag_range, int mag_steps)
+					 int level, int mag_min, int mag_range, int mag_steps, bool lazy_loading)
 		: ZoneArray(file->fileName(), file, level, mag_min, mag_range, mag_steps),
 		  stars(0), mmap_start(0)
 {
@@ -367,6 +608,20 @@ SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mm
 			zones = Q_NULLPTR;
 			nr_of_zones = 0;
 		}
+		else if (lazy_loading)
+		{
+			// Only remember where the stars of each zone are, they are read by loadZone()
+			if (!initLazyLoading(use_mmap, sizeof(Star)))
+			{
+				qDebug() << "ERROR: SpecialZoneArray(" << level
+					 << ")::SpecialZoneArray: file" << file->fileName() << "is truncated";
+				lazyLoading = false;
+				nr_of_stars = 0;
+				delete[] getZones();
+				zones = Q_NULLPTR;
+				nr_of_zones = 0;
+			}
+		}
 		else
 		{
 			if (use_mmap)
@@ -436,7 +691,12 @@ SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mm
 template<class Star>
 SpecialZoneArray<Star>::~SpecialZoneArray(void)
 {
-	if (stars)
+	if (lazyLoading)
+	{
+		releaseAllZones();
+		delete file;
+	}
+	else if (stars)
 	{
 		if (mmap_start != Q_NULLPTR)
 		{
@@ -461,17 +721,9 @@ SpecialZoneArray<Star>::~SpecialZoneArray(void)
 template<class Star>
 void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsideViewport, const RCMag* rcmag_table,
 				  int limitMagIndex, StelCore* core, int maxMagStarName, float names_brightness,
-				  const QVector<SphericalCap> &boundingCaps) const
+				  const QVector<SphericalCap> &boundingCaps, const ZoneDrawCacheState& cacheState) const
 {
 	StelSkyDrawer* drawer = core->getSkyDrawer();
-	Vec3f vf;
-	static const double d2000 = 2451545.0;
-	const float movementFactor = (M_PI/180.)*(0.0001/3600.) * ((core->getJDE()-d2000)/365.25) / star_position_scale;
-
-	// GZ, added for extinction
-	const Extinction& extinction=core->getSkyDrawer()->getExtinction();
-	const bool withExtinction=drawer->getFlagHasAtmosphere() && extinction.getExtinctionCoefficient()>=0.01f;
-	const float k = 0.001f*mag_range/mag_steps; // from StarMgr.cpp line 654
 	
 	// Allow artificial cutoff:
 	// find the (integer) mag at which is just bright enough to be drawn.
@@ -483,64 +735,140 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 			cutoffMagStep = limitMagIndex;
 	}
 	Q_ASSERT(cutoffMagStep<RCMAG_TABLE_SIZE);
-    
-	// Go through all stars, which are sorted by magnitude (bright stars first)
+
 	const SpecialZoneData<Star>* zoneToDraw = getZones() + index;
-	const Star* lastStar = zoneToDraw->getStars() + zoneToDraw->size;
-	for (const Star* s=zoneToDraw->getStars();s<lastStar;++s)
+	ZoneDrawCache& cache = drawCache[index];
+	cache.lastFrame = cacheState.frame;
+
+	// Recompute proper motion, cutoff and extinction only if the date, the location or the limits changed
+	if (cache.starsGeneration!=cacheState.starsGeneration || cache.cutoffMagStep!=cutoffMagStep || cache.maxMagStarName!=maxMagStarName)
 	{
-		// Artifical cutoff per magnitude
-		if (s->getMag() > cutoffMagStep)
-			break;
-    
-		// Because of the test above, the star should always be visible from this point.
-		
-		// Array of 2 numbers containing radius and magnitude
-		const RCMag* tmpRcmag = &rcmag_table[s->getMag()];
-		
-		// Get the star position from the array
-		s->getJ2000Pos(zoneToDraw, movementFactor, vf);
-		
-		// If the star zone is not strictly contained inside the viewport, eliminate from the 
-		// beginning the stars actually outside viewport.
-		if (!isInsideViewport)
+		if (!loadZone(index))
+		{
+			drawCache.remove(index);
+			return;
+		}
+
+		static const double d2000 = 2451545.0;
+		const float movementFactor = (M_PI/180.)*(0.0001/3600.) * ((core->getJDE()-d2000)/365.25) / star_position_scale;
+
+		// GZ, added for extinction
+		const Extinction& extinction=drawer->getExtinction();
+		const bool withExtinction=drawer->getFlagHasAtmosphere() && extinction.getExtinctionCoefficient()>=0.01f;
+		const float k = 0.001f*mag_range/mag_steps; // from StarMgr.cpp line 654
+
+		cache.stars.clear();
+		// Go through all stars, which are sorted by magnitude (bright stars first)
+		const Star* firstStar = zoneToDraw->getStars();
+		const Star* lastStar = firstStar + zoneToDraw->size;
+		for (const Star* s=firstStar;s<lastStar;++s)
 		{
-			vf.normalize();
-			bool isVisible = true;
-			foreach (const SphericalCap& cap, boundingCaps)
+			// Artifical cutoff per magnitude
+			if (s->getMag() > cutoffMagStep)
+				break;
+
+			CachedStar star;
+			// Get the star position from the array
+			s->getJ2000Pos(zoneToDraw, movementFactor, star.pos);
+
+			int extinctedMagIndex = s->getMag();
+			star.twinkleFactor=1.0f; // allow height-dependent twinkle.
+			if (withExtinction)
 			{
-				if (!cap.contains(vf))
-				{
-					isVisible = false;
+				Vec3f altAz(star.pos);
+				altAz.normalize();
+				core->j2000ToAltAzInPlaceNoRefraction(&altAz);
+				float extMagShift=0.0f;
+				extinction.forward(altAz, &extMagShift);
+				extinctedMagIndex = s->getMag() + (int)(extMagShift/k);
+				if (extinctedMagIndex >= cutoffMagStep || extinctedMagIndex<0) // i.e., if extincted it is dimmer than cutoff or extinctedMagIndex is negative (missing star catalog), so remove
 					continue;
-				}
+				star.twinkleFactor=qMin(1.0f, 1.0f-0.9f*altAz[2]); // suppress twinkling in higher altitudes. Keep 0.1 twinkle amount in zenith.
 			}
-			if (!isVisible)
-				continue;
+			star.magIndex = extinctedMagIndex;
+			star.bV = s->getBVIndex();
+			star.mayHaveLabel = s->hasName() && extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1;
+			star.starIndex = s - firstStar;
+			cache.stars.append(star);
 		}
+		cache.starsGeneration = cacheState.starsGeneration;
+		cache.cutoffMagStep = cutoffMagStep;
+		cache.maxMagStarName = maxMagStarName;
+		cache.projectionGeneration = 0;
+	}
 
-		int extinctedMagIndex = s->getMag();
-		float twinkleFactor=1.0f; // allow height-dependent twinkle.
-		if (withExtinction)
+	// Reproject only if the view changed or the zone entered or left the viewport
+	if (cache.projectionGeneration!=cacheState.projectionGeneration || cache.isInsideViewport!=isInsideViewport)
+	{
+		const StelProjectorP prj = sPainter->getProjector();
+		cache.sources.clear();
+		cache.labelled.clear();
+
+		const int nbStars = cache.stars.size();
+		QVarLengthArray<int, 1024> visible(nbStars);
+		int nbVisible = nbStars;
+		if (isInsideViewport)
 		{
-			Vec3f altAz(vf);
-			altAz.normalize();
-			core->j2000ToAltAzInPlaceNoRefraction(&altAz);
-			float extMagShift=0.0f;
-			extinction.forward(altAz, &extMagShift);
-			extinctedMagIndex = s->getMag() + (int)(extMagShift/k);
-			if (extinctedMagIndex >= cutoffMagStep || extinctedMagIndex<0) // i.e., if extincted it is dimmer than cutoff or extinctedMagIndex is negative (missing star catalog), so remove
+			for (int i=0;i<nbStars;++i)
+				visible[i] = i;
+		}
+		else
+		{
+			// If the star zone is not strictly contained inside the viewport, eliminate from the
+			// beginning the stars actually outside viewport, all stars of the zone in one pass.
+			QVarLengthArray<float, 1024> x(nbStars), y(nbStars), z(nbStars);
+			for (int i=0;i<nbStars;++i)
+			{
+				const Vec3f& pos = cache.stars.at(i).pos;
+				x[i] = pos[0];
+				y[i] = pos[1];
+				z[i] = pos[2];
+			}
+			nbVisible = cullOutsideCaps(x.constData(), y.constData(), z.constData(), nbStars, boundingCaps, visible.data());
+		}
+
+		Vec3f win;
+		for (int j=0;j<nbVisible;++j)
+		{
+			const int i = visible[j];
+			const CachedStar& star = cache.stars.at(i);
+
+			// Stars with labels are projected every frame together with their labels
+			if (star.mayHaveLabel)
+			{
+				cache.labelled.append(i);
 				continue;
-			tmpRcmag = &rcmag_table[extinctedMagIndex];
-			twinkleFactor=qMin(1.0f, 1.0f-0.9f*altAz[2]); // suppress twinkling in higher altitudes. Keep 0.1 twinkle amount in zenith.
+			}
+
+			if (!(isInsideViewport ? prj->project(star.pos, win) : prj->projectCheck(star.pos, win)))
+				continue;
+
+			StelSkyDrawer::PointSource source;
+			source.win.set(win[0], win[1]);
+			source.twinkleFactor = star.twinkleFactor;
+			source.magIndex = star.magIndex;
+			source.bV = star.bV;
+			cache.sources.append(source);
 		}
+		cache.projectionGeneration = cacheState.projectionGeneration;
+		cache.isInsideViewport = isInsideViewport;
+	}
+
+	// Luminance, radius and twinkling are not cached, they change with the eye adaptation
+	drawer->drawPointSources(sPainter, cache.sources.constData(), cache.sources.size(), rcmag_table);
 
-		if (drawer->drawPointSource(sPainter, vf, *tmpRcmag, s->getBVIndex(), !isInsideViewport, twinkleFactor) && s->hasName() && extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1)
+	if (!cache.labelled.isEmpty() && !loadZone(index))
+		return;
+	foreach (int i, cache.labelled)
+	{
+		const CachedStar& star = cache.stars.at(i);
+		const RCMag* tmpRcmag = &rcmag_table[star.magIndex];
+		if (drawer->drawPointSource(sPainter, star.pos, *tmpRcmag, star.bV, !isInsideViewport, star.twinkleFactor))
 		{
 			const float offset = tmpRcmag->radius*0.7f;
-			const Vec3f colorr = StelSkyDrawer::indexToColor(s->getBVIndex())*0.75f;
+			const Vec3f colorr = StelSkyDrawer::indexToColor(star.bV)*0.75f;
 			sPainter->setColor(colorr[0], colorr[1], colorr[2],names_brightness);
-			sPainter->drawText(Vec3d(vf[0], vf[1], vf[2]), s->getNameI18n(), 0, offset, offset, false);
+			sPainter->drawText(Vec3d(star.pos[0], star.pos[1], star.pos[2]), zoneToDraw->getStars()[star.starIndex].getNameI18n(), 0, offset, offset, false);
 		}
 	}
 }
@@ -549,6 +877,8 @@ template<class Star>
 void SpecialZoneArray<Star>::searchAround(const StelCore* core, int index, const Vec3d &v, double cosLimFov,
 					  QList<StelObjectP > &result)
 {
+	if (!loadZone(index))
+		return;
 	static const double d2000 = 2451545.0;
 	const double movementFactor = (M_PI/180.)*(0.0001/3600.) * ((core->getJDE()-d2000)/365.25)/ star_position_scale;
 	const SpecialZoneData<Star> *const z = getZones()+index;
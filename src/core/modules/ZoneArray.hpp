@@ -32,6 +32,9 @@
 
 #include <QString>
 #include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QFuture>
 #include <QDebug>
 
 #ifdef __OpenBSD__
@@ -81,8 +84,11 @@ public:
 	//! loading.
 	//! @param extended_file_name path of the star catalog to load from
 	//! @param use_mmap whether or not to mmap the star catalog
+	//! @param lazy_loading_min_level if the catalog level is at least this, the stars of a zone
+	//! are only loaded when the zone is first used, see loadZone(). Negative to load all stars at once.
+	//! Catalogs of Hipparcos stars are always loaded at once.
 	//! @return an instance of SpecialZoneArray or HipZoneArray
-	static ZoneArray *create(const QString &extended_file_name, bool use_mmap);
+	static ZoneArray *create(const QString &extended_file_name, bool use_mmap, int lazy_loading_min_level=-1);
 	virtual ~ZoneArray()
 	{
 		nr_of_zones = 0;
@@ -102,7 +108,28 @@ public:
 	virtual void draw(StelPainter* sPainter, int index,bool is_inside,
 					  const RCMag* rcmag_table, int limitMagIndex, StelCore* core,
 					  int maxMagStarName, float names_brightness,
-					  const QVector<SphericalCap>& boundingCaps) const = 0;
+					  const QVector<SphericalCap>& boundingCaps,
+					  const ZoneDrawCacheState& cacheState) const = 0;
+
+	//! Release the cached star lists of all zones which were not drawn in the given frame,
+	//! i.e. which have left the viewport.
+	void releaseDrawCache(quint64 frame) const;
+
+	//! Whether the stars of the zones are loaded on demand.
+	bool isLazyLoading() const { return lazyLoading; }
+
+	//! Make sure the stars of the zone are in memory and mark the zone as recently used.
+	//! Does nothing if the catalog is not loaded lazily.
+	//! @return @c false if the stars could not be read.
+	bool loadZone(int index) const;
+
+	//! Load the stars of the given zones in a background thread, unless a previous prefetch is still running.
+	void prefetchZones(const QVector<int>& indices) const;
+
+	//! Release the stars of the least recently used zones until at most @em maxBytes are used.
+	//! Must be called from the thread which draws, never while stars of this catalog are being used.
+	//! @return the number of bytes still used by the loaded zones
+	qint64 trimLoadedZones(qint64 maxBytes) const;
 
 	//! Get whether or not the catalog was successfully loaded.
 	//! @return @c true if at least one zone was loaded, otherwise @c false
@@ -141,6 +168,57 @@ protected:
 	unsigned int nr_of_stars;
 	ZoneData *zones;
 	QFile* file;
+
+	//! Prepare demand paging: the stars of the zones follow at the current position of the file.
+	//! @return @c false if the file is too short for the zone sizes
+	bool initLazyLoading(bool use_mmap, int star_size);
+	//! Read or map the stars of a zone. pagingMutex must be locked.
+	bool readZone(int index) const;
+	//! Release the stars of a zone. pagingMutex must be locked.
+	void releaseZone(int index) const;
+	//! Release the stars of all zones, waiting for a running prefetch first.
+	void releaseAllZones();
+
+	// Demand paging of the stars of the zones
+	bool lazyLoading;
+	bool lazyMmap;
+	int starSize;
+	QVector<qint64> zoneFileOffset;
+	mutable QVector<quint64> zoneLastUse;
+	mutable quint64 useCounter;
+	mutable quint64 lastTrimUse;
+	mutable qint64 loadedBytes;
+	mutable QMutex pagingMutex;	// guards the file, the star pointers of the zones and the counters
+	mutable QFuture<void> prefetchFuture;
+
+	//! A star of a zone after proper motion, magnitude cutoff and extinction.
+	struct CachedStar
+	{
+		Vec3f pos;			//!< J2000 position, not normalized
+		float twinkleFactor;
+		unsigned short magIndex;	//!< extincted magnitude index
+		unsigned char bV;
+		bool mayHaveLabel;		//!< drawn individually, with its label
+		int starIndex;			//!< index of the star in its zone
+	};
+
+	//! The stars of a zone as drawn in the last frame. The stars are recomputed when
+	//! ZoneDrawCacheState::starsGeneration changes, the projected positions when
+	//! ZoneDrawCacheState::projectionGeneration changes.
+	struct ZoneDrawCache
+	{
+		ZoneDrawCache() : starsGeneration(0), projectionGeneration(0), lastFrame(0),
+			cutoffMagStep(-1), maxMagStarName(-1), isInsideViewport(false) {}
+		quint64 starsGeneration, projectionGeneration, lastFrame;
+		int cutoffMagStep, maxMagStarName;
+		bool isInsideViewport;
+		QVector<CachedStar> stars;
+		//! Projected stars without label
+		QVector<StelSkyDrawer::PointSource> sources;
+		//! Indices in stars of the visible stars which may have a label
+		QVector<int> labelled;
+	};
+	mutable QHash<int, ZoneDrawCache> drawCache;
 };
 
 //! @class SpecialZoneArray
@@ -160,8 +238,9 @@ public:
 	//! @param mag_min lower bound of magnitudes
 	//! @param mag_range range of magnitudes
 	//! @param mag_steps number of steps used to describe values in range
+	//! @param lazy_loading whether to load the stars of a zone only when it is first used
 	SpecialZoneArray(QFile* file,bool byte_swap,bool use_mmap,int level,int mag_min,
-			 int mag_range,int mag_steps);
+			 int mag_range,int mag_steps,bool lazy_loading=false);
 	~SpecialZoneArray(void);
 protected:
 	//! Get an array of all SpecialZoneData objects in this catalog.
@@ -179,10 +258,13 @@ protected:
 	//! @param core core to use for drawing
 	//! @param maxMagStarName magnitude limit of stars that display labels
 	//! @param names_brightness brightness of labels
+	//! @param boundingCaps the caps bounding the viewport
+	//! @param cacheState tells which parts of the stars cached for the zone in the last frame are still valid
 	virtual void draw(StelPainter* sPainter, int index, bool isInsideViewport,
 			  const RCMag *rcmag_table, int limitMagIndex, StelCore* core,
 			  int maxMagStarName, float names_brightness,
-			  const QVector<SphericalCap>& boundingCaps) const;
+			  const QVector<SphericalCap>& boundingCaps,
+			  const ZoneDrawCacheState& cacheState) const;
 
 	virtual void scaleAxis();
 	virtual void searchAround(const StelCore* core, int index,const Vec3d &v,double cosLimFov,
@@ -21,8 +21,6 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #include "EphemWrapper.hpp"
 #include "StelApp.hpp"
 #include "StelCore.hpp"
-#include "vsop87.h"
-#include "elp82b.h"
 #include "marssat.h"
 #include "l1.h"
 #include "tass17.h"
@@ -31,6 +29,9 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #include "de430.hpp"
 #include "pluto.h"
 
+#include <QMutex>
+#include <QThreadStorage>
+
 #define EPHEM_MERCURY_ID  0
 #define EPHEM_VENUS_ID    1
 #define EPHEM_EMB_ID    2
@@ -94,8 +95,30 @@ bool use_de431(const double jd)
 	return StelApp::getInstance().getCore()->de431IsActive() && EphemWrapper::jd_fits_de431(jd);
 }
 
+// Default cache contexts, one per thread, so that SolarSystem may compute positions in parallel.
+static QThreadStorage<EphemCacheContext*> threadCacheContext;
+
+static EphemCacheContext* get_cache_context(EphemCacheContext* ctx)
+{
+	if (ctx)
+		return ctx;
+	if (!threadCacheContext.hasLocalData())
+		threadCacheContext.setLocalData(new EphemCacheContext());
+	return threadCacheContext.localData();
+}
+
+static void get_vsop87_osculating_coords(const double jd0, const double jd, const int planet_id, double xyz[3], EphemCacheContext* ctx)
+{
+	GetVsop87OsculatingCoorCtx(&get_cache_context(ctx)->vsop87, jd0, jd, planet_id, xyz);
+}
+
+static void get_elp82b_coords(const double jd, double xyz[3], EphemCacheContext* ctx)
+{
+	GetElp82bCoorCtx(&get_cache_context(ctx)->elp82b, jd, xyz);
+}
+
 // planet_id is ONLY one of the #defined values 0..8 above.
-void get_planet_helio_coordsv(const double jd, double xyz[3], const int planet_id)
+void get_planet_helio_coordsv(const double jd, double xyz[3], const int planet_id, EphemCacheContext* ctx)
 {
 	bool deOk=false;
 	if(!std::isfinite(jd))
@@ -114,13 +137,13 @@ void get_planet_helio_coordsv(const double jd, double xyz[3], const int planet_i
 	}
 	if (!deOk) //VSOP87 as fallback
 	{
-		GetVsop87Coor(jd, planet_id, xyz);
+		get_vsop87_osculating_coords(jd, jd, planet_id, xyz, ctx);
 	}
 }
 
 // Osculating positions for time JDE in elements for JDE0, if possible by the theory used (e.g. VSOP87).
 // For ephemerides like DE4xx, JDE0 is irrelevant.
-void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], int planet_id)
+void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], int planet_id, EphemCacheContext* ctx)
 {
 	bool deOk=false;
 	if(!(std::isfinite(jd) && std::isfinite(jd0)))
@@ -139,7 +162,7 @@ void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], i
 	}
 	if (!deOk) //VSOP87 as fallback
 	{
-		GetVsop87OsculatingCoor(jd0, jd, planet_id, xyz);
+		get_vsop87_osculating_coords(jd0, jd, planet_id, xyz, ctx);
 	}
 }
 
@@ -180,20 +203,17 @@ void get_sun_helio_coordsv(double jd,double xyz[3], void* unused)
 	xyz[0]=0.; xyz[1]=0.; xyz[2]=0.;
 }
 
-void get_mercury_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_mercury_helio_coordsv(double jd,double xyz[3], void* ctx)
 {
-	Q_UNUSED(unused);
-  	get_planet_helio_coordsv(jd, xyz, EPHEM_MERCURY_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_MERCURY_ID, static_cast<EphemCacheContext*>(ctx));
 }
-void get_venus_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_venus_helio_coordsv(double jd,double xyz[3], void* ctx)
 {
-	Q_UNUSED(unused);
-  	get_planet_helio_coordsv(jd, xyz, EPHEM_VENUS_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_VENUS_ID, static_cast<EphemCacheContext*>(ctx));
 }
 
-void get_earth_helio_coordsv(const double jd,double xyz[3], void* unused) 
+void get_earth_helio_coordsv(const double jd,double xyz[3], void* ctx)
 {
-	Q_UNUSED(unused);
 	bool deOk=false;
 	if(!std::isfinite(jd))
 	{
@@ -211,9 +231,10 @@ void get_earth_helio_coordsv(const double jd,double xyz[3], void* unused)
 	}
 	if (!deOk) //VSOP87 as fallback
 	{
+		EphemCacheContext* cacheCtx = static_cast<EphemCacheContext*>(ctx);
 		double moon[3];
-		GetVsop87Coor(jd,EPHEM_EMB_ID,xyz);
-		GetElp82bCoor(jd,moon);
+		get_vsop87_osculating_coords(jd, jd, EPHEM_EMB_ID, xyz, cacheCtx);
+		get_elp82b_coords(jd, moon, cacheCtx);
 		/* Earth != EMB:
 	0.0121505677733761 = mu_m/(1+mu_m),
 	mu_m = mass(moon)/mass(earth) = 0.01230002 */
@@ -223,74 +244,109 @@ void get_earth_helio_coordsv(const double jd,double xyz[3], void* unused)
 	}
 }
 
-void get_mars_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_mars_helio_coordsv(double jd,double xyz[3], void* ctx)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_MARS_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_MARS_ID, static_cast<EphemCacheContext*>(ctx));
 }
 
-void get_jupiter_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_jupiter_helio_coordsv(double jd,double xyz[3], void* ctx)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_JUPITER_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_JUPITER_ID, static_cast<EphemCacheContext*>(ctx));
 }
 
-void get_saturn_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_saturn_helio_coordsv(double jd,double xyz[3], void* ctx)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_SATURN_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_SATURN_ID, static_cast<EphemCacheContext*>(ctx));
 }
 
-void get_uranus_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_uranus_helio_coordsv(double jd,double xyz[3], void* ctx)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_URANUS_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_URANUS_ID, static_cast<EphemCacheContext*>(ctx));
 }
 
-void get_neptune_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_neptune_helio_coordsv(double jd,double xyz[3], void* ctx)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_NEPTUNE_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_NEPTUNE_ID, static_cast<EphemCacheContext*>(ctx));
 }
 
 void get_mercury_helio_osculating_coords(double jd0,double jd,double xyz[3])
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MERCURY_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MERCURY_ID, Q_NULLPTR);
+}
+
+void get_mercury_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx)
+{
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MERCURY_ID, ctx);
 }
 
 void get_venus_helio_osculating_coords(double jd0,double jd,double xyz[3])
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_VENUS_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_VENUS_ID, Q_NULLPTR);
+}
+
+void get_venus_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx)
+{
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_VENUS_ID, ctx);
 }
 
 void get_earth_helio_osculating_coords(double jd0,double jd,double xyz[3])
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_EMB_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_EMB_ID, Q_NULLPTR);
+}
+
+void get_earth_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx)
+{
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_EMB_ID, ctx);
 }
 
 void get_mars_helio_osculating_coords(double jd0,double jd,double xyz[3])
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MARS_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MARS_ID, Q_NULLPTR);
+}
+
+void get_mars_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx)
+{
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MARS_ID, ctx);
 }
 
 void get_jupiter_helio_osculating_coords(double jd0,double jd,double xyz[3])
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_JUPITER_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_JUPITER_ID, Q_NULLPTR);
+}
+
+void get_jupiter_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx)
+{
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_JUPITER_ID, ctx);
 }
 
 void get_saturn_helio_osculating_coords(double jd0,double jd,double xyz[3])
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_SATURN_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_SATURN_ID, Q_NULLPTR);
+}
+
+void get_saturn_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx)
+{
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_SATURN_ID, ctx);
 }
 
 void get_uranus_helio_osculating_coords(double jd0,double jd,double xyz[3])
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_URANUS_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_URANUS_ID, Q_NULLPTR);
+}
+
+void get_uranus_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx)
+{
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_URANUS_ID, ctx);
 }
 
 void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3])
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_NEPTUNE_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_NEPTUNE_ID, Q_NULLPTR);
+}
+
+void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx)
+{
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_NEPTUNE_ID, ctx);
 }
 
 /* Calculate the rectangular geocentric lunar coordinates to the inertial mean
@@ -300,129 +356,155 @@ void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3])
  * Michelle Chapront-Touze and Jean Chapront of the Bureau des Longitudes,
  * Paris. ELP 2000-82B theory
  * param jd Julian day, rect pos */
-void get_lunar_parent_coordsv(double jde,double xyz[3], void* unused)
+void get_lunar_parent_coordsv(double jde,double xyz[3], void* ctx)
 {
-	Q_UNUSED(unused);
 	bool deOk=false;
 	if(use_de430(jde))
 		deOk=GetDe430Coor(jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
 	else if(use_de431(jde))
 		deOk=GetDe431Coor(jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
 	if (!deOk) // fallback...
-		GetElp82bCoor(jde,xyz);
+		get_elp82b_coords(jde, xyz, static_cast<EphemCacheContext*>(ctx));
 }
 
+// The theories of the satellites of Mars, Jupiter, Saturn and Uranus keep their last result in static variables.
+// They are usually only called by the group of their planet in SolarSystem::computePositionsParallel(),
+// but an EphemerisContext may evaluate them from another thread at the same time.
+static QMutex marsSatMutex;
+static QMutex l1Mutex;
+static QMutex tass17Mutex;
+static QMutex gust86Mutex;
+
 void get_phobos_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&marsSatMutex);
 	GetMarsSatCoor(jd,MARS_SAT_PHOBOS,xyz);
 }
 
 void get_deimos_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&marsSatMutex);
 	GetMarsSatCoor(jd,MARS_SAT_DEIMOS,xyz);
 }
 
 void get_io_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&l1Mutex);
 	GetL1Coor(jd,L1_IO,xyz);
 }
 
 void get_europa_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&l1Mutex);
 	GetL1Coor(jd,L1_EUROPA,xyz);
 }
 
 void get_ganymede_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&l1Mutex);
 	GetL1Coor(jd,L1_GANYMEDE,xyz);
 }
 
 void get_callisto_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&l1Mutex);
 	GetL1Coor(jd,L1_CALLISTO,xyz);
 }
 
 void get_mimas_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker lock(&tass17Mutex);
 	GetTass17Coor(jd,TASS17_MIMAS,xyz);
 }
 
 void get_enceladus_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&tass17Mutex);
 	GetTass17Coor(jd,TASS17_ENCELADUS,xyz);
 }
 
 void get_tethys_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker lock(&tass17Mutex);
 	GetTass17Coor(jd,TASS17_TETHYS,xyz);
 }
 
 void get_dione_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker lock(&tass17Mutex);
 	GetTass17Coor(jd,TASS17_DIONE,xyz);
 }
 
 void get_rhea_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker lock(&tass17Mutex);
 	GetTass17Coor(jd,TASS17_RHEA,xyz);
 }
 
 void get_titan_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker lock(&tass17Mutex);
 	GetTass17Coor(jd,TASS17_TITAN,xyz);
 }
 
 void get_hyperion_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker lock(&tass17Mutex);
 	GetTass17Coor(jd,TASS17_HYPERION,xyz);
 }
 
 void get_iapetus_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker lock(&tass17Mutex);
 	GetTass17Coor(jd,TASS17_IAPETUS,xyz);
 }
 
 void get_miranda_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&gust86Mutex);
 	GetGust86Coor(jd,GUST86_MIRANDA,xyz);
 }
 
 void get_ariel_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&gust86Mutex);
 	GetGust86Coor(jd,GUST86_ARIEL,xyz);
 }
 
 void get_umbriel_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&gust86Mutex);
 	GetGust86Coor(jd,GUST86_UMBRIEL,xyz);
 }
 
 void get_titania_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&gust86Mutex);
 	GetGust86Coor(jd,GUST86_TITANIA,xyz);
 }
 
 void get_oberon_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker lock(&gust86Mutex);
 	GetGust86Coor(jd,GUST86_OBERON,xyz);
 }
 
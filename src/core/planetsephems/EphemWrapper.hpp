@@ -35,6 +35,26 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #define DE430_FILENAME  "linux_p1550p2650.430"
 #define DE431_FILENAME  "lnxm13000p17000.431"
 
+#include "vsop87.h"
+#include "elp82b.h"
+
+//! Cache context for the analytical theories (VSOP87, ELP82B).
+//! A caller that calculates positions for unrelated dates (e.g. a search over many years)
+//! creates its own EphemCacheContext and hands a pointer to it as the last argument of
+//! the get_*_helio_coordsv() functions below, so that it does not spoil the cache of the live scene.
+//! Without an explicit context, each thread uses its own default context.
+//! Note that the DE430/DE431 readers are shared between all callers and serialized by a mutex.
+struct EphemCacheContext
+{
+	EphemCacheContext()
+	{
+		InitVsop87Context(&vsop87);
+		InitElp82bContext(&elp82b);
+	}
+	Vsop87Context vsop87;
+	Elp82bContext elp82b;
+};
+
 class EphemWrapper{
 public:
     static void init_de430(const char* filepath);
@@ -43,7 +63,9 @@ public:
     static bool jd_fits_de431(const double jd);
 };
 
-// These functions have an unused void pointer to be compatible to PosFuncType in SolarSystem and Planet classes.
+// These functions have a void pointer to be compatible to PosFuncType in SolarSystem and Planet classes.
+// For the planets and the Moon it may point to an EphemCacheContext (Q_NULLPTR: use the static default cache),
+// for all other bodies it is unused.
 void get_sun_helio_coordsv(double jd,double xyz[3], void*);
 void get_mercury_helio_coordsv(double jd,double xyz[3], void*);
 void get_venus_helio_coordsv(double jd,double xyz[3], void*);
@@ -63,6 +85,16 @@ void get_jupiter_helio_osculating_coords(double jd0,double jd,double xyz[3]);
 void get_saturn_helio_osculating_coords(double jd0,double jd,double xyz[3]);
 void get_uranus_helio_osculating_coords(double jd0,double jd,double xyz[3]);
 void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3]);
+
+// Variants of the osculating functions with an explicit cache context, see EphemCacheContext.
+void get_mercury_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx);
+void get_venus_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx);
+void get_earth_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx);
+void get_mars_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx);
+void get_jupiter_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx);
+void get_saturn_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx);
+void get_uranus_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx);
+void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3], EphemCacheContext* ctx);
 void get_pluto_helio_osculating_coords(double jd0,double jd,double xyz[3]);
 
 void get_lunar_parent_coordsv(double jde, double xyz[3], void*);
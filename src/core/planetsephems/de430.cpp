@@ -36,11 +36,8 @@ THE SOFTWARE.
 
 static void * ephem;
 
-static Vec3d tempECL = Vec3d(0,0,0);
-static Vec3d tempICRF = Vec3d(0,0,0);
 static char nams[JPL_MAX_N_CONSTANTS][6];
 static double vals[JPL_MAX_N_CONSTANTS];
-static double tempXYZ[6];
 #ifdef UNIT_TEST
 // NOTE: Added hook for unit testing
 static const Mat4d matJ2000ToVsop87(Mat4d::xrotation(-23.4392803055555555556*(M_PI/180)) * Mat4d::zrotation(0.0000275*(M_PI/180)));
@@ -78,6 +75,8 @@ bool GetDe430Coor(const double jde, const int planet_id, double * xyz, const int
 {
     if(initDone)
     {
+	// The ephemeris object is not modified by the computation, several threads may use it at once.
+	double tempXYZ[6];
 	// This may return some error code!
 	int jplresult=jpl_pleph(ephem, jde, planet_id, centralBody_id, tempXYZ, 0);
 
@@ -111,13 +110,11 @@ bool GetDe430Coor(const double jde, const int planet_id, double * xyz, const int
 			break;
 	}
 
-	jpl_pleph(ephem, jde, planet_id, centralBody_id, tempXYZ, 0);
-
-        tempICRF = Vec3d(tempXYZ[0], tempXYZ[1], tempXYZ[2]);
+        const Vec3d tempICRF = Vec3d(tempXYZ[0], tempXYZ[1], tempXYZ[2]);
 	#ifdef UNIT_TEST
-	tempECL = matJ2000ToVsop87 * tempICRF;
+	const Vec3d tempECL = matJ2000ToVsop87 * tempICRF;
 	#else
-        tempECL = StelCore::matJ2000ToVsop87 * tempICRF;
+        const Vec3d tempECL = StelCore::matJ2000ToVsop87 * tempICRF;
 	#endif
 
         xyz[0] = tempECL[0];
@@ -51,6 +51,19 @@ the original Fortran code:
 extern "C" {
 #endif
 
+struct Elp82bContext {
+  double t_0,t_1,t_2;
+  double r_0[3];
+  double r_1[3];
+  double r_2[3];
+};
+  /* Interpolation cache for the spherical coordinates of the moon.
+     Every thread that calculates positions must own its own context
+     and initialize it with InitElp82bContext() before the first use.
+  */
+
+void InitElp82bContext(struct Elp82bContext *ctx);
+
 void GetElp82bCoor(double jd,double xyz[3]);
 
   /* Return the rectangular coordinates of the earths moon
@@ -79,6 +92,12 @@ void GetElp82bCoor(double jd,double xyz[3]);
      ICRF, J2000 and FK5 are the same, while the transformation
      ICRF <-> VSOP87 must be done with the matrix given above.
    */
+
+void GetElp82bCoorCtx(struct Elp82bContext *ctx,double jd,double xyz[3]);
+  /* Reentrant variant of GetElp82bCoor().
+     GetElp82bCoor() uses one static context
+     and must therefore only be called from the main thread.
+  */
      
 
 #ifdef __cplusplus
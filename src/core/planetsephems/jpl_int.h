@@ -27,6 +27,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
             /* expansion.  There's an assert to catch it if this changes.. */
 #define MAX_CHEBY          18
 
+struct jpl_reader;
+
 #pragma pack(1)
 
 struct interpolation_info
@@ -46,12 +48,14 @@ struct jpl_eph_data {
                /* items computed within my code.                     */
    uint32_t kernel_size, recsize, ncoeff;
    uint32_t swap_bytes;
-   uint32_t curr_cache_loc;
-   double pvsun[9];
-   double pvsun_t;
-   double *cache;
-   struct interpolation_info iinfo;
    FILE *ifile;
+               /* Stellarium: the records are used in place from a memory */
+               /* mapping of the file when its byte order is right,  else */
+               /* they are read through 'reader',  which keeps the recent */
+               /* decoded records.  Nothing here changes after init,  so  */
+               /* several threads may compute positions at once.          */
+   const double *records;
+   struct jpl_reader *reader;
    };
 #pragma pack()
 
@@ -63,6 +63,11 @@ details of the implementation encapsulated.
 #include <stdint.h>
 
 #include "StelUtils.hpp"
+#include <QCache>
+#include <QFile>
+#include <QMutex>
+#include <QVarLengthArray>
+#include <QVector>
 /**** include variable and type definitions, specific for this C version */
 
 #include "jpleph.h"
@@ -79,6 +84,24 @@ details of the implementation encapsulated.
 #define FSeek(__FILE, __OFFSET, _MODE) fseeko(__FILE, __OFFSET, _MODE)
 #endif
 
+/* Stellarium: records which cannot be used in place from the memory mapping
+(because the file could not be mapped,  e.g. DE431 on 32-bit systems,  or
+has the wrong byte order) are read and decoded once,  and kept in a small
+LRU cache shared by all threads. */
+struct jpl_reader
+{
+   QFile file;
+   qint64 size;
+   uchar *map;
+   QMutex mutex;
+   QCache<uint32_t, QVector<double> > records;
+
+   jpl_reader(const char *filename) : file(QFile::decodeName(filename)), size(0), map(NULL), records(64) {}
+};
+
+static int state(const struct jpl_eph_data *eph, const double et, const int list[14],
+                 double pv[][6], double nut[4], const int bary, double pvsun[9]);
+
 
 double DLL_FUNC jpl_get_double(const void *ephem, const int value)
 {
@@ -144,7 +167,8 @@ int DLL_FUNC jpl_pleph(void *ephem, const double et, const int ntarg,
                       const int ncent, double rrd[], const int calc_velocity)
 {
     struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
-    double pv[13][6]={{0.}};/* pv is the position/velocity array
+    double pv[13][6]={{0.}};
+    double pvsun[9];/* pv is the position/velocity array
                              NUMBERED FROM ZERO: 0=Mercury,1=Venus,...
                              8=Pluto,9=Moon,10=Sun,11=SSBary,12=EMBary
                              First 10 elements (0-9) are affected by
@@ -189,7 +213,7 @@ int DLL_FUNC jpl_pleph(void *ephem, const double et, const int ntarg,
 	  //     which accesses it at byte offset 56.
 	  // I see it does explicitly NOT access list[14].
 	  // TODO: check again after next round of travis.
-          rval = jpl_state(ephem, et, list, pv, rrd, 0);
+          rval = state(eph, et, list, pv, rrd, 0, pvsun);
         }
         else          /*  quantity doesn't exist in the ephemeris file  */
           rval = JPL_EPH_QUANTITY_NOT_IN_EPHEMERIS;
@@ -213,11 +237,11 @@ int DLL_FUNC jpl_pleph(void *ephem, const double et, const int ntarg,
     }
 
   /*   make call to state   */
-   rval = jpl_state(eph, et, list, pv, rrd, 1);
+   rval = state(eph, et, list, pv, rrd, 1, pvsun);
    /* Solar System barycentric Sun state goes to pv[10][] */
    if(ntarg == 11 || ncent == 11)
       for(i = 0; i < 6; i++)
-         pv[10][i] = eph->pvsun[i];
+         pv[10][i] = pvsun[i];
 
    /* Solar System Barycenter coordinates & velocities equal to zero */
    if(ntarg == 12 || ncent == 12)
@@ -580,14 +604,86 @@ static int dimension(const int idx)
 int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
                           double pv[][6], double nut[4], const int bary)
 {
-	struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
+	double pvsun[9];
+	return(state((const struct jpl_eph_data *)ephem, et, list, pv, nut, bary, pvsun));
+}
+
+typedef QVarLengthArray<double, 1024> jpl_record_buffer;
+
+/* Get the coefficients of record nr,  either in place in the memory mapping
+or copied to 'buffer' from the record cache of the reader.  */
+static const double *get_record(const struct jpl_eph_data *eph, const uint32_t nr,
+                                jpl_record_buffer &buffer, int *error)
+{
+	/* Two blocks ahead to account for header: */
+	const qint64 offset = ((qint64)nr + 2) * eph->recsize;
+
+	if(eph->records)
+	{
+		if(offset + eph->recsize > eph->reader->size)
+		{
+			*error = JPL_EPH_READ_ERROR;
+			return(NULL);
+		}
+		return(eph->records + (size_t)nr * eph->ncoeff);
+	}
+
+	QMutexLocker locker(&eph->reader->mutex);
+	const QVector<double> *record = eph->reader->records.object(nr);
+	if(!record)
+	{
+		QVector<double> *decoded = new QVector<double>(eph->ncoeff);
+		if(eph->reader->map)
+		{
+			if(offset + eph->recsize > eph->reader->size)
+			{
+				delete decoded;
+				*error = JPL_EPH_READ_ERROR;
+				return(NULL);
+			}
+			memcpy(decoded->data(), eph->reader->map + offset, eph->ncoeff * sizeof(double));
+		}
+		else
+		{
+			if(FSeek(eph->ifile, offset, SEEK_SET))
+			{
+				delete decoded;
+				*error = JPL_EPH_FSEEK_ERROR;
+				return(NULL);
+			}
+			if(fread(decoded->data(), sizeof(double), (size_t)eph->ncoeff, eph->ifile)
+					!= (size_t)eph->ncoeff)
+			{
+				delete decoded;
+				*error = JPL_EPH_READ_ERROR;
+				return(NULL);
+			}
+		}
+		if(eph->swap_bytes)
+			swap_64_bit_val(decoded->data(), eph->ncoeff);
+		eph->reader->records.insert(nr, decoded);
+		record = decoded;
+	}
+	/* The record may be dropped from the cache by another thread once unlocked */
+	buffer.resize(eph->ncoeff);
+	memcpy(buffer.data(), record->constData(), eph->ncoeff * sizeof(double));
+	return(buffer.constData());
+}
+
+/* jpl_state() with the barycentric state of the Sun in pvsun.  All the
+state of the computation is local,  so that it may run in several threads. */
+static int state(const struct jpl_eph_data *eph, const double et, const int list[14],
+                 double pv[][6], double nut[4], const int bary, double pvsun[9])
+{
 	unsigned i, j, n_intervals;
 	uint32_t nr;
-	double *buf = eph->cache;
+	jpl_record_buffer record_buffer;
+	const double *buf;
 	double t[2];
 	const double block_loc = (et - eph->ephem_start) / eph->ephem_step;
-	bool recompute_pvsun;
 	const double aufac = 1.0 / eph->au;
+	struct interpolation_info iinfo;
+	int error = 0;
 
 	/*   error return for epoch out of range  */
 	if(et < eph->ephem_start || et > eph->ephem_end)
@@ -603,33 +699,18 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
 		nr--;
 	}
 
-	/*   read correct record if not in core (static vector buf[])   */
-	if(nr != eph->curr_cache_loc)
-	{
-		eph->curr_cache_loc = nr;
-		/* Read two blocks ahead to account for header: */
-		if(FSeek(eph->ifile, (nr + 2) * eph->recsize, SEEK_SET))
-		{
-			// GZ: Make sure we will try again on next call...
-			eph->curr_cache_loc=0;
-			return(JPL_EPH_FSEEK_ERROR);
-		}
-		if(fread(buf, sizeof(double), (size_t)eph->ncoeff, eph->ifile)
-				!= (size_t)eph->ncoeff)
-			return(JPL_EPH_READ_ERROR);
-
-		if(eph->swap_bytes)
-			swap_64_bit_val(buf, eph->ncoeff);
-	}
+	buf = get_record(eph, nr, record_buffer, &error);
+	if(!buf)
+		return(error);
 	t[1] = eph->ephem_step;
 
-	if(eph->pvsun_t != et)   /* If several calls are made for the same et, */
-	{                      /* don't recompute pvsun each time... only on */
-		recompute_pvsun = true;   /* the first run through.                     */
-		eph->pvsun_t = et;
-	}
-	else
-		recompute_pvsun = false;
+	iinfo.posn_coeff[0] = 1.0;
+	/* Seed a bogus value here.  The first call to 'interp' will correct */
+	/* it to a value between -1 and +1.                                   */
+	iinfo.posn_coeff[1] = -2.0;
+	iinfo.vel_coeff[0] = 0.0;
+	iinfo.vel_coeff[1] = 1.0;
+	iinfo.n_posn_avail = iinfo.n_vel_avail = 0;
 
 	/* Here, i loops through the "traditional" 14 listed items -- 10
 	  solar system objects,  nutations,  librations,  lunar mantle angles,
@@ -642,11 +723,11 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
 		for(i = 0; i < 15; i++)
 		{
 			unsigned quantities;
-			uint32_t *iptr = &eph->ipt[i + 1][0];
+			const uint32_t *iptr;
 
 			if(i == 14)
 			{
-				quantities = (recompute_pvsun ? 3 : 0);
+				quantities = 3;
 				iptr = &eph->ipt[10][0];
 			}
 			else
@@ -656,15 +737,15 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
 			}
 			if(n_intervals == iptr[2] && quantities)
 			{
-				double *dest = ((i == 10) ? eph->pvsun : pv[i]);
+				double *dest;
 
 				if(i < 10)
 					dest = pv[i];
 				else if(i == 14)
-					dest = eph->pvsun;
+					dest = pvsun;
 				else
 					dest = nut;
-				interp(&eph->iinfo, &buf[iptr[0]-1], t, (int)iptr[1],
+				interp(&iinfo, &buf[iptr[0]-1], t, (int)iptr[1],
 						dimension(i + 1),
 						n_intervals, quantities, dest);
 
@@ -676,7 +757,7 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
 	if(!bary)                             /* gotta correct everybody for */
 		for(i = 0; i < 9; i++)            /* the solar system barycenter */
 			for(j = 0; j < (unsigned)list[i] * 3; j++)
-				pv[i][j] -= eph->pvsun[j];
+				pv[i][j] -= pvsun[j];
 	return(0);
 }
 
@@ -879,12 +960,7 @@ void * DLL_FUNC jpl_init_ephemeris(const char *ephemeris_filename,
     temp_data.recsize = temp_data.kernel_size * 4L;
     temp_data.ncoeff = temp_data.kernel_size / 2L;
 
-               /* Rather than do two separate allocations,  everything     */
-               /* we need is allocated in _one_ chunk,  then parceled out. */
-               /* This looks a little weird,  but it simplifies error      */
-               /* handling and cleanup.                                    */
-    rval = (struct jpl_eph_data *)calloc(sizeof(struct jpl_eph_data)
-                        + temp_data.recsize, 1);
+    rval = (struct jpl_eph_data *)calloc(sizeof(struct jpl_eph_data), 1);
     if(!rval)
     {
       init_err_code = JPL_INIT_MEMORY_FAILURE;
@@ -892,16 +968,22 @@ void * DLL_FUNC jpl_init_ephemeris(const char *ephemeris_filename,
       return(NULL);
     }
     memcpy(rval, &temp_data, sizeof(struct jpl_eph_data));
-    rval->iinfo.posn_coeff[0] = 1.0;
-            /* Seed a bogus value here.  The first and subsequent calls to */
-            /* 'interp' will correct it to a value between -1 and +1.      */
-    rval->iinfo.posn_coeff[1] = -2.0;
-    rval->iinfo.vel_coeff[0] = 0.0;
-    rval->iinfo.vel_coeff[1] = 1.0;
-    rval->curr_cache_loc = (uint32_t)-1;
-    
-              /* The 'cache' data is right after the 'jpl_eph_data' struct: */
-    rval->cache = (double *)(rval + 1);
+    rval->records = NULL;
+
+              /* Map the whole file:  the records are then read by the    */
+              /* virtual memory system,  without seeking and locking.     */
+              /* The records of a file which cannot be mapped are read    */
+              /* with fread() when they are not in the cache of 'reader'. */
+    rval->reader = new jpl_reader(ephemeris_filename);
+    if(rval->reader->file.open(QIODevice::ReadOnly))
+    {
+      rval->reader->size = rval->reader->file.size();
+      rval->reader->map = rval->reader->file.map(0, rval->reader->size);
+    }
+    if(rval->reader->map && !rval->swap_bytes)
+      rval->records = (const double *)(rval->reader->map + 2 * (qint64)rval->recsize);
+    else
+      qDebug() << "jpl_init_ephemeris(): cannot map" << ephemeris_filename << "in place, records will be read and cached.";
                /* If there are more than 400 constants,  the names of       */
                /* the extra constants are stored in what would normally     */
                /* be zero-padding after the header record.  However,        */
@@ -958,6 +1040,7 @@ void DLL_FUNC jpl_close_ephemeris(void *ephem)
 {
    struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
 
+   delete eph->reader;     /* also unmaps the file */
    fclose(eph->ifile);
    free(ephem);
 }
@@ -973,6 +1056,7 @@ double DLL_FUNC jpl_get_constant(const int idx, void *ephem, char *constant_name
 	*constant_name = '\0';
 	if(idx >= 0 && idx < (int)eph->ncon)
 	{
+		QMutexLocker locker(&eph->reader->mutex);   /* ifile is shared with get_record() */
 		// GZ extended from const long to const long long
 		const long long seek_loc = (idx < 400 ? 84L * 3L + (long)idx * 6 :
 							START_400TH_CONSTANT_NAME + (idx - 400) * 6);
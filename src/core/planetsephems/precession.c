@@ -39,9 +39,17 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 /* Interval threshold (days) for re-computing nutation values. with 1/24, compute only every hour  */
 #define NUTATION_EPOCH_THRESHOLD (1./24.)
 
+/* The caches below are kept per thread, so that positions for other dates can be computed
+ * in worker threads (e.g. with EphemerisContext) without mixing up the angles of the main thread. */
+#if defined(_MSC_VER)
+#define PRECESSION_THREAD_LOCAL __declspec(thread)
+#else
+#define PRECESSION_THREAD_LOCAL __thread
+#endif
+
 /* cache results for retrieval if recomputation is not required */
 
-static double c_psi_A=0.0, c_omega_A=0.0, c_chi_A=0.0, /*c_p_A=0.0, */ c_epsilon_A=0.0,
+static PRECESSION_THREAD_LOCAL double c_psi_A=0.0, c_omega_A=0.0, c_chi_A=0.0, /*c_p_A=0.0, */ c_epsilon_A=0.0,
 		c_Y_A=0.0, c_X_A=0.0, c_Q_A=0.0, c_P_A=0.0,
 		c_lastJDE=-1e100;
 
@@ -369,9 +377,9 @@ static const struct nut2000B nut2000Btable[78] = {
 { -1,  0,  4,  0,  2,     9.06,       1146,       0,     -490,     0,     -3,    -1}};
 
 /* cache results for retrieval if recomputation is not required */
-static double c_deltaEps=0.0;
-static double c_deltaPsi=0.0;
-static double c_jdeLastNut=-1e-100;
+static PRECESSION_THREAD_LOCAL double c_deltaEps=0.0;
+static PRECESSION_THREAD_LOCAL double c_deltaPsi=0.0;
+static PRECESSION_THREAD_LOCAL double c_jdeLastNut=-1e-100;
 
 
 //! Compute and return nutation angles of the abridged IAU-2000B nutation.
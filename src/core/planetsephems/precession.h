@@ -52,6 +52,7 @@ void getPrecessionAnglesVondrakPQXYe(const double jde, double *vP_A, double *vQ_
 double getPrecessionAngleVondrakEpsilon(const double jde);
 
 //! Just return (previously computed) ecliptic obliquity. [radians]
+//! The angles are cached per thread, so this is the value last computed by the calling thread.
 double getPrecessionAngleVondrakCurrentEpsilonA(void);
 
 // To complete the task of correct&accurate precession-nutation handling, we need fitting IAU-2000A or IAU-2000B Nutation.
@@ -51,6 +51,24 @@ so that for given T the functions cos and sin have only to be called 12 times.
 extern "C" {
 #endif
 
+#define VSOP87_DIM (8*6)
+
+struct Vsop87Context {
+  double t_0,t_1,t_2;
+  double elem_0[VSOP87_DIM];
+  double elem_1[VSOP87_DIM];
+  double elem_2[VSOP87_DIM];
+  double jd0;
+  double elem[VSOP87_DIM];
+};
+  /* Interpolation cache for the VSOP87 elements.
+     Every thread that calculates positions must own its own context
+     and initialize it with InitVsop87Context() before the first use.
+     The members belong to the functions below, never change them.
+  */
+
+void InitVsop87Context(struct Vsop87Context *ctx);
+
 void GetVsop87Coor(double jd,int body,double *xyz);
   /* Return the rectangular coordinates of the given planet
      and the given julian date jd expressed in dynamical time (TAI+32.184s).
@@ -63,6 +81,16 @@ void GetVsop87OsculatingCoor(const double jd0,const double jd, const int body,do
   /* The oculating orbit of epoch jd0, evaluated at jd, is returned.
   */
 
+void GetVsop87CoorCtx(struct Vsop87Context *ctx,
+                      double jd,int body,double *xyz);
+void GetVsop87OsculatingCoorCtx(struct Vsop87Context *ctx,
+                                const double jd0,const double jd,
+                                const int body,double *xyz);
+  /* Reentrant variants of the functions above.
+     GetVsop87Coor() and GetVsop87OsculatingCoor() use one static context
+     and must therefore only be called from the main thread.
+  */
+
 #ifdef __cplusplus
 }
 #endif
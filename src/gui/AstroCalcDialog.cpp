@@ -40,8 +40,12 @@
 #include "ui_astroCalcDialog.h"
 #include "external/qcustomplot/qcustomplot.h"
 
+#include "StelProgressController.hpp"
+#include "StelMinimumFinder.hpp"
+
 #include <QFileDialog>
 #include <QDir>
+#include <QtConcurrent>
 
 QVector<Vec3d> AstroCalcDialog::EphemerisListCoords;
 QVector<QString> AstroCalcDialog::EphemerisListDates;
@@ -61,6 +65,9 @@ QString AstroCalcDialog::yAxis2Legend = "";
 AstroCalcDialog::AstroCalcDialog(QObject *parent)
 	: StelDialog("AstroCalc",parent)
 	, currentTimeLine(Q_NULLPTR)
+	, jobTimer(Q_NULLPTR)
+	, jobProgressBar(Q_NULLPTR)
+	, jobButton(Q_NULLPTR)
 	, delimiter(", ")
 	, acEndl("\n")
 {
@@ -79,6 +86,11 @@ AstroCalcDialog::AstroCalcDialog(QObject *parent)
 
 AstroCalcDialog::~AstroCalcDialog()
 {
+	// The widgets may already be gone, so only stop the worker
+	jobCancelled.store(1);
+	jobFuture.waitForFinished();
+	if (jobProgressBar)
+		StelApp::getInstance().removeProgressBar(jobProgressBar);
 	if (currentTimeLine)
 	{
 		currentTimeLine->stop();
@@ -237,6 +249,8 @@ void AstroCalcDialog::createDialogContent()
 	connect(currentTimeLine, SIGNAL(timeout()), this, SLOT(drawCurrentTimeDiagram()));
 	currentTimeLine->start(500); // Update 'now' line position every 0.5 seconds
 
+	// The job has to be stopped before the old bodies are deleted, not after
+	connect(solarSystem, SIGNAL(solarSystemDataAboutToReload()), this, SLOT(stopJobBeforeReload()), Qt::DirectConnection);
 	connect(solarSystem, SIGNAL(solarSystemDataReloaded()), this, SLOT(updateSolarSystemData()));
 	connect(core, SIGNAL(locationChanged(StelLocation)), this, SLOT(updateAstroCalcData()));
 	connect(ui->stackListWidget, SIGNAL(currentItemChanged(QListWidgetItem *, QListWidgetItem *)), this, SLOT(changePage(QListWidgetItem *, QListWidgetItem*)));
@@ -821,6 +835,7 @@ void AstroCalcDialog::initListEphemeris()
 
 void AstroCalcDialog::reGenerateEphemeris()
 {
+	cancelJob();
 	if (EphemerisListCoords.size()>0)
 		generateEphemeris(); // Update list of ephemeris
 	else
@@ -829,17 +844,17 @@ void AstroCalcDialog::reGenerateEphemeris()
 
 void AstroCalcDialog::generateEphemeris()
 {
-	float currentStep, ra, dec;
-	Vec3d observerHelioPos;
-	QString currentPlanet = ui->celestialBodyComboBox->currentData().toString();
-	QString distanceInfo = q_("Planetocentric distance");
-	if (core->getUseTopocentricCoordinates())
-		distanceInfo = q_("Topocentric distance");
-	QString distanceUM = qc_("AU", "distance, astronomical unit");
+	// The button stops the computation while it runs
+	if (jobButton==ui->ephemerisPushButton)
+	{
+		cancelJob();
+		return;
+	}
+	cancelJob();
 
-	QString elongStr = "", phaseStr = "";
+	float currentStep;
+	QString currentPlanet = ui->celestialBodyComboBox->currentData().toString();
 	bool horizon = ui->ephemerisHorizontalCoordinatesCheckBox->isChecked();
-	bool useSouthAzimuth = StelApp::getInstance().getFlagSouthAzimuthUsage();
 
 	initListEphemeris();
 
@@ -885,7 +900,7 @@ void AstroCalcDialog::generateEphemeris()
 	PlanetP obj = solarSystem->searchByEnglishName(currentPlanet);
 	if (obj)
 	{
-		double currentJD = core->getJD(); // save current JD
+		ephemeris = EphemerisContext(core);
 		double firstJD = StelUtils::qDateTimeToJd(ui->dateFromDateTimeEdit->dateTime());
 		firstJD = firstJD - core->getUTCOffset(firstJD)/24;
 		int elements = (int)((StelUtils::qDateTimeToJd(ui->dateToDateTimeEdit->dateTime()) - firstJD)/currentStep);
@@ -896,91 +911,95 @@ void AstroCalcDialog::generateEphemeris()
 		EphemerisListMagnitudes.clear();
 		EphemerisListMagnitudes.reserve(elements);
 		bool withTime = false;
-		QString dash = QChar(0x2014); // dash
 		if (currentStep<StelCore::JD_DAY)
 			withTime = true;
+		bool isSun = (obj==solarSystem->getSun());
 
-		if (obj==solarSystem->getSun())
-		{
-			phaseStr = dash;
-			elongStr = dash;
-		}
-
-		Vec3d pos;
-		QString raStr = "", decStr = "";
-
-		for (int i=0; i<elements; i++)
-		{
-			double JD = firstJD + i*currentStep;
-			core->setJD(JD);
-			core->update(0); // force update to get new coordinates			
-
-			if (horizon)
+		startJob(ui->ephemerisPushButton, QString("%1: %p%").arg(obj->getNameI18n()), elements, [=]() {
+			for (int i=0; i<elements && !jobCancelled.load(); i++)
 			{
-				pos = obj->getAltAzPosAuto(core);
-				StelUtils::rectToSphe(&ra, &dec, pos);
-				float direction = 3.; // N is zero, E is 90 degrees
-				if (useSouthAzimuth)
-					direction = 2.;
-				ra = direction*M_PI - ra;
-				if (ra > M_PI*2)
-					ra -= M_PI*2;
-				raStr = StelUtils::radToDmsStr(ra, true);
-				decStr = StelUtils::radToDmsStr(dec, true);
+				double JD = firstJD + i*currentStep;
+				const EphemerisContext::BodyState state = ephemeris.computeState(obj.data(), JD);
+				postJobResult([=]() { fillEphemerisTable(state, horizon, withTime, isSun); });
+				jobProgress.ref();
 			}
-			else
+		}, [this]() {
+			// adjust the column width
+			for(int i = 0; i < EphemerisCount; ++i)
 			{
-				pos = obj->getJ2000EquatorialPos(core);
-				StelUtils::rectToSphe(&ra, &dec, pos);
-				raStr = StelUtils::radToHmsStr(ra);
-				decStr = StelUtils::radToDmsStr(dec, true);
+			    ui->ephemerisTreeWidget->resizeColumnToContents(i);
 			}
 
-			EphemerisListCoords.append(pos);
-			if (withTime)
-				EphemerisListDates.append(QString("%1 %2").arg(localeMgr->getPrintableDateLocal(JD), localeMgr->getPrintableTimeLocal(JD)));
-			else
-				EphemerisListDates.append(localeMgr->getPrintableDateLocal(JD));
-			EphemerisListMagnitudes.append(obj->getVMagnitudeWithExtinction(core));
-			StelUtils::rectToSphe(&ra,&dec,pos);
-
-			observerHelioPos = core->getObserverHeliocentricEclipticPos();
-
-			if (phaseStr!=dash)
-				phaseStr = QString("%1%").arg(QString::number(obj->getPhase(observerHelioPos) * 100, 'f', 2));
-
-			if (elongStr!=dash)
-				elongStr = StelUtils::radToDmsStr(obj->getElongation(observerHelioPos), true);
-
-			ACEphemTreeWidgetItem *treeItem = new ACEphemTreeWidgetItem(ui->ephemerisTreeWidget);
-			// local date and time
-			treeItem->setText(EphemerisDate, QString("%1 %2").arg(localeMgr->getPrintableDateLocal(JD), localeMgr->getPrintableTimeLocal(JD)));
-			treeItem->setText(EphemerisJD, QString::number(JD, 'f', 5));
-			treeItem->setText(EphemerisRA, raStr);
-			treeItem->setTextAlignment(EphemerisRA, Qt::AlignRight);
-			treeItem->setText(EphemerisDec, decStr);
-			treeItem->setTextAlignment(EphemerisDec, Qt::AlignRight);
-			treeItem->setText(EphemerisMagnitude, QString::number(obj->getVMagnitudeWithExtinction(core), 'f', 2));
-			treeItem->setTextAlignment(EphemerisMagnitude, Qt::AlignRight);
-			treeItem->setText(EphemerisPhase, phaseStr);
-			treeItem->setTextAlignment(EphemerisPhase, Qt::AlignRight);
-			treeItem->setText(EphemerisDistance, QString::number(obj->getJ2000EquatorialPos(core).length(), 'f', 6));
-			treeItem->setTextAlignment(EphemerisDistance, Qt::AlignRight);
-			treeItem->setToolTip(EphemerisDistance, QString("%1, %2").arg(distanceInfo, distanceUM));
-			treeItem->setText(EphemerisElongation, elongStr);
-			treeItem->setTextAlignment(EphemerisElongation, Qt::AlignRight);
-		}
-		core->setJD(currentJD); // restore time
+			// sort-by-date
+			ui->ephemerisTreeWidget->sortItems(EphemerisDate, Qt::AscendingOrder);
+		});
 	}
+}
 
-	// adjust the column width
-	for(int i = 0; i < EphemerisCount; ++i)
+void AstroCalcDialog::fillEphemerisTable(const EphemerisContext::BodyState& state, bool horizon, bool withTime, bool isSun)
+{
+	float ra, dec;
+	QString distanceInfo = q_("Planetocentric distance");
+	if (core->getUseTopocentricCoordinates())
+		distanceInfo = q_("Topocentric distance");
+	QString distanceUM = qc_("AU", "distance, astronomical unit");
+	QString dash = QChar(0x2014); // dash
+	QString elongStr = dash, phaseStr = dash;
+	QString raStr = "", decStr = "";
+	Vec3d pos;
+	double JD = state.JD;
+
+	if (horizon)
 	{
-	    ui->ephemerisTreeWidget->resizeColumnToContents(i);
+		pos = state.altAzPosAuto;
+		StelUtils::rectToSphe(&ra, &dec, pos);
+		float direction = 3.; // N is zero, E is 90 degrees
+		if (StelApp::getInstance().getFlagSouthAzimuthUsage())
+			direction = 2.;
+		ra = direction*M_PI - ra;
+		if (ra > M_PI*2)
+			ra -= M_PI*2;
+		raStr = StelUtils::radToDmsStr(ra, true);
+		decStr = StelUtils::radToDmsStr(dec, true);
+	}
+	else
+	{
+		pos = state.j2000Pos;
+		StelUtils::rectToSphe(&ra, &dec, pos);
+		raStr = StelUtils::radToHmsStr(ra);
+		decStr = StelUtils::radToDmsStr(dec, true);
 	}
 
-	// sort-by-date
-	ui->ephemerisTreeWidget->sortItems(EphemerisDate, Qt::AscendingOrder);
+	EphemerisListCoords.append(pos);
+	if (withTime)
+		EphemerisListDates.append(QString("%1 %2").arg(localeMgr->getPrintableDateLocal(JD), localeMgr->getPrintableTimeLocal(JD)));
+	else
+		EphemerisListDates.append(localeMgr->getPrintableDateLocal(JD));
+	EphemerisListMagnitudes.append(state.vMagnitudeWithExtinction);
+
+	if (!isSun)
+	{
+		phaseStr = QString("%1%").arg(QString::number(state.phase * 100, 'f', 2));
+		elongStr = StelUtils::radToDmsStr(state.elongation, true);
+	}
+
+	ACEphemTreeWidgetItem *treeItem = new ACEphemTreeWidgetItem(ui->ephemerisTreeWidget);
+	// local date and time
+	treeItem->setText(EphemerisDate, QString("%1 %2").arg(localeMgr->getPrintableDateLocal(JD), localeMgr->getPrintableTimeLocal(JD)));
+	treeItem->setText(EphemerisJD, QString::number(JD, 'f', 5));
+	treeItem->setText(EphemerisRA, raStr);
+	treeItem->setTextAlignment(EphemerisRA, Qt::AlignRight);
+	treeItem->setText(EphemerisDec, decStr);
+	treeItem->setTextAlignment(EphemerisDec, Qt::AlignRight);
+	treeItem->setText(EphemerisMagnitude, QString::number(state.vMagnitudeWithExtinction, 'f', 2));
+	treeItem->setTextAlignment(EphemerisMagnitude, Qt::AlignRight);
+	treeItem->setText(EphemerisPhase, phaseStr);
+	treeItem->setTextAlignment(EphemerisPhase, Qt::AlignRight);
+	treeItem->setText(EphemerisDistance, QString::number(state.distance, 'f', 6));
+	treeItem->setTextAlignment(EphemerisDistance, Qt::AlignRight);
+	treeItem->setToolTip(EphemerisDistance, QString("%1, %2").arg(distanceInfo, distanceUM));
+	treeItem->setText(EphemerisElongation, elongStr);
+	treeItem->setTextAlignment(EphemerisElongation, Qt::AlignRight);
 }
 
 void AstroCalcDialog::saveEphemeris()
@@ -1020,6 +1039,7 @@ void AstroCalcDialog::saveEphemeris()
 
 void AstroCalcDialog::cleanupEphemeris()
 {
+	cancelJob();
 	EphemerisListCoords.clear();
 	ui->ephemerisTreeWidget->clear();
 }
@@ -1228,6 +1248,7 @@ void AstroCalcDialog::savePhenomenaCelestialGroup(int index)
 
 void AstroCalcDialog::cleanupPhenomena()
 {
+	cancelJob();
 	ui->phenomenaTreeWidget->clear();
 }
 
@@ -1272,6 +1293,9 @@ void AstroCalcDialog::drawAltVsTimeDiagram()
 			step = 720;
 			isSatellite = true;
 		}
+		const EphemerisContext context(core);
+		const Planet* planet = dynamic_cast<const Planet*>(selectedObject.data());
+		const Vec3d fixedJ2000Pos = selectedObject->getJ2000EquatorialPos(core);
 		for(int i=-5;i<=limit;i++) // 24 hours + 15 minutes in both directions
 		{
 			// A new point on the graph every 3 minutes with shift to right 12 hours
@@ -1279,8 +1303,17 @@ void AstroCalcDialog::drawAltVsTimeDiagram()
 			double ltime = i*step + 43200;
 			aX.append(ltime);
 			double JD = noon + ltime/86400 - shift - 0.5;
-			core->setJD(JD);
-			StelUtils::rectToSphe(&az, &alt, selectedObject->getAltAzPosAuto(core));
+			Vec3d altAzPos;
+			if (isSatellite)
+			{
+				core->setJD(JD);
+				altAzPos = selectedObject->getAltAzPosAuto(core);
+			}
+			else if (planet)
+				altAzPos = context.computeState(planet, JD).altAzPosAuto;
+			else
+				altAzPos = context.j2000ToAltAz(fixedJ2000Pos, JD, true);
+			StelUtils::rectToSphe(&az, &alt, altAzPos);
 			StelUtils::radToDecDeg(alt, sign, deg);
 			if (!sign)
 				deg *= -1;
@@ -1297,10 +1330,9 @@ void AstroCalcDialog::drawAltVsTimeDiagram()
 				GETSTELMODULE(Satellites)->update(0.0); // force update to avoid caching! WTF???
 				#endif
 			}
-			else
-				core->update(0.0);
 		}
-		core->setJD(currentJD);
+		if (isSatellite)
+			core->setJD(currentJD);
 
 		QVector<double> x = aX.toVector(), y = aY.toVector();
 		double minYa = aY.first();
@@ -1429,6 +1461,7 @@ void AstroCalcDialog::drawXVsTimeGraphs()
 
 		float width = 1.0f;
 		int dYear = (int)core->getCurrentPlanet()->getSiderealPeriod() + 3;
+		const EphemerisContext context(core);
 
 		for(int i=-2;i<=dYear;i++)
 		{
@@ -1436,67 +1469,64 @@ void AstroCalcDialog::drawXVsTimeGraphs()
 			ltime = (JD - startJD) * StelCore::ONE_OVER_JD_SECOND;
 			aX.append(ltime);
 
-			core->setJD(JD);
+			const EphemerisContext::BodyState state = context.computeState(ssObj.data(), JD);
 
 			switch (ui->graphsFirstComboBox->currentData().toInt())
 			{
 				case GraphMagnitudeVsTime:
-					aY.append(ssObj->getVMagnitude(core));
+					aY.append(state.vMagnitude);
 					break;
 				case GraphPhaseVsTime:
-					aY.append(ssObj->getPhase(core->getObserverHeliocentricEclipticPos()) * 100.f);
+					aY.append(state.phase * 100.f);
 					break;
 				case GraphDistanceVsTime:
-					distance = ssObj->getJ2000EquatorialPos(core).length();
+					distance = state.distance;
 					if (distance < 0.1)
 						distance *= AU/1000.f;
 					aY.append(distance);
 					break;
 				case GraphElongationVsTime:
-					aY.append(ssObj->getElongation(core->getObserverHeliocentricEclipticPos())*180./M_PI);
+					aY.append(state.elongation*180./M_PI);
 					break;
 				case GraphAngularSizeVsTime:
-					angularSize = ssObj->getAngularSize(core)*360./M_PI;
+					angularSize = ssObj->getAngularSizeAtDistance(state.distance)*360./M_PI;
 					if (angularSize<1.)
 						angularSize *= 60.;
 					aY.append(angularSize);
 					break;
 				case GraphPhaseAngleVsTime:
-					aY.append(ssObj->getPhaseAngle(core->getObserverHeliocentricEclipticPos())*180./M_PI);
+					aY.append(state.phaseAngle*180./M_PI);
 					break;
 			}
 
 			switch (ui->graphsSecondComboBox->currentData().toInt())
 			{
 				case GraphMagnitudeVsTime:
-					bY.append(ssObj->getVMagnitude(core));
+					bY.append(state.vMagnitude);
 					break;
 				case GraphPhaseVsTime:
-					bY.append(ssObj->getPhase(core->getObserverHeliocentricEclipticPos()) * 100.f);
+					bY.append(state.phase * 100.f);
 					break;
 				case GraphDistanceVsTime:
-					distance = ssObj->getJ2000EquatorialPos(core).length();
+					distance = state.distance;
 					if (distance < 0.1)
 						distance *= AU/1000.f;
 					bY.append(distance);
 					break;
 				case GraphElongationVsTime:
-					bY.append(ssObj->getElongation(core->getObserverHeliocentricEclipticPos())*180./M_PI);
+					bY.append(state.elongation*180./M_PI);
 					break;
 				case GraphAngularSizeVsTime:
-					angularSize = ssObj->getAngularSize(core)*360./M_PI;
+					angularSize = ssObj->getAngularSizeAtDistance(state.distance)*360./M_PI;
 					if (angularSize<1.)
 						angularSize *= 60.;
 					bY.append(angularSize);
 					break;
 				case GraphPhaseAngleVsTime:
-					bY.append(ssObj->getPhaseAngle(core->getObserverHeliocentricEclipticPos())*180./M_PI);
+					bY.append(state.phaseAngle*180./M_PI);
 					break;
 			}
-
-			core->update(0.0);
 		}
-		core->setJD(currentJD);
 
 		QVector<double> x = aX.toVector(), ya = aY.toVector(), yb = bY.toVector();
 
@@ -1846,6 +1876,14 @@ void AstroCalcDialog::selectCurrentPhenomen(const QModelIndex &modelIndex)
 
 void AstroCalcDialog::calculatePhenomena()
 {
+	// The button stops the computation while it runs
+	if (jobButton==ui->phenomenaPushButton)
+	{
+		cancelJob();
+		return;
+	}
+	cancelJob();
+
 	QString currentPlanet = ui->object1ComboBox->currentData().toString();
 	double separation = ui->allowedSeparationDoubleSpinBox->value();
 	bool opposition = ui->phenomenaOppositionCheckBox->isChecked();
@@ -2016,8 +2054,8 @@ void AstroCalcDialog::calculatePhenomena()
 	PlanetP planet = solarSystem->searchByEnglishName(currentPlanet);
 	if (planet)
 	{
-		double currentJD = core->getJD(); // save current JD
-		double currentJDE = core->getJDE(); // save current JDE
+		ephemeris = EphemerisContext(core);
+		double currentJDE = core->getJDE();
 		double startJD = StelUtils::qDateTimeToJd(QDateTime(ui->phenomenFromDateEdit->date()));
 		double stopJD = StelUtils::qDateTimeToJd(QDateTime(ui->phenomenToDateEdit->date().addDays(1)));
 		startJD = startJD - core->getUTCOffset(startJD)/24;
@@ -2028,60 +2066,93 @@ void AstroCalcDialog::calculatePhenomena()
 		coordsLimit += separation*M_PI/180;
 		double ra, dec;
 
-		if (obj2Type<10)
+		// The stars are searched at their current positions, neglecting their proper motions.
+		// The positions are taken here, as the objects must not be used in the worker thread.
+		QList<QPair<StelObjectP, Vec3d> > nearStars;
+		QList<QPair<NebulaP, Vec3d> > nearDSO;
+		if (obj2Type==10 || obj2Type==11 || obj2Type==12)
 		{
-			// Solar system objects
-			foreach (PlanetP obj, objects)
-			{
-				// conjunction
-				fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation, false), planet, obj, false);
-				// opposition
-				if (opposition)
-					fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation, true), planet, obj, true);
-			}
-		}
-		else if (obj2Type==10 || obj2Type==11 || obj2Type==12)
-		{
-			// Stars
 			foreach (StelObjectP obj, star)
 			{
 				StelUtils::rectToSphe(&ra, &dec, obj->getEquinoxEquatorialPos(core));
 				// Add limits on coordinates for speed-up calculations
 				if (dec<=coordsLimit && dec>=-coordsLimit)
-				{
-					// conjunction
-					fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation), planet, obj);
-				}
+					nearStars.append(qMakePair(obj, obj->getJ2000EquatorialPos(core)));
 			}
 		}
-		else
+		else if (obj2Type>=10)
 		{
-			// Deep-sky objects
 			foreach (NebulaP obj, dso)
 			{
 				StelUtils::rectToSphe(&ra, &dec, obj->getEquinoxEquatorialPos(core));
 				// Add limits on coordinates for speed-up calculations
 				if (dec<=coordsLimit && dec>=-coordsLimit)
+					nearDSO.append(qMakePair(obj, obj->getJ2000EquatorialPos(core)));
+			}
+		}
+
+		int total = objects.size();
+		if (obj2Type==10 || obj2Type==11 || obj2Type==12)
+			total = nearStars.size();
+		else if (obj2Type>=10)
+			total = nearDSO.size();
+
+		// The search runs on a worker thread, the results are added to the table as they are found
+		startJob(ui->phenomenaPushButton, QString("%1: %p%").arg(planet->getNameI18n()), total, [=]() mutable {
+			if (obj2Type<10)
+			{
+				// Solar system objects
+				foreach (PlanetP obj, objects)
 				{
+					if (jobCancelled.load())
+						break;
 					// conjunction
-					fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation), planet, obj);
+					const QMap<double, double> conjunctions = findClosestApproach(planet, obj, startJD, stopJD, separation, false);
+					postJobResult([=]() { fillPhenomenaTable(conjunctions, planet, obj, false); });
+					// opposition
+					if (opposition)
+					{
+						const QMap<double, double> oppositions = findClosestApproach(planet, obj, startJD, stopJD, separation, true);
+						postJobResult([=]() { fillPhenomenaTable(oppositions, planet, obj, true); });
+					}
+					jobProgress.ref();
 				}
 			}
-		}
-
+			else if (obj2Type==10 || obj2Type==11 || obj2Type==12)
+			{
+				// Stars
+				for (int i=0; i<nearStars.size() && !jobCancelled.load(); ++i)
+				{
+					const StelObjectP obj = nearStars.at(i).first;
+					// conjunction
+					const QMap<double, double> conjunctions = findClosestApproach(planet, nearStars.at(i).second, startJD, stopJD, separation);
+					postJobResult([=]() { fillPhenomenaTable(conjunctions, planet, obj); });
+					jobProgress.ref();
+				}
+			}
+			else
+			{
+				// Deep-sky objects
+				for (int i=0; i<nearDSO.size() && !jobCancelled.load(); ++i)
+				{
+					const NebulaP obj = nearDSO.at(i).first;
+					// conjunction
+					const QMap<double, double> conjunctions = findClosestApproach(planet, nearDSO.at(i).second, startJD, stopJD, separation);
+					postJobResult([=]() { fillPhenomenaTable(conjunctions, planet, obj); });
+					jobProgress.ref();
+				}
+			}
+		}, [this]() {
+			// adjust the column width
+			for(int i = 0; i < PhenomenaCount; ++i)
+			{
+			    ui->phenomenaTreeWidget->resizeColumnToContents(i);
+			}
 
-		core->setJD(currentJD); // restore time
-		core->update(0);
+			// sort-by-date
+			ui->phenomenaTreeWidget->sortItems(PhenomenaDate, Qt::AscendingOrder);
+		});
 	}
-
-	// adjust the column width
-	for(int i = 0; i < PhenomenaCount; ++i)
-	{
-	    ui->phenomenaTreeWidget->resizeColumnToContents(i);
-	}
-
-	// sort-by-date
-	ui->phenomenaTreeWidget->sortItems(PhenomenaDate, Qt::AscendingOrder);
 }
 
 void AstroCalcDialog::savePhenomena()
@@ -2124,14 +2195,14 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	QMap<double, double>::ConstIterator it;
 	for (it=list.constBegin(); it!=list.constEnd(); ++it)
 	{
-		core->setJD(it.key());
-		core->update(0);
+		const double d1 = ephemeris.getJ2000EquatorialPos(object1.data(), it.key()).length();
+		const double d2 = ephemeris.getJ2000EquatorialPos(object2.data(), it.key()).length();
 
 		QString phenomenType = q_("Conjunction");
 		double separation = it.value();
 		bool occultation = false;
-		double s1 = object1->getSpheroidAngularSize(core);
-		double s2 = object2->getSpheroidAngularSize(core);
+		double s1 = object1->getSpheroidAngularSizeAtDistance(d1);
+		double s2 = object2->getSpheroidAngularSizeAtDistance(d2);
 		if (opposition)
 		{
 			phenomenType = q_("Opposition");
@@ -2139,8 +2210,6 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 		}
 		else if (separation<(s2*M_PI/180.) || separation<(s1*M_PI/180.))
 		{
-			double d1 = object1->getJ2000EquatorialPos(core).length();
-			double d2 = object2->getJ2000EquatorialPos(core).length();
 			if ((d1<d2 && s1<=s2) || (d1>d2 && s1>s2))
 				phenomenType = q_("Transit");
 			else
@@ -2166,128 +2235,42 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	}
 }
 
-QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, PlanetP &object2, double startJD, double stopJD, double maxSeparation, bool opposition)
+double AstroCalcDialog::findSamplingStep(const Planet* object1, const Planet* object2) const
 {
-	double dist, prevDist, step, step0;
-	int sgn, prevSgn = 0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	step0 = (stopJD - startJD)/12.0;
-	if (step0>24.8*365.25)
-		step0 = 24.8*365.25;
-
-	if (object1->getEnglishName()=="Neptune" || object2->getEnglishName()=="Neptune" || object1->getEnglishName()=="Uranus" || object2->getEnglishName()=="Uranus")
-		if (step0 > 3652.5)
-			step0 = 3652.5;
-	if (object1->getEnglishName()=="Jupiter" || object2->getEnglishName()=="Jupiter" || object1->getEnglishName()=="Saturn" || object2->getEnglishName()=="Saturn")
-		if (step0 > 365.25)
-			step0 = 365.f;
-	if (object1->getEnglishName()=="Mars" || object2->getEnglishName()=="Mars")
-		if (step0 > 10.f)
-			step0 = 10.f;
-	if (object1->getEnglishName()=="Venus" || object2->getEnglishName()=="Venus" || object1->getEnglishName()=="Mercury" || object2->getEnglishName()=="Mercury")
-		if (step0 > 5.f)
-			step0 = 5.f;
-	if (object1->getEnglishName()=="Moon" || object2->getEnglishName()=="Moon")
-		if (step0 > 0.25)
-			step0 = 0.25;
-
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2, opposition);
-	jd += step;
-	while(jd <= stopJD)
+	// The apparent motions seen by the observer do not change faster than the orbits of the observer's planet,
+	// of the bodies and of their parents, so the minima of the separation of the bodies are at least a fair
+	// fraction of the shortest of these periods apart.
+	double period = 0.;
+	const Planet* bodies[3] = {ephemeris.getHomePlanet(), object1, object2};
+	for (int i=0; i<3; ++i)
 	{
-		dist = findDistance(jd, object1, object2, opposition);
-		sgn = StelUtils::sign(dist - prevDist);
-
-		double factor = qAbs((dist - prevDist)/dist);
-		if (factor>10.f)
-			step = step0 * factor/10.f;
-		else
-			step = step0;
-
-		if (sgn != prevSgn && prevSgn == -1)
+		for (const Planet* body=bodies[i]; body && body->getParent(); body=body->getParent().data())
 		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				sgn = prevSgn;
-				while(jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2, opposition);
-					sgn = StelUtils::sign(dist - prevDist);
-					if (sgn!=prevSgn)
-						break;
-
-					prevDist = dist;
-					prevSgn = sgn;
-					jd += step;
-				}
-			}
-
-			if (findPrecise(&extremum, object1, object2, jd, step, sgn, opposition))
-			{
-				double sep = extremum.second*180./M_PI;
-				if (sep<maxSeparation)
-					separations.insert(extremum.first, extremum.second);
-			}
-
+			const double bodyPeriod = body->getSiderealPeriod();
+			if (bodyPeriod>0. && (period<=0. || bodyPeriod<period))
+				period = bodyPeriod;
 		}
-
-		prevDist = dist;
-		prevSgn = sgn;
-		jd += step;
 	}
-
-	return separations;
+	if (period<=0.)
+		period = 365.25;
+	return period/16.;
 }
 
-bool AstroCalcDialog::findPrecise(QPair<double, double> *out, PlanetP object1, PlanetP object2, double JD, double step, int prevSign, bool opposition)
+QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, PlanetP &object2, double startJD, double stopJD, double maxSeparation, bool opposition)
 {
-	int sgn;
-	double dist, prevDist;
-
-	if (out==Q_NULLPTR)
-		return false;
-
-	prevDist = findDistance(JD, object1, object2, opposition);
-	step = -step/2.f;
-	prevSign = -prevSign;
-
-	while(true)
-	{
-		JD += step;
-		dist = findDistance(JD, object1, object2, opposition);
-
-		if (qAbs(step)< 1.f/1440.f)
-		{
-			out->first = JD - step/2.0;
-			out->second = findDistance(JD - step/2.0, object1, object2, opposition);
-			if (out->second < findDistance(JD - 5.0, object1, object2, opposition))
-				return true;
-			else
-				return false;
-		}
-		sgn = StelUtils::sign(dist - prevDist);
-		if (sgn!=prevSign)
-		{
-			step = -step/2.0;
-			sgn = -sgn;
-		}
-		prevDist = dist;
-		prevSign = sgn;
-	}
+	QMap<double, double> separations;
+	const QList<StelMinimumFinder::Minimum> minima = StelMinimumFinder::findMinima(
+		[&](double JD) { return findDistance(JD, object1, object2, opposition); },
+		startJD, stopJD, findSamplingStep(object1.data(), object2.data()), maxSeparation*M_PI/180., StelCore::JD_SECOND, &jobCancelled);
+	foreach (const StelMinimumFinder::Minimum& minimum, minima)
+		separations.insert(minimum.x, minimum.value);
+	return separations;
 }
 
 double AstroCalcDialog::findDistance(double JD, PlanetP object1, PlanetP object2, bool opposition)
 {
-	core->setJD(JD);
-	core->update(0);
-	Vec3d obj1 = object1->getJ2000EquatorialPos(core);
-	Vec3d obj2 = object2->getJ2000EquatorialPos(core);
+	Vec3d obj1 = ephemeris.getJ2000EquatorialPos(object1.data(), JD);
+	Vec3d obj2 = ephemeris.getJ2000EquatorialPos(object2.data(), JD);
 	double angle = obj1.angle(obj2);
 	if (opposition)
 		angle = M_PI - angle;
@@ -2299,13 +2282,12 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	QMap<double, double>::ConstIterator it;
 	for (it=list.constBegin(); it!=list.constEnd(); ++it)
 	{
-		core->setJD(it.key());
-		core->update(0);
+		const double d1 = ephemeris.getJ2000EquatorialPos(object1.data(), it.key()).length();
 
 		QString phenomenType = q_("Conjunction");
 		double separation = it.value();
 		bool occultation = false;
-		if (separation<(object2->getAngularSize(core)*M_PI/180.) || separation<(object1->getSpheroidAngularSize(core)*M_PI/180.))
+		if (separation<(object2->getAngularSize(core)*M_PI/180.) || separation<(object1->getSpheroidAngularSizeAtDistance(d1)*M_PI/180.))
 		{
 			phenomenType = q_("Occultation");
 			occultation = true;
@@ -2327,143 +2309,17 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	}
 }
 
-QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, NebulaP &object2, double startJD, double stopJD, double maxSeparation)
-{
-	double dist, prevDist, step, step0;
-	int sgn, prevSgn = 0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	step0 = (stopJD - startJD)/8.0;
-	if (step0>24.8*365.25)
-		step0 = 24.8*365.25;
-
-	if (object1->getEnglishName()=="Neptune" || object1->getEnglishName()=="Uranus")
-		if (step0 > 3652.5)
-			step0 = 3652.5;
-	if (object1->getEnglishName()=="Jupiter" || object1->getEnglishName()=="Saturn")
-		if (step0 > 365.25)
-			step0 = 365.f;
-	if (object1->getEnglishName()=="Mars")
-		if (step0 > 10.f)
-			step0 = 10.f;
-	if (object1->getEnglishName()=="Venus" || object1->getEnglishName()=="Mercury")
-		if (step0 > 5.f)
-			step0 = 5.f;
-	if (object1->getEnglishName()=="Moon")
-		if (step0 > 0.25)
-			step0 = 0.25;
-
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2);
-	jd += step;
-	while(jd <= stopJD)
-	{
-		dist = findDistance(jd, object1, object2);
-		sgn = StelUtils::sign(dist - prevDist);
-
-		double factor = qAbs((dist - prevDist)/dist);
-		if (factor>10.f)
-			step = step0 * factor/10.f;
-		else
-			step = step0;
-
-		if (sgn != prevSgn && prevSgn == -1)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				sgn = prevSgn;
-				while(jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2);
-					sgn = StelUtils::sign(dist - prevDist);
-					if (sgn!=prevSgn)
-						break;
-
-					prevDist = dist;
-					prevSgn = sgn;
-					jd += step;
-				}
-			}
-
-			if (findPrecise(&extremum, object1, object2, jd, step, sgn))
-			{
-				double sep = extremum.second*180./M_PI;
-				if (sep<maxSeparation)
-					separations.insert(extremum.first, extremum.second);
-			}
-
-		}
-
-		prevDist = dist;
-		prevSgn = sgn;
-		jd += step;
-	}
-
-	return separations;
-}
-
-bool AstroCalcDialog::findPrecise(QPair<double, double> *out, PlanetP object1, NebulaP object2, double JD, double step, int prevSign)
-{
-	int sgn;
-	double dist, prevDist;
-
-	if (out==Q_NULLPTR)
-		return false;
-
-	prevDist = findDistance(JD, object1, object2);
-	step = -step/2.f;
-	prevSign = -prevSign;
-
-	while(true)
-	{
-		JD += step;
-		dist = findDistance(JD, object1, object2);
-
-		if (qAbs(step)< 1.f/1440.f)
-		{
-			out->first = JD - step/2.0;
-			out->second = findDistance(JD - step/2.0, object1, object2);
-			if (out->second < findDistance(JD - 5.0, object1, object2))
-				return true;
-			else
-				return false;
-		}
-		sgn = StelUtils::sign(dist - prevDist);
-		if (sgn!=prevSign)
-		{
-			step = -step/2.0;
-			sgn = -sgn;
-		}
-		prevDist = dist;
-		prevSign = sgn;
-	}
-}
-
-double AstroCalcDialog::findDistance(double JD, PlanetP object1, NebulaP object2)
-{
-	core->setJD(JD);
-	core->update(0);
-	Vec3d obj1 = object1->getJ2000EquatorialPos(core);
-	Vec3d obj2 = object2->getJ2000EquatorialPos(core);
-	return obj1.angle(obj2);
-}
-
 void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const StelObjectP object2)
 {
 	QMap<double, double>::ConstIterator it;
 	for (it=list.constBegin(); it!=list.constEnd(); ++it)
 	{
-		core->setJD(it.key());
-		core->update(0);
+		const double d1 = ephemeris.getJ2000EquatorialPos(object1.data(), it.key()).length();
 
 		QString phenomenType = q_("Conjunction");
 		double separation = it.value();
 		bool occultation = false;
-		if (separation<(object2->getAngularSize(core)*M_PI/180.) || separation<(object1->getSpheroidAngularSize(core)*M_PI/180.))
+		if (separation<(object2->getAngularSize(core)*M_PI/180.) || separation<(object1->getSpheroidAngularSizeAtDistance(d1)*M_PI/180.))
 		{
 			phenomenType = q_("Occultation");
 			occultation = true;
@@ -2482,129 +2338,21 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	}
 }
 
-QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, StelObjectP &object2, double startJD, double stopJD, double maxSeparation)
+QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, const Vec3d& object2Pos, double startJD, double stopJD, double maxSeparation)
 {
-	double dist, prevDist, step, step0;
-	int sgn, prevSgn = 0;
 	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	step0 = (stopJD - startJD)/8.0;
-	if (step0>24.8*365.25)
-		step0 = 24.8*365.25;
-
-	if (object1->getEnglishName()=="Neptune" || object1->getEnglishName()=="Uranus")
-		if (step0 > 1811.25)
-			step0 = 1811.25;
-	if (object1->getEnglishName()=="Jupiter" || object1->getEnglishName()=="Saturn")
-		if (step0 > 181.125)
-			step0 = 181.125;
-	if (object1->getEnglishName()=="Mars")
-		if (step0 > 5.f)
-			step0 = 5.0;
-	if (object1->getEnglishName()=="Venus" || object1->getEnglishName()=="Mercury")
-		if (step0 > 2.5f)
-			step0 = 2.5;
-	if (object1->getEnglishName()=="Moon")
-		if (step0 > 0.25)
-			step0 = 0.25;
-
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2);
-	jd += step;
-	while(jd <= stopJD)
-	{
-		dist = findDistance(jd, object1, object2);
-		sgn = StelUtils::sign(dist - prevDist);
-
-		double factor = qAbs((dist - prevDist)/dist);
-		if (factor>10.f)
-			step = step0 * factor/10.f;
-		else
-			step = step0;
-
-		if (sgn != prevSgn && prevSgn == -1)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				sgn = prevSgn;
-				while(jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2);
-					sgn = StelUtils::sign(dist - prevDist);
-					if (sgn!=prevSgn)
-						break;
-
-					prevDist = dist;
-					prevSgn = sgn;
-					jd += step;
-				}
-			}
-
-			if (findPrecise(&extremum, object1, object2, jd, step, sgn))
-			{
-				double sep = extremum.second*180./M_PI;
-				if (sep<maxSeparation)
-					separations.insert(extremum.first, extremum.second);
-			}
-
-		}
-
-		prevDist = dist;
-		prevSgn = sgn;
-		jd += step;
-	}
-
+	const QList<StelMinimumFinder::Minimum> minima = StelMinimumFinder::findMinima(
+		[&](double JD) { return findDistance(JD, object1, object2Pos); },
+		startJD, stopJD, findSamplingStep(object1.data(), Q_NULLPTR), maxSeparation*M_PI/180., StelCore::JD_SECOND, &jobCancelled);
+	foreach (const StelMinimumFinder::Minimum& minimum, minima)
+		separations.insert(minimum.x, minimum.value);
 	return separations;
 }
 
-bool AstroCalcDialog::findPrecise(QPair<double, double> *out, PlanetP object1, StelObjectP object2, double JD, double step, int prevSign)
-{
-	int sgn;
-	double dist, prevDist;
-
-	if (out==Q_NULLPTR)
-		return false;
-
-	prevDist = findDistance(JD, object1, object2);
-	step = -step/2.f;
-	prevSign = -prevSign;
-
-	while(true)
-	{
-		JD += step;
-		dist = findDistance(JD, object1, object2);
-
-		if (qAbs(step)< 1.f/1440.f)
-		{
-			out->first = JD - step/2.0;
-			out->second = findDistance(JD - step/2.0, object1, object2);
-			if (out->second < findDistance(JD - 5.0, object1, object2))
-				return true;
-			else
-				return false;
-		}
-		sgn = StelUtils::sign(dist - prevDist);
-		if (sgn!=prevSign)
-		{
-			step = -step/2.0;
-			sgn = -sgn;
-		}
-		prevDist = dist;
-		prevSign = sgn;
-	}
-}
-
-double AstroCalcDialog::findDistance(double JD, PlanetP object1, StelObjectP object2)
+double AstroCalcDialog::findDistance(double JD, PlanetP object1, const Vec3d& object2Pos)
 {
-	core->setJD(JD);
-	core->update(0);
-	Vec3d obj1 = object1->getJ2000EquatorialPos(core);
-	Vec3d obj2 = object2->getJ2000EquatorialPos(core);
-	return obj1.angle(obj2);
+	Vec3d obj1 = ephemeris.getJ2000EquatorialPos(object1.data(), JD);
+	return obj1.angle(object2Pos);
 }
 
 void AstroCalcDialog::changePage(QListWidgetItem *current, QListWidgetItem *previous)
@@ -2652,6 +2400,12 @@ void AstroCalcDialog::updateTabBarListWidgetWidth()
 	ui->stackListWidget->setMinimumWidth(width);
 }
 
+void AstroCalcDialog::stopJobBeforeReload()
+{
+	// Waits for the worker, which still uses the orbits of the old bodies
+	cancelJob();
+}
+
 void AstroCalcDialog::updateSolarSystemData()
 {
 	if (dialog)
@@ -2663,6 +2417,77 @@ void AstroCalcDialog::updateSolarSystemData()
 	}
 }
 
+void AstroCalcDialog::startJob(QPushButton* button, const QString& progressFormat, int total, const std::function<void()>& work, const std::function<void()>& finished)
+{
+	Q_ASSERT(jobFuture.isFinished());
+
+	jobButton = button;
+	jobButtonText = button->text();
+	button->setText(q_("Stop"));
+	jobFinished = finished;
+	jobCancelled.store(0);
+	jobProgress.store(0);
+
+	jobProgressBar = StelApp::getInstance().addProgressBar();
+	jobProgressBar->setFormat(progressFormat);
+	jobProgressBar->setRange(0, qMax(total, 1));
+	jobProgressBar->setValue(0);
+
+	if (!jobTimer)
+	{
+		jobTimer = new QTimer(this);
+		connect(jobTimer, SIGNAL(timeout()), this, SLOT(processJobResults()));
+	}
+	jobTimer->start(100);
+
+	jobFuture = QtConcurrent::run(work);
+}
+
+void AstroCalcDialog::postJobResult(const std::function<void()>& result)
+{
+	QMutexLocker locker(&jobMutex);
+	jobResults.append(result);
+}
+
+void AstroCalcDialog::processJobResults()
+{
+	// Check before taking the results, so that none posted at the end is missed
+	const bool done = jobFuture.isFinished();
+
+	QList<std::function<void()> > results;
+	jobMutex.lock();
+	results.swap(jobResults);
+	jobMutex.unlock();
+	foreach (const std::function<void()>& result, results)
+		result();
+
+	if (!jobProgressBar)
+		return;
+	jobProgressBar->setValue(jobProgress.load());
+	if (!done)
+		return;
+
+	jobTimer->stop();
+	StelApp::getInstance().removeProgressBar(jobProgressBar);
+	jobProgressBar = Q_NULLPTR;
+	jobButton->setText(jobButtonText);
+	jobButton = Q_NULLPTR;
+	std::function<void()> finished;
+	finished.swap(jobFinished);
+	if (finished)
+		finished();
+}
+
+void AstroCalcDialog::cancelJob()
+{
+	if (!jobButton)
+		return;
+	jobCancelled.store(1);
+	jobFuture.waitForFinished();
+	// Keep the results found so far
+	processJobResults();
+}
+
 void AstroCalcDialog::populateTimeIntervalsList()
 {
 	Q_ASSERT(ui->wutComboBox);
@@ -27,11 +27,17 @@
 #include <QMap>
 #include <QVector>
 #include <QTimer>
+#include <QFuture>
+#include <QAtomicInt>
+#include <QMutex>
+
+#include <functional>
 
 #include "StelDialog.hpp"
 #include "StelCore.hpp"
 #include "Planet.hpp"
 #include "SolarSystem.hpp"
+#include "EphemerisContext.hpp"
 #include "Nebula.hpp"
 #include "NebulaMgr.hpp"
 #include "StarMgr.hpp"
@@ -39,6 +45,8 @@
 
 class Ui_astroCalcDialogForm;
 class QListWidgetItem;
+class QPushButton;
+class StelProgressController;
 
 class AstroCalcDialog : public StelDialog
 {
@@ -168,8 +176,12 @@ private slots:
 
 	void changePage(QListWidgetItem *current, QListWidgetItem *previous);
 
+	void stopJobBeforeReload();
 	void updateSolarSystemData();
 
+	//! Add the results posted by the background job to the tables, and finish the job when it is done.
+	void processJobResults();
+
 private:
 	class StelCore* core;
 	class SolarSystem* solarSystem;
@@ -181,6 +193,31 @@ private:
 	QTimer *currentTimeLine;
 	QHash<QString,QString> wutObjects;
 	QHash<QString,int> wutCategories;
+	//! Observer and settings for the background job, taken from the core when the job starts
+	EphemerisContext ephemeris;
+
+	//! The background job computing ephemerides or phenomena. Only one job runs at a time.
+	//! The worker posts functions which add its results to the tables, processJobResults() runs them on the GUI thread.
+	QFuture<void> jobFuture;
+	QAtomicInt jobCancelled;
+	//! Number of steps done by the worker, shown by jobProgressBar
+	QAtomicInt jobProgress;
+	QMutex jobMutex;
+	QList<std::function<void()> > jobResults;
+	std::function<void()> jobFinished;
+	QTimer* jobTimer;
+	StelProgressController* jobProgressBar;
+	//! The button which started the job, and stops it while it runs
+	QPushButton* jobButton;
+	QString jobButtonText;
+
+	//! Run work on a worker thread, with a progress bar of total steps.
+	//! finished is called on the GUI thread once all results have been processed, even if the job was cancelled.
+	void startJob(QPushButton* button, const QString& progressFormat, int total, const std::function<void()>& work, const std::function<void()>& finished);
+	//! Called by the worker to queue a result for the GUI thread.
+	void postJobResult(const std::function<void()>& result);
+	//! Stop the running job, if any, and wait for the worker. The results found so far are kept.
+	void cancelJob();
 
 	//! Update header names for celestial positions tables
 	void setCelestialPositionsHeaderNames();
@@ -196,6 +233,9 @@ private:
 	//! Init header and list of phenomena
 	void initListPhenomena();
 
+	//! Add a row to the ephemeris table and to the lists of ephemeris markers
+	void fillEphemerisTable(const EphemerisContext::BodyState& state, bool horizon, bool withTime, bool isSun);
+
 	//! Populates the drop-down list of celestial bodies.
 	//! The displayed names are localized in the current interface language.
 	//! The original names are kept in the user data field of each QComboBox
@@ -218,23 +258,20 @@ private:
 	void populateFunctionsList();
 
 	//! Calculation conjunctions and oppositions.
-	//! @note Ported from KStars, should be improved, because this feature calculate
-	//! angular separation ("conjunction" defined as equality of right ascension
-	//! of two body) and current solution is not accurate and slow.
+	//! The minima of the angular separation (of its supplement for oppositions) below maxSeparation are searched
+	//! with StelMinimumFinder, which samples the separation with the step given by findSamplingStep() and refines the minima.
+	//! The find* functions run on the worker thread of the background job, the fillPhenomenaTable() ones on the GUI thread.
 	QMap<double, double> findClosestApproach(PlanetP& object1, PlanetP& object2, double startJD, double stopJD, double maxSeparation, bool opposition);
 	double findDistance(double JD, PlanetP object1, PlanetP object2, bool opposition);
-	bool findPrecise(QPair<double, double>* out, PlanetP object1, PlanetP object2, double JD, double step, int prevSign, bool opposition);
 	void fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const PlanetP object2, bool opposition);
-
-	QMap<double, double> findClosestApproach(PlanetP& object1, NebulaP& object2, double startJD, double stopJD, double maxSeparation);
-	double findDistance(double JD, PlanetP object1, NebulaP object2);
-	bool findPrecise(QPair<double, double>* out, PlanetP object1, NebulaP object2, double JD, double step, int prevSign);
 	void fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const NebulaP object2);
 
-	QMap<double, double> findClosestApproach(PlanetP& object1, StelObjectP& object2, double startJD, double stopJD, double maxSeparation);
-	double findDistance(double JD, PlanetP object1, StelObjectP object2);
-	bool findPrecise(QPair<double, double>* out, PlanetP object1, StelObjectP object2, double JD, double step, int prevSign);
+	//! For stars and deep-sky objects, which are given by their equatorial J2000 position. The proper motion of stars is neglected.
+	QMap<double, double> findClosestApproach(PlanetP& object1, const Vec3d& object2Pos, double startJD, double stopJD, double maxSeparation);
+	double findDistance(double JD, PlanetP object1, const Vec3d& object2Pos);
 	void fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const StelObjectP object2);
+	//! Sampling step (days) for the search of the closest approaches of object1 and object2 (if any), seen from the observer's planet
+	double findSamplingStep(const Planet* object1, const Planet* object2) const;
 
 	QString delimiter, acEndl;
 	QStringList ephemerisHeader, phenomenaHeader, positionsHeader;
@@ -0,0 +1,154 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testChebyshevEphemeris.hpp"
+#include "ChebyshevEphemeris.hpp"
+
+#include <QAtomicInt>
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestChebyshevEphemeris)
+
+namespace
+{
+	const double period = 87.969;
+	QAtomicInt theoryCalls;
+
+	// An eccentric orbit with a small perturbation, like the orbit of Mercury
+	void theory(double JDE, double xyz[3], void*)
+	{
+		theoryCalls.ref();
+		const double M = 2.*M_PI*(JDE-2451545.)/period;
+		const double E = M+0.2*std::sin(M)+0.02*std::sin(2.*M);
+		xyz[0] = 0.387*(std::cos(E)-0.2056)+1e-4*std::sin(2.*M_PI*JDE/4332.6);
+		xyz[1] = 0.379*std::sin(E);
+		xyz[2] = 0.04*std::sin(E+0.5);
+	}
+
+	// A theory which cannot be fitted
+	void steps(double JDE, double xyz[3], void*)
+	{
+		xyz[0] = std::floor(JDE);
+		xyz[1] = 1.;
+		xyz[2] = 0.;
+	}
+
+	double difference(const double a[3], const double b[3])
+	{
+		return std::sqrt((a[0]-b[0])*(a[0]-b[0])+(a[1]-b[1])*(a[1]-b[1])+(a[2]-b[2])*(a[2]-b[2]));
+	}
+}
+
+void TestChebyshevEphemeris::testAccuracy()
+{
+	ChebyshevEphemeris cache(&theory, "Test", ChebyshevEphemeris::segmentLengthForPeriod(period), 2451545.-3650., 2451545.+3650.);
+	QVERIFY(!cache.isModified());
+	double maxError = 0.;
+	for (int i=0; i<5000; ++i)
+	{
+		const double JDE = 2451545.-3000.+i*1.2345;
+		double cached[3], exact[3];
+		cache.position(JDE, cached);
+		theory(JDE, exact, Q_NULLPTR);
+		maxError = qMax(maxError, difference(cached, exact));
+	}
+	QVERIFY2(maxError<1e-7, qPrintable(QString("max error %1 AU").arg(maxError)));
+	QVERIFY(cache.isModified());
+	QVERIFY(cache.getFittedSegmentCount()>0);
+}
+
+void TestChebyshevEphemeris::testOutsideWindow()
+{
+	ChebyshevEphemeris cache(&theory, "Test", 8., 2451545., 2451545.+100.);
+	double cached[3], exact[3];
+	cache.position(2451545.-0.5, cached);
+	theory(2451545.-0.5, exact, Q_NULLPTR);
+	QCOMPARE(difference(cached, exact), 0.);
+	cache.position(2451545.+200., cached);
+	theory(2451545.+200., exact, Q_NULLPTR);
+	QCOMPARE(difference(cached, exact), 0.);
+	QCOMPARE(cache.getFittedSegmentCount(), 0);
+}
+
+void TestChebyshevEphemeris::testPrefill()
+{
+	const double length = 5.;
+	ChebyshevEphemeris cache(&theory, "Test", length, 2451545.-1000., 2451545.+1000.);
+	cache.prefill(2451545.-100., 2451545.+100.);
+	QCOMPARE(cache.getFittedSegmentCount(), 40);
+
+	theoryCalls.store(0);
+	double xyz[3];
+	for (int i=0; i<1000; ++i)
+		cache.position(2451545.-99.+i*0.198, xyz);
+	QCOMPARE(theoryCalls.load(), 0);
+
+	QAtomicInt cancelled(1);
+	cache.prefill(2451545.+100., 2451545.+500., &cancelled);
+	QCOMPARE(cache.getFittedSegmentCount(), 40);
+}
+
+void TestChebyshevEphemeris::testFailedSegments()
+{
+	ChebyshevEphemeris cache(&steps, "Steps", 8., 0., 100.);
+	double cached[3];
+	cache.position(12.5, cached);
+	QCOMPARE(cached[0], 12.);
+	cache.position(13.5, cached);
+	QCOMPARE(cached[0], 13.);
+	QCOMPARE(cache.getFittedSegmentCount(), 1);
+}
+
+void TestChebyshevEphemeris::testSaveLoad()
+{
+	QVERIFY(dir.isValid());
+	const QString fileName = dir.path()+"/ephemeris/test/Test.cheb";
+	ChebyshevEphemeris cache(&theory, "Test", 5., 2451545.-1000., 2451545.+1000.);
+	cache.prefill(2451545.-50., 2451545.+50.);
+	QVERIFY(cache.save(fileName, "stamp"));
+	QVERIFY(!cache.isModified());
+
+	ChebyshevEphemeris loaded(&theory, "Test", 5., 2451545.-1000., 2451545.+1000.);
+	QVERIFY(loaded.load(fileName, "stamp"));
+	QCOMPARE(loaded.getFittedSegmentCount(), cache.getFittedSegmentCount());
+	QVERIFY(!loaded.isModified());
+	theoryCalls.store(0);
+	for (int i=0; i<100; ++i)
+	{
+		const double JDE = 2451545.-49.5+i;
+		double a[3], b[3];
+		cache.position(JDE, a);
+		loaded.position(JDE, b);
+		QCOMPARE(difference(a, b), 0.);
+	}
+	QCOMPARE(theoryCalls.load(), 0);
+
+	// Another theory, program version or segment length
+	ChebyshevEphemeris other(&theory, "Test", 5., 2451545.-1000., 2451545.+1000.);
+	QVERIFY(!other.load(fileName, "other stamp"));
+	ChebyshevEphemeris shorter(&theory, "Test", 2.5, 2451545.-1000., 2451545.+1000.);
+	QVERIFY(!shorter.load(fileName, "stamp"));
+	QCOMPARE(other.getFittedSegmentCount()+shorter.getFittedSegmentCount(), 0);
+
+	// Only the segments within the window are kept
+	ChebyshevEphemeris narrow(&theory, "Test", 5., 2451545., 2451545.+1000.);
+	QVERIFY(narrow.load(fileName, "stamp"));
+	QCOMPARE(narrow.getFittedSegmentCount(), 10);
+}
@@ -0,0 +1,507 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testComputePositions.hpp"
+
+#include <QFile>
+#include <QHash>
+#include <QTextStream>
+#include <QtGlobal>
+#include <cmath>
+
+#include "Orbit.hpp"
+#include "KeplerOrbitBatch.hpp"
+#include "SolarSystem.hpp"
+#include "SolarSystemCache.hpp"
+
+// SolarSystem has a QFont, which needs a QGuiApplication
+QTEST_MAIN(TestComputePositions)
+
+namespace
+{
+	// Planets with satellites, whose theories must run in the group of their planet. The elements of Mars and Jupiter
+	// are the mean elements at J2000, the minor bodies are appended by createSolarSystem().
+	const char* const planetsFile =
+		"[sun]\n"
+		"name = Sun\n"
+		"parent = none\n"
+		"radius = 696000\n"
+		"albedo = -1.\n"
+		"coord_func = sun_special\n"
+		"type = star\n"
+		"\n"
+		"[mars]\n"
+		"name = Mars\n"
+		"radius = 3396.19\n"
+		"albedo = 0.15\n"
+		"coord_func = ell_orbit\n"
+		"orbit_SemiMajorAxis = 227939200\n"
+		"orbit_Eccentricity = 0.0933941\n"
+		"orbit_Inclination = 1.84969142\n"
+		"orbit_AscendingNode = 49.55953891\n"
+		"orbit_LongOfPericenter = 336.05637041\n"
+		"orbit_MeanLongitude = 355.45332\n"
+		"rot_periode = 24.622962\n"
+		"type = planet\n"
+		"\n"
+		"[phobos]\n"
+		"name = Phobos\n"
+		"parent = Mars\n"
+		"radius = 11.1\n"
+		"coord_func = phobos_special\n"
+		"type = moon\n"
+		"\n"
+		"[deimos]\n"
+		"name = Deimos\n"
+		"parent = Mars\n"
+		"radius = 6.2\n"
+		"coord_func = deimos_special\n"
+		"type = moon\n"
+		"\n"
+		"[jupiter]\n"
+		"name = Jupiter\n"
+		"radius = 71492\n"
+		"albedo = 0.538\n"
+		"coord_func = ell_orbit\n"
+		"orbit_SemiMajorAxis = 778547200\n"
+		"orbit_Eccentricity = 0.04838624\n"
+		"orbit_Inclination = 1.30439695\n"
+		"orbit_AscendingNode = 100.47390909\n"
+		"orbit_LongOfPericenter = 14.72847983\n"
+		"orbit_MeanLongitude = 34.39644051\n"
+		"rot_periode = 9.925\n"
+		"type = planet\n"
+		"\n"
+		"[io]\n"
+		"name = Io\n"
+		"parent = Jupiter\n"
+		"radius = 1821.6\n"
+		"coord_func = io_special\n"
+		"type = moon\n"
+		"\n"
+		"[europa]\n"
+		"name = Europa\n"
+		"parent = Jupiter\n"
+		"radius = 1560.8\n"
+		"coord_func = europa_special\n"
+		"type = moon\n";
+	const int planetCount = 7;
+
+	// Same chunk size as in SolarSystem::getIndependentPlanetGroups()
+	const int chunkSize = 256;
+
+	const double dates[] = {2446480.5, 2451545.0, 2455197.5, 2458396.25};
+	const int dateCount = sizeof(dates)/sizeof(dates[0]);
+
+	// The dates in UT only have to be the same for both runs, DeltaT needs a StelCore
+	const double deltaT = 69.184/86400.;
+}
+
+void TestComputePositions::initTestCase()
+{
+	QVERIFY(dir.isValid());
+	Planet::init();
+}
+
+SolarSystem* TestComputePositions::createSolarSystem(int minorCount)
+{
+	const QString fileName = QString("%1/ssystem_%2.ini").arg(dir.path()).arg(minorCount);
+	if (!QFile::exists(fileName))
+	{
+		QFile file(fileName);
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+			return Q_NULLPTR;
+		QTextStream out(&file);
+		out.setRealNumberPrecision(12);
+		out << planetsFile;
+		qsrand(42);
+		for (int i=0; i<minorCount; ++i)
+		{
+			// like createOrbits(): 9 of 10 main belt asteroids, and comets including some parabolic and hyperbolic orbits
+			const bool comet = (i%10==0);
+			const double q = comet ? 0.3 + 4.*qrand()/RAND_MAX : 2.1 + 1.2*qrand()/RAND_MAX;
+			const double e = comet ? 0.5 + 0.55*qrand()/RAND_MAX : 0.3*qrand()/RAND_MAX;
+			out << "\n[minor" << i << "]\n"
+			    << "name = " << (comet ? "C/2017 A" : "2017 AB") << i << "\n"
+			    << "coord_func = comet_orbit\n"
+			    << "orbit_TimeAtPericenter = " << 2451545.0 + 3650.*qrand()/RAND_MAX - 1825. << "\n"
+			    << "orbit_PericenterDistance = " << q << "\n"
+			    << "orbit_Eccentricity = " << e << "\n"
+			    << "orbit_Inclination = " << 30.*qrand()/RAND_MAX << "\n"
+			    << "orbit_AscendingNode = " << 360.*qrand()/RAND_MAX << "\n"
+			    << "orbit_ArgOfPericenter = " << 360.*qrand()/RAND_MAX << "\n"
+			    << "radius = 1\n"
+			    << "type = " << (comet ? "comet" : "asteroid") << "\n";
+		}
+	}
+
+	QVector<SolarSystemBodyData> bodies;
+	if (!SolarSystem::readSolarSystemFile(fileName, bodies))
+		return Q_NULLPTR;
+	SolarSystem* ssystem = new SolarSystem();
+	QHash<QString, PlanetP> bodiesByName;
+	foreach (const SolarSystemBodyData& data, bodies)
+	{
+		PlanetP p = ssystem->addBody(data, bodiesByName);
+		if (!p.isNull())
+			bodiesByName.insert(p->getEnglishName(), p);
+	}
+	return ssystem;
+}
+
+void TestComputePositions::cleanup()
+{
+	qDeleteAll(asteroids);
+	asteroids.clear();
+	qDeleteAll(comets);
+	comets.clear();
+}
+
+void TestComputePositions::createOrbits(int count)
+{
+	cleanup();
+	qsrand(42);
+	for (int i=0; i<count; ++i)
+	{
+		const double node = 2.*M_PI*qrand()/RAND_MAX;
+		const double peri = 2.*M_PI*qrand()/RAND_MAX;
+		const double incl = 0.5*qrand()/RAND_MAX;
+		if (i%10)
+		{
+			// main belt asteroid
+			const double a = 2.1 + 1.2*qrand()/RAND_MAX;
+			const double e = 0.3*qrand()/RAND_MAX;
+			const double period = 365.25*a*std::sqrt(a);
+			asteroids.append(new EllipticalOrbit(a*(1.-e), e, incl, node, peri, 2.*M_PI*qrand()/RAND_MAX,
+							     period, 2451545.0, 0., 0., 0.));
+		}
+		else
+		{
+			// comet, including some parabolic and hyperbolic orbits
+			const double q = 0.3 + 4.*qrand()/RAND_MAX;
+			const double e = 0.5 + 0.55*qrand()/RAND_MAX;
+			const double a = std::fabs(q/(1.-e));
+			const double n = 0.01720209895 / (a*std::sqrt(a));
+			comets.append(new CometOrbit(q, e, incl, node, peri, 2451545.0 + 3650.*qrand()/RAND_MAX - 1825.,
+						     1e10, n, 0., 0., 0.));
+		}
+	}
+}
+
+void TestComputePositions::computeSerial(double JDE, QVector<double>& xyz)
+{
+	xyz.resize(3*(asteroids.size()+comets.size()));
+	double* v = xyz.data();
+	foreach (EllipticalOrbit* orbit, asteroids)
+	{
+		orbit->positionAtTimevInVSOP87Coordinates(JDE, v);
+		v += 3;
+	}
+	foreach (CometOrbit* orbit, comets)
+	{
+		orbit->positionAtTimevInVSOP87Coordinates(JDE, v);
+		v += 3;
+	}
+}
+
+void TestComputePositions::compareWithReference(const QVector<double>& reference, const QVector<double>& referenceVelocities,
+						 const QVector<double>& JDE)
+{
+	// The batch solves Kepler's equation with a fixed number of iterations and its own sin/cos,
+	// so only agreement to well below the accuracy of the orbital elements can be expected.
+	for (int i=0; i<asteroids.size()+comets.size(); ++i)
+	{
+		Vec3d pos, expected(reference.at(3*i), reference.at(3*i+1), reference.at(3*i+2));
+		if (i<asteroids.size())
+			asteroids.at(i)->positionAtTimevInVSOP87Coordinates(JDE.at(i), pos);
+		else
+		{
+			CometOrbit* comet = comets.at(i-asteroids.size());
+			comet->positionAtTimevInVSOP87Coordinates(JDE.at(i), pos);
+			const int j = i-asteroids.size();
+			const Vec3d expectedVelocity(referenceVelocities.at(3*j), referenceVelocities.at(3*j+1), referenceVelocities.at(3*j+2));
+			QVERIFY2((comet->getVelocity()-expectedVelocity).length() <= 1e-9*expectedVelocity.length(),
+				 QString("JDE=%1 comet=%2 velocity error=%3")
+				 .arg(QString::number(JDE.at(i), 'f', 1))
+				 .arg(j)
+				 .arg((comet->getVelocity()-expectedVelocity).length())
+				 .toUtf8());
+		}
+		QVERIFY2((pos-expected).length() <= 1e-9*qMax(1., expected.length()),
+			 QString("JDE=%1 index=%2 error=%3 AU")
+			 .arg(QString::number(JDE.at(i), 'f', 1))
+			 .arg(i)
+			 .arg((pos-expected).length())
+			 .toUtf8());
+	}
+}
+
+void TestComputePositions::testIndependentPlanetGroups()
+{
+	const int minorCount = 1000;
+	SolarSystem* ssystem = createSolarSystem(minorCount);
+	QVERIFY(ssystem);
+	QCOMPARE(ssystem->getAllPlanets().size(), planetCount+minorCount);
+	const Planet* sun = ssystem->getSun().data();
+	const Planet* mars = ssystem->searchByEnglishName("Mars").data();
+	const Planet* jupiter = ssystem->searchByEnglishName("Jupiter").data();
+	QVERIFY(sun && mars && jupiter);
+
+	const QVector<QVector<Planet*> > groups = ssystem->getIndependentPlanetGroups();
+	QHash<const Planet*, int> groupOf;
+	for (int g=0; g<groups.size(); ++g)
+	{
+		QVERIFY(!groups.at(g).isEmpty());
+		foreach (const Planet* p, groups.at(g))
+		{
+			QVERIFY2(!groupOf.contains(p), qPrintable(p->getEnglishName()));
+			groupOf.insert(p, g);
+		}
+	}
+
+	// every body but the Sun is updated exactly once
+	QVERIFY(!groupOf.contains(sun));
+	QCOMPARE(groupOf.size(), ssystem->getAllPlanets().size()-1);
+
+	// satellites are updated after their planet, by the same task
+	foreach (const PlanetP& p, ssystem->getAllPlanets())
+	{
+		const Planet* parent = p->getParent().data();
+		if (!parent || parent==sun)
+			continue;
+		const QString name = p->getEnglishName();
+		QVERIFY2(groupOf.value(p.data())==groupOf.value(parent), qPrintable(name));
+		const QVector<Planet*>& group = groups.at(groupOf.value(parent));
+		QVERIFY2(group.indexOf(const_cast<Planet*>(parent)) < group.indexOf(p.data()), qPrintable(name));
+	}
+	QCOMPARE(groups.at(groupOf.value(mars)).size(), 3);
+	QCOMPARE(groups.at(groupOf.value(jupiter)).size(), 3);
+
+	// the other bodies are cut into chunks
+	int chunkCount = 0;
+	int chunkedBodies = 0;
+	for (int g=0; g<groups.size(); ++g)
+	{
+		if (g==groupOf.value(mars) || g==groupOf.value(jupiter))
+			continue;
+		QVERIFY(groups.at(g).size()<=chunkSize);
+		chunkedBodies += groups.at(g).size();
+		++chunkCount;
+	}
+	QCOMPARE(chunkedBodies, minorCount);
+	QCOMPARE(chunkCount, (minorCount+chunkSize-1)/chunkSize);
+
+	delete ssystem;
+}
+
+void TestComputePositions::testParallelMatchesSerial_data()
+{
+	QTest::addColumn<bool>("lightTime");
+	QTest::newRow("geometric") << false;
+	QTest::newRow("light time") << true;
+}
+
+void TestComputePositions::testParallelMatchesSerial()
+{
+	QFETCH(bool, lightTime);
+	SolarSystem* serial = createSolarSystem(3000);
+	SolarSystem* parallel = createSolarSystem(3000);
+	QVERIFY(serial && parallel);
+	serial->setFlagParallelPositions(false);
+	parallel->setFlagParallelPositions(true);
+	serial->setFlagLightTravelTime(lightTime);
+	parallel->setFlagLightTravelTime(lightTime);
+
+	// observer on Mars, so that its satellites get a light time correction relative to it
+	const PlanetP serialObserver = serial->searchByEnglishName("Mars");
+	const PlanetP parallelObserver = parallel->searchByEnglishName("Mars");
+	const QList<PlanetP>& a = serial->getAllPlanets();
+	const QList<PlanetP>& b = parallel->getAllPlanets();
+	QCOMPARE(b.size(), a.size());
+
+	for (int d=0; d<dateCount; ++d)
+	{
+		const double JDE = dates[d];
+		serial->computePositions(JDE-deltaT, JDE, serialObserver);
+		parallel->computePositions(JDE-deltaT, JDE, parallelObserver);
+		QVERIFY((serial->getLightTimeSunPosition()-parallel->getLightTimeSunPosition()).length() <= 1e-12);
+
+		for (int i=0; i<a.size(); ++i)
+		{
+			const QString name = a.at(i)->getEnglishName();
+			QCOMPARE(b.at(i)->getEnglishName(), name);
+			const Vec3d pos = a.at(i)->getHeliocentricEclipticPos();
+			QVERIFY2((b.at(i)->getHeliocentricEclipticPos()-pos).length() <= 1e-12*qMax(1., pos.length()),
+				 QString("JDE=%1 %2 serial=%3 parallel=%4")
+				 .arg(QString::number(JDE, 'f', 2))
+				 .arg(name)
+				 .arg(pos.toString())
+				 .arg(b.at(i)->getHeliocentricEclipticPos().toString())
+				 .toUtf8());
+			Mat4d rotA = a.at(i)->getRotEquatorialToVsop87();
+			Mat4d rotB = b.at(i)->getRotEquatorialToVsop87();
+			for (int k=0; k<16; ++k)
+				QVERIFY2(std::fabs(rotA[k]-rotB[k]) <= 1e-12, qPrintable(QString("JDE=%1 %2").arg(QString::number(JDE, 'f', 2)).arg(name)));
+		}
+	}
+
+	delete serial;
+	delete parallel;
+}
+
+void TestComputePositions::testBatchMatchesSerial()
+{
+	createOrbits(5000);
+	KeplerOrbitBatch batch;
+	foreach (EllipticalOrbit* orbit, asteroids)
+		QVERIFY(batch.add(orbit)>=0);
+	int rejected = 0;
+	foreach (CometOrbit* orbit, comets)
+		if (batch.add(orbit)<0)
+		{
+			QVERIFY(orbit->getEccentricity()>=1.);
+			++rejected;
+		}
+	QCOMPARE(batch.size(), asteroids.size()+comets.size()-rejected);
+	qDebug() << "KeplerOrbitBatch uses" << KeplerOrbitBatch::instructionSet();
+
+	QVector<double> reference, velocities;
+	for (double JDE=2415020.5; JDE<2488069.5; JDE+=3652.5)
+	{
+		// Reference before the batch has filled the caches for this date
+		computeSerial(JDE, reference);
+		velocities.clear();
+		foreach (CometOrbit* orbit, comets)
+		{
+			const Vec3d v = orbit->getVelocity();
+			velocities << v[0] << v[1] << v[2];
+		}
+
+		batch.computePositions(JDE, JDE>2451545.0);
+		compareWithReference(reference, velocities, QVector<double>(asteroids.size()+comets.size(), JDE));
+	}
+}
+
+void TestComputePositions::testBatchPerSlotDates()
+{
+	createOrbits(2000);
+	KeplerOrbitBatch batch;
+	QVector<int> slots;
+	foreach (EllipticalOrbit* orbit, asteroids)
+		slots.append(batch.add(orbit));
+	foreach (CometOrbit* orbit, comets)
+		slots.append(batch.add(orbit));
+
+	// Different date for every orbit, like with light time correction
+	QVector<double> JDE, slotJDE(batch.size());
+	for (int i=0; i<slots.size(); ++i)
+	{
+		JDE.append(2451545.0 + 0.37*i);
+		if (slots.at(i)>=0)
+			slotJDE[slots.at(i)] = JDE.at(i);
+	}
+
+	QVector<double> reference, velocities;
+	double* v;
+	reference.resize(3*slots.size());
+	v = reference.data();
+	for (int i=0; i<slots.size(); ++i, v+=3)
+	{
+		if (i<asteroids.size())
+			asteroids.at(i)->positionAtTimevInVSOP87Coordinates(JDE.at(i), v);
+		else
+		{
+			comets.at(i-asteroids.size())->positionAtTimevInVSOP87Coordinates(JDE.at(i), v);
+			const Vec3d vel = comets.at(i-asteroids.size())->getVelocity();
+			velocities << vel[0] << vel[1] << vel[2];
+		}
+	}
+
+	batch.computePositions(slotJDE);
+	compareWithReference(reference, velocities, JDE);
+}
+
+void TestComputePositions::benchmarkSerial_data()
+{
+	QTest::addColumn<int>("count");
+	QTest::newRow("10k orbits") << 10000;
+	QTest::newRow("100k orbits") << 100000;
+}
+
+void TestComputePositions::benchmarkSerial()
+{
+	QFETCH(int, count);
+	createOrbits(count);
+	QVector<double> xyz;
+	double JDE = 2451545.0;
+	QBENCHMARK
+	{
+		computeSerial(JDE, xyz);
+		JDE += 1.;
+	}
+}
+
+void TestComputePositions::benchmarkBatch_data()
+{
+	benchmarkSerial_data();
+}
+
+void TestComputePositions::benchmarkBatch()
+{
+	QFETCH(int, count);
+	createOrbits(count);
+	KeplerOrbitBatch batch;
+	foreach (EllipticalOrbit* orbit, asteroids)
+		batch.add(orbit);
+	foreach (CometOrbit* orbit, comets)
+		batch.add(orbit);
+	QVector<double> xyz;
+	double JDE = 2451545.0;
+	QBENCHMARK
+	{
+		// The batch fills the caches, the serial loop collects the results and handles the remaining orbits.
+		batch.computePositions(JDE);
+		computeSerial(JDE, xyz);
+		JDE += 1.;
+	}
+}
+
+void TestComputePositions::benchmarkSolarSystem_data()
+{
+	QTest::addColumn<bool>("parallel");
+	QTest::newRow("serial") << false;
+	QTest::newRow("parallel") << true;
+}
+
+void TestComputePositions::benchmarkSolarSystem()
+{
+	QFETCH(bool, parallel);
+	SolarSystem* ssystem = createSolarSystem(10000);
+	QVERIFY(ssystem);
+	ssystem->setFlagParallelPositions(parallel);
+	ssystem->setFlagLightTravelTime(true);
+	const PlanetP observer = ssystem->searchByEnglishName("Mars");
+	double JDE = 2451545.0;
+	QBENCHMARK
+	{
+		ssystem->computePositions(JDE-deltaT, JDE, observer);
+		JDE += 1.;
+	}
+	delete ssystem;
+}
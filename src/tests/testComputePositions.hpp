@@ -0,0 +1,69 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TESTCOMPUTEPOSITIONS_HPP_
+#define _TESTCOMPUTEPOSITIONS_HPP_
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QVector>
+
+class EllipticalOrbit;
+class CometOrbit;
+class SolarSystem;
+
+//! Checks and benchmarks the position update of SolarSystem::computePositions(), serial and split into the groups
+//! of SolarSystem::getIndependentPlanetGroups(), and the batched update of many Keplerian orbits (KeplerOrbitBatch)
+//! it uses for minor bodies and comets.
+class TestComputePositions : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanup();
+	void testIndependentPlanetGroups();
+	void testParallelMatchesSerial_data();
+	void testParallelMatchesSerial();
+	void testBatchMatchesSerial();
+	void testBatchPerSlotDates();
+	void benchmarkSerial_data();
+	void benchmarkSerial();
+	void benchmarkBatch_data();
+	void benchmarkBatch();
+	void benchmarkSolarSystem_data();
+	void benchmarkSolarSystem();
+
+private:
+	//! Create count synthetic orbits, 9 of 10 asteroids and 1 of 10 comets.
+	void createOrbits(int count);
+	void computeSerial(double JDE, QVector<double>& xyz);
+	//! Compare positions (and comet velocities) after a batch run with reference values of the scalar code.
+	void compareWithReference(const QVector<double>& reference, const QVector<double>& referenceVelocities,
+				  const QVector<double>& JDE);
+	//! Create a Solar System with planets, satellites and minorCount synthetic minor bodies and comets,
+	//! which only use orbital elements and satellite theories and need no StelCore.
+	SolarSystem* createSolarSystem(int minorCount);
+
+	QVector<EllipticalOrbit*> asteroids;
+	QVector<CometOrbit*> comets;
+	QTemporaryDir dir;
+};
+
+#endif // _TESTCOMPUTEPOSITIONS_HPP_
@@ -20,13 +20,17 @@
 #include "tests/testEphemeris.hpp"
 
 #include <QDebug>
+#include <QFile>
 #include <QVariantList>
+#include <QVector>
 #include <QString>
 #include <QtGlobal>
+#include <QtConcurrent>
 
 #include "StelFileMgr.hpp"
 #include "EphemWrapper.hpp"
 #include "vsop87.h"
+#include "elp82b.h"
 #include "de430.hpp"
 #include "de431.hpp"
 
@@ -47,10 +51,16 @@ void TestEphemeris::initTestCase()
 	de431FilePath = StelFileMgr::findFile("ephem/" + QString(DE431_FILENAME), StelFileMgr::File);
 
 	if (!de430FilePath.isEmpty())
+	{
 		qWarning() << "Use DE430 ephemeris file" << de430FilePath;
+		InitDE430(QFile::encodeName(de430FilePath).constData());
+	}
 
 	if (!de431FilePath.isEmpty())
+	{
 		qWarning() << "Use DE431 ephemeris file" << de431FilePath;
+		InitDE431(QFile::encodeName(de431FilePath).constData());
+	}
 
 	// test data was obtained from http://ssd.jpl.nasa.gov/horizons.cgi#results
 
@@ -1233,6 +1243,67 @@ void TestEphemeris::testNeptuneHeliocentricEphemerisVsop87()
 	}
 }
 
+void TestEphemeris::testVsop87CacheContexts()
+{
+	// The interpolation cache depends on the call history, so a context must give
+	// exactly the same results no matter what other callers do in the meantime.
+	const int count = 50;
+	QVector<double> reference;
+	Vsop87Context ctxA, ctxB;
+	double xyzA[3], xyzB[3], xyz[3];
+
+	InitVsop87Context(&ctxA);
+	for (int i=0; i<count; ++i)
+	{
+		for (int planet_id=0; planet_id<8; ++planet_id)
+		{
+			GetVsop87CoorCtx(&ctxA, 2451545.0 + i*0.7, planet_id, xyzA);
+			reference << xyzA[0] << xyzA[1] << xyzA[2];
+		}
+	}
+
+	InitVsop87Context(&ctxA);
+	InitVsop87Context(&ctxB);
+	for (int i=0; i<count; ++i)
+	{
+		for (int planet_id=0; planet_id<8; ++planet_id)
+		{
+			GetVsop87CoorCtx(&ctxB, 2305447.5 - i*13.1, planet_id, xyzB);
+			GetVsop87Coor(2378496.5 + i*3.3, planet_id, xyz);
+			GetVsop87CoorCtx(&ctxA, 2451545.0 + i*0.7, planet_id, xyzA);
+			const int idx = (i*8 + planet_id)*3;
+			QVERIFY2(xyzA[0]==reference.at(idx) && xyzA[1]==reference.at(idx+1) && xyzA[2]==reference.at(idx+2),
+				 QString("jd=%1 planet=%2").arg(QString::number(2451545.0 + i*0.7, 'f', 5)).arg(planet_id).toUtf8());
+		}
+	}
+}
+
+void TestEphemeris::testElp82bCacheContexts()
+{
+	const int count = 50;
+	QVector<double> reference;
+	Elp82bContext ctxA, ctxB;
+	double xyzA[3], xyzB[3], xyz[3];
+
+	InitElp82bContext(&ctxA);
+	for (int i=0; i<count; ++i)
+	{
+		GetElp82bCoorCtx(&ctxA, 2451545.0 + i*0.01, xyzA);
+		reference << xyzA[0] << xyzA[1] << xyzA[2];
+	}
+
+	InitElp82bContext(&ctxA);
+	InitElp82bContext(&ctxB);
+	for (int i=0; i<count; ++i)
+	{
+		GetElp82bCoorCtx(&ctxB, 2305447.5 - i*27.3, xyzB);
+		GetElp82bCoor(2378496.5 + i*0.02, xyz);
+		GetElp82bCoorCtx(&ctxA, 2451545.0 + i*0.01, xyzA);
+		QVERIFY2(xyzA[0]==reference.at(i*3) && xyzA[1]==reference.at(i*3+1) && xyzA[2]==reference.at(i*3+2),
+			 QString("jd=%1").arg(QString::number(2451545.0 + i*0.01, 'f', 5)).toUtf8());
+	}
+}
+
 void TestEphemeris::testMercuryHeliocentricEphemerisDe430()
 {
 	if (de430FilePath.isEmpty())
@@ -1499,6 +1570,14 @@ void TestEphemeris::testNeptuneHeliocentricEphemerisDe430()
 	}
 }
 
+void TestEphemeris::testConcurrentReadsDe430()
+{
+	if (de430FilePath.isEmpty())
+		qWarning() << "Ephemeris JPL DE430 unit test has been marked as 'passed' (He cannot be passed, because DE430 file ephemeris is not exists)!";
+	else
+		checkConcurrentReads(&GetDe430Coor, 2287185.5, 2688975.5);
+}
+
 void TestEphemeris::testMercuryHeliocentricEphemerisDe431()
 {
 	if (de431FilePath.isEmpty())
@@ -1764,3 +1843,39 @@ void TestEphemeris::testNeptuneHeliocentricEphemerisDe431()
 		}
 	}
 }
+
+void TestEphemeris::testConcurrentReadsDe431()
+{
+	if (de431FilePath.isEmpty())
+		qWarning() << "Ephemeris JPL DE431 unit test has been marked as 'passed' (He cannot be passed, because DE431 file ephemeris is not exists)!";
+	else
+		checkConcurrentReads(&GetDe431Coor, -3027214.5, 7930191.5);
+}
+
+void TestEphemeris::checkConcurrentReads(bool (*getCoor)(const double, const int, double*, const int), double startJD, double endJD)
+{
+	// Random jumps over the whole file by several threads must give the same positions as one thread
+	struct Query
+	{
+		double jd;
+		int planet;
+		double xyz[3];
+		bool ok;
+	};
+	QVector<Query> serial(4000);
+	for (int i=0; i<serial.size(); ++i)
+	{
+		Query& q = serial[i];
+		q.jd = startJD + (endJD-startJD)*((i*7919)%serial.size())/serial.size();
+		q.planet = 1+i%8;
+		q.ok = getCoor(q.jd, q.planet, q.xyz, CENTRAL_BODY_ID);
+	}
+	QVector<Query> parallel = serial;
+	QtConcurrent::blockingMap(parallel, [getCoor](Query& q) { q.ok = getCoor(q.jd, q.planet, q.xyz, CENTRAL_BODY_ID); });
+	for (int i=0; i<serial.size(); ++i)
+	{
+		QVERIFY(serial.at(i).ok && parallel.at(i).ok);
+		QVERIFY2(serial.at(i).xyz[0]==parallel.at(i).xyz[0] && serial.at(i).xyz[1]==parallel.at(i).xyz[1] && serial.at(i).xyz[2]==parallel.at(i).xyz[2],
+			 QString("jd=%1 planet=%2").arg(QString::number(serial.at(i).jd, 'f', 5)).arg(serial.at(i).planet).toUtf8());
+	}
+}
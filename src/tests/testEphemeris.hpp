@@ -37,6 +37,9 @@ private slots:
 	void testSaturnHeliocentricEphemerisVsop87();
 	void testUranusHeliocentricEphemerisVsop87();
 	void testNeptuneHeliocentricEphemerisVsop87();
+	// VSOP87 and ELP82B with caller-owned cache contexts
+	void testVsop87CacheContexts();
+	void testElp82bCacheContexts();
 	// JPL DE430
 	void testMercuryHeliocentricEphemerisDe430();
 	void testVenusHeliocentricEphemerisDe430();
@@ -45,6 +48,7 @@ private slots:
 	void testSaturnHeliocentricEphemerisDe430();
 	void testUranusHeliocentricEphemerisDe430();
 	void testNeptuneHeliocentricEphemerisDe430();
+	void testConcurrentReadsDe430();
 	// JPL DE431
 	void testMercuryHeliocentricEphemerisDe431();
 	void testVenusHeliocentricEphemerisDe431();
@@ -53,8 +57,12 @@ private slots:
 	void testSaturnHeliocentricEphemerisDe431();
 	void testUranusHeliocentricEphemerisDe431();
 	void testNeptuneHeliocentricEphemerisDe431();
+	void testConcurrentReadsDe431();
 
 private:
+	//! Compare the positions computed at random dates between startJD and endJD by one and by several threads
+	void checkConcurrentReads(bool (*getCoor)(const double, const int, double*, const int), double startJD, double endJD);
+
 	QString de430FilePath, de431FilePath;
 	QVariantList mercury, venus, mars, jupiter, saturn, uranus, neptune;
 
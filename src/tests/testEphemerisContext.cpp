@@ -0,0 +1,293 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testEphemerisContext.hpp"
+#include "EphemerisContext.hpp"
+#include "SolarSystem.hpp"
+#include "SolarSystemCache.hpp"
+#include "StelCore.hpp"
+#include "StelUtils.hpp"
+
+#include <QFile>
+#include <QTextStream>
+
+// SolarSystem has a QFont, which needs a QGuiApplication
+QTEST_MAIN(TestEphemerisContext)
+
+namespace
+{
+	// A small Solar System with bodies computed from orbital elements or satellite theories only, as the planetary
+	// theories need a StelCore. The elements of Earth and Mars are the mean elements at J2000.
+	const char* const solarSystemFile =
+		"[sun]\n"
+		"name = Sun\n"
+		"parent = none\n"
+		"radius = 696000\n"
+		"albedo = -1.\n"
+		"coord_func = sun_special\n"
+		"type = star\n"
+		"\n"
+		"[earth]\n"
+		"name = Earth\n"
+		"radius = 6378.1366\n"
+		"oblateness = 0.0033528\n"
+		"albedo = 0.306\n"
+		"coord_func = ell_orbit\n"
+		"orbit_SemiMajorAxis = 149598261\n"
+		"orbit_Eccentricity = 0.01671123\n"
+		"orbit_Inclination = 0.\n"
+		"orbit_AscendingNode = 0.\n"
+		"orbit_LongOfPericenter = 102.93768193\n"
+		"orbit_MeanLongitude = 100.46457166\n"
+		"type = planet\n"
+		"\n"
+		"[mars]\n"
+		"name = Mars\n"
+		"radius = 3396.19\n"
+		"albedo = 0.15\n"
+		"coord_func = ell_orbit\n"
+		"orbit_SemiMajorAxis = 227939200\n"
+		"orbit_Eccentricity = 0.0933941\n"
+		"orbit_Inclination = 1.84969142\n"
+		"orbit_AscendingNode = 49.55953891\n"
+		"orbit_LongOfPericenter = 336.05637041\n"
+		"orbit_MeanLongitude = 355.45332\n"
+		"type = planet\n"
+		"\n"
+		"[phobos]\n"
+		"name = Phobos\n"
+		"parent = Mars\n"
+		"radius = 11.1\n"
+		"albedo = 0.071\n"
+		"coord_func = phobos_special\n"
+		"type = moon\n"
+		"\n"
+		"[ceres]\n"
+		"name = Ceres\n"
+		"radius = 473\n"
+		"albedo = 0.09\n"
+		"coord_func = comet_orbit\n"
+		"orbit_Epoch = 2458000.5\n"
+		"orbit_MeanAnomaly = 352.2304\n"
+		"orbit_PericenterDistance = 2.5577\n"
+		"orbit_Eccentricity = 0.0758\n"
+		"orbit_Inclination = 10.593\n"
+		"orbit_AscendingNode = 80.305\n"
+		"orbit_ArgOfPericenter = 73.597\n"
+		"absolute_magnitude = 3.34\n"
+		"slope_parameter = 0.12\n"
+		"type = dwarf planet\n"
+		"\n"
+		"[halley]\n"
+		"name = 1P/Halley\n"
+		"radius = 5\n"
+		"albedo = 0.04\n"
+		"coord_func = comet_orbit\n"
+		"orbit_TimeAtPericenter = 2446470.5\n"
+		"orbit_PericenterDistance = 0.5871\n"
+		"orbit_Eccentricity = 0.9671\n"
+		"orbit_Inclination = 162.26\n"
+		"orbit_AscendingNode = 58.42\n"
+		"orbit_ArgOfPericenter = 111.33\n"
+		"absolute_magnitude = 5.5\n"
+		"slope_parameter = 4.0\n"
+		"type = comet\n";
+
+	const double dates[] = {2446480.5, 2451545.0, 2455197.5, 2457754.5, 2458396.25};
+	const int dateCount = sizeof(dates)/sizeof(dates[0]);
+	const char* const bodyNames[] = {"Sun", "Earth", "Phobos", "Ceres", "1P/Halley"};
+	const int bodyCount = sizeof(bodyNames)/sizeof(bodyNames[0]);
+
+	// Observer at the center of Mars
+	const char* const homePlanetName = "Mars";
+
+	// 1 meter
+	const double positionTolerance = 1e-3/AU;
+
+	bool fuzzyEqual(const Vec3d& a, const Vec3d& b)
+	{
+		return (a-b).length() <= positionTolerance;
+	}
+}
+
+void TestEphemerisContext::initTestCase()
+{
+	QVERIFY(dir.isValid());
+	const QString fileName = dir.path()+"/ssystem.ini";
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+	QTextStream(&file) << solarSystemFile;
+	file.close();
+
+	Planet::init();
+	ssystem = new SolarSystem();
+	ssystem->setFlagLightTravelTime(false);
+	QVector<SolarSystemBodyData> bodies;
+	QVERIFY(SolarSystem::readSolarSystemFile(fileName, bodies));
+	QHash<QString, PlanetP> bodiesByName;
+	foreach (const SolarSystemBodyData& data, bodies)
+	{
+		PlanetP p = ssystem->addBody(data, bodiesByName);
+		QVERIFY2(!p.isNull(), qPrintable(data.englishName));
+		bodiesByName.insert(p->getEnglishName(), p);
+	}
+	QCOMPARE(ssystem->getAllPlanets().size(), 6);
+	QVERIFY(!ssystem->getSun().isNull());
+	QVERIFY(!ssystem->getEarth().isNull());
+}
+
+void TestEphemerisContext::cleanupTestCase()
+{
+	delete ssystem;
+	ssystem = Q_NULLPTR;
+}
+
+// Same as the serial position update of SolarSystem::computePositions() without light time correction.
+void TestEphemerisContext::computeLivePositions(double JDE)
+{
+	foreach (const PlanetP& p, ssystem->getAllPlanets())
+		p->computePosition(JDE);
+}
+
+void TestEphemerisContext::testPositions()
+{
+	const PlanetP home = ssystem->searchByEnglishName(homePlanetName);
+	QVERIFY(!home.isNull());
+	const EphemerisContext context(ssystem, home);
+	QVERIFY(context.isValid());
+
+	for (int i=0; i<dateCount; ++i)
+	{
+		const double JD = dates[i];
+		// Without a core DeltaT is neglected
+		QCOMPARE(context.getJDE(JD), JD);
+		computeLivePositions(JD);
+		const Vec3d homePos = home->getHeliocentricEclipticPos();
+		QVERIFY(fuzzyEqual(context.getObserverHeliocentricEclipticPos(JD), homePos));
+
+		for (int j=0; j<bodyCount; ++j)
+		{
+			const char* name = bodyNames[j];
+			const PlanetP p = ssystem->searchByEnglishName(name);
+			QVERIFY2(!p.isNull(), name);
+			const Vec3d pos = p->getHeliocentricEclipticPos();
+			const Vec3d j2000Pos = StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(pos-homePos);
+			const EphemerisContext::BodyState state = context.computeState(p.data(), JD);
+
+			QVERIFY2(fuzzyEqual(state.heliocentricPos, pos), name);
+			QVERIFY2(fuzzyEqual(state.observerHeliocentricPos, homePos), name);
+			QVERIFY2(fuzzyEqual(state.j2000Pos, j2000Pos), name);
+			QVERIFY2(fuzzyEqual(context.getJ2000EquatorialPos(p.data(), JD), j2000Pos), name);
+			QVERIFY2(qAbs(state.distance-j2000Pos.length()) <= positionTolerance, name);
+			if (p!=ssystem->getSun())
+			{
+				QVERIFY2(qAbs(state.phaseAngle-p->getPhaseAngle(homePos)) < 1e-9, name);
+				QVERIFY2(qAbs(state.elongation-p->getElongation(homePos)) < 1e-9, name);
+			}
+		}
+	}
+}
+
+void TestEphemerisContext::testMagnitudes()
+{
+	const PlanetP home = ssystem->searchByEnglishName(homePlanetName);
+	const PlanetP sun = ssystem->getSun();
+	const PlanetP phobos = ssystem->searchByEnglishName("Phobos");
+	const EphemerisContext context(ssystem, home);
+
+	for (int i=0; i<dateCount; ++i)
+	{
+		const double JD = dates[i];
+		computeLivePositions(JD);
+		const Vec3d homePos = home->getHeliocentricEclipticPos();
+		for (int j=0; j<bodyCount; ++j)
+		{
+			const char* name = bodyNames[j];
+			const PlanetP p = ssystem->searchByEnglishName(name);
+			// The geometry of Planet::getVMagnitude() for an observer at the center of the home planet
+			Planet::MagnitudeGeometry geometry;
+			geometry.observerHelioPos = homePos;
+			geometry.planetHelioPos = p->getHeliocentricEclipticPos();
+			geometry.parentHelioPos = p->getParent() ? p->getParent()->getHeliocentricEclipticPos() : Vec3d(0.);
+			geometry.earthHelioPos = ssystem->getEarth()->getHeliocentricEclipticPos();
+			geometry.JDE = JD;
+			geometry.observerOnEarth = false;
+			geometry.eclipseFactor = 1.;
+			if (p==sun)
+				geometry.eclipseFactor = SolarSystem::computeEclipseIllumination(sun->getHeliocentricEclipticPos(), sun->getRadius(), homePos,
+												  phobos->getHeliocentricEclipticPos(), phobos->getRadius());
+			const float vMagnitude = p->computeVMagnitude(geometry);
+
+			const EphemerisContext::BodyState state = context.computeState(p.data(), JD);
+			QVERIFY2(qAbs(state.vMagnitude-vMagnitude) < 1e-4f, qPrintable(QString("%1 at JD %2: %3 instead of %4").arg(name).arg(JD, 0, 'f', 2).arg(state.vMagnitude).arg(vMagnitude)));
+			// No atmosphere
+			QCOMPARE(state.vMagnitudeWithExtinction, state.vMagnitude);
+		}
+	}
+}
+
+// With light time correction, each body must be at the position SolarSystem::computePositions() computes for it:
+// the position at the date when the light seen by the observer left the body.
+void TestEphemerisContext::testLightTime()
+{
+	const PlanetP home = ssystem->searchByEnglishName(homePlanetName);
+	ssystem->setFlagLightTravelTime(true);
+	const EphemerisContext context(ssystem, home);
+	ssystem->setFlagLightTravelTime(false);
+
+	for (int i=0; i<dateCount; ++i)
+	{
+		const double JD = dates[i];
+		computeLivePositions(JD);
+		const Vec3d homePos = home->getHeliocentricEclipticPos();
+		for (int j=0; j<bodyCount; ++j)
+		{
+			const char* name = bodyNames[j];
+			const PlanetP p = ssystem->searchByEnglishName(name);
+			if (p==ssystem->getSun())
+				continue;
+			const double lightTime = (p->getHeliocentricEclipticPos()-homePos).length() * (AU / (SPEED_OF_LIGHT * 86400.));
+			QVERIFY(lightTime > 0.);
+			p->computePosition(JD-lightTime);
+			const Vec3d pos = p->getHeliocentricEclipticPos();
+			const EphemerisContext::BodyState state = context.computeState(p.data(), JD);
+			QVERIFY2(fuzzyEqual(state.heliocentricPos, pos), name);
+			QVERIFY2(fuzzyEqual(state.j2000Pos, StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(pos-homePos)), name);
+			// Without correction the body would be elsewhere
+			QVERIFY2(!fuzzyEqual(state.heliocentricPos, p->computeHeliocentricEclipticPos(JD)), name);
+		}
+	}
+}
+
+void TestEphemerisContext::testStateIsConst()
+{
+	const PlanetP home = ssystem->searchByEnglishName(homePlanetName);
+	const EphemerisContext context(ssystem, home);
+	computeLivePositions(dates[0]);
+	QVector<Vec3d> positions;
+	foreach (const PlanetP& p, ssystem->getAllPlanets())
+		positions << p->getHeliocentricEclipticPos();
+
+	for (int j=0; j<bodyCount; ++j)
+		context.computeState(ssystem->searchByEnglishName(bodyNames[j]).data(), dates[3]);
+
+	for (int i=0; i<positions.size(); ++i)
+		QVERIFY(ssystem->getAllPlanets().at(i)->getHeliocentricEclipticPos()==positions.at(i));
+}
@@ -0,0 +1,48 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _TESTEPHEMERISCONTEXT_HPP_
+#define _TESTEPHEMERISCONTEXT_HPP_
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+
+class SolarSystem;
+
+//! Compares the positions and magnitudes of EphemerisContext with the values of the Planet objects
+//! after a position update. The bodies only use orbital elements and satellite theories, which do not need a StelCore.
+class TestEphemerisContext : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testPositions();
+	void testMagnitudes();
+	void testLightTime();
+	void testStateIsConst();
+private:
+	void computeLivePositions(double JDE);
+	QTemporaryDir dir;
+	SolarSystem* ssystem;
+};
+
+#endif // _TESTEPHEMERISCONTEXT_HPP_
@@ -0,0 +1,384 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testSolarSystemCache.hpp"
+#include "SolarSystem.hpp"
+#include "MinorPlanet.hpp"
+#include "StelUtils.hpp"
+
+#include <QFile>
+#include <QTextStream>
+
+// SolarSystem has a QFont, which needs a QGuiApplication
+QTEST_MAIN(TestSolarSystemCache)
+
+#define COMPARE_VALUE(field) QVERIFY2(b.values.field == a.values.field, qPrintable(a.section + ": " #field))
+
+namespace
+{
+	// The bodies cover both orbit types with and without their optional elements, and the sections which are
+	// treated differently by SolarSystem::addBody(). Only bodies which need no StelCore are used.
+	const char* const solarSystemFile =
+		"[sun]\n"
+		"name = Sun\n"
+		"parent = none\n"
+		"radius = 696000\n"
+		"albedo = -1.\n"
+		"coord_func = sun_special\n"
+		"type = star\n"
+		"\n"
+		"[earth]\n"
+		"name = Earth\n"
+		"radius = 6378.1366\n"
+		"oblateness = 0.0033528\n"
+		"albedo = 0.306\n"
+		"color = 1., 0.915, 0.75\n"
+		"atmosphere = true\n"
+		"coord_func = ell_orbit\n"
+		"orbit_SemiMajorAxis = 149598261\n"
+		"orbit_Eccentricity = 0.01671123\n"
+		"orbit_Inclination = 0.\n"
+		"orbit_AscendingNode = 0.\n"
+		"orbit_LongOfPericenter = 102.93768193\n"
+		"orbit_MeanLongitude = 100.46457166\n"
+		"rot_periode = 23.9344694\n"
+		"rot_obliquity = 23.4392803055555555556\n"
+		"type = planet\n"
+		"\n"
+		"[mars]\n"
+		"name = Mars\n"
+		"radius = 3396.19\n"
+		"albedo = 0.15\n"
+		"normals_map = mars_normals2.png\n"
+		"coord_func = ell_orbit\n"
+		"orbit_SemiMajorAxis = 227939200\n"
+		"orbit_Eccentricity = 0.0933941\n"
+		"orbit_Inclination = 1.84969142\n"
+		"orbit_AscendingNode = 49.55953891\n"
+		"orbit_LongOfPericenter = 336.05637041\n"
+		"orbit_MeanLongitude = 355.45332\n"
+		"type = planet\n"
+		"\n"
+		"[phobos]\n"
+		"name = Phobos\n"
+		"parent = Mars\n"
+		"radius = 11.1\n"
+		"albedo = 0.071\n"
+		"coord_func = phobos_special\n"
+		"iau_moon_number = I\n"
+		"type = moon\n"
+		"\n"
+		"[ceres]\n"
+		"name = Ceres\n"
+		"radius = 473\n"
+		"albedo = 0.09\n"
+		"coord_func = comet_orbit\n"
+		"orbit_Epoch = 2458000.5\n"
+		"orbit_MeanAnomaly = 352.2304\n"
+		"orbit_PericenterDistance = 2.5577\n"
+		"orbit_Eccentricity = 0.0758\n"
+		"orbit_Inclination = 10.593\n"
+		"orbit_AscendingNode = 80.305\n"
+		"orbit_ArgOfPericenter = 73.597\n"
+		"absolute_magnitude = 3.34\n"
+		"slope_parameter = 0.12\n"
+		"minor_planet_number = 1\n"
+		"type = dwarf planet\n"
+		"\n"
+		"[pallas]\n"
+		"name = Pallas\n"
+		"radius = 256\n"
+		"albedo = 0.101\n"
+		"coord_func = comet_orbit\n"
+		"orbit_Epoch = 2458000.5\n"
+		"orbit_MeanAnomaly = 320.1138\n"
+		"orbit_SemiMajorAxis = 2.7724\n"
+		"orbit_Eccentricity = 0.2313\n"
+		"orbit_Inclination = 34.837\n"
+		"orbit_AscendingNode = 173.08\n"
+		"orbit_ArgOfPericenter = 310.05\n"
+		"absolute_magnitude = 4.13\n"
+		"minor_planet_number = 2\n"
+		"provisional_designation = A802 FA\n"
+		"type = asteroid\n"
+		"\n"
+		"[halley]\n"
+		"name = 1P/Halley\n"
+		"radius = 5\n"
+		"albedo = 0.04\n"
+		"coord_func = comet_orbit\n"
+		"orbit_TimeAtPericenter = 2446470.5\n"
+		"orbit_PericenterDistance = 0.5871\n"
+		"orbit_Eccentricity = 0.9671\n"
+		"orbit_Inclination = 162.26\n"
+		"orbit_AscendingNode = 58.42\n"
+		"orbit_ArgOfPericenter = 111.33\n"
+		"absolute_magnitude = 5.5\n"
+		"dust_lengthfactor = 0.6\n"
+		"type = comet\n";
+
+	// Asteroids without orbit_Epoch and orbit_ArgOfPericenter, so that the comet_orbit defaults are used,
+	// and with shared strings like a large imported file
+	const int generatedCount = 300;
+
+	const double dates[] = {2446480.5, 2451545.0, 2458396.25};
+	const int dateCount = sizeof(dates)/sizeof(dates[0]);
+}
+
+void TestSolarSystemCache::initTestCase()
+{
+	QVERIFY(dir.isValid());
+	const QString fileName = dir.path()+"/ssystem_minor.ini";
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+	QTextStream out(&file);
+	out.setRealNumberPrecision(12);
+	out << solarSystemFile;
+	for (int i=0; i<generatedCount; ++i)
+	{
+		out << "\n[a" << i << "]\n"
+		    << "name = 2017 AB" << i << "\n"
+		    << "provisional_designation = 2017 AB" << i << "\n"
+		    << "coord_func = comet_orbit\n"
+		    << "orbit_TimeAtPericenter = " << 2458000.5+i << "\n"
+		    << "orbit_PericenterDistance = " << 1.5+0.005*i << "\n"
+		    << "orbit_Eccentricity = " << 0.001*i << "\n"
+		    << "orbit_Inclination = " << 0.1*i << "\n"
+		    << "orbit_AscendingNode = " << 1.1*i << "\n"
+		    << "absolute_magnitude = " << 15.+0.01*i << "\n"
+		    << "radius = 1\n"
+		    << "type = asteroid\n";
+		if (i%7==0)
+			out << "hidden = true\n";
+	}
+	out.flush();
+	file.close();
+
+	QVERIFY(SolarSystem::readSolarSystemFile(fileName, parsed));
+	QCOMPARE(parsed.size(), 7+generatedCount);
+
+	const QString cacheFileName = dir.path()+"/ssystem_minor.cache";
+	QVERIFY(SolarSystemCache::write(cacheFileName, "stamp", parsed));
+	QVERIFY(SolarSystemCache::read(cacheFileName, "stamp", cached));
+
+	Planet::init();
+}
+
+void TestSolarSystemCache::cleanupTestCase()
+{
+	parsed.clear();
+	cached.clear();
+}
+
+SolarSystem* TestSolarSystemCache::createSolarSystem(const QVector<SolarSystemBodyData>& bodies)
+{
+	SolarSystem* ssystem = new SolarSystem();
+	ssystem->setFlagLightTravelTime(false);
+	QHash<QString, PlanetP> bodiesByName;
+	foreach (const SolarSystemBodyData& data, bodies)
+	{
+		PlanetP p = ssystem->addBody(data, bodiesByName);
+		if (!p.isNull())
+			bodiesByName.insert(p->getEnglishName(), p);
+	}
+	return ssystem;
+}
+
+// The defaults of the file format are applied by the parser, so the cache has to keep them.
+void TestSolarSystemCache::testDefaults()
+{
+	QHash<QString, SolarSystemBodyData> bySection;
+	foreach (const SolarSystemBodyData& data, cached)
+		bySection.insert(data.section, data);
+
+	// ell_orbit: epoch J2000, argument of pericenter from the longitude of pericenter
+	const SolarSystemBodyData earth = bySection.value("earth");
+	QCOMPARE(earth.englishName, QString("Earth"));
+	QCOMPARE(earth.parent, QString("Sun"));
+	QCOMPARE(earth.values.orbitEpoch, J2000);
+	QCOMPARE(earth.values.orbitArgOfPericenter, -1e100);
+	QCOMPARE(earth.values.slopeParameter, 0.15);
+	QCOMPARE(earth.normalsMap, QString("earth_normals.png"));
+	QCOMPARE(earth.texMap, QString("nomap.png"));
+
+	// comet_orbit: no epoch, argument of pericenter 0
+	const SolarSystemBodyData asteroid = bySection.value("a1");
+	QCOMPARE(asteroid.values.orbitEpoch, -1e100);
+	QCOMPARE(asteroid.values.orbitArgOfPericenter, 0.);
+	QCOMPARE(asteroid.values.orbitSemiMajorAxis, -1e100);
+	QCOMPARE(asteroid.provisionalDesignation, QString("2017 AB1"));
+
+	// no normal map for hidden bodies
+	const SolarSystemBodyData hidden = bySection.value("a7");
+	QVERIFY(hidden.values.hidden);
+	QVERIFY(hidden.normalsMap.isEmpty());
+
+	const SolarSystemBodyData halley = bySection.value("halley");
+	QCOMPARE(halley.values.slopeParameter, 4.0);
+	QCOMPARE(halley.values.orbitEpoch, -1e100);
+	QCOMPARE(halley.values.dustLengthFactor, 0.6f);
+
+	QCOMPARE(bySection.value("phobos").iauMoonNumber, QString("I"));
+	QCOMPARE(bySection.value("mars").normalsMap, QString("mars_normals2.png"));
+	QCOMPARE(bySection.value("sun").parent, QString("none"));
+}
+
+void TestSolarSystemCache::testRoundTrip()
+{
+	QCOMPARE(cached.size(), parsed.size());
+	for (int i=0; i<parsed.size(); ++i)
+	{
+		const SolarSystemBodyData& a = parsed.at(i);
+		const SolarSystemBodyData& b = cached.at(i);
+		// same order, the parents have to come first
+		QCOMPARE(b.section, a.section);
+		QCOMPARE(b.englishName, a.englishName);
+		QCOMPARE(b.parent, a.parent);
+		QCOMPARE(b.coordFunc, a.coordFunc);
+		QCOMPARE(b.type, a.type);
+		QCOMPARE(b.texMap, a.texMap);
+		QCOMPARE(b.normalsMap, a.normalsMap);
+		QCOMPARE(b.model, a.model);
+		QCOMPARE(b.provisionalDesignation, a.provisionalDesignation);
+		QCOMPARE(b.iauMoonNumber, a.iauMoonNumber);
+		QCOMPARE(b.texRing, a.texRing);
+
+		// the numbers are copied, so they must be identical and not only close
+		COMPARE_VALUE(orbitEpoch);
+		COMPARE_VALUE(orbitEccentricity);
+		COMPARE_VALUE(orbitPericenterDistance);
+		COMPARE_VALUE(orbitSemiMajorAxis);
+		COMPARE_VALUE(orbitMeanMotion);
+		COMPARE_VALUE(orbitPeriod);
+		COMPARE_VALUE(orbitInclination);
+		COMPARE_VALUE(orbitAscendingNode);
+		COMPARE_VALUE(orbitArgOfPericenter);
+		COMPARE_VALUE(orbitLongOfPericenter);
+		COMPARE_VALUE(orbitMeanAnomaly);
+		COMPARE_VALUE(orbitMeanLongitude);
+		COMPARE_VALUE(orbitTimeAtPericenter);
+		COMPARE_VALUE(orbitGood);
+		COMPARE_VALUE(orbitVisualizationPeriod);
+		COMPARE_VALUE(radius);
+		COMPARE_VALUE(oblateness);
+		COMPARE_VALUE(absoluteMagnitude);
+		COMPARE_VALUE(slopeParameter);
+		COMPARE_VALUE(rotPeriod);
+		COMPARE_VALUE(rotRotationOffset);
+		COMPARE_VALUE(rotEpoch);
+		COMPARE_VALUE(rotObliquity);
+		COMPARE_VALUE(rotAscendingNode);
+		COMPARE_VALUE(rotPoleRA);
+		COMPARE_VALUE(rotPoleDE);
+		COMPARE_VALUE(rotPrecessionRate);
+		COMPARE_VALUE(ringInnerSize);
+		COMPARE_VALUE(ringOuterSize);
+		COMPARE_VALUE(color[0]);
+		COMPARE_VALUE(color[1]);
+		COMPARE_VALUE(color[2]);
+		COMPARE_VALUE(albedo);
+		COMPARE_VALUE(roughness);
+		COMPARE_VALUE(outgasIntensity);
+		COMPARE_VALUE(outgasFalloff);
+		COMPARE_VALUE(dustWidthFactor);
+		COMPARE_VALUE(dustLengthFactor);
+		COMPARE_VALUE(dustBrightnessFactor);
+		COMPARE_VALUE(minorPlanetNumber);
+		COMPARE_VALUE(closeOrbit);
+		COMPARE_VALUE(hidden);
+		COMPARE_VALUE(atmosphere);
+		COMPARE_VALUE(halo);
+		COMPARE_VALUE(rings);
+	}
+}
+
+// The bodies created from the cache must be the same as the ones created from the parsed file.
+void TestSolarSystemCache::testBodies()
+{
+	SolarSystem* fromFile = createSolarSystem(parsed);
+	SolarSystem* fromCache = createSolarSystem(cached);
+	const QList<PlanetP>& a = fromFile->getAllPlanets();
+	const QList<PlanetP>& b = fromCache->getAllPlanets();
+	QCOMPARE(a.size(), parsed.size());
+	QCOMPARE(b.size(), a.size());
+	QVERIFY(!fromCache->getSun().isNull());
+	QVERIFY(!fromCache->getEarth().isNull());
+
+	for (int i=0; i<a.size(); ++i)
+	{
+		const PlanetP& p = a.at(i);
+		const PlanetP& q = b.at(i);
+		const QString name = p->getEnglishName();
+		QCOMPARE(q->getEnglishName(), name);
+		QCOMPARE(q->getPlanetType(), p->getPlanetType());
+		QCOMPARE(q->getParent().isNull(), p->getParent().isNull());
+		if (!p->getParent().isNull())
+			QCOMPARE(q->getParent()->getEnglishName(), p->getParent()->getEnglishName());
+		QCOMPARE(q->getRadius(), p->getRadius());
+		QCOMPARE(q->getAlbedo(), p->getAlbedo());
+		QCOMPARE(q->getAbsoluteMagnitude(), p->getAbsoluteMagnitude());
+		QCOMPARE(q->getSiderealPeriod(), p->getSiderealPeriod());
+		QCOMPARE(q->getSiderealDay(), p->getSiderealDay());
+	}
+
+	for (int d=0; d<dateCount; ++d)
+	{
+		for (int i=0; i<a.size(); ++i)
+		{
+			a.at(i)->computePosition(dates[d]);
+			b.at(i)->computePosition(dates[d]);
+			QVERIFY2(a.at(i)->getHeliocentricEclipticPos() == b.at(i)->getHeliocentricEclipticPos(), qPrintable(a.at(i)->getEnglishName()));
+		}
+	}
+
+	// A missing orbit_SemiMajorAxis (-1e100 in the file data) gives minor planets no sidereal period
+	const QSharedPointer<MinorPlanet> ceres = fromCache->searchMinorPlanetByEnglishName("Ceres").dynamicCast<MinorPlanet>();
+	QVERIFY(!ceres.isNull());
+	QCOMPARE(ceres->getSiderealPeriod(), 0.);
+	const QSharedPointer<MinorPlanet> pallas = fromCache->searchMinorPlanetByEnglishName("Pallas").dynamicCast<MinorPlanet>();
+	QVERIFY(!pallas.isNull());
+	QCOMPARE(pallas->getSiderealPeriod(), StelUtils::calculateSiderealPeriod(2.7724));
+
+	delete fromFile;
+	delete fromCache;
+}
+
+void TestSolarSystemCache::testStamp()
+{
+	const QString fileName = dir.path()+"/stamp.cache";
+	QVERIFY(SolarSystemCache::write(fileName, "version 1", parsed));
+	QVector<SolarSystemBodyData> res;
+	QVERIFY(!SolarSystemCache::read(fileName, "version 2", res));
+	QVERIFY(res.isEmpty());
+	QVERIFY(!SolarSystemCache::read(dir.path()+"/missing.cache", "version 1", res));
+}
+
+void TestSolarSystemCache::testInvalidFile()
+{
+	const QString fileName = dir.path()+"/truncated.cache";
+	QVERIFY(SolarSystemCache::write(fileName, "stamp", parsed));
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::ReadWrite));
+	QVERIFY(file.resize(file.size()-2));
+	file.close();
+	QVector<SolarSystemBodyData> res;
+	QVERIFY(!SolarSystemCache::read(fileName, "stamp", res));
+	QVERIFY(res.isEmpty());
+}
@@ -0,0 +1,53 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _TESTSOLARSYSTEMCACHE_HPP_
+#define _TESTSOLARSYSTEMCACHE_HPP_
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "SolarSystemCache.hpp"
+
+class SolarSystem;
+
+//! Checks that loading a Solar System file through its cache gives the same bodies as parsing the file,
+//! which is what SolarSystem::loadPlanets() relies on.
+class TestSolarSystemCache : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testDefaults();
+	void testRoundTrip();
+	void testBodies();
+	void testStamp();
+	void testInvalidFile();
+private:
+	//! Creates the bodies like SolarSystem::loadPlanets() does after reading the file or the cache
+	SolarSystem* createSolarSystem(const QVector<SolarSystemBodyData>& bodies);
+	QTemporaryDir dir;
+	QVector<SolarSystemBodyData> parsed;
+	QVector<SolarSystemBodyData> cached;
+};
+
+#endif // _TESTSOLARSYSTEMCACHE_HPP_
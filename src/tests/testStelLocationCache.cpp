@@ -0,0 +1,97 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelLocationCache.hpp"
+
+#include <QFile>
+
+QTEST_GUILESS_MAIN(TestStelLocationCache)
+
+void TestStelLocationCache::initTestCase()
+{
+	QVERIFY(dir.isValid());
+	for (int i=0; i<1000; ++i)
+	{
+		StelLocation loc;
+		loc.name = QString("Place %1").arg(i);
+		loc.state = (i%3==0) ? QString() : QString("State %1").arg(i%7);
+		loc.country = (i%2==0) ? "France" : QString::fromUtf8("Côte d'Ivoire");
+		loc.planetName = (i%10==0) ? "Mars" : "Earth";
+		loc.longitude = 0.37f*i-180.f;
+		loc.latitude = 0.17f*i-85.f;
+		loc.altitude = i-100;
+		loc.bortleScaleIndex = 1+i%9;
+		loc.population = i*1000;
+		loc.role = QChar::fromLatin1("CRNOX"[i%5]);
+		loc.ianaTimeZone = (i%4==0) ? "Europe/Paris" : "UTC+05:30";
+		loc.landscapeKey = (i%10==0) ? "mars" : QString();
+		loc.isUserLocation = (i%2==1);
+		locations.insert(QString("%1, %2").arg(loc.name, loc.country), loc);
+	}
+}
+
+void TestStelLocationCache::testRoundTrip()
+{
+	const QString fileName = dir.path()+"/roundtrip.cache";
+	QVERIFY(StelLocationCache::write(fileName, "stamp", locations));
+	QMap<QString, StelLocation> res;
+	QVERIFY(StelLocationCache::read(fileName, "stamp", res));
+	QCOMPARE(res.keys(), locations.keys());
+	for (QMap<QString, StelLocation>::const_iterator it=locations.constBegin(); it!=locations.constEnd(); ++it)
+	{
+		const StelLocation& a = it.value();
+		const StelLocation& b = res.value(it.key());
+		QCOMPARE(b.name, a.name);
+		QCOMPARE(b.state, a.state);
+		QCOMPARE(b.country, a.country);
+		QCOMPARE(b.planetName, a.planetName);
+		QCOMPARE(b.longitude, a.longitude);
+		QCOMPARE(b.latitude, a.latitude);
+		QCOMPARE(b.altitude, a.altitude);
+		QCOMPARE(b.bortleScaleIndex, a.bortleScaleIndex);
+		QCOMPARE(b.population, a.population);
+		QCOMPARE(b.role, a.role);
+		QCOMPARE(b.ianaTimeZone, a.ianaTimeZone);
+		QCOMPARE(b.landscapeKey, a.landscapeKey);
+		QCOMPARE(b.isUserLocation, a.isUserLocation);
+	}
+}
+
+void TestStelLocationCache::testStamp()
+{
+	const QString fileName = dir.path()+"/stamp.cache";
+	QVERIFY(StelLocationCache::write(fileName, "version 1", locations));
+	QMap<QString, StelLocation> res;
+	QVERIFY(!StelLocationCache::read(fileName, "version 2", res));
+	QVERIFY(res.isEmpty());
+	QVERIFY(!StelLocationCache::read(dir.path()+"/missing.cache", "version 1", res));
+}
+
+void TestStelLocationCache::testInvalidFile()
+{
+	const QString fileName = dir.path()+"/truncated.cache";
+	QVERIFY(StelLocationCache::write(fileName, "stamp", locations));
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::ReadWrite));
+	QVERIFY(file.resize(file.size()-2));
+	file.close();
+	QMap<QString, StelLocation> res;
+	QVERIFY(!StelLocationCache::read(fileName, "stamp", res));
+	QVERIFY(res.isEmpty());
+}
@@ -0,0 +1,131 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelLocationIndex.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestStelLocationIndex)
+
+// Same as StelLocation::distanceDegrees(), which is not linked to the test
+static float distanceDegrees(const float long1, const float lat1, const float long2, const float lat2)
+{
+	const float DEGREES=M_PI/180.0f;
+	return std::acos( std::sin(lat1*DEGREES)*std::sin(lat2*DEGREES) +
+			  std::cos(lat1*DEGREES)*std::cos(lat2*DEGREES) *
+			  std::cos((long1-long2)*DEGREES) ) / DEGREES;
+}
+
+void TestStelLocationIndex::initTestCase()
+{
+	qsrand(42);
+	for (int i=0; i<20000; ++i)
+	{
+		StelLocation loc;
+		loc.name = QString("Place %1").arg(i);
+		loc.planetName = (i%10==0) ? "Mars" : "Earth";
+		loc.longitude = 360.f*qrand()/RAND_MAX-180.f;
+		loc.latitude = 180.f*qrand()/RAND_MAX-90.f;
+		locations.insert(QString("%1, %2").arg(loc.name, loc.planetName), loc);
+	}
+	// Corner cases: poles, antimeridian
+	const float corners[][2] = {{0.f, 90.f}, {123.f, -90.f}, {180.f, 10.f}, {-180.f, -10.f}, {179.99f, 45.f}, {-179.99f, 45.f}};
+	for (unsigned int i=0; i<sizeof(corners)/sizeof(corners[0]); ++i)
+	{
+		StelLocation loc;
+		loc.name = QString("Corner %1").arg(i);
+		loc.planetName = "Earth";
+		loc.longitude = corners[i][0];
+		loc.latitude = corners[i][1];
+		locations.insert(QString("%1, Earth").arg(loc.name), loc);
+	}
+	StelLocation loc;
+	loc.planetName = "Earth";
+	locations.insert("Paris, France", loc);
+	locations.insert("paris, Texas", loc);
+	locations.insert("Parma, Italy", loc);
+	locations.insert("Pasadena, California", loc);
+	index.build(locations);
+}
+
+QStringList TestStelLocationIndex::nearbyByLinearScan(const QString& planetName, float longitude, float latitude, float radius) const
+{
+	QStringList result;
+	for (QMap<QString, StelLocation>::const_iterator it=locations.constBegin(); it!=locations.constEnd(); ++it)
+	{
+		if (it->planetName==planetName && distanceDegrees(longitude, latitude, it->longitude, it->latitude)<=radius)
+			result.append(it.key());
+	}
+	return result;
+}
+
+QStringList TestStelLocationIndex::nearbyByIndex(const QString& planetName, float longitude, float latitude, float radius) const
+{
+	QStringList result;
+	foreach (const StelLocationIndex::Entry& it, index.candidatesNearby(planetName, longitude, latitude, radius))
+	{
+		if (it->planetName!=planetName)
+			result.append("Wrong planet: "+it.key());
+		else if (distanceDegrees(longitude, latitude, it->longitude, it->latitude)<=radius)
+			result.append(it.key());
+	}
+	result.sort();
+	return result;
+}
+
+void TestStelLocationIndex::testNearbyMatchesLinearScan()
+{
+	const float radii[] = {0.5f, 1.f, 3.f, 10.f, 30.f, 89.f, 120.f, 180.f};
+	const float centers[][2] = {{0.f, 0.f}, {2.35f, 48.85f}, {180.f, 0.f}, {-180.f, 45.f}, {179.5f, -60.f},
+				    {0.f, 89.5f}, {-45.f, -89.5f}, {10.f, 90.f}, {-170.f, 75.f}, {190.f, 20.f}};
+	for (unsigned int c=0; c<sizeof(centers)/sizeof(centers[0]); ++c)
+	{
+		for (unsigned int r=0; r<sizeof(radii)/sizeof(radii[0]); ++r)
+		{
+			const QStringList expected = nearbyByLinearScan("Earth", centers[c][0], centers[c][1], radii[r]);
+			const QStringList found = nearbyByIndex("Earth", centers[c][0], centers[c][1], radii[r]);
+			QVERIFY2(found==expected, qPrintable(QString("center %1/%2 radius %3: %4 found, %5 expected")
+							     .arg(centers[c][0]).arg(centers[c][1]).arg(radii[r]).arg(found.size()).arg(expected.size())));
+		}
+	}
+}
+
+void TestStelLocationIndex::testNearbyOtherPlanet()
+{
+	QCOMPARE(nearbyByIndex("Mars", 20.f, -30.f, 15.f), nearbyByLinearScan("Mars", 20.f, -30.f, 15.f));
+	QVERIFY(index.candidatesNearby("Jupiter", 0.f, 0.f, 180.f).isEmpty());
+	QVERIFY(index.candidatesNearby("Earth", 0.f, 0.f, -1.f).isEmpty());
+}
+
+void TestStelLocationIndex::testPrefix()
+{
+	QCOMPARE(index.idsWithPrefix("par"), QStringList() << "Paris, France" << "paris, Texas" << "Parma, Italy");
+	QCOMPARE(index.idsWithPrefix("PARIS"), QStringList() << "Paris, France" << "paris, Texas");
+	QCOMPARE(index.idsWithPrefix("pa", 2), QStringList() << "Paris, France" << "paris, Texas");
+	QVERIFY(index.idsWithPrefix("Paz").isEmpty());
+	QCOMPARE(index.idsWithPrefix("Place 1234").size(), 1+10);
+	QCOMPARE(index.idsWithPrefix("").size(), locations.size());
+}
+
+void TestStelLocationIndex::benchmarkNearby()
+{
+	QBENCHMARK {
+		index.candidatesNearby("Earth", 2.35f, 48.85f, 3.f);
+	}
+}
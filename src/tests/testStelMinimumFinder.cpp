@@ -0,0 +1,120 @@
+/*
+ * Stellarium
+ * Copyright (C) 2017 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testStelMinimumFinder.hpp"
+#include "StelMinimumFinder.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestStelMinimumFinder)
+
+namespace
+{
+	const double synodicMonth = 29.530589;
+
+	// Like the angular separation of the Moon and a star: periodic, with a minimum of 0.5 every synodic month
+	double periodic(double x)
+	{
+		return 1.5-std::cos(2.*M_PI*x/synodicMonth);
+	}
+
+	// Minima whose depth changes slowly, some of them below 0.3
+	double modulated(double x)
+	{
+		return 1.5-std::cos(2.*M_PI*x/synodicMonth)+0.4*std::sin(2.*M_PI*x/700.);
+	}
+}
+
+void TestStelMinimumFinder::testBrentParabola()
+{
+	int evaluations = 0;
+	const StelMinimumFinder::Minimum minimum = StelMinimumFinder::brentMinimize([](double x) { return (x-3.3)*(x-3.3)+2.; },
+										     0., 10., 4., 2.49, 1e-6, &evaluations);
+	QVERIFY2(std::fabs(minimum.x-3.3)<1e-5, qPrintable(QString("x=%1").arg(minimum.x, 0, 'g', 10)));
+	QVERIFY(std::fabs(minimum.value-2.)<1e-9);
+	// The parabolic steps find the minimum of a parabola at once
+	QVERIFY2(evaluations<10, qPrintable(QString("%1 evaluations").arg(evaluations)));
+}
+
+void TestStelMinimumFinder::testPeriodicMinima()
+{
+	int evaluations = 0;
+	const double stop = 3652.5;
+	const QList<StelMinimumFinder::Minimum> minima = StelMinimumFinder::findMinima(periodic, 0., stop, synodicMonth/16., 1., 1e-4, Q_NULLPTR, &evaluations);
+	QCOMPARE(minima.size(), (int)std::floor(stop/synodicMonth));
+	for (int i=0; i<minima.size(); ++i)
+	{
+		QVERIFY2(std::fabs(minima.at(i).x-(i+1)*synodicMonth)<1e-3, qPrintable(QString("minimum %1 at %2").arg(i).arg(minima.at(i).x, 0, 'f', 6)));
+		QVERIFY(std::fabs(minima.at(i).value-0.5)<1e-6);
+	}
+	// A fixed step of 0.25 days needed more than 14600 evaluations for the same decade
+	QVERIFY2(evaluations<3000, qPrintable(QString("%1 evaluations").arg(evaluations)));
+}
+
+void TestStelMinimumFinder::testSharpMinimum()
+{
+	// Like the angular separation of two bodies passing close to each other: not smooth at the scale of the step
+	const StelMinimumFinder::Function f = [](double x) { return std::sqrt(1e-4+0.04*(x-123.456)*(x-123.456)); };
+	const QList<StelMinimumFinder::Minimum> minima = StelMinimumFinder::findMinima(f, 0., 1000., 10., 1., 1e-4);
+	QCOMPARE(minima.size(), 1);
+	QVERIFY2(std::fabs(minima.first().x-123.456)<1e-3, qPrintable(QString("x=%1").arg(minima.first().x, 0, 'f', 6)));
+	QVERIFY(std::fabs(minima.first().value-0.01)<1e-6);
+}
+
+void TestStelMinimumFinder::testMaxValue()
+{
+	const double stop = 2000.;
+	const double maxValue = 0.3;
+	const QList<StelMinimumFinder::Minimum> minima = StelMinimumFinder::findMinima(modulated, 0., stop, synodicMonth/16., maxValue, 1e-5);
+
+	// Count the minima below maxValue with a dense sampling
+	int expected = 0;
+	const double h = 0.01;
+	for (double x=h; x<stop-h; x+=h)
+	{
+		const double fx = modulated(x);
+		if (fx<maxValue && fx<modulated(x-h) && fx<=modulated(x+h))
+			++expected;
+	}
+	QVERIFY(expected>0);
+	QCOMPARE(minima.size(), expected);
+	foreach (const StelMinimumFinder::Minimum& minimum, minima)
+	{
+		QVERIFY(minimum.value<maxValue);
+		QVERIFY(minimum.value<=modulated(minimum.x-1e-3));
+		QVERIFY(minimum.value<=modulated(minimum.x+1e-3));
+	}
+}
+
+void TestStelMinimumFinder::testNoMinimum()
+{
+	// Minima at the ends of the interval are not local minima
+	QVERIFY(StelMinimumFinder::findMinima([](double x) { return x; }, 0., 100., 1., 1000., 1e-4).isEmpty());
+	QVERIFY(StelMinimumFinder::findMinima([](double x) { return -x; }, 0., 100., 1., 1000., 1e-4).isEmpty());
+	QVERIFY(StelMinimumFinder::findMinima(periodic, 10., 5., 1., 1000., 1e-4).isEmpty());
+}
+
+void TestStelMinimumFinder::testCancelled()
+{
+	QAtomicInt cancelled(1);
+	int evaluations = 0;
+	QVERIFY(StelMinimumFinder::findMinima(periodic, 0., 3652.5, 1., 1000., 1e-4, &cancelled, &evaluations).isEmpty());
+	QVERIFY(evaluations<=2);
+}